@@ -0,0 +1,77 @@
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "arena_scope.h"
+
+namespace {
+
+/**
+ * Simulates handling of a request: parses headers into a map, builds a list of tokens, and renders a response.
+ */
+std::size_t handle_request(std::pmr::memory_resource* mr, std::size_t headers)
+{
+    std::pmr::unordered_map<std::pmr::string, std::pmr::string> map(mr);
+    std::pmr::vector<std::pmr::string> tokens(mr);
+    for (std::size_t i = 0; i < headers; ++i) {
+        std::pmr::string name("X-Header-Name-Number-", mr);
+        name += std::to_string(i);
+        map.emplace(name, std::pmr::string("a header value which is long enough to need a heap buffer", mr));
+        tokens.emplace_back(name);
+    }
+
+    std::pmr::string response(mr);
+    for (const auto& [name, value] : map) {
+        response += name;
+        response += ": ";
+        response += value;
+        response += "\r\n";
+    }
+
+    return response.size() + tokens.size();
+}
+
+void BM_RequestArena(benchmark::State& state)
+{
+    const auto headers = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state) {
+        alignas(std::max_align_t) std::array<std::byte, 16384> buffer;  // NOLINT(*-member-init)
+        wwa::utils::arena_scope arena(buffer);
+        benchmark::DoNotOptimize(handle_request(arena.resource(), headers));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_RequestArenaNoBuffer(benchmark::State& state)
+{
+    const auto headers = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state) {
+        wwa::utils::arena_scope arena;
+        benchmark::DoNotOptimize(handle_request(arena.resource(), headers));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_RequestMalloc(benchmark::State& state)
+{
+    const auto headers = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(handle_request(std::pmr::new_delete_resource(), headers));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+BENCHMARK(BM_RequestArena)->Arg(8)->Arg(32)->Arg(256);
+BENCHMARK(BM_RequestArenaNoBuffer)->Arg(8)->Arg(32)->Arg(256);
+BENCHMARK(BM_RequestMalloc)->Arg(8)->Arg(32)->Arg(256);
@@ -0,0 +1,131 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "construction_guard.h"
+#include "scope_action.h"
+
+namespace {
+
+constexpr std::size_t count = 10'000'000;
+
+/**
+ * A type with a non-trivial destructor.
+ */
+struct handle {
+    std::uint64_t value = 0;
+
+    handle() = default;
+    explicit handle(std::uint64_t v) noexcept : value(v) {}
+    handle(const handle&)            = default;
+    handle& operator=(const handle&) = default;
+    ~handle() noexcept { benchmark::DoNotOptimize(this->value); }
+};
+
+template<typename T>
+class fixture {
+public:
+    fixture() : m_source(count), m_data(std::allocator<T>().allocate(count)) {}
+    fixture(const fixture&)            = delete;
+    fixture(fixture&&)                 = delete;
+    fixture& operator=(const fixture&) = delete;
+    fixture& operator=(fixture&&)      = delete;
+    ~fixture() { std::allocator<T>().deallocate(this->m_data, count); }
+
+    [[nodiscard]] const std::vector<T>& source() const noexcept { return this->m_source; }
+    [[nodiscard]] T* data() const noexcept { return this->m_data; }
+
+    void destroy(benchmark::State& state) const
+    {
+        state.PauseTiming();
+        std::destroy_n(this->m_data, count);
+        state.ResumeTiming();
+    }
+
+private:
+    std::vector<T> m_source;
+    T* m_data;
+};
+
+template<typename T>
+void BM_GuardCopy(benchmark::State& state)
+{
+    const fixture<T> f;
+    for (auto _ : state) {
+        wwa::utils::construction_guard guard(f.data());
+        guard.copy(f.source().begin(), f.source().end());
+        benchmark::DoNotOptimize(guard.release());
+        f.destroy(state);
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * count));
+}
+
+template<typename T>
+void BM_HandWrittenCopy(benchmark::State& state)
+{
+    const fixture<T> f;
+    for (auto _ : state) {
+        T* data           = f.data();
+        std::size_t built = 0;
+        wwa::utils::fail_action destroy([data, &built]() noexcept { std::destroy_n(data, built); });
+        for (const T& item : f.source()) {
+            std::construct_at(data + built, item);
+            ++built;
+        }
+
+        destroy.release();
+        benchmark::DoNotOptimize(data);
+        f.destroy(state);
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * count));
+}
+
+template<typename T>
+void BM_GuardValueConstruct(benchmark::State& state)
+{
+    const fixture<T> f;
+    for (auto _ : state) {
+        wwa::utils::construction_guard guard(f.data());
+        guard.value_construct(count);
+        benchmark::DoNotOptimize(guard.release());
+        f.destroy(state);
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * count));
+}
+
+template<typename T>
+void BM_HandWrittenValueConstruct(benchmark::State& state)
+{
+    const fixture<T> f;
+    for (auto _ : state) {
+        T* data           = f.data();
+        std::size_t built = 0;
+        wwa::utils::fail_action destroy([data, &built]() noexcept { std::destroy_n(data, built); });
+        for (; built < count; ++built) {
+            std::construct_at(data + built);
+        }
+
+        destroy.release();
+        benchmark::DoNotOptimize(data);
+        f.destroy(state);
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * count));
+}
+
+}  // namespace
+
+BENCHMARK(BM_GuardCopy<std::uint64_t>);
+BENCHMARK(BM_HandWrittenCopy<std::uint64_t>);
+BENCHMARK(BM_GuardCopy<handle>);
+BENCHMARK(BM_HandWrittenCopy<handle>);
+BENCHMARK(BM_GuardValueConstruct<std::uint64_t>);
+BENCHMARK(BM_HandWrittenValueConstruct<std::uint64_t>);
+BENCHMARK(BM_GuardValueConstruct<handle>);
+BENCHMARK(BM_HandWrittenValueConstruct<handle>);
@@ -0,0 +1,168 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "container_rollback.h"
+
+namespace {
+
+constexpr std::size_t batch = 100;
+
+std::vector<std::string> make_vector(std::size_t size)
+{
+    std::vector<std::string> v;
+    v.reserve(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        v.push_back("element #" + std::to_string(i) + " which does not fit into the small string buffer");
+    }
+
+    return v;
+}
+
+std::unordered_map<std::uint64_t, std::string> make_map(std::size_t size)
+{
+    std::unordered_map<std::uint64_t, std::string> m;
+    for (std::size_t i = 0; i < size; ++i) {
+        m.try_emplace(i, "value #" + std::to_string(i));
+    }
+
+    return m;
+}
+
+/**
+ * Appends a batch of elements, failing at the end of the batch.
+ */
+void append_batch(std::vector<std::string>& v)
+{
+    for (std::size_t i = 0; i < batch; ++i) {
+        v.emplace_back("new element");
+    }
+
+    throw std::runtime_error("error");
+}
+
+void BM_AppendGuard(benchmark::State& state)
+{
+    auto v = make_vector(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+        try {
+            wwa::utils::append_guard guard(v);
+            append_batch(v);
+        }
+        catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+        }
+    }
+
+    benchmark::DoNotOptimize(v);
+}
+
+void BM_AppendCopyAndSwap(benchmark::State& state)
+{
+    auto v = make_vector(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+        try {
+            auto copy = v;
+            append_batch(copy);
+            v.swap(copy);
+        }
+        catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+        }
+    }
+
+    benchmark::DoNotOptimize(v);
+}
+
+void BM_InsertGuard(benchmark::State& state)
+{
+    const auto size = static_cast<std::uint64_t>(state.range(0));
+    auto m          = make_map(size);
+    for (auto _ : state) {
+        try {
+            wwa::utils::insert_guard guard(m);
+            for (std::uint64_t i = 0; i < batch; ++i) {
+                guard.try_emplace(size + i, "new value");
+            }
+
+            throw std::runtime_error("error");
+        }
+        catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+        }
+    }
+
+    benchmark::DoNotOptimize(m);
+}
+
+void BM_InsertCopyAndSwap(benchmark::State& state)
+{
+    const auto size = static_cast<std::uint64_t>(state.range(0));
+    auto m          = make_map(size);
+    for (auto _ : state) {
+        try {
+            auto copy = m;
+            for (std::uint64_t i = 0; i < batch; ++i) {
+                copy.try_emplace(size + i, "new value");
+            }
+
+            throw std::runtime_error("error");
+            m.swap(copy);  // NOLINT(*-unreachable-code)
+        }
+        catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+        }
+    }
+
+    benchmark::DoNotOptimize(m);
+}
+
+void BM_OverwriteGuard(benchmark::State& state)
+{
+    auto v = make_vector(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+        try {
+            wwa::utils::overwrite_guard guard(v);
+            for (std::size_t i = 0; i < batch; ++i) {
+                guard.modify(i * 7 % v.size()) += '!';
+            }
+
+            throw std::runtime_error("error");
+        }
+        catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+        }
+    }
+
+    benchmark::DoNotOptimize(v);
+}
+
+void BM_OverwriteCopyAndSwap(benchmark::State& state)
+{
+    auto v = make_vector(static_cast<std::size_t>(state.range(0)));
+    for (auto _ : state) {
+        try {
+            auto copy = v;
+            for (std::size_t i = 0; i < batch; ++i) {
+                copy[i * 7 % copy.size()] += '!';
+            }
+
+            throw std::runtime_error("error");
+            v.swap(copy);  // NOLINT(*-unreachable-code)
+        }
+        catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+        }
+    }
+
+    benchmark::DoNotOptimize(v);
+}
+
+}  // namespace
+
+BENCHMARK(BM_AppendGuard)->Arg(1'000)->Arg(100'000);
+BENCHMARK(BM_AppendCopyAndSwap)->Arg(1'000)->Arg(100'000);
+BENCHMARK(BM_InsertGuard)->Arg(1'000)->Arg(100'000);
+BENCHMARK(BM_InsertCopyAndSwap)->Arg(1'000)->Arg(100'000);
+BENCHMARK(BM_OverwriteGuard)->Arg(1'000)->Arg(100'000);
+BENCHMARK(BM_OverwriteCopyAndSwap)->Arg(1'000)->Arg(100'000);
@@ -0,0 +1,177 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "deferred_maintenance.h"
+
+namespace {
+
+std::vector<std::uint64_t> random_values(std::size_t n, std::uint64_t seed)
+{
+    std::mt19937_64 rng(seed);
+    std::vector<std::uint64_t> v(n);
+    std::ranges::generate(v, rng);
+    return v;
+}
+
+// Erase every other element while iterating
+
+void BM_EraseDeferred(benchmark::State& state)
+{
+    const auto source = random_values(static_cast<std::size_t>(state.range(0)), 1);
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto v = source;
+        state.ResumeTiming();
+        {
+            wwa::utils::deferred_maintenance batch(v);
+            for (std::size_t i = 0; i < v.size(); ++i) {
+                if (v[i] % 2 == 0) {
+                    batch.erase(i);
+                }
+            }
+        }
+
+        benchmark::DoNotOptimize(v.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_EraseImmediate(benchmark::State& state)
+{
+    const auto source = random_values(static_cast<std::size_t>(state.range(0)), 1);
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto v = source;
+        state.ResumeTiming();
+        for (auto it = v.begin(); it != v.end();) {
+            it = *it % 2 == 0 ? v.erase(it) : it + 1;
+        }
+
+        benchmark::DoNotOptimize(v.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Insert N random values into a sorted vector of N elements
+
+void BM_SortedInsertDeferred(benchmark::State& state)
+{
+    const auto n      = static_cast<std::size_t>(state.range(0));
+    auto sorted       = random_values(n, 1);
+    const auto values = random_values(n, 2);
+    std::ranges::sort(sorted);
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto v = sorted;
+        state.ResumeTiming();
+        {
+            wwa::utils::deferred_maintenance batch(v, wwa::utils::container_order::sorted);
+            for (const auto value : values) {
+                batch.insert(value);
+            }
+        }
+
+        benchmark::DoNotOptimize(v.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_SortedInsertImmediate(benchmark::State& state)
+{
+    const auto n      = static_cast<std::size_t>(state.range(0));
+    auto sorted       = random_values(n, 1);
+    const auto values = random_values(n, 2);
+    std::ranges::sort(sorted);
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto v = sorted;
+        state.ResumeTiming();
+        for (const auto value : values) {
+            v.insert(std::ranges::upper_bound(v, value), value);
+        }
+
+        benchmark::DoNotOptimize(v.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Cancel every other element of a heap of N elements and push N new ones
+
+void BM_HeapDeferred(benchmark::State& state)
+{
+    const auto n      = static_cast<std::size_t>(state.range(0));
+    auto heap         = random_values(n, 1);
+    const auto values = random_values(n, 2);
+    std::ranges::make_heap(heap);
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto v = heap;
+        state.ResumeTiming();
+        {
+            wwa::utils::deferred_maintenance batch(v, wwa::utils::container_order::heap);
+            for (std::size_t i = 0; i < v.size(); ++i) {
+                if (v[i] % 2 == 0) {
+                    batch.erase(i);
+                }
+            }
+
+            for (const auto value : values) {
+                batch.insert(value);
+            }
+        }
+
+        benchmark::DoNotOptimize(v.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_HeapImmediate(benchmark::State& state)
+{
+    const auto n      = static_cast<std::size_t>(state.range(0));
+    auto heap         = random_values(n, 1);
+    const auto values = random_values(n, 2);
+    std::ranges::make_heap(heap);
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto v = heap;
+        state.ResumeTiming();
+        for (auto it = v.begin(); it != v.end();) {
+            if (*it % 2 == 0) {
+                it = v.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+
+        std::ranges::make_heap(v);
+        for (const auto value : values) {
+            v.push_back(value);
+            std::ranges::push_heap(v);
+        }
+
+        benchmark::DoNotOptimize(v.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+}  // namespace
+
+// Immediate erasure and sorted insertion are quadratic: 10^6 elements would take minutes
+BENCHMARK(BM_EraseDeferred)->Arg(10'000)->Arg(100'000)->Arg(1'000'000);
+BENCHMARK(BM_EraseImmediate)->Arg(10'000)->Arg(100'000);
+BENCHMARK(BM_SortedInsertDeferred)->Arg(10'000)->Arg(100'000)->Arg(1'000'000);
+BENCHMARK(BM_SortedInsertImmediate)->Arg(10'000)->Arg(100'000);
+BENCHMARK(BM_HeapDeferred)->Arg(10'000)->Arg(100'000)->Arg(1'000'000);
+BENCHMARK(BM_HeapImmediate)->Arg(10'000)->Arg(100'000);
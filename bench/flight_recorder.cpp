@@ -0,0 +1,48 @@
+#include <benchmark/benchmark.h>
+
+#include "scope_action.h"
+
+namespace {
+
+void BM_FlightRecord(benchmark::State& state)
+{
+    int guard = 0;
+    for (auto _ : state) {
+        wwa::utils::detail::flight_record(
+            wwa::utils::detail::flight_event_type::armed, 0, wwa::utils::detail::probe_site(), &guard
+        );
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_RecordedExitAction(benchmark::State& state)
+{
+    int calls = 0;
+    for (auto _ : state) {
+        const wwa::utils::exit_action guard([&calls]() { ++calls; });
+        benchmark::DoNotOptimize(&guard);
+    }
+
+    benchmark::DoNotOptimize(calls);
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_RecordedFailAction(benchmark::State& state)
+{
+    int calls = 0;
+    for (auto _ : state) {
+        const wwa::utils::fail_action guard([&calls]() { ++calls; });
+        benchmark::DoNotOptimize(&guard);
+    }
+
+    benchmark::DoNotOptimize(calls);
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+BENCHMARK(BM_FlightRecord);
+BENCHMARK(BM_RecordedExitAction);
+BENCHMARK(BM_RecordedFailAction);
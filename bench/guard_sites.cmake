@@ -0,0 +1,98 @@
+# Measures the code generated for many guard sites: compiles a synthetic translation unit with SITES functions, each
+# with two exit_action guards (a free function with an int, and a member function with an object), once with lambdas
+# and once with bound arguments. Reports the compile time, the total size of the .text sections of the object file, and
+# the number of exit_action symbols defined in it.
+#
+# Usage: cmake -DCXX=<compiler> -DNM=<nm> -DSIZE=<size> -DSOURCE_DIR=<src> -DWORK_DIR=<dir> [-DSITES=<n>]
+#        [-DOPTIMIZATIONS=<o1;o2;...>] -P guard_sites.cmake
+
+if(NOT DEFINED SITES)
+    set(SITES 1000)
+endif()
+
+if(NOT DEFINED OPTIMIZATIONS)
+    set(OPTIMIZATIONS -O0 -O2)
+endif()
+
+file(MAKE_DIRECTORY "${WORK_DIR}")
+
+string(CONCAT PROLOGUE
+    "#include \"exit_action.h\"\n\n"
+    "struct connection {\n    int fd = -1;\n    void close() noexcept;\n};\n\n"
+    "void release(int fd) noexcept;\nvoid use(connection& c, int fd);\n"
+)
+
+set(LAMBDAS "${PROLOGUE}")
+set(BOUND "${PROLOGUE}")
+math(EXPR LAST "${SITES} - 1")
+foreach(I RANGE 0 ${LAST})
+    string(APPEND LAMBDAS
+        "\nvoid site_${I}(connection& c, int fd)\n{\n"
+        "    const wwa::utils::exit_action a([fd]() noexcept { release(fd); });\n"
+        "    const wwa::utils::exit_action b([&c]() noexcept { c.close(); });\n"
+        "    use(c, fd);\n}\n"
+    )
+    string(APPEND BOUND
+        "\nvoid site_${I}(connection& c, int fd)\n{\n"
+        "    const wwa::utils::exit_action a(release, fd);\n"
+        "    const wwa::utils::exit_action b(&connection::close, c);\n"
+        "    use(c, fd);\n}\n"
+    )
+endforeach()
+
+file(WRITE "${WORK_DIR}/lambdas.cpp" "${LAMBDAS}")
+file(WRITE "${WORK_DIR}/bound.cpp" "${BOUND}")
+
+message("variant    flags   compile, ms       .text   exit_action symbols")
+foreach(OPT ${OPTIMIZATIONS})
+    foreach(VARIANT lambdas bound)
+        set(OBJECT "${WORK_DIR}/${VARIANT}${OPT}.o")
+
+        string(TIMESTAMP START "%s%f")
+        execute_process(
+            COMMAND ${CXX} -std=c++20 ${OPT} "-I${SOURCE_DIR}" -c "${WORK_DIR}/${VARIANT}.cpp" -o "${OBJECT}"
+            RESULT_VARIABLE RESULT
+        )
+        string(TIMESTAMP END "%s%f")
+        if(NOT RESULT EQUAL 0)
+            message(FATAL_ERROR "Failed to compile ${VARIANT}.cpp with ${OPT}")
+        endif()
+
+        math(EXPR ELAPSED "(${END} - ${START}) / 1000")
+
+        # Inline functions and template instantiations are emitted into .text.<name> sections
+        execute_process(COMMAND ${SIZE} -A "${OBJECT}" OUTPUT_VARIABLE SECTIONS RESULT_VARIABLE RESULT)
+        if(NOT RESULT EQUAL 0)
+            message(FATAL_ERROR "Failed to read the sections of ${OBJECT}")
+        endif()
+
+        set(TEXT 0)
+        string(REGEX MATCHALL "(^|\n)\\.text[^ \n]*[ ]+[0-9]+" ENTRIES "${SECTIONS}")
+        foreach(ENTRY ${ENTRIES})
+            string(REGEX REPLACE ".*[ ]([0-9]+)$" "\\1" BYTES "${ENTRY}")
+            math(EXPR TEXT "${TEXT} + ${BYTES}")
+        endforeach()
+
+        execute_process(COMMAND ${NM} -C --defined-only "${OBJECT}" OUTPUT_VARIABLE SYMBOLS RESULT_VARIABLE RESULT)
+        if(NOT RESULT EQUAL 0)
+            message(FATAL_ERROR "Failed to read the symbols of ${OBJECT}")
+        endif()
+
+        string(REGEX MATCHALL "[^\n]*exit_action<[^\n]*" GUARD_SYMBOLS "${SYMBOLS}")
+        list(LENGTH GUARD_SYMBOLS GUARD_COUNT)
+
+        string(REPEAT " " 24 PAD)
+        string(SUBSTRING "${VARIANT}${PAD}" 0 8 COLUMN)
+        string(SUBSTRING "${OPT}${PAD}" 0 6 OPT_COLUMN)
+        string(LENGTH "${ELAPSED}" LEN)
+        math(EXPR LEN "14 - ${LEN}")
+        string(SUBSTRING "${PAD}" 0 ${LEN} TIME_PAD)
+        string(LENGTH "${TEXT}" LEN)
+        math(EXPR LEN "12 - ${LEN}")
+        string(SUBSTRING "${PAD}" 0 ${LEN} TEXT_PAD)
+        string(LENGTH "${GUARD_COUNT}" LEN)
+        math(EXPR LEN "22 - ${LEN}")
+        string(SUBSTRING "${PAD}" 0 ${LEN} COUNT_PAD)
+        message("${COLUMN}   ${OPT_COLUMN}${TIME_PAD}${ELAPSED}${TEXT_PAD}${TEXT}${COUNT_PAD}${GUARD_COUNT}")
+    endforeach()
+endforeach()
@@ -0,0 +1,34 @@
+#include <benchmark/benchmark.h>
+
+#include "scope_action.h"
+
+namespace {
+
+void BM_CountedExitAction(benchmark::State& state)
+{
+    int calls = 0;
+    for (auto _ : state) {
+        const wwa::utils::exit_action guard([&calls]() { ++calls; });
+        benchmark::DoNotOptimize(&guard);
+    }
+
+    benchmark::DoNotOptimize(calls);
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_CountedFailAction(benchmark::State& state)
+{
+    int calls = 0;
+    for (auto _ : state) {
+        const wwa::utils::fail_action guard([&calls]() { ++calls; });
+        benchmark::DoNotOptimize(&guard);
+    }
+
+    benchmark::DoNotOptimize(calls);
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+BENCHMARK(BM_CountedExitAction)->ThreadRange(1, 4);
+BENCHMARK(BM_CountedFailAction);
@@ -0,0 +1,65 @@
+# Measures the cost of including each header on its own: the size of the preprocessed translation unit and the time
+# the compiler takes to parse it (-fsyntax-only, best of REPEAT runs).
+#
+# Usage: cmake -DCXX=<compiler> -DSOURCE_DIR=<src> -DWORK_DIR=<dir> [-DREPEAT=<n>] [-DHEADERS=<h1;h2;...>]
+#        -P header_cost.cmake
+
+if(NOT DEFINED REPEAT)
+    set(REPEAT 5)
+endif()
+
+if(NOT DEFINED HEADERS)
+    set(HEADERS exit_action.h fail_action.h success_action.h scope_action.h)
+endif()
+
+file(MAKE_DIRECTORY "${WORK_DIR}")
+set(FLAGS -std=c++20 "-I${SOURCE_DIR}")
+
+message("header                    lines      bytes   parse, ms")
+foreach(HEADER ${HEADERS})
+    string(MAKE_C_IDENTIFIER "${HEADER}" NAME)
+    set(TU "${WORK_DIR}/${NAME}.cpp")
+    file(WRITE "${TU}" "#include \"${HEADER}\"\n")
+
+    execute_process(
+        COMMAND ${CXX} ${FLAGS} -E -P "${TU}"
+        OUTPUT_FILE "${WORK_DIR}/${NAME}.ii"
+        RESULT_VARIABLE RESULT
+    )
+    if(NOT RESULT EQUAL 0)
+        message(FATAL_ERROR "Failed to preprocess ${HEADER}")
+    endif()
+
+    file(SIZE "${WORK_DIR}/${NAME}.ii" BYTES)
+    file(READ "${WORK_DIR}/${NAME}.ii" CONTENT)
+    string(REGEX REPLACE "[^\n]" "" CONTENT "${CONTENT}")
+    string(LENGTH "${CONTENT}" LINE_COUNT)
+
+    set(BEST "")
+    foreach(I RANGE 1 ${REPEAT})
+        string(TIMESTAMP START "%s%f")
+        execute_process(COMMAND ${CXX} ${FLAGS} -fsyntax-only "${TU}" RESULT_VARIABLE RESULT)
+        string(TIMESTAMP END "%s%f")
+        if(NOT RESULT EQUAL 0)
+            message(FATAL_ERROR "Failed to compile ${HEADER}")
+        endif()
+
+        math(EXPR ELAPSED "(${END} - ${START}) / 1000")
+        if(BEST STREQUAL "" OR ELAPSED LESS BEST)
+            set(BEST ${ELAPSED})
+        endif()
+    endforeach()
+
+    string(REPEAT " " 24 PAD)
+    string(SUBSTRING "${HEADER}${PAD}" 0 24 COLUMN)
+    string(LENGTH "${LINE_COUNT}" LEN)
+    math(EXPR LEN "7 - ${LEN}")
+    string(SUBSTRING "${PAD}" 0 ${LEN} LINE_PAD)
+    string(LENGTH "${BYTES}" LEN)
+    math(EXPR LEN "11 - ${LEN}")
+    string(SUBSTRING "${PAD}" 0 ${LEN} BYTE_PAD)
+    string(LENGTH "${BEST}" LEN)
+    math(EXPR LEN "12 - ${LEN}")
+    string(SUBSTRING "${PAD}" 0 ${LEN} TIME_PAD)
+    message("${COLUMN}${LINE_PAD}${LINE_COUNT}${BYTE_PAD}${BYTES}${TIME_PAD}${BEST}")
+endforeach()
@@ -0,0 +1,52 @@
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cstdint>
+
+#include "latency_histogram.h"
+
+namespace {
+
+wwa::utils::latency_histogram shared_histogram;
+
+void BM_SteadyClockNow(benchmark::State& state)
+{
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(std::chrono::steady_clock::now());
+    }
+}
+
+void BM_LatencyHistogramRecord(benchmark::State& state)
+{
+    std::uint64_t value = 1;
+    for (auto _ : state) {
+        shared_histogram.record(value & 0xF'FFFF);
+        value = value * 6364136223846793005U + 1442695040888963407U;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_LatencyScope(benchmark::State& state)
+{
+    for (auto _ : state) {
+        const wwa::utils::latency_scope timer(shared_histogram);
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_LatencySnapshot(benchmark::State& state)
+{
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(shared_histogram.snapshot());
+    }
+}
+
+}  // namespace
+
+BENCHMARK(BM_SteadyClockNow);
+BENCHMARK(BM_LatencyHistogramRecord)->ThreadRange(1, 8);
+BENCHMARK(BM_LatencyScope)->ThreadRange(1, 8);
+BENCHMARK(BM_LatencySnapshot);
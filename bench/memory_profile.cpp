@@ -0,0 +1,36 @@
+#include <benchmark/benchmark.h>
+
+#include <functional>
+
+#include "memory_profile.h"
+
+namespace {
+
+void BM_MemorySampleNow(benchmark::State& state)
+{
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(wwa::utils::memory_sample::now());
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_MemoryScope(benchmark::State& state)
+{
+    wwa::utils::memory_profile_aggregator aggregator;
+    wwa::utils::memory_profiler profiler(
+        std::ref(aggregator), {.sample_every = static_cast<std::uint32_t>(state.range(0))}
+    );
+
+    for (auto _ : state) {
+        const wwa::utils::memory_scope scope(profiler, "bench");
+        benchmark::DoNotOptimize(&scope);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+BENCHMARK(BM_MemorySampleNow);
+BENCHMARK(BM_MemoryScope)->Arg(1)->Arg(16)->Arg(1024)->Arg(0);
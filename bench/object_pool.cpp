@@ -0,0 +1,105 @@
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "object_pool.h"
+
+namespace {
+
+/**
+ * An expensive object: a large buffer, as used by a compression context.
+ */
+struct context {
+    std::array<std::byte, 65536> buffer{};
+};
+
+void use(context& c)
+{
+    c.buffer[0] = std::byte{1};
+    benchmark::DoNotOptimize(c.buffer.data());
+}
+
+/**
+ * A pool protected by a mutex, for comparison.
+ */
+class locked_pool {
+public:
+    std::unique_ptr<context> acquire()
+    {
+        const std::lock_guard lock(this->m_mutex);
+        if (this->m_free.empty()) {
+            return std::make_unique<context>();
+        }
+
+        auto c = std::move(this->m_free.back());
+        this->m_free.pop_back();
+        return c;
+    }
+
+    void release(std::unique_ptr<context> c)
+    {
+        const std::lock_guard lock(this->m_mutex);
+        this->m_free.push_back(std::move(c));
+    }
+
+private:
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<context>> m_free;
+};
+
+wwa::utils::object_pool<context> pool(256);
+locked_pool locked;
+
+void BM_ObjectPool(benchmark::State& state)
+{
+    for (auto _ : state) {
+        auto c = pool.acquire();
+        use(*c);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_ObjectPoolTwoLeases(benchmark::State& state)
+{
+    for (auto _ : state) {
+        auto a = pool.acquire();
+        auto b = pool.acquire();
+        use(*a);
+        use(*b);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_LockedPool(benchmark::State& state)
+{
+    for (auto _ : state) {
+        auto c = locked.acquire();
+        use(*c);
+        locked.release(std::move(c));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_MakeUnique(benchmark::State& state)
+{
+    for (auto _ : state) {
+        auto c = std::make_unique<context>();
+        use(*c);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+BENCHMARK(BM_ObjectPool)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(BM_ObjectPoolTwoLeases)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(BM_LockedPool)->ThreadRange(1, 16)->UseRealTime();
+BENCHMARK(BM_MakeUnique)->ThreadRange(1, 16)->UseRealTime();
@@ -0,0 +1,119 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+
+#include <sys/mman.h>
+
+#include "page_snapshot.h"
+
+namespace {
+
+constexpr std::size_t region_size = std::size_t{64} << 20;
+
+class region_fixture {
+public:
+    region_fixture()
+    {
+        void* map = ::mmap(nullptr, region_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (map == MAP_FAILED) {  // NOLINT(*-cstyle-cast,performance-no-int-to-ptr)
+            wwa::utils::detail::throw_errno("mmap");
+        }
+
+        this->m_map = static_cast<std::byte*>(map);
+        std::memset(this->m_map, 1, region_size);
+    }
+
+    region_fixture(const region_fixture&)            = delete;
+    region_fixture(region_fixture&&)                 = delete;
+    region_fixture& operator=(const region_fixture&) = delete;
+    region_fixture& operator=(region_fixture&&)      = delete;
+
+    ~region_fixture() { ::munmap(this->m_map, region_size); }
+
+    [[nodiscard]] std::span<std::byte> region() const { return {this->m_map, region_size}; }
+
+    /**
+     * Writes one byte to each of @a count pages spread evenly over the region.
+     */
+    void touch(std::size_t count, std::byte value) const
+    {
+        const std::size_t stride = region_size / count;
+        for (std::size_t offset = 0; offset < region_size; offset += stride) {
+            this->m_map[offset] = value;
+        }
+    }
+
+private:
+    std::byte* m_map = nullptr;
+};
+
+void BM_PageSnapshotRollback(benchmark::State& state)
+{
+    const auto count = static_cast<std::size_t>(state.range(0));
+    const region_fixture f;
+    for (auto _ : state) {
+        wwa::utils::page_snapshot snapshot(f.region());
+        f.touch(count, std::byte{2});
+        snapshot.rollback();
+    }
+
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * region_size));
+}
+
+void BM_PageSnapshotCommit(benchmark::State& state)
+{
+    const auto count = static_cast<std::size_t>(state.range(0));
+    const region_fixture f;
+    for (auto _ : state) {
+        const wwa::utils::page_snapshot snapshot(f.region());
+        f.touch(count, std::byte{2});
+    }
+
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * region_size));
+}
+
+void BM_MemcpySnapshotRollback(benchmark::State& state)
+{
+    const auto count = static_cast<std::size_t>(state.range(0));
+    const region_fixture f;
+    auto copy = std::make_unique_for_overwrite<std::byte[]>(region_size);
+    for (auto _ : state) {
+        std::memcpy(copy.get(), f.region().data(), region_size);
+        f.touch(count, std::byte{2});
+        std::memcpy(f.region().data(), copy.get(), region_size);
+        benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * region_size));
+}
+
+void BM_MemcpySnapshotCommit(benchmark::State& state)
+{
+    const auto count = static_cast<std::size_t>(state.range(0));
+    const region_fixture f;
+    auto copy = std::make_unique_for_overwrite<std::byte[]>(region_size);
+    for (auto _ : state) {
+        std::memcpy(copy.get(), f.region().data(), region_size);
+        benchmark::ClobberMemory();
+        f.touch(count, std::byte{2});
+    }
+
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * region_size));
+}
+
+// Number of modified pages: sparse (1, 16, 256) and dense (every page of the 64 MiB region with 4 KiB pages)
+void touched_pages(benchmark::internal::Benchmark* b)
+{
+    b->Arg(1)->Arg(16)->Arg(256)->Arg(region_size / 4096);
+}
+
+}  // namespace
+
+BENCHMARK(BM_PageSnapshotRollback)->Apply(touched_pages);
+BENCHMARK(BM_MemcpySnapshotRollback)->Apply(touched_pages);
+BENCHMARK(BM_PageSnapshotCommit)->Apply(touched_pages);
+BENCHMARK(BM_MemcpySnapshotCommit)->Apply(touched_pages);
@@ -0,0 +1,33 @@
+#include <benchmark/benchmark.h>
+
+#include "perf_counters.h"
+
+namespace {
+
+void BM_PerfCountersRead(benchmark::State& state)
+{
+    const auto& counters = wwa::utils::perf_counters::this_thread();
+    if (!counters.available()) {
+        state.SetLabel("unavailable");
+    }
+    else {
+        state.SetLabel(counters.uses_rdpmc() ? "rdpmc" : "read()");
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(counters.read());
+    }
+}
+
+void BM_PerfScope(benchmark::State& state)
+{
+    wwa::utils::perf_profile profile;
+    for (auto _ : state) {
+        const wwa::utils::perf_scope scope(profile, "empty");
+    }
+}
+
+}  // namespace
+
+BENCHMARK(BM_PerfCountersRead);
+BENCHMARK(BM_PerfScope);
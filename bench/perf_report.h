@@ -0,0 +1,55 @@
+#ifndef C99600AC_001E_4E77_9C5D_1E791FFE6F79
+#define C99600AC_001E_4E77_9C5D_1E791FFE6F79
+
+#include <benchmark/benchmark.h>
+
+#if defined(__linux__)
+#    include "perf_counters.h"
+#endif
+
+/**
+ * Reports hardware performance counters per iteration of a benchmark loop (`instructions/iter`, `cycles/iter`,
+ * `branch_misses/iter`). Construct it right before the loop; the counters are reported when it is destroyed.
+ * Does nothing if the counters are not available.
+ */
+class perf_report {
+public:
+    explicit perf_report(benchmark::State& state) : m_state(state)
+    {
+#if defined(__linux__)
+        this->m_begin = wwa::utils::perf_counters::this_thread().read();
+#endif
+    }
+
+    perf_report(const perf_report&)            = delete;
+    perf_report(perf_report&&)                 = delete;
+    perf_report& operator=(const perf_report&) = delete;
+    perf_report& operator=(perf_report&&)      = delete;
+
+    ~perf_report()
+    {
+#if defined(__linux__)
+        const auto& counters = wwa::utils::perf_counters::this_thread();
+        if (counters.available()) {
+            const auto delta = counters.read() - this->m_begin;
+            this->set("instructions/iter", delta.instructions);
+            this->set("cycles/iter", delta.cycles);
+            this->set("branch_misses/iter", delta.branch_misses);
+        }
+#endif
+    }
+
+private:
+    benchmark::State& m_state;
+#if defined(__linux__)
+    wwa::utils::perf_values m_begin;
+#endif
+
+    void set(const char* name, std::uint64_t value)
+    {
+        this->m_state.counters[name] =
+            benchmark::Counter(static_cast<double>(value), benchmark::Counter::kAvgIterations);
+    }
+};
+
+#endif /* C99600AC_001E_4E77_9C5D_1E791FFE6F79 */
@@ -0,0 +1,90 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "redo_log.h"
+
+namespace {
+
+void BM_RedoLogCommit(benchmark::State& state)
+{
+    const auto writes = static_cast<std::size_t>(state.range(0));
+    std::vector<std::uint64_t> values(writes);
+    wwa::utils::redo_log log;
+    std::uint64_t n = 0;
+    for (auto _ : state) {
+        auto tx = log.begin();
+        ++n;
+        for (auto& value : values) {
+            log.write(value, n);
+        }
+    }
+
+    benchmark::DoNotOptimize(values.data());
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_RedoLogDiscard(benchmark::State& state)
+{
+    const auto writes = static_cast<std::size_t>(state.range(0));
+    std::vector<std::uint64_t> values(writes);
+    wwa::utils::redo_log log;
+    std::uint64_t n = 0;
+    for (auto _ : state) {
+        ++n;
+        for (auto& value : values) {
+            log.write(value, n);
+        }
+
+        log.discard();
+    }
+
+    benchmark::DoNotOptimize(values.data());
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_RedoLogReadOwnWrites(benchmark::State& state)
+{
+    const auto writes = static_cast<std::size_t>(state.range(0));
+    std::vector<std::uint64_t> values(writes);
+    wwa::utils::redo_log log;
+    for (auto& value : values) {
+        log.write(value, std::uint64_t{1});
+    }
+
+    for (auto _ : state) {
+        std::uint64_t sum = 0;
+        for (const auto& value : values) {
+            sum += log.read(value);
+        }
+
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+void BM_DirectWrite(benchmark::State& state)
+{
+    const auto writes = static_cast<std::size_t>(state.range(0));
+    std::vector<std::uint64_t> values(writes);
+    std::uint64_t n = 0;
+    for (auto _ : state) {
+        ++n;
+        for (auto& value : values) {
+            value = n;
+        }
+
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+}  // namespace
+
+BENCHMARK(BM_RedoLogCommit)->Arg(4)->Arg(16)->Arg(1024)->Arg(65536);
+BENCHMARK(BM_RedoLogDiscard)->Arg(4)->Arg(16)->Arg(1024)->Arg(65536);
+BENCHMARK(BM_RedoLogReadOwnWrites)->Arg(4)->Arg(16)->Arg(1024)->Arg(65536);
+BENCHMARK(BM_DirectWrite)->Arg(4)->Arg(16)->Arg(1024)->Arg(65536);
@@ -0,0 +1,96 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <string>
+
+#include "perf_report.h"
+#include "restore_guard.h"
+#include "scope_action.h"
+
+namespace {
+
+struct counters {
+    std::uint64_t hits;
+    std::uint64_t misses;
+    std::uint64_t evictions;
+    std::uint32_t generation;
+};
+
+struct state {
+    counters stats{};
+    std::uint64_t cursor = 0;
+    std::string name     = "a name which does not fit into the small string buffer";
+};
+
+void mutate(state& s, std::uint64_t n)
+{
+    s.stats.hits += n;
+    s.stats.generation = static_cast<std::uint32_t>(n);
+    s.cursor           = n;
+    s.name.back()      = static_cast<char>('a' + n % 26);
+}
+
+void BM_ExitRestoreTrivial(benchmark::State& bench)
+{
+    state s;
+    std::uint64_t n = 0;
+    const perf_report report(bench);
+    for (auto _ : bench) {
+        wwa::utils::exit_restore restore(s.stats, s.cursor);
+        mutate(s, ++n);
+        benchmark::DoNotOptimize(s);
+    }
+}
+
+void BM_HandWrittenTrivial(benchmark::State& bench)
+{
+    state s;
+    std::uint64_t n = 0;
+    const perf_report report(bench);
+    for (auto _ : bench) {
+        auto saved_stats  = s.stats;
+        auto saved_cursor = s.cursor;
+        wwa::utils::exit_action restore([&s, &saved_stats, &saved_cursor]() {
+            s.stats  = saved_stats;
+            s.cursor = saved_cursor;
+        });
+        mutate(s, ++n);
+        benchmark::DoNotOptimize(s);
+    }
+}
+
+void BM_ExitRestoreString(benchmark::State& bench)
+{
+    state s;
+    std::uint64_t n = 0;
+    const perf_report report(bench);
+    for (auto _ : bench) {
+        wwa::utils::exit_restore restore(s.stats, s.name);
+        mutate(s, ++n);
+        benchmark::DoNotOptimize(s);
+    }
+}
+
+void BM_HandWrittenString(benchmark::State& bench)
+{
+    state s;
+    std::uint64_t n = 0;
+    const perf_report report(bench);
+    for (auto _ : bench) {
+        auto saved_stats = s.stats;
+        auto saved_name  = s.name;
+        wwa::utils::exit_action restore([&s, &saved_stats, &saved_name]() {
+            s.stats = saved_stats;
+            s.name  = saved_name;
+        });
+        mutate(s, ++n);
+        benchmark::DoNotOptimize(s);
+    }
+}
+
+}  // namespace
+
+BENCHMARK(BM_ExitRestoreTrivial);
+BENCHMARK(BM_HandWrittenTrivial);
+BENCHMARK(BM_ExitRestoreString);
+BENCHMARK(BM_HandWrittenString);
@@ -0,0 +1,96 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "ring_buffer.h"
+
+namespace {
+
+constexpr std::size_t message_size = 64;
+constexpr std::size_t capacity     = 4096;
+constexpr std::int64_t messages    = 1 << 18;
+
+template<wwa::utils::producer_model Producers>
+void run(benchmark::State& state)
+{
+    const auto producers    = static_cast<int>(state.range(0));
+    const auto per_producer = messages / producers;
+
+    for (auto _ : state) {
+        wwa::utils::ring_buffer<message_size, Producers> ring(capacity);
+
+        std::vector<std::thread> threads;
+        threads.reserve(static_cast<std::size_t>(producers));
+        for (int p = 0; p < producers; ++p) {
+            threads.emplace_back([&ring, per_producer]() {
+                for (std::int64_t i = 0; i < per_producer; ++i) {
+                    auto slot = ring.reserve();
+                    std::memcpy(slot.data().data(), &i, sizeof(i));
+                    slot.resize(sizeof(i));
+                }
+            });
+        }
+
+        std::int64_t consumed = 0;
+        std::int64_t sum      = 0;
+        while (consumed < per_producer * producers) {
+            if (ring.try_consume([&sum](std::span<const std::byte> record) {
+                    std::int64_t value = 0;
+                    std::memcpy(&value, record.data(), sizeof(value));
+                    sum += value;
+                }))
+            {
+                ++consumed;
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.SetItemsProcessed(state.iterations() * (messages / producers) * producers);
+}
+
+void BM_RingBufferSPSC(benchmark::State& state)
+{
+    run<wwa::utils::producer_model::single>(state);
+}
+
+void BM_RingBufferMPSC(benchmark::State& state)
+{
+    run<wwa::utils::producer_model::multiple>(state);
+}
+
+void BM_RingBufferReserveConsume(benchmark::State& state)
+{
+    wwa::utils::ring_buffer<message_size, wwa::utils::producer_model::single> ring(capacity);
+    std::int64_t i = 0;
+    for (auto _ : state) {
+        {
+            auto slot = ring.reserve();
+            std::memcpy(slot.data().data(), &i, sizeof(i));
+        }
+
+        ring.try_consume([](std::span<const std::byte> record) { benchmark::DoNotOptimize(record.data()); });
+        ++i;
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+BENCHMARK(BM_RingBufferReserveConsume);
+BENCHMARK(BM_RingBufferSPSC)->Arg(1)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_RingBufferMPSC)->RangeMultiplier(2)->Range(1, 8)->UseRealTime()->Unit(benchmark::kMillisecond);
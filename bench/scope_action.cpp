@@ -0,0 +1,77 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <stdexcept>
+
+#include "perf_report.h"
+#include "scope_action.h"
+
+namespace {
+
+void BM_ExitAction(benchmark::State& state)
+{
+    std::uint64_t n = 0;
+    const perf_report report(state);
+    for (auto _ : state) {
+        const wwa::utils::exit_action guard([&n]() { ++n; });
+        benchmark::DoNotOptimize(n);
+    }
+}
+
+void BM_ExitActionReleased(benchmark::State& state)
+{
+    std::uint64_t n = 0;
+    const perf_report report(state);
+    for (auto _ : state) {
+        wwa::utils::exit_action guard([&n]() { ++n; });
+        benchmark::DoNotOptimize(n);
+        guard.release();
+    }
+}
+
+void BM_FailAction(benchmark::State& state)
+{
+    std::uint64_t n = 0;
+    const perf_report report(state);
+    for (auto _ : state) {
+        const wwa::utils::fail_action guard([&n]() { ++n; });
+        benchmark::DoNotOptimize(n);
+    }
+}
+
+void BM_SuccessAction(benchmark::State& state)
+{
+    std::uint64_t n = 0;
+    const perf_report report(state);
+    for (auto _ : state) {
+        const wwa::utils::success_action guard([&n]() { ++n; });
+        benchmark::DoNotOptimize(n);
+    }
+}
+
+[[gnu::noinline]] void throw_through(std::uint64_t& n)
+{
+    const wwa::utils::fail_action guard([&n]() { ++n; });
+    throw std::runtime_error("error");
+}
+
+void BM_FailActionUnwinding(benchmark::State& state)
+{
+    std::uint64_t n = 0;
+    const perf_report report(state);
+    for (auto _ : state) {
+        try {
+            throw_through(n);
+        }
+        catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+        }
+    }
+}
+
+}  // namespace
+
+BENCHMARK(BM_ExitAction);
+BENCHMARK(BM_ExitActionReleased);
+BENCHMARK(BM_FailAction);
+BENCHMARK(BM_SuccessAction);
+BENCHMARK(BM_FailActionUnwinding);
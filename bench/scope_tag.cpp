@@ -0,0 +1,45 @@
+#include <benchmark/benchmark.h>
+
+#include "scope_tag.h"
+
+namespace {
+
+void BM_ScopeTag(benchmark::State& state)
+{
+    for (auto _ : state) {
+        const wwa::utils::scope_tag tag("tag");
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_ScopeTagNested(benchmark::State& state)
+{
+    for (auto _ : state) {
+        const wwa::utils::scope_tag outer("outer");
+        const wwa::utils::scope_tag inner("inner");
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_ScopeTagSampled(benchmark::State& state)
+{
+    wwa::utils::tag_sampler sampler({.interval = std::chrono::microseconds(state.range(0))});
+    for (auto _ : state) {
+        const wwa::utils::scope_tag tag("tag");
+        benchmark::ClobberMemory();
+    }
+
+    sampler.stop();
+    state.counters["samples"] = static_cast<double>(sampler.samples());
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+BENCHMARK(BM_ScopeTag);
+BENCHMARK(BM_ScopeTagNested);
+BENCHMARK(BM_ScopeTagSampled)->Arg(1000)->Arg(100);
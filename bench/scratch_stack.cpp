@@ -0,0 +1,86 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include "scratch_stack.h"
+
+namespace {
+
+constexpr std::size_t alignment = 64;
+constexpr std::size_t page_size = 4096;
+
+/**
+ * Writes to every page of the buffer, as a kernel using it would.
+ */
+void touch(void* p, std::size_t size)
+{
+    auto* b = static_cast<unsigned char*>(p);
+    for (std::size_t i = 0; i < size; i += page_size) {
+        b[i] = 1;
+    }
+
+    benchmark::DoNotOptimize(b);
+    benchmark::ClobberMemory();
+}
+
+void BM_ScratchScope(benchmark::State& state)
+{
+    const auto size = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state) {
+        wwa::utils::scratch_scope scratch;
+        touch(scratch.allocate(size, alignment), size);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_ScratchScopeNested(benchmark::State& state)
+{
+    // Four buffers of a quarter of the size each, as a pipeline of kernels would use
+    const auto size = static_cast<std::size_t>(state.range(0)) / 4;
+    for (auto _ : state) {
+        wwa::utils::scratch_scope outer;
+        touch(outer.allocate(size, alignment), size);
+        touch(outer.allocate(size, alignment), size);
+        {
+            wwa::utils::scratch_scope inner;
+            touch(inner.allocate(size, alignment), size);
+            touch(inner.allocate(size, alignment), size);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_AlignedNew(benchmark::State& state)
+{
+    const auto size = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state) {
+        void* p = ::operator new(size, std::align_val_t{alignment});
+        touch(p, size);
+        ::operator delete(p, size, std::align_val_t{alignment});
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_Malloc(benchmark::State& state)
+{
+    const auto size = static_cast<std::size_t>(state.range(0));
+    for (auto _ : state) {
+        void* p = std::malloc(size);  // NOLINT(*-no-malloc)
+        touch(p, size);
+        std::free(p);  // NOLINT(*-no-malloc)
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+BENCHMARK(BM_ScratchScope)->RangeMultiplier(16)->Range(64, 1 << 20);
+BENCHMARK(BM_ScratchScopeNested)->RangeMultiplier(16)->Range(64, 1 << 20);
+BENCHMARK(BM_AlignedNew)->RangeMultiplier(16)->Range(64, 1 << 20);
+BENCHMARK(BM_Malloc)->RangeMultiplier(16)->Range(64, 1 << 20);
@@ -0,0 +1,77 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+
+#include "seqlock.h"
+
+namespace {
+
+struct routing_weights {
+    std::uint64_t weights[4];
+};
+
+wwa::utils::seqlock<routing_weights> g_seqlock;  // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+std::shared_mutex g_mutex;                       // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+routing_weights g_value{};                       // NOLINT(cppcoreguidelines-avoid-non-const-global-variables)
+
+constexpr int write_interval = 1024;
+
+void BM_SeqlockRead(benchmark::State& state)
+{
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(g_seqlock.load());
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_SeqlockReadWithWriter(benchmark::State& state)
+{
+    std::uint64_t n = 0;
+    for (auto _ : state) {
+        if (state.thread_index() == 0 && ++n % write_interval == 0) {
+            g_seqlock.store({{n, n, n, n}});
+        }
+        else {
+            benchmark::DoNotOptimize(g_seqlock.load());
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_SharedMutexRead(benchmark::State& state)
+{
+    for (auto _ : state) {
+        const std::shared_lock lock(g_mutex);
+        benchmark::DoNotOptimize(g_value);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_SharedMutexReadWithWriter(benchmark::State& state)
+{
+    std::uint64_t n = 0;
+    for (auto _ : state) {
+        if (state.thread_index() == 0 && ++n % write_interval == 0) {
+            const std::unique_lock lock(g_mutex);
+            g_value = {{n, n, n, n}};
+        }
+        else {
+            const std::shared_lock lock(g_mutex);
+            benchmark::DoNotOptimize(g_value);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+BENCHMARK(BM_SeqlockRead)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK(BM_SeqlockReadWithWriter)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK(BM_SharedMutexRead)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK(BM_SharedMutexReadWithWriter)->ThreadRange(1, 64)->UseRealTime();
@@ -0,0 +1,67 @@
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <string>
+
+#include <unistd.h>
+
+#include "trace_zone.h"
+
+namespace {
+
+std::string trace_path()
+{
+    return (std::filesystem::temp_directory_path() / ("bench_trace_" + std::to_string(::getpid()) + ".json")).string();
+}
+
+void BM_TraceTicks(benchmark::State& state)
+{
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(wwa::utils::detail::trace_ticks());
+    }
+}
+
+void BM_MonotonicRaw(benchmark::State& state)
+{
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(wwa::utils::detail::monotonic_raw_ns());
+    }
+}
+
+void BM_TraceZoneInactive(benchmark::State& state)
+{
+    for (auto _ : state) {
+        const wwa::utils::trace_zone zone("zone");
+        benchmark::DoNotOptimize(&zone);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_TraceZone(benchmark::State& state)
+{
+    const auto path = trace_path();
+    {
+        wwa::utils::trace_session session(
+            path, {.buffer_events = std::size_t{1} << 20, .flush_interval = std::chrono::milliseconds(1)}
+        );
+        wwa::utils::trace_session::register_thread();
+
+        for (auto _ : state) {
+            const wwa::utils::trace_zone zone("zone");
+            benchmark::DoNotOptimize(&zone);
+        }
+
+        state.counters["dropped"] = static_cast<double>(session.dropped());
+    }
+
+    std::filesystem::remove(path);
+    state.SetItemsProcessed(state.iterations());
+}
+
+}  // namespace
+
+BENCHMARK(BM_TraceTicks);
+BENCHMARK(BM_MonotonicRaw);
+BENCHMARK(BM_TraceZoneInactive);
+BENCHMARK(BM_TraceZone);
@@ -0,0 +1,113 @@
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "undo_journal.h"
+
+namespace {
+
+constexpr std::size_t region_size = 1 << 20;
+
+class fixture {
+public:
+    fixture()
+        : m_dir(std::filesystem::temp_directory_path() / ("wwa-undo-journal-bench-" + std::to_string(::getpid())))
+    {
+        std::filesystem::create_directories(this->m_dir);
+        this->m_fd = ::open((this->m_dir / "data").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);  // NOLINT(*-vararg)
+        if (this->m_fd == -1 || ::ftruncate(this->m_fd, region_size) == -1) {
+            wwa::utils::detail::throw_errno("open");
+        }
+
+        void* map = ::mmap(nullptr, region_size, PROT_READ | PROT_WRITE, MAP_SHARED, this->m_fd, 0);
+        if (map == MAP_FAILED) {  // NOLINT(*-cstyle-cast,performance-no-int-to-ptr)
+            wwa::utils::detail::throw_errno("mmap");
+        }
+
+        this->m_map = static_cast<std::uint64_t*>(map);
+    }
+
+    fixture(const fixture&)            = delete;
+    fixture(fixture&&)                 = delete;
+    fixture& operator=(const fixture&) = delete;
+    fixture& operator=(fixture&&)      = delete;
+
+    ~fixture()
+    {
+        ::munmap(this->m_map, region_size);
+        ::close(this->m_fd);
+        std::filesystem::remove_all(this->m_dir);
+    }
+
+    [[nodiscard]] std::span<std::byte> region() const
+    {
+        return {reinterpret_cast<std::byte*>(this->m_map), region_size};
+    }
+
+    [[nodiscard]] std::uint64_t* words() const { return this->m_map; }
+    [[nodiscard]] std::filesystem::path journal() const { return this->m_dir / "journal"; }
+
+private:
+    std::filesystem::path m_dir;
+    int m_fd             = -1;
+    std::uint64_t* m_map = nullptr;
+};
+
+void run(benchmark::State& state, wwa::utils::undo_journal::sync_mode mode, bool fail)
+{
+    const auto records = static_cast<std::size_t>(state.range(0));
+    const fixture f;
+    wwa::utils::undo_journal journal(f.journal(), f.region(), wwa::utils::undo_journal::default_capacity, mode);
+    std::uint64_t* words = f.words();
+
+    std::uint64_t n = 0;
+    for (auto _ : state) {
+        ++n;
+        for (std::size_t i = 0; i < records; ++i) {
+            // Spread the records over the region, one per 512 bytes
+            std::uint64_t& word = words[(i * 64) % (region_size / sizeof(std::uint64_t))];
+            journal.save(word);
+            word = n;
+        }
+
+        if (fail) {
+            journal.rollback();
+        }
+        else {
+            journal.commit();
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.counters["tx_per_second"] =
+        benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+}
+
+void BM_UndoJournalCommit(benchmark::State& state)
+{
+    run(state, wwa::utils::undo_journal::sync_mode::commit, false);
+}
+
+void BM_UndoJournalRollback(benchmark::State& state)
+{
+    run(state, wwa::utils::undo_journal::sync_mode::commit, true);
+}
+
+void BM_UndoJournalCommitSyncRecords(benchmark::State& state)
+{
+    run(state, wwa::utils::undo_journal::sync_mode::record, false);
+}
+
+}  // namespace
+
+BENCHMARK(BM_UndoJournalCommit)->Arg(1)->Arg(16)->Arg(256);
+BENCHMARK(BM_UndoJournalRollback)->Arg(1)->Arg(16)->Arg(256);
+BENCHMARK(BM_UndoJournalCommitSyncRecords)->Arg(1)->Arg(16);
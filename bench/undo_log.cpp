@@ -0,0 +1,89 @@
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstdint>
+#include <utility>
+
+#include "undo_log.h"
+
+namespace {
+
+struct record {
+    std::array<std::uint64_t, 64> fields;
+};
+
+struct state {
+    record a{};
+    record b{};
+    record c{};
+};
+
+void mutate(state& s, std::uint64_t n)
+{
+    s.a.fields[1] = n;
+    s.b.fields[7] = n;
+    s.c.fields[3] = n;
+    s.c.fields[9] = n;
+}
+
+void BM_UndoLogCommit(benchmark::State& bench)
+{
+    state s;
+    wwa::utils::undo_log log;
+    std::uint64_t n = 0;
+    for (auto _ : bench) {
+        auto tx = log.begin();
+        log.save(s.a.fields[1], s.b.fields[7], s.c.fields[3], s.c.fields[9]);
+        mutate(s, ++n);
+    }
+
+    benchmark::DoNotOptimize(s);
+}
+
+void BM_UndoLogRollback(benchmark::State& bench)
+{
+    state s;
+    wwa::utils::undo_log log;
+    std::uint64_t n = 0;
+    for (auto _ : bench) {
+        auto tx = log.begin();
+        log.save(s.a.fields[1], s.b.fields[7], s.c.fields[3], s.c.fields[9]);
+        mutate(s, ++n);
+        tx.rollback();
+    }
+
+    benchmark::DoNotOptimize(s);
+}
+
+void BM_CopyAndSwapCommit(benchmark::State& bench)
+{
+    state s;
+    std::uint64_t n = 0;
+    for (auto _ : bench) {
+        state copy = s;
+        mutate(copy, ++n);
+        std::swap(s, copy);
+    }
+
+    benchmark::DoNotOptimize(s);
+}
+
+void BM_CopyAndSwapRollback(benchmark::State& bench)
+{
+    state s;
+    std::uint64_t n = 0;
+    for (auto _ : bench) {
+        state copy = s;
+        mutate(copy, ++n);
+        benchmark::DoNotOptimize(copy);
+    }
+
+    benchmark::DoNotOptimize(s);
+}
+
+}  // namespace
+
+BENCHMARK(BM_UndoLogCommit);
+BENCHMARK(BM_UndoLogRollback);
+BENCHMARK(BM_CopyAndSwapCommit);
+BENCHMARK(BM_CopyAndSwapRollback);
@@ -10,7 +10,7 @@ endif()
 find_program(CLANG_FORMAT NAMES clang-format)
 find_program(CLANG_TIDY NAMES clang-tidy)
 
-file(GLOB_RECURSE CPP_FILES "${CMAKE_SOURCE_DIR}/src/*.cpp" "${CMAKE_SOURCE_DIR}/test/*.cpp")
+file(GLOB_RECURSE CPP_FILES "${CMAKE_SOURCE_DIR}/src/*.cpp" "${CMAKE_SOURCE_DIR}/test/*.cpp" "${CMAKE_SOURCE_DIR}/bench/*.cpp")
 file(GLOB_RECURSE H_FILES "${CMAKE_SOURCE_DIR}/src/*.h" "${CMAKE_SOURCE_DIR}/test/*.h")
 
 if(CLANG_FORMAT)
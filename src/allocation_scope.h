@@ -0,0 +1,524 @@
+#ifndef E72A6098_C83B_49D2_9F4C_2BF6BBDA32F8
+#define E72A6098_C83B_49D2_9F4C_2BF6BBDA32F8
+
+/**
+ * @file
+ * @brief Scopes that count heap allocations made by the current thread.
+ *
+ * This file provides `allocation_scope`, which reports how many heap allocations and deallocations the current thread
+ * has made, and how many bytes it has requested, since the scope was entered. It is meant for tests that prove that
+ * hot paths never touch the heap.
+ *
+ * The counts come from replacements of the global allocation functions. They are defined in the translation unit that
+ * defines `WWA_ALLOCATION_SCOPE_DEFINE_HOOKS` before including this header; exactly one translation unit of the program
+ * must do so. The replacements count every form of `operator new` and `operator delete`; on glibc, `malloc()`,
+ * `calloc()`, `realloc()`, `posix_memalign()`, `aligned_alloc()`, `memalign()`, `valloc()`, `pvalloc()`, and `free()`
+ * are counted too, except in sanitizer builds, whose runtimes own these functions. Without the hooks, all counts are zero; use `allocation_scope::hooks_installed()` to tell the difference.
+ *
+ * Counts are inclusive: allocations made inside a nested scope are counted by the enclosing scopes as well.
+ *
+ * Usage example:
+ * @code{.cpp}
+ * // In exactly one translation unit of the test program:
+ * #define WWA_ALLOCATION_SCOPE_DEFINE_HOOKS
+ * #include "allocation_scope.h"
+ *
+ * TEST(HotPath, DoesNotAllocate)
+ * {
+ *     wwa::utils::allocation_scope scope;
+ *     hot_path();
+ *     EXPECT_EQ(scope.stats().allocations, 0);
+ * }
+ * @endcode
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+#include "success_action.h"
+
+#if !defined(WWA_ALLOCATION_SCOPE_COUNTS_MALLOC)
+#    if defined(__has_feature)
+#        if __has_feature(address_sanitizer) || __has_feature(thread_sanitizer) || __has_feature(memory_sanitizer)
+#            define WWA_ALLOCATION_SCOPE_SANITIZED 1
+#        endif
+#    endif
+#    if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#        define WWA_ALLOCATION_SCOPE_SANITIZED 1
+#    endif
+#    if defined(__GLIBC__) && !defined(WWA_ALLOCATION_SCOPE_SANITIZED)
+#        define WWA_ALLOCATION_SCOPE_COUNTS_MALLOC 1
+#    else
+#        define WWA_ALLOCATION_SCOPE_COUNTS_MALLOC 0
+#    endif
+#endif
+
+namespace wwa::utils {
+
+/**
+ * @brief Heap activity of a thread.
+ */
+struct allocation_stats {
+    std::uint64_t allocations   = 0;  ///< Number of allocations, including reallocations.
+    std::uint64_t deallocations = 0;  ///< Number of deallocations of non-null pointers.
+    std::uint64_t bytes         = 0;  ///< Number of bytes requested.
+
+    /**
+     * @brief Returns the activity between two snapshots.
+     *
+     * @param other Earlier snapshot.
+     * @return Difference of the counters.
+     */
+    [[nodiscard]] constexpr allocation_stats operator-(const allocation_stats& other) const noexcept
+    {
+        return {
+            this->allocations - other.allocations, this->deallocations - other.deallocations, this->bytes - other.bytes
+        };
+    }
+
+    /**
+     * @brief Compares two snapshots.
+     */
+    constexpr bool operator==(const allocation_stats&) const noexcept = default;
+};
+
+/// @cond INTERNAL
+
+namespace detail {
+
+/**
+ * @brief Returns the counters of the calling thread.
+ *
+ * The counters are constant-initialized, so that accessing them from the allocation functions never allocates.
+ *
+ * @return Reference to the counters.
+ */
+inline allocation_stats& thread_allocation_stats() noexcept
+{
+    constinit static thread_local allocation_stats stats;
+    return stats;
+}
+
+/**
+ * @brief Returns the flag that is set by the translation unit that defines the hooks.
+ *
+ * @return Reference to the flag.
+ */
+inline bool& allocation_hooks_flag() noexcept
+{
+    static bool installed = false;
+    return installed;
+}
+
+inline void count_allocation(std::size_t bytes) noexcept
+{
+    auto& stats = thread_allocation_stats();
+    ++stats.allocations;
+    stats.bytes += bytes;
+}
+
+inline void count_deallocation(const void* p) noexcept
+{
+    if (p != nullptr) {
+        ++thread_allocation_stats().deallocations;
+    }
+}
+
+}  // namespace detail
+
+/// @endcond
+
+/**
+ * @brief A scope that counts the heap allocations of the current thread.
+ *
+ * Optionally, a reporter is called with the counts when the scope is exited.
+ *
+ * @note Constructing an `allocation_scope` of dynamic storage duration might lead to unexpected behavior.
+ */
+class [[nodiscard("The object must be used to count allocations in the scope.")]] allocation_scope {
+    /// @cond INTERNAL
+    struct report_fn {
+        allocation_scope* scope;
+        void operator()() const
+        {
+            if (this->scope->m_reporter) {
+                this->scope->m_reporter(this->scope->stats());
+            }
+        }
+    };
+    /// @endcond
+
+public:
+    /// @brief Function called with the counts of the scope on scope exit.
+    using reporter_type = std::function<void(const allocation_stats&)>;
+
+    /**
+     * @brief Starts counting.
+     *
+     * @param reporter Function to call with the counts on scope exit; optional. Exceptions thrown by the reporter
+     * propagate, unless the scope is exited via an exception, in which case the reporter is not called.
+     */
+    explicit allocation_scope(reporter_type reporter = {}) noexcept
+        : m_reporter(std::move(reporter)), m_start(detail::thread_allocation_stats()), m_on_exit(report_fn{this})
+    {}
+
+    /** @cond */
+    allocation_scope(const allocation_scope&)            = delete;
+    allocation_scope(allocation_scope&&)                 = delete;
+    allocation_scope& operator=(const allocation_scope&) = delete;
+    allocation_scope& operator=(allocation_scope&&)      = delete;
+    /** @endcond */
+
+    /**
+     * @brief Returns the heap activity of the current thread since the scope was entered.
+     *
+     * @return Counts.
+     */
+    [[nodiscard]] allocation_stats stats() const noexcept { return detail::thread_allocation_stats() - this->m_start; }
+
+    /**
+     * @brief Restarts counting from zero.
+     */
+    void reset() noexcept { this->m_start = detail::thread_allocation_stats(); }
+
+    /**
+     * @brief Checks whether the allocation functions of the program count allocations.
+     *
+     * @return Whether some translation unit defines `WWA_ALLOCATION_SCOPE_DEFINE_HOOKS`.
+     */
+    [[nodiscard]] static bool hooks_installed() noexcept { return detail::allocation_hooks_flag(); }
+
+    /**
+     * @brief Checks whether `malloc()` and related functions are counted in addition to `operator new`.
+     *
+     * @return Whether C allocation functions are counted.
+     */
+    [[nodiscard]] static constexpr bool counts_malloc() noexcept { return WWA_ALLOCATION_SCOPE_COUNTS_MALLOC != 0; }
+
+private:
+    reporter_type m_reporter;             ///< Reporter; may be empty.
+    allocation_stats m_start;             ///< Counters of the thread when counting started.
+    success_action<report_fn> m_on_exit;  ///< Calls the reporter on scope exit.
+};
+
+}  // namespace wwa::utils
+
+#if defined(WWA_ALLOCATION_SCOPE_DEFINE_HOOKS)
+
+#    include <algorithm>
+#    include <cerrno>
+#    include <cstdlib>
+#    include <new>
+
+#    if WWA_ALLOCATION_SCOPE_COUNTS_MALLOC
+extern "C" {
+void* __libc_malloc(std::size_t size);                           // NOLINT(bugprone-reserved-identifier)
+void* __libc_calloc(std::size_t count, std::size_t size);        // NOLINT(bugprone-reserved-identifier)
+void* __libc_realloc(void* p, std::size_t size);                 // NOLINT(bugprone-reserved-identifier)
+void* __libc_memalign(std::size_t alignment, std::size_t size);  // NOLINT(bugprone-reserved-identifier)
+void* __libc_valloc(std::size_t size);                           // NOLINT(bugprone-reserved-identifier)
+void* __libc_pvalloc(std::size_t size);                          // NOLINT(bugprone-reserved-identifier)
+void __libc_free(void* p);                                       // NOLINT(bugprone-reserved-identifier)
+}
+#    endif
+
+/// @cond INTERNAL
+
+namespace wwa::utils::detail::hooks {
+
+#    if WWA_ALLOCATION_SCOPE_COUNTS_MALLOC
+inline void* raw_malloc(std::size_t size) noexcept
+{
+    return __libc_malloc(size);
+}
+
+inline void raw_free(void* p) noexcept
+{
+    __libc_free(p);
+}
+#    else
+inline void* raw_malloc(std::size_t size) noexcept
+{
+    return std::malloc(size);  // NOLINT(*-no-malloc)
+}
+
+inline void raw_free(void* p) noexcept
+{
+    std::free(p);  // NOLINT(*-no-malloc)
+}
+#    endif
+
+inline void* raw_aligned_malloc(std::size_t size, std::size_t alignment) noexcept
+{
+#    if defined(_WIN32)
+    return ::_aligned_malloc(size, alignment);
+#    elif WWA_ALLOCATION_SCOPE_COUNTS_MALLOC
+    // posix_memalign() is replaced below and would count the allocation again
+    return __libc_memalign(std::max(alignment, sizeof(void*)), size);
+#    else
+    void* p = nullptr;
+    return ::posix_memalign(&p, std::max(alignment, sizeof(void*)), size) == 0 ? p : nullptr;
+#    endif
+}
+
+inline void raw_aligned_free(void* p) noexcept
+{
+#    if defined(_WIN32)
+    ::_aligned_free(p);
+#    else
+    raw_free(p);
+#    endif
+}
+
+inline void* allocate(std::size_t size) noexcept
+{
+    count_allocation(size);
+    return raw_malloc(size != 0 ? size : 1);
+}
+
+inline void* allocate(std::size_t size, std::align_val_t alignment) noexcept
+{
+    count_allocation(size);
+    return raw_aligned_malloc(size != 0 ? size : 1, static_cast<std::size_t>(alignment));
+}
+
+/**
+ * @brief Implements the throwing forms of `operator new`: calls the new handler until the allocation succeeds.
+ */
+template<typename... Alignment>
+void* allocate_or_throw(std::size_t size, Alignment... alignment)
+{
+    for (;;) {
+        if (void* p = allocate(size, alignment...); p != nullptr) {
+            return p;
+        }
+
+        std::new_handler handler = std::get_new_handler();
+        if (handler == nullptr) {
+            throw std::bad_alloc();
+        }
+
+        handler();
+    }
+}
+
+inline void deallocate(void* p) noexcept
+{
+    count_deallocation(p);
+    raw_free(p);
+}
+
+inline void deallocate(void* p, std::align_val_t /* alignment */) noexcept
+{
+    count_deallocation(p);
+    raw_aligned_free(p);
+}
+
+/// @brief Marks the hooks as installed during static initialization.
+inline const bool installed = (allocation_hooks_flag() = true);
+
+}  // namespace wwa::utils::detail::hooks
+
+/// @endcond
+
+// NOLINTBEGIN(cert-dcl54-cpp,misc-new-delete-overloads,hicpp-new-delete-operators)
+
+void* operator new(std::size_t size)
+{
+    return wwa::utils::detail::hooks::allocate_or_throw(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return wwa::utils::detail::hooks::allocate_or_throw(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    return wwa::utils::detail::hooks::allocate_or_throw(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return wwa::utils::detail::hooks::allocate_or_throw(size, alignment);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    try {
+        return wwa::utils::detail::hooks::allocate_or_throw(size);
+    }
+    catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    try {
+        return wwa::utils::detail::hooks::allocate_or_throw(size);
+    }
+    catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    try {
+        return wwa::utils::detail::hooks::allocate_or_throw(size, alignment);
+    }
+    catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    try {
+        return wwa::utils::detail::hooks::allocate_or_throw(size, alignment);
+    }
+    catch (...) {
+        return nullptr;
+    }
+}
+
+void operator delete(void* p) noexcept
+{
+    wwa::utils::detail::hooks::deallocate(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    wwa::utils::detail::hooks::deallocate(p);
+}
+
+void operator delete(void* p, std::size_t /* size */) noexcept
+{
+    wwa::utils::detail::hooks::deallocate(p);
+}
+
+void operator delete[](void* p, std::size_t /* size */) noexcept
+{
+    wwa::utils::detail::hooks::deallocate(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+    wwa::utils::detail::hooks::deallocate(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+    wwa::utils::detail::hooks::deallocate(p);
+}
+
+void operator delete(void* p, std::align_val_t alignment) noexcept
+{
+    wwa::utils::detail::hooks::deallocate(p, alignment);
+}
+
+void operator delete[](void* p, std::align_val_t alignment) noexcept
+{
+    wwa::utils::detail::hooks::deallocate(p, alignment);
+}
+
+void operator delete(void* p, std::size_t /* size */, std::align_val_t alignment) noexcept
+{
+    wwa::utils::detail::hooks::deallocate(p, alignment);
+}
+
+void operator delete[](void* p, std::size_t /* size */, std::align_val_t alignment) noexcept
+{
+    wwa::utils::detail::hooks::deallocate(p, alignment);
+}
+
+void operator delete(void* p, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    wwa::utils::detail::hooks::deallocate(p, alignment);
+}
+
+void operator delete[](void* p, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    wwa::utils::detail::hooks::deallocate(p, alignment);
+}
+
+// NOLINTEND(cert-dcl54-cpp,misc-new-delete-overloads,hicpp-new-delete-operators)
+
+#    if WWA_ALLOCATION_SCOPE_COUNTS_MALLOC
+
+// NOLINTBEGIN(*-no-malloc,cert-dcl37-c,cert-dcl51-cpp,bugprone-reserved-identifier)
+
+extern "C" void* malloc(std::size_t size) noexcept
+{
+    wwa::utils::detail::count_allocation(size);
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(std::size_t count, std::size_t size) noexcept
+{
+    wwa::utils::detail::count_allocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* p, std::size_t size) noexcept
+{
+    wwa::utils::detail::count_allocation(size);
+    return __libc_realloc(p, size);
+}
+
+extern "C" int posix_memalign(void** memptr, std::size_t alignment, std::size_t size) noexcept
+{
+    if (alignment == 0 || alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+
+    wwa::utils::detail::count_allocation(size);
+    void* p = __libc_memalign(alignment, size);
+    if (p == nullptr) {
+        return ENOMEM;
+    }
+
+    *memptr = p;
+    return 0;
+}
+
+extern "C" void* aligned_alloc(std::size_t alignment, std::size_t size) noexcept
+{
+    wwa::utils::detail::count_allocation(size);
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" void* memalign(std::size_t alignment, std::size_t size) noexcept
+{
+    wwa::utils::detail::count_allocation(size);
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" void* valloc(std::size_t size) noexcept
+{
+    wwa::utils::detail::count_allocation(size);
+    return __libc_valloc(size);
+}
+
+extern "C" void* pvalloc(std::size_t size) noexcept
+{
+    wwa::utils::detail::count_allocation(size);
+    return __libc_pvalloc(size);
+}
+
+extern "C" void free(void* p) noexcept
+{
+    wwa::utils::detail::count_deallocation(p);
+    __libc_free(p);
+}
+
+// NOLINTEND(*-no-malloc,cert-dcl37-c,cert-dcl51-cpp,bugprone-reserved-identifier)
+
+#    endif
+
+#endif /* defined(WWA_ALLOCATION_SCOPE_DEFINE_HOOKS) */
+
+#endif /* E72A6098_C83B_49D2_9F4C_2BF6BBDA32F8 */
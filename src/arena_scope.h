@@ -0,0 +1,232 @@
+#ifndef A6CBD81D_3C6F_4DE1_806E_000B41C6221B
+#define A6CBD81D_3C6F_4DE1_806E_000B41C6221B
+
+/**
+ * @file
+ * @brief Scoped monotonic arenas.
+ *
+ * This file provides `arena_scope`, which owns a `std::pmr::monotonic_buffer_resource` and makes it the current arena
+ * of the calling thread for the lifetime of the scope. The arena is handed out explicitly, by `resource()` or
+ * `arena_scope::current()`, to the `std::pmr` containers that should allocate from it. When the scope is exited, the
+ * enclosing arena becomes current again and all memory of the arena is released at once, without running
+ * `deallocate()` for individual allocations.
+ *
+ * The arena starts with an optional caller-provided buffer (typically on the stack) and then allocates geometrically
+ * growing chunks; chunks of 2 MiB and above are aligned to 2 MiB and, where supported, backed by transparent huge
+ * pages.
+ *
+ * `arena_scope` does not change the default memory resource: `std::pmr::set_default_resource()` is process-wide, and
+ * containers constructed with the default resource (possibly outside the scope) would otherwise get storage that
+ * does not outlive the scope.
+ *
+ * Usage example:
+ * @code{.cpp}
+ * void handle(const request& req)
+ * {
+ *     std::array<std::byte, 16384> buffer;
+ *     wwa::utils::arena_scope arena(buffer);
+ *     std::pmr::vector<std::pmr::string> headers = parse_headers(req, arena.resource());  // From `buffer`, then chunks
+ *     respond(req, headers);
+ * }  // All memory is released here
+ * @endcode
+ *
+ * @note Memory allocated from an arena must not outlive the scope.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <span>
+#include <vector>
+
+#if __has_include(<sys/mman.h>)
+#    include <sys/mman.h>
+#endif
+
+#include "exit_action.h"
+
+namespace wwa::utils {
+
+/// @cond INTERNAL
+
+namespace detail {
+
+/**
+ * @brief Upstream resource of an arena: allocates chunks and remembers them.
+ */
+class chunk_resource final : public std::pmr::memory_resource {
+public:
+    /// @brief Minimum size of a chunk backed by huge pages.
+    static constexpr std::size_t huge_page_size = std::size_t{2} << 20;
+
+    /// @brief Size of the first chunk of an arena without an initial buffer.
+    static constexpr std::size_t initial_chunk_size = 4096;
+
+    chunk_resource() = default;
+
+    chunk_resource(const chunk_resource&)            = delete;
+    chunk_resource(chunk_resource&&)                 = delete;
+    chunk_resource& operator=(const chunk_resource&) = delete;
+    chunk_resource& operator=(chunk_resource&&)      = delete;
+
+    ~chunk_resource() override
+    {
+        for (const chunk& c : this->m_chunks) {
+            ::operator delete(c.address, c.size, std::align_val_t{c.alignment});
+        }
+    }
+
+private:
+    struct chunk {
+        void* address;          ///< Start of the chunk.
+        std::size_t size;       ///< Size of the chunk.
+        std::size_t alignment;  ///< Alignment the chunk was allocated with.
+    };
+
+    std::vector<chunk> m_chunks;  ///< Allocated chunks.
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        if (bytes >= huge_page_size) {
+            alignment = std::max(alignment, huge_page_size);
+            bytes     = (bytes + huge_page_size - 1) & ~(huge_page_size - 1);
+        }
+
+        alignment = std::max<std::size_t>(alignment, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+        this->m_chunks.reserve(this->m_chunks.size() + 1);
+        void* p = ::operator new(bytes, std::align_val_t{alignment});
+#if defined(MADV_HUGEPAGE)
+        if (bytes >= huge_page_size) {
+            ::madvise(p, bytes, MADV_HUGEPAGE);
+        }
+#endif
+
+        this->m_chunks.push_back({p, bytes, alignment});
+        return p;
+    }
+
+    void do_deallocate(void* p, std::size_t /* bytes */, std::size_t /* alignment */) override
+    {
+        // Called by monotonic_buffer_resource::release() for every chunk
+        auto it = std::ranges::find(this->m_chunks, p, &chunk::address);
+        if (it != this->m_chunks.end()) {
+            ::operator delete(it->address, it->size, std::align_val_t{it->alignment});
+            this->m_chunks.erase(it);
+        }
+    }
+
+    [[nodiscard]] bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+}  // namespace detail
+
+/// @endcond
+
+/**
+ * @brief A scope that makes a monotonic arena the current arena of the calling thread.
+ *
+ * Scopes nest: an inner scope has its own arena and releases it independently of the outer one. Scopes
+ * must be destroyed in the reverse order of construction, which automatic storage duration guarantees.
+ *
+ * @note Constructing an `arena_scope` of dynamic storage duration might lead to unexpected behavior.
+ */
+class [[nodiscard("The object must be used to release the arena on scope exit.")]] arena_scope {
+    /// @cond INTERNAL
+    struct restore_fn {
+        arena_scope* scope;
+        void operator()() const noexcept { current_scope() = this->scope->m_outer; }
+    };
+    /// @endcond
+
+public:
+    /**
+     * @brief Creates an arena and makes it the current arena of the calling thread.
+     *
+     * @param buffer Initial buffer of the arena; may be empty.
+     */
+    explicit arena_scope(std::span<std::byte> buffer = {})
+        : m_arena(make_arena(buffer, &this->m_chunks)), m_outer(current_scope()), m_restore(restore_fn{this})
+    {
+        current_scope() = this;
+    }
+
+    /** @cond */
+    arena_scope(const arena_scope&)            = delete;
+    arena_scope(arena_scope&&)                 = delete;
+    arena_scope& operator=(const arena_scope&) = delete;
+    arena_scope& operator=(arena_scope&&)      = delete;
+    ~arena_scope() noexcept                    = default;
+    /** @endcond */
+
+    /**
+     * @brief Returns the arena.
+     *
+     * Pass the arena to the `std::pmr` containers that should allocate from it.
+     *
+     * @return The arena resource.
+     */
+    [[nodiscard]] std::pmr::memory_resource* resource() noexcept { return &this->m_arena; }
+
+    /**
+     * @brief Returns the innermost active arena of the current thread.
+     *
+     * @return Arena resource, or `nullptr` if the thread has no active `arena_scope`.
+     */
+    [[nodiscard]] static std::pmr::memory_resource* current() noexcept
+    {
+        arena_scope* scope = current_scope();
+        return scope != nullptr ? &scope->m_arena : nullptr;
+    }
+
+    /**
+     * @brief Releases all memory allocated from the arena so far; the scope remains active.
+     *
+     * All objects allocated from the arena must have been destroyed or abandoned.
+     */
+    void reset() noexcept { this->m_arena.release(); }
+
+private:
+    detail::chunk_resource m_chunks;              ///< Upstream resource of the arena.
+    std::pmr::monotonic_buffer_resource m_arena;  ///< The arena.
+    arena_scope* m_outer;                         ///< Enclosing scope of the same thread.
+    exit_action<restore_fn> m_restore;            ///< Restores the enclosing scope on exit.
+
+    /**
+     * @brief Returns the innermost active scope of the current thread.
+     *
+     * @return Reference to the thread-local pointer to the scope.
+     */
+    static arena_scope*& current_scope() noexcept
+    {
+        static thread_local arena_scope* scope = nullptr;
+        return scope;
+    }
+
+    /**
+     * @brief Creates the arena resource.
+     *
+     * Without an initial buffer, the first chunk is `initial_chunk_size` bytes rather than the size derived from the
+     * (empty) buffer, so that small allocations do not each end up in a separate tiny chunk.
+     *
+     * @param buffer Initial buffer.
+     * @param upstream Upstream resource.
+     * @return The arena resource.
+     */
+    static std::pmr::monotonic_buffer_resource
+    make_arena(std::span<std::byte> buffer, std::pmr::memory_resource* upstream) noexcept
+    {
+        if (buffer.empty()) {
+            return std::pmr::monotonic_buffer_resource(detail::chunk_resource::initial_chunk_size, upstream);
+        }
+
+        return {buffer.data(), buffer.size(), upstream};
+    }
+};
+
+}  // namespace wwa::utils
+
+#endif /* A6CBD81D_3C6F_4DE1_806E_000B41C6221B */
@@ -0,0 +1,255 @@
+#ifndef DBC5C5A7_CA74_4504_9AE7_6E4965B1A95C
+#define DBC5C5A7_CA74_4504_9AE7_6E4965B1A95C
+
+/**
+ * @file
+ * @brief Exit functions made of a callable and bound arguments.
+ *
+ * `exit_action`, `fail_action`, and `success_action` can be constructed from a callable followed by its arguments,
+ * instead of a lambda:
+ * @code{.cpp}
+ * // exit_action<bound_call<int (*)(int), int>>
+ * wwa::utils::exit_action close_fd(::close, fd);
+ * // fail_action<bound_call<void (transaction::*)(), transaction*>>
+ * wwa::utils::fail_action rollback(&transaction::rollback, txn);
+ * @endcode
+ *
+ * Every lambda has a type of its own, so each lambda-based guard is a separate instantiation of the guard template.
+ * Guards built from the same callable type and argument types share one instantiation (and the code generated for
+ * it) across all call sites.
+ *
+ * The callable and the arguments are decay-copied into a `bound_call`, like `std::bind_front()` does, except that an
+ * object passed by reference after a pointer to member is stored as a pointer to it (so that `obj.close()` is called
+ * on `obj`, not on a copy). Pass `std::ref()` to bind other arguments by reference. Empty callables and arguments
+ * (such as stateless function objects) take no space: they are stored as base classes.
+ *
+ * The header does not include `<functional>`, `<memory>`, or `<tuple>`, so that the guards stay cheap to include.
+ */
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace wwa::utils {
+
+/// @cond INTERNAL
+
+namespace detail {
+
+/**
+ * @brief Storage of one bound value; empty non-final types are stored as a base class.
+ */
+template<std::size_t Index, typename T, bool = std::is_empty_v<T> && !std::is_final_v<T>>
+class bound_slot {
+public:
+    template<typename U>
+    explicit bound_slot(U&& value) noexcept(std::is_nothrow_constructible_v<T, U>) : m_value(std::forward<U>(value))
+    {}
+
+    T& get() noexcept { return this->m_value; }
+
+private:
+    T m_value;  ///< The value.
+};
+
+template<std::size_t Index, typename T>
+class bound_slot<Index, T, true> : private T {
+public:
+    template<typename U>
+    explicit bound_slot(U&& value) noexcept(std::is_nothrow_constructible_v<T, U>) : T(std::forward<U>(value))
+    {}
+
+    T& get() noexcept { return *this; }
+};
+
+template<typename Member>
+struct bound_member_class;
+
+template<typename Member, typename Class>
+struct bound_member_class<Member Class::*> {
+    using type = Class;
+};
+
+/**
+ * @brief Type stored for the first argument after a pointer to member: a pointer if an object of the class of the
+ * member (rather than a pointer, a smart pointer, or a `std::reference_wrapper`) was passed as an lvalue.
+ */
+template<typename Func, typename Arg>
+using bound_object_t = std::conditional_t<
+    std::is_lvalue_reference_v<Arg> &&
+        std::is_base_of_v<typename bound_member_class<std::decay_t<Func>>::type, std::remove_cvref_t<Arg>>,
+    std::remove_reference_t<Arg>*, std::decay_t<Arg>>;
+
+template<typename... Ts>
+struct bound_list {};
+
+template<typename Func, typename... Args>
+struct bound_types {
+    using type = bound_list<std::decay_t<Func>, std::decay_t<Args>...>;
+};
+
+template<typename Func, typename Object, typename... Args>
+requires(std::is_member_pointer_v<std::decay_t<Func>>)
+struct bound_types<Func, Object, Args...> {
+    using type = bound_list<std::decay_t<Func>, bound_object_t<Func, Object>, std::decay_t<Args>...>;
+};
+
+/**
+ * @brief The object a pointer to member of `Class` is applied to: `object` itself, the object a
+ * `std::reference_wrapper` refers to, or the object `object` points to.
+ */
+template<typename Class, typename Object>
+constexpr decltype(auto) bound_target(Object&& object) noexcept
+{
+    if constexpr (std::is_base_of_v<Class, std::remove_cvref_t<Object>>) {
+        return std::forward<Object>(object);
+    }
+    else if constexpr (requires { requires std::is_base_of_v<Class, std::remove_cvref_t<decltype(object.get())>>; }) {
+        return object.get();
+    }
+    else {
+        return *std::forward<Object>(object);
+    }
+}
+
+template<typename Member, typename Class, typename Object, typename... Args>
+constexpr void bound_invoke_member(Member Class::* member, Object&& object, Args&&... args)
+{
+    decltype(auto) target = bound_target<Class>(std::forward<Object>(object));
+    if constexpr (std::is_function_v<Member>) {
+        (std::forward<decltype(target)>(target).*member)(std::forward<Args>(args)...);
+    }
+    else {
+        static_cast<void>(std::forward<decltype(target)>(target).*member);
+    }
+}
+
+/**
+ * @brief Calls `fn` with `args` like `std::invoke()` does, discarding the result.
+ */
+template<typename F, typename... Args>
+constexpr void bound_invoke(F&& fn, Args&&... args) noexcept(std::is_nothrow_invocable_v<F, Args...>)
+{
+    if constexpr (std::is_member_pointer_v<std::remove_cvref_t<F>>) {
+        bound_invoke_member(fn, std::forward<Args>(args)...);
+    }
+    else {
+        std::forward<F>(fn)(std::forward<Args>(args)...);
+    }
+}
+
+/**
+ * @brief Whether storing `Arg` as `Stored` cannot throw.
+ */
+template<typename Stored, typename Arg>
+inline constexpr bool bound_nothrow = std::is_pointer_v<Stored> || std::is_nothrow_constructible_v<Stored, Arg>;
+
+/**
+ * @brief Passes a constructor argument to its slot: by address for objects bound to pointers to members, otherwise
+ * forwarded if `Move` is `true`, or as a const lvalue (to be copied) if it is `false`.
+ */
+template<typename Stored, bool Move, typename Arg>
+constexpr decltype(auto) bound_pass(Arg&& arg) noexcept
+{
+    if constexpr (std::is_pointer_v<Stored> && std::is_lvalue_reference_v<Arg> &&
+                  std::is_same_v<Stored, std::remove_reference_t<Arg>*>) {
+        return __builtin_addressof(arg);  // std::addressof() without <memory>
+    }
+    else if constexpr (Move) {
+        return std::forward<Arg>(arg);
+    }
+    else {
+        return std::as_const(arg);
+    }
+}
+
+template<typename Indices, typename Func, typename... Args>
+class bound_call_base;
+
+template<std::size_t... Indices, typename Func, typename... Args>
+class bound_call_base<std::index_sequence<Indices...>, Func, Args...>
+    : private bound_slot<0, Func>, private bound_slot<Indices + 1, Args>... {
+public:
+    template<typename F, typename... As>
+    requires(sizeof...(As) == sizeof...(Args))
+    bound_call_base(std::in_place_t, F&& fn, As&&... args) noexcept(
+        moves<F, As...> || (bound_nothrow<Func, const F&> && (bound_nothrow<Args, const As&> && ...))
+    )
+        : bound_slot<0, Func>(bound_pass<Func, moves<F, As...>>(std::forward<F>(fn))),
+          bound_slot<Indices + 1, Args>(bound_pass<Args, moves<F, As...>>(std::forward<As>(args)))...
+    {}
+
+    void operator()() noexcept(std::is_nothrow_invocable_v<Func&, Args&...>)
+    {
+        bound_invoke(bound_slot<0, Func>::get(), bound_slot<Indices + 1, Args>::get()...);
+    }
+
+private:
+    // The values are moved from only if nothing can throw; otherwise they are copied, so that the guard can call the
+    // exit function with them if the copy throws
+    template<typename F, typename... As>
+    static constexpr bool moves = bound_nothrow<Func, F> && (bound_nothrow<Args, As> && ...);
+};
+
+}  // namespace detail
+
+/// @endcond
+
+/**
+ * @brief A callable with bound arguments, used as the exit function of guards constructed from several arguments.
+ *
+ * `bound_call<Func, Args...>` calls `std::invoke(fn, args...)` with the stored callable and arguments.
+ *
+ * @tparam Func Callable type (decayed).
+ * @tparam Args Stored argument types.
+ */
+template<typename Func, typename... Args>
+class bound_call : private detail::bound_call_base<std::index_sequence_for<Args...>, Func, Args...> {
+    /// @cond INTERNAL
+    using base = detail::bound_call_base<std::index_sequence_for<Args...>, Func, Args...>;
+    /// @endcond
+
+public:
+    /**
+     * @brief Stores a callable and its arguments.
+     *
+     * @param fn Callable.
+     * @param args Arguments.
+     * @throw anything Any exception thrown by the copy or move constructors of the callable or the arguments.
+     */
+    template<typename F, typename... As>
+    requires(std::is_constructible_v<base, std::in_place_t, F, As...>)
+    explicit bound_call(std::in_place_t, F&& fn, As&&... args) noexcept(
+        std::is_nothrow_constructible_v<base, std::in_place_t, F, As...>
+    )
+        : base(std::in_place, std::forward<F>(fn), std::forward<As>(args)...)
+    {}
+
+    using base::operator();
+};
+
+/// @cond INTERNAL
+
+namespace detail {
+
+template<typename List>
+struct bound_call_from;
+
+template<typename... Ts>
+struct bound_call_from<bound_list<Ts...>> {
+    using type = bound_call<Ts...>;
+};
+
+/**
+ * @brief The `bound_call` type that stores `Func` and `Args`.
+ */
+template<typename Func, typename... Args>
+using bound_call_t = typename bound_call_from<typename bound_types<Func, Args...>::type>::type;
+
+}  // namespace detail
+
+/// @endcond
+
+}  // namespace wwa::utils
+
+#endif /* DBC5C5A7_CA74_4504_9AE7_6E4965B1A95C */
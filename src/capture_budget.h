@@ -0,0 +1,196 @@
+#ifndef BF729871_A637_40E9_8BDB_D1A6D81C77BF
+#define BF729871_A637_40E9_8BDB_D1A6D81C77BF
+
+/**
+ * @file
+ * @brief Size budget for the exit functions stored by the scope guards.
+ *
+ * A lambda that captures a large object by value copies it into the guard, that is, into the stack frame of the
+ * function that creates the guard, every time the function runs. To catch such lambdas at compile time, define
+ * `WWA_SCOPE_ACTION_MAX_CAPTURE_SIZE` to a byte budget: `exit_action`, `fail_action`, and `success_action` then reject
+ * exit functions that are larger than the budget or that are not nothrow move constructible, with a diagnostic that
+ * names the guard kind, for example:
+ * @code{.unparsed}
+ * error: static assertion failed: exit_action: the exit function is larger than WWA_SCOPE_ACTION_MAX_CAPTURE_SIZE bytes
+ * @endcode
+ * Exit functions stored by reference (such as functions passed as lvalues) are always accepted.
+ *
+ * To choose a budget, define `WWA_SCOPE_ACTION_CAPTURE_REPORT` to a non-zero value: every guard type used in the
+ * program then registers itself at startup, and `capture_report` lists the sizes of all of them.
+ *
+ * Usage example:
+ * @code{.cpp}
+ * // Compiled with -DWWA_SCOPE_ACTION_CAPTURE_REPORT=1
+ * int main()
+ * {
+ *     wwa::utils::capture_report::write(std::cerr);
+ * }
+ * @endcode
+ *
+ * @note Both macros default to 0 (no budget, no report). All translation units of a program should be compiled with
+ * the same value of `WWA_SCOPE_ACTION_CAPTURE_REPORT`.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <iomanip>
+#include <ostream>
+#include <source_location>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#ifndef WWA_SCOPE_ACTION_MAX_CAPTURE_SIZE
+#    define WWA_SCOPE_ACTION_MAX_CAPTURE_SIZE 0
+#endif
+
+#ifndef WWA_SCOPE_ACTION_CAPTURE_REPORT
+#    define WWA_SCOPE_ACTION_CAPTURE_REPORT 0
+#endif
+
+namespace wwa::utils {
+
+/**
+ * @brief A guard type used in the program.
+ */
+struct capture_report_entry {
+    std::string_view guard;             ///< Name of the guard type.
+    std::size_t function_size = 0;      ///< Size of the stored exit function.
+    std::size_t guard_size    = 0;      ///< Size of the guard.
+    bool nothrow_movable      = false;  ///< Whether the exit function is nothrow move constructible.
+};
+
+/// @cond INTERNAL
+
+namespace detail {
+
+template<typename Guard>
+struct capture_function;
+
+template<template<typename> class Guard, typename ExitFunc>
+struct capture_function<Guard<ExitFunc>> {
+    using type = ExitFunc;
+};
+
+struct capture_node {
+    const char* name = nullptr;    ///< Name of the function that names the guard type.
+    capture_report_entry entry;    ///< Sizes.
+    capture_node* next = nullptr;  ///< Next registered guard type.
+};
+
+inline std::atomic<capture_node*>& capture_nodes() noexcept
+{
+    static constinit std::atomic<capture_node*> head{nullptr};
+    return head;
+}
+
+template<typename Guard>
+constexpr const char* capture_guard_name() noexcept
+{
+    return std::source_location::current().function_name();
+}
+
+template<typename Guard>
+inline constinit capture_node capture_node_of{
+    .name  = capture_guard_name<Guard>(),
+    .entry = {
+        .guard           = {},
+        .function_size   = sizeof(typename capture_function<Guard>::type),
+        .guard_size      = sizeof(Guard),
+        .nothrow_movable = std::is_nothrow_move_constructible_v<typename capture_function<Guard>::type>,
+    },
+};
+
+inline bool capture_register(capture_node& node) noexcept
+{
+    node.next = capture_nodes().load(std::memory_order_relaxed);
+    while (!capture_nodes().compare_exchange_weak(
+        node.next, &node, std::memory_order_release, std::memory_order_relaxed
+    )) {
+    }
+
+    return true;
+}
+
+template<typename Guard>
+inline const bool capture_registered = capture_register(capture_node_of<Guard>);
+
+/**
+ * @brief Makes sure the guard type is registered at startup; generates no code.
+ */
+template<typename Guard>
+inline void capture_report_use(const Guard* /*guard*/) noexcept
+{
+    static_cast<void>(capture_registered<Guard>);
+}
+
+/**
+ * @brief Extracts the guard type from the name of `capture_guard_name<Guard>()`.
+ */
+inline std::string_view capture_guard_type(std::string_view function) noexcept
+{
+    // GCC: "... [with Guard = T]"; Clang: "... [Guard = T]"
+    constexpr std::string_view marker = "Guard = ";
+    const auto begin                  = function.find(marker);
+    const auto end                    = function.rfind(']');
+    if (begin == std::string_view::npos || end == std::string_view::npos || end < begin) {
+        return function;
+    }
+
+    return function.substr(begin + marker.size(), end - begin - marker.size());
+}
+
+}  // namespace detail
+
+/// @endcond
+
+/**
+ * @brief Lists the guard types used in the program and the sizes of their exit functions.
+ */
+class capture_report {
+public:
+    /// @brief Whether guard types are registered (`WWA_SCOPE_ACTION_CAPTURE_REPORT`).
+    static constexpr bool enabled = WWA_SCOPE_ACTION_CAPTURE_REPORT != 0;
+
+    /// @brief The budget enforced at compile time (`WWA_SCOPE_ACTION_MAX_CAPTURE_SIZE`); 0 if there is none.
+    static constexpr std::size_t budget = WWA_SCOPE_ACTION_MAX_CAPTURE_SIZE;
+
+    /**
+     * @brief Returns the registered guard types, largest exit function first.
+     */
+    [[nodiscard]] static std::vector<capture_report_entry> entries()
+    {
+        std::vector<capture_report_entry> result;
+        const detail::capture_node* node = detail::capture_nodes().load(std::memory_order_acquire);
+        for (; node != nullptr; node = node->next) {
+            result.push_back(node->entry);
+            result.back().guard = detail::capture_guard_type(node->name);
+        }
+
+        std::ranges::stable_sort(result, std::ranges::greater{}, &capture_report_entry::function_size);
+        return result;
+    }
+
+    /**
+     * @brief Writes the registered guard types as a text table, largest exit function first.
+     *
+     * @param os Output stream.
+     */
+    static void write(std::ostream& os)
+    {
+        if (!enabled) {
+            os << "# the capture report is disabled (WWA_SCOPE_ACTION_CAPTURE_REPORT)\n";
+        }
+
+        os << "function  guard  nothrow_move  guard type\n";
+        for (const capture_report_entry& e : entries()) {
+            os << std::setw(8) << e.function_size << "  " << std::setw(5) << e.guard_size << "  "
+               << std::setw(12) << (e.nothrow_movable ? "yes" : "no") << "  " << e.guard << '\n';
+        }
+    }
+};
+
+}  // namespace wwa::utils
+
+#endif /* BF729871_A637_40E9_8BDB_D1A6D81C77BF */
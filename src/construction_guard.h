@@ -0,0 +1,187 @@
+#ifndef D1A0D59E_CD35_497E_9086_76C8AB5A621F
+#define D1A0D59E_CD35_497E_9086_76C8AB5A621F
+
+/**
+ * @file
+ * @brief Exception-safe construction of a sequence of objects in uninitialized storage.
+ *
+ * This file provides `construction_guard`, which tracks the range of objects constructed so far in raw storage and
+ * destroys them in reverse order when the scope is exited via an exception. It replaces the usual `fail_action` with a
+ * hand-maintained counter: objects can be constructed one by one, or in batches with the standard
+ * `std::uninitialized_*` algorithms, which remain free to use `memcpy`/`memset` or vectorized loops. For trivially
+ * destructible types, the guard has nothing to do on failure and compiles to nothing.
+ *
+ * Usage example:
+ * @code{.cpp}
+ * T* data = std::allocator<T>().allocate(n + m);
+ * wwa::utils::construction_guard guard(data);
+ * guard.copy(src.begin(), src.end());  // If this throws, nothing is left constructed
+ * guard.value_construct(m);            // If this throws, the copies are destroyed
+ * this->m_end = guard.release();
+ * @endcode
+ */
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "fail_action.h"
+
+namespace wwa::utils {
+
+/**
+ * @brief A scope guard that destroys the objects constructed in uninitialized storage when the scope is exited via
+ * an exception.
+ *
+ * The objects are constructed contiguously starting at the address passed to the constructor. The guard does not own
+ * the storage; on success (or after `release()`), the constructed objects belong to the caller.
+ *
+ * @tparam T Object type.
+ * @note Constructing a `construction_guard` of dynamic storage duration might lead to unexpected behavior.
+ */
+template<typename T>
+requires(std::is_nothrow_destructible_v<T>)
+class [[nodiscard("The object must be used to destroy the constructed objects on failure.")]] construction_guard {
+    /// @cond INTERNAL
+    struct destroy_fn {
+        construction_guard* guard;
+        void operator()() const noexcept
+        {
+            const auto* g = this->guard;
+            std::destroy(std::make_reverse_iterator(g->m_last), std::make_reverse_iterator(g->m_first));
+        }
+    };
+
+    struct no_action {
+        explicit no_action(destroy_fn /* unused */) noexcept {}
+        void release() noexcept {}
+    };
+
+    using action_type = std::conditional_t<std::is_trivially_destructible_v<T>, no_action, fail_action<destroy_fn>>;
+    /// @endcond
+
+public:
+    /**
+     * @brief Starts constructing objects at @a first.
+     *
+     * @param first Start of the uninitialized storage.
+     */
+    explicit construction_guard(T* first) noexcept : m_first(first), m_last(first), m_on_fail(destroy_fn{this}) {}
+
+    /** @cond */
+    construction_guard(const construction_guard&)            = delete;
+    construction_guard(construction_guard&&)                 = delete;
+    construction_guard& operator=(const construction_guard&) = delete;
+    construction_guard& operator=(construction_guard&&)      = delete;
+    ~construction_guard() noexcept                           = default;
+    /** @endcond */
+
+    /**
+     * @brief Constructs one object from @a args after the already constructed ones.
+     *
+     * @param args Constructor arguments.
+     * @return Reference to the constructed object.
+     * @throw anything Any exception thrown by the constructor; the object is not constructed.
+     */
+    template<typename... Args>
+    T& emplace(Args&&... args)
+    {
+        T* p = std::construct_at(this->m_last, std::forward<Args>(args)...);
+        ++this->m_last;
+        return *p;
+    }
+
+    /**
+     * @brief Copy-constructs objects from the range [@a first, @a last), as `std::uninitialized_copy()` does.
+     *
+     * @param first Start of the source range.
+     * @param last End of the source range.
+     * @throw anything Any exception thrown by a copy constructor; the objects constructed by this call are destroyed.
+     */
+    template<std::input_iterator It>
+    void copy(It first, It last)
+    {
+        this->m_last = std::uninitialized_copy(first, last, this->m_last);
+    }
+
+    /**
+     * @brief Move-constructs objects from the range [@a first, @a last), as `std::uninitialized_move()` does.
+     *
+     * @param first Start of the source range.
+     * @param last End of the source range.
+     * @throw anything Any exception thrown by a move constructor; the objects constructed by this call are destroyed,
+     * and some of the source objects may have been moved from.
+     */
+    template<std::input_iterator It>
+    void move(It first, It last)
+    {
+        this->m_last = std::uninitialized_move(first, last, this->m_last);
+    }
+
+    /**
+     * @brief Value-initializes @a count objects, as `std::uninitialized_value_construct_n()` does.
+     *
+     * @param count Number of objects.
+     * @throw anything Any exception thrown by the constructor; the objects constructed by this call are destroyed.
+     */
+    void value_construct(std::size_t count)
+    {
+        this->m_last = std::uninitialized_value_construct_n(this->m_last, count);
+    }
+
+    /**
+     * @brief Constructs @a count copies of @a value, as `std::uninitialized_fill_n()` does.
+     *
+     * @param count Number of objects.
+     * @param value The value to copy.
+     * @throw anything Any exception thrown by the copy constructor; the objects constructed by this call are destroyed.
+     */
+    void fill(std::size_t count, const T& value)
+    {
+        this->m_last = std::uninitialized_fill_n(this->m_last, count, value);
+    }
+
+    /**
+     * @brief Returns the number of constructed objects.
+     *
+     * @return Number of objects constructed through the guard.
+     */
+    [[nodiscard]] std::size_t size() const noexcept { return static_cast<std::size_t>(this->m_last - this->m_first); }
+
+    /**
+     * @brief Returns the end of the constructed range.
+     *
+     * @return Pointer past the last constructed object.
+     */
+    [[nodiscard]] T* end() const noexcept { return this->m_last; }
+
+    /**
+     * @brief Makes the guard inactive: the constructed objects will not be destroyed on failure.
+     *
+     * @return Pointer past the last constructed object.
+     */
+    T* release() noexcept
+    {
+        this->m_on_fail.release();
+        return this->m_last;
+    }
+
+private:
+    T* m_first;                                   ///< Start of the constructed range.
+    T* m_last;                                    ///< End of the constructed range.
+    [[no_unique_address]] action_type m_on_fail;  ///< Destroys the constructed objects on failure.
+};
+
+/**
+ * @brief Deduction guide for @a construction_guard.
+ *
+ * @tparam T Object type.
+ */
+template<typename T>
+construction_guard(T*) -> construction_guard<T>;
+
+}  // namespace wwa::utils
+
+#endif /* D1A0D59E_CD35_497E_9086_76C8AB5A621F */
@@ -0,0 +1,411 @@
+#ifndef CDA21F98_D15C_4F2E_B4DD_8DE0365DABEF
+#define CDA21F98_D15C_4F2E_B4DD_8DE0365DABEF
+
+/**
+ * @file
+ * @brief Strong exception guarantee for batches of container mutations without copying the container.
+ *
+ * The usual way to make a batch of mutations all-or-nothing is copy-and-swap: copy the container, mutate the copy, and
+ * swap it in on success. This costs O(n) for every batch, however small. The guards in this file record just enough
+ * information to undo the batch instead:
+ *   - `append_guard` remembers the size of a sequence container (`std::vector`, `std::string`, `std::deque`) and
+ *     erases the appended elements on failure;
+ *   - `insert_guard` inserts into an associative container with unique keys (`std::unordered_map`, `std::map`, and
+ *     their set counterparts) on behalf of the caller, and erases the inserted elements on failure;
+ *   - `overwrite_guard` saves the old values of the elements of a random-access or associative container before they
+ *     are modified, and restores them on failure.
+ *
+ * All guards are built on `fail_action`: when the scope is exited normally, the changes are kept and the recorded
+ * information is discarded.
+ *
+ * Usage example:
+ * @code{.cpp}
+ * {
+ *     wwa::utils::append_guard g1(orders);
+ *     wwa::utils::insert_guard g2(orders_by_id);
+ *     for (const auto& order : batch) {
+ *         orders.push_back(order);
+ *         g2.emplace(order.id, orders.size() - 1);  // If this throws, both containers are restored
+ *     }
+ * }
+ * @endcode
+ */
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "fail_action.h"
+
+namespace wwa::utils {
+
+/// @cond INTERNAL
+
+namespace detail {
+
+/**
+ * @brief Addressing of the elements of a random-access container: by index.
+ */
+template<typename Container>
+struct element_traits {
+    using key_type   = typename Container::size_type;
+    using value_type = typename Container::value_type;
+};
+
+/**
+ * @brief Addressing of the elements of a map: by key.
+ */
+template<typename Container>
+requires requires { typename Container::mapped_type; }
+struct element_traits<Container> {
+    using key_type   = typename Container::key_type;
+    using value_type = typename Container::mapped_type;
+};
+
+}  // namespace detail
+
+/// @endcond
+
+/**
+ * @brief A scope guard that erases the elements appended to a sequence container when the scope is exited via an
+ * exception.
+ *
+ * Only appends are undone: the elements that existed when the guard was created must not be erased or modified
+ * (use `overwrite_guard` for the latter).
+ *
+ * @tparam Container Sequence container with random-access iterators, such as `std::vector` or `std::string`.
+ * @note Constructing an `append_guard` of dynamic storage duration might lead to unexpected behavior.
+ */
+template<typename Container>
+requires requires(Container& c, typename Container::size_type n) {
+    { c.size() } -> std::same_as<typename Container::size_type>;
+    c.erase(c.begin() + n, c.end());
+}
+class [[nodiscard("The object must be used to roll back on failure.")]] append_guard {
+    /// @cond INTERNAL
+    struct rollback_fn {
+        append_guard* guard;
+        void operator()() const noexcept { this->guard->rollback(); }
+    };
+    /// @endcond
+
+public:
+    /**
+     * @brief Remembers the size of @a container.
+     *
+     * @param container The container to protect.
+     */
+    explicit append_guard(Container& container) noexcept
+        : m_container(&container), m_size(container.size()), m_on_fail(rollback_fn{this})
+    {}
+
+    /** @cond */
+    append_guard(const append_guard&)            = delete;
+    append_guard(append_guard&&)                 = delete;
+    append_guard& operator=(const append_guard&) = delete;
+    append_guard& operator=(append_guard&&)      = delete;
+    ~append_guard() noexcept                     = default;
+    /** @endcond */
+
+    /**
+     * @brief Erases the elements appended since the guard was created or last committed.
+     *
+     * The guard remains active.
+     */
+    void rollback() noexcept
+    {
+        if (this->m_container->size() > this->m_size) {
+            this->m_container->erase(this->m_container->begin() + this->m_size, this->m_container->end());
+        }
+    }
+
+    /**
+     * @brief Keeps the appended elements: subsequent rollbacks truncate the container to its current size.
+     */
+    void commit() noexcept { this->m_size = this->m_container->size(); }
+
+private:
+    Container* m_container;                ///< The protected container.
+    typename Container::size_type m_size;  ///< Size to truncate the container to.
+    fail_action<rollback_fn> m_on_fail;    ///< Truncates the container on failure.
+};
+
+/**
+ * @brief A scope guard that inserts into an associative container and erases the inserted elements when the scope is
+ * exited via an exception.
+ *
+ * The guard remembers the address of the key of each inserted element; references to the elements of node-based
+ * containers remain valid on rehashing, so no keys are copied. Inserted elements must not be erased while the guard is
+ * active.
+ *
+ * @tparam Container Associative container with unique keys, such as `std::unordered_map` or `std::map`.
+ * @note Constructing an `insert_guard` of dynamic storage duration might lead to unexpected behavior.
+ */
+template<typename Container>
+requires requires(Container& c, typename Container::const_iterator it) {
+    typename Container::key_type;
+    c.find(std::declval<const typename Container::key_type&>());
+    c.erase(it);
+}
+class [[nodiscard("The object must be used to roll back on failure.")]] insert_guard {
+    /// @cond INTERNAL
+    struct rollback_fn {
+        insert_guard* guard;
+        void operator()() const noexcept { this->guard->rollback(); }
+    };
+    /// @endcond
+
+public:
+    /// @brief Key type of the container.
+    using key_type = typename Container::key_type;
+
+    /**
+     * @brief Creates a guard for @a container.
+     *
+     * @param container The container to protect.
+     */
+    explicit insert_guard(Container& container) noexcept : m_container(&container), m_on_fail(rollback_fn{this}) {}
+
+    /** @cond */
+    insert_guard(const insert_guard&)            = delete;
+    insert_guard(insert_guard&&)                 = delete;
+    insert_guard& operator=(const insert_guard&) = delete;
+    insert_guard& operator=(insert_guard&&)      = delete;
+    ~insert_guard() noexcept                     = default;
+    /** @endcond */
+
+    /**
+     * @brief Inserts an element constructed from @a args, as `Container::emplace()` does.
+     *
+     * @param args Constructor arguments.
+     * @return The result of `Container::emplace()`.
+     * @throw std::bad_alloc Memory allocation failed; the container is not modified.
+     */
+    template<typename... Args>
+    auto emplace(Args&&... args)
+    {
+        return this->track([&]() { return this->m_container->emplace(std::forward<Args>(args)...); });
+    }
+
+    /**
+     * @brief Inserts @a value, as `Container::insert()` does.
+     *
+     * @param value The value to insert.
+     * @return The result of `Container::insert()`.
+     * @throw std::bad_alloc Memory allocation failed; the container is not modified.
+     */
+    template<typename Value>
+    auto insert(Value&& value)
+    {
+        return this->track([&]() { return this->m_container->insert(std::forward<Value>(value)); });
+    }
+
+    /**
+     * @brief Inserts an element with the key @a key constructed from @a args if the key does not exist, as
+     * `Container::try_emplace()` does.
+     *
+     * @param key The key.
+     * @param args Constructor arguments of the mapped value.
+     * @return The result of `Container::try_emplace()`.
+     * @throw std::bad_alloc Memory allocation failed; the container is not modified.
+     */
+    template<typename Key, typename... Args>
+    auto try_emplace(Key&& key, Args&&... args)
+    {
+        return this->track([&]() {
+            return this->m_container->try_emplace(std::forward<Key>(key), std::forward<Args>(args)...);
+        });
+    }
+
+    /**
+     * @brief Returns the number of elements inserted through the guard since it was created or last committed.
+     *
+     * @return Number of inserted elements.
+     */
+    [[nodiscard]] std::size_t size() const noexcept { return this->m_keys.size(); }
+
+    /**
+     * @brief Erases the elements inserted since the guard was created or last committed, in reverse order.
+     *
+     * The guard remains active.
+     */
+    void rollback() noexcept
+    {
+        for (auto it = this->m_keys.rbegin(); it != this->m_keys.rend(); ++it) {
+            this->m_container->erase(this->m_container->find(**it));
+        }
+
+        this->m_keys.clear();
+    }
+
+    /**
+     * @brief Keeps the inserted elements: subsequent rollbacks only erase elements inserted after this call.
+     */
+    void commit() noexcept { this->m_keys.clear(); }
+
+private:
+    Container* m_container;               ///< The protected container.
+    std::vector<const key_type*> m_keys;  ///< Keys of the inserted elements, in insertion order.
+    fail_action<rollback_fn> m_on_fail;   ///< Erases the inserted elements on failure.
+
+    /**
+     * @brief Runs an insert operation and remembers the key of the inserted element.
+     *
+     * @param op Insert operation; returns a pair of an iterator and a flag.
+     * @return The result of @a op.
+     */
+    template<typename Op>
+    auto track(Op op)
+    {
+        // Make room first, so that remembering the key cannot fail after the element has been inserted
+        if (this->m_keys.size() == this->m_keys.capacity()) {
+            this->m_keys.reserve(std::max<std::size_t>(this->m_keys.size() * 2, 16));
+        }
+
+        auto result = op();
+        if (result.second) {
+            this->m_keys.push_back(std::addressof(key_of(*result.first)));
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief Returns the key of a container element.
+     *
+     * @param element Element of a map or a set.
+     * @return The key.
+     */
+    template<typename Element>
+    static const key_type& key_of(const Element& element) noexcept
+    {
+        if constexpr (requires { element.first; }) {
+            return element.first;
+        }
+        else {
+            return element;
+        }
+    }
+};
+
+/**
+ * @brief A scope guard that saves the old values of container elements before they are modified, and restores them
+ * when the scope is exited via an exception.
+ *
+ * Elements are addressed by index for random-access containers and by key for maps, so the saved values stay valid
+ * when a vector reallocates. Only the modified elements are saved (a sparse log); the element type must be
+ * nothrow move-assignable, so that restoring cannot fail.
+ *
+ * @tparam Container Random-access container (such as `std::vector`) or map (such as `std::unordered_map`).
+ * @note Constructing an `overwrite_guard` of dynamic storage duration might lead to unexpected behavior.
+ */
+template<typename Container>
+class [[nodiscard("The object must be used to roll back on failure.")]] overwrite_guard {
+    /// @cond INTERNAL
+    static constexpr bool is_map = requires { typename Container::mapped_type; };
+
+    struct rollback_fn {
+        overwrite_guard* guard;
+        void operator()() const noexcept { this->guard->rollback(); }
+    };
+    /// @endcond
+
+public:
+    /// @brief Element index (random-access containers) or key (maps).
+    using key_type = typename detail::element_traits<Container>::key_type;
+    /// @brief Type of the saved values.
+    using value_type = typename detail::element_traits<Container>::value_type;
+
+    static_assert(std::is_nothrow_move_assignable_v<value_type>, "Elements must be nothrow move-assignable");
+
+    /**
+     * @brief Creates a guard for @a container.
+     *
+     * @param container The container to protect.
+     */
+    explicit overwrite_guard(Container& container) noexcept : m_container(&container), m_on_fail(rollback_fn{this})
+    {}
+
+    /** @cond */
+    overwrite_guard(const overwrite_guard&)            = delete;
+    overwrite_guard(overwrite_guard&&)                 = delete;
+    overwrite_guard& operator=(const overwrite_guard&) = delete;
+    overwrite_guard& operator=(overwrite_guard&&)      = delete;
+    ~overwrite_guard() noexcept                        = default;
+    /** @endcond */
+
+    /**
+     * @brief Saves the value of the element at @a key and returns a reference to it for modification.
+     *
+     * @param key Index or key of an existing element.
+     * @return Reference to the element.
+     * @throw std::out_of_range There is no such element; nothing is saved.
+     * @throw std::bad_alloc Memory allocation failed; nothing is saved.
+     */
+    value_type& modify(const key_type& key)
+    {
+        value_type& element = this->m_container->at(key);
+        this->m_log.emplace_back(key, element);
+        return element;
+    }
+
+    /**
+     * @brief Saves the value of the element at @a key and assigns @a value to it.
+     *
+     * @param key Index or key of an existing element.
+     * @param value New value.
+     * @throw std::out_of_range There is no such element; nothing is saved.
+     * @throw std::bad_alloc Memory allocation failed; nothing is saved.
+     */
+    template<typename Value>
+    void set(const key_type& key, Value&& value)
+    {
+        this->modify(key) = std::forward<Value>(value);
+    }
+
+    /**
+     * @brief Returns the number of saved values.
+     *
+     * @return Number of saved values.
+     */
+    [[nodiscard]] std::size_t size() const noexcept { return this->m_log.size(); }
+
+    /**
+     * @brief Restores the saved values in reverse order and clears the log.
+     *
+     * Elements that no longer exist are skipped. The guard remains active.
+     */
+    void rollback() noexcept
+    {
+        for (auto it = this->m_log.rbegin(); it != this->m_log.rend(); ++it) {
+            if constexpr (is_map) {
+                if (auto pos = this->m_container->find(it->first); pos != this->m_container->end()) {
+                    pos->second = std::move(it->second);
+                }
+            }
+            else if (it->first < this->m_container->size()) {
+                (*this->m_container)[it->first] = std::move(it->second);
+            }
+        }
+
+        this->m_log.clear();
+    }
+
+    /**
+     * @brief Keeps the modifications: clears the log.
+     */
+    void commit() noexcept { this->m_log.clear(); }
+
+private:
+    Container* m_container;                              ///< The protected container.
+    std::vector<std::pair<key_type, value_type>> m_log;  ///< Saved values, in modification order.
+    fail_action<rollback_fn> m_on_fail;                  ///< Restores the saved values on failure.
+};
+
+}  // namespace wwa::utils
+
+#endif /* CDA21F98_D15C_4F2E_B4DD_8DE0365DABEF */
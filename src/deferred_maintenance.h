@@ -0,0 +1,263 @@
+#ifndef E49434E8_C7D3_4F3D_A7F9_7703DE8522E8
+#define E49434E8_C7D3_4F3D_A7F9_7703DE8522E8
+
+/**
+ * @file
+ * @brief Batched erases and inserts for vectors, applied in a single pass when a scope is exited.
+ *
+ * Erasing elements from a `std::vector` one at a time while iterating over it, or inserting elements into a sorted
+ * vector one at a time, costs O(n) per operation. This file provides `deferred_maintenance`, a scope that only records
+ * erase marks and pending inserts, and brings the container up to date when the scope is exited normally:
+ *   - marked elements are removed in one compaction pass (`std::remove_if()`);
+ *   - pending elements are appended; for a sorted vector, they are sorted and merged with the existing elements
+ *     (`std::inplace_merge()`); for a heap, the heap is rebuilt (`std::make_heap()`) or the new elements are pushed
+ *     one by one, whichever is cheaper.
+ *
+ * The container is not modified while the scope is active, so reads and iteration during the scope see a consistent
+ * view, and indices remain stable. When the scope is exited via an exception, the recorded changes are discarded.
+ *
+ * Usage example:
+ * @code{.cpp}
+ * {
+ *     wwa::utils::deferred_maintenance batch(timers, wwa::utils::container_order::heap, std::greater<>{});
+ *     for (std::size_t i = 0; i < timers.size(); ++i) {
+ *         if (timers[i].cancelled) {
+ *             batch.erase(i);
+ *         }
+ *         else if (timers[i].periodic) {
+ *             batch.insert(timers[i].next());
+ *         }
+ *     }
+ * }  // One compaction and one heap rebuild here
+ * @endcode
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "success_action.h"
+
+namespace wwa::utils {
+
+/**
+ * @brief Ordering invariant maintained by `deferred_maintenance`.
+ */
+enum class container_order : std::uint8_t {
+    unordered,  ///< No ordering: pending elements are appended.
+    sorted,     ///< The container is sorted by the comparator.
+    heap,       ///< The container is a heap with respect to the comparator (as with `std::make_heap()`).
+};
+
+/**
+ * @brief A scope that defers erases and inserts on a vector and applies them in a single pass on success.
+ *
+ * The container must not be modified directly while the scope is active. The changes are applied by the destructor,
+ * which propagates any exception thrown while applying them (see `apply()`).
+ *
+ * @tparam Container Contiguous sequence container, such as `std::vector`.
+ * @tparam Compare Comparator used for `container_order::sorted` and `container_order::heap`.
+ * @note Constructing a `deferred_maintenance` of dynamic storage duration might lead to unexpected behavior.
+ */
+template<std::ranges::contiguous_range Container, typename Compare = std::less<>>
+requires std::ranges::sized_range<Container>
+class [[nodiscard("The object must be used to apply the changes on success.")]] deferred_maintenance {
+    /// @cond INTERNAL
+    struct apply_fn {
+        deferred_maintenance* scope;
+        void operator()() const { this->scope->apply(); }
+    };
+    /// @endcond
+
+public:
+    /// @brief Element type.
+    using value_type = typename Container::value_type;
+
+    /**
+     * @brief Starts deferring changes to @a container.
+     *
+     * @param container The container.
+     * @param order Ordering invariant of the container, which must already hold.
+     * @param compare Comparator.
+     */
+    explicit deferred_maintenance(
+        Container& container, container_order order = container_order::unordered, Compare compare = Compare{}
+    )
+        : m_container(&container), m_order(order), m_compare(std::move(compare)), m_on_success(apply_fn{this})
+    {}
+
+    /** @cond */
+    deferred_maintenance(const deferred_maintenance&)            = delete;
+    deferred_maintenance(deferred_maintenance&&)                 = delete;
+    deferred_maintenance& operator=(const deferred_maintenance&) = delete;
+    deferred_maintenance& operator=(deferred_maintenance&&)      = delete;
+    /** @endcond */
+
+    /**
+     * @brief Marks the element at @a index for erasure. Marking an element twice has no effect.
+     *
+     * @param index Index of the element, as of the start of the scope.
+     * @throw std::out_of_range @a index is out of range.
+     * @throw std::bad_alloc Memory allocation failed.
+     */
+    void erase(std::size_t index)
+    {
+        if (index >= std::ranges::size(*this->m_container)) {
+            throw std::out_of_range("deferred_maintenance::erase: index out of range");
+        }
+
+        if (this->m_marks.empty()) {
+            this->m_marks.resize(std::ranges::size(*this->m_container));
+        }
+
+        this->m_erased += this->m_marks[index] ? 0 : 1;
+        this->m_marks[index] = true;
+    }
+
+    /**
+     * @brief Checks whether the element at @a index is marked for erasure.
+     *
+     * @param index Index of the element.
+     * @return Whether the element is marked.
+     */
+    [[nodiscard]] bool erased(std::size_t index) const noexcept
+    {
+        return index < this->m_marks.size() && this->m_marks[index];
+    }
+
+    /**
+     * @brief Records an element to be inserted.
+     *
+     * @param args Constructor arguments of the element.
+     * @throw anything Any exception thrown by the constructor or by memory allocation; nothing is recorded.
+     */
+    template<typename... Args>
+    void insert(Args&&... args)
+    {
+        this->m_pending.emplace_back(std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Returns the elements to be inserted.
+     *
+     * @return Pending elements, in the order they were recorded.
+     */
+    [[nodiscard]] std::span<const value_type> pending() const noexcept { return this->m_pending; }
+
+    /**
+     * @brief Returns the number of elements marked for erasure.
+     *
+     * @return Number of marked elements.
+     */
+    [[nodiscard]] std::size_t erase_count() const noexcept { return this->m_erased; }
+
+    /**
+     * @brief Applies the recorded changes now; the scope remains active.
+     *
+     * Removes the marked elements, then adds the pending elements while maintaining the ordering invariant.
+     *
+     * @throw anything Any exception thrown by the element operations, the comparator, or memory allocation. The
+     * container is left in a valid but unspecified state.
+     */
+    void apply()
+    {
+        auto& c              = *this->m_container;
+        const bool compacted = this->m_erased != 0;
+        if (compacted) {
+            const auto* base  = std::ranges::data(c);
+            const auto& marks = this->m_marks;
+            // remove_if() tests each element at its original position before anything is moved over it
+            auto first = std::remove_if(std::ranges::begin(c), std::ranges::end(c), [base, &marks](const auto& v) {
+                return marks[static_cast<std::size_t>(std::addressof(v) - base)];
+            });
+
+            c.erase(first, std::ranges::end(c));
+        }
+
+        this->m_marks.clear();
+        this->m_erased = 0;
+        if (!this->m_pending.empty() || (compacted && this->m_order == container_order::heap)) {
+            this->merge(compacted);
+        }
+    }
+
+    /**
+     * @brief Discards the recorded changes; the scope remains active.
+     */
+    void discard() noexcept
+    {
+        this->m_marks.clear();
+        this->m_pending.clear();
+        this->m_erased = 0;
+    }
+
+private:
+    Container* m_container;                   ///< The container.
+    container_order m_order;                  ///< Ordering invariant.
+    [[no_unique_address]] Compare m_compare;  ///< Comparator.
+    std::vector<bool> m_marks;                ///< Erase marks, by index; empty if nothing is marked.
+    std::size_t m_erased = 0;                 ///< Number of marked elements.
+    std::vector<value_type> m_pending;        ///< Elements to insert.
+    success_action<apply_fn> m_on_success;    ///< Applies the changes on success.
+
+    /**
+     * @brief Adds the pending elements to the container and restores the ordering invariant.
+     *
+     * @param compacted Whether elements have just been erased; erasing elements breaks the heap property.
+     */
+    void merge(bool compacted)
+    {
+        auto& c         = *this->m_container;
+        const auto size = std::ranges::size(c);
+        if (this->m_order == container_order::sorted) {
+            std::ranges::sort(this->m_pending, std::ref(this->m_compare));
+        }
+
+        c.insert(
+            std::ranges::end(c), std::make_move_iterator(this->m_pending.begin()),
+            std::make_move_iterator(this->m_pending.end())
+        );
+
+        const auto added = static_cast<double>(this->m_pending.size());
+        this->m_pending.clear();
+
+        auto first = std::ranges::begin(c);
+        auto mid   = first + static_cast<std::ptrdiff_t>(size);
+        auto last  = std::ranges::end(c);
+        switch (this->m_order) {
+            case container_order::sorted:
+                std::inplace_merge(first, mid, last, std::ref(this->m_compare));
+                break;
+
+            case container_order::heap:
+                // Pushing k elements costs O(k log n); rebuilding the heap costs O(n)
+                if (!compacted && added * std::log2(static_cast<double>(size) + added) < static_cast<double>(size)) {
+                    for (auto it = mid; it != last; ++it) {
+                        std::push_heap(first, it + 1, std::ref(this->m_compare));
+                    }
+                }
+                else {
+                    std::make_heap(first, last, std::ref(this->m_compare));
+                }
+
+                break;
+
+            case container_order::unordered:
+                break;
+        }
+    }
+};
+
+}  // namespace wwa::utils
+
+#endif /* E49434E8_C7D3_4F3D_A7F9_7703DE8522E8 */
@@ -0,0 +1,242 @@
+#ifndef A2B581AC_C33A_4C5A_9E11_E52DA815A582
+#define A2B581AC_C33A_4C5A_9E11_E52DA815A582
+
+/**
+ * @file
+ * @brief `exit_action`: a scope guard that calls its exit function when a scope is exited.
+ *
+ * scope_action.h includes this header along with the other scope guards.
+ */
+
+#include <type_traits>
+#include <utility>
+
+#include "scope_action_detail.h"
+
+namespace wwa::utils {
+
+/**
+ * @brief A scope guard that calls its exit function on destruction, when a scope is exited.
+ *
+ * An `exit_action` may be either active (i.e., it will calls its exit function on destruction),
+ * or inactive (it does nothing on destruction). An `exit_action` is active after construction from an exit function.
+ *
+ * An `exit_action` becomes inactive by calling `release()` or a move constructor. An inactive `exit_action`
+ * may also be obtained by initializing with another inactive `exit_action`. Once an `exit_action` is inactive,
+ * it cannot become active again.
+ *
+ * Usage example:
+ * @snippet{trimleft} scope_action.cpp Using exit_action: runs on scope exit (success or exception)
+ *
+ * @tparam ExitFunc Exit function type. Func is either a
+ * [Destructible](https://en.cppreference.com/w/cpp/named_req/Destructible)
+ * [FunctionObject](https://en.cppreference.com/w/cpp/named_req/FunctionObject) type, or an lvalue reference to a
+ * [FunctionObject](https://en.cppreference.com/w/cpp/named_req/FunctionObject) or function.
+ * @see https://en.cppreference.com/w/cpp/experimental/scope_exit
+ * @see https://github.com/microsoft/GSL/blob/main/docs/headers.md#user-content-H-util-final_action
+ * @note Constructing an `exit_action` of dynamic storage duration might lead to unexpected behavior.
+ * @note If the exit function stored in an `exit_action` object refers to a local variable of the function where it is
+ * defined (e.g., as a lambda capturing the variable by reference), and that variable is used as a return operand in
+ * that function, that variable might have already been returned when the `exit_action`'s destructor executes, calling
+ * the exit function. This can lead to surprising behavior.
+ */
+template<typename ExitFunc>
+class [[nodiscard("The object must be used to ensure the exit function is called on scope exit.")]] exit_action {
+public:
+    /**
+     * @brief Constructs a new @a exit_action from an exit function of type @a Func.
+     *
+     * Initializes the exit function with a function or function object `fn`. The constructed `exit_action` is active.
+     * If `Func` is not an lvalue reference type, and `std::is_nothrow_constructible_v<ExitFunc, Func>` is `true`, the
+     * stored exit function is initialized with `std::forward<Func>(fn)`; otherwise it is initialized with `fn`. If
+     * initialization of the stored exit function throws an exception, calls `fn()`.
+     *
+     * This overload participates in overload resolution only if:
+     *   - `std::is_same_v<std::remove_cvref_t<Func>, exit_action>` is `false`, and
+     *   - `std::is_constructible_v<ExitFunc, Func>` is `true`.
+     *
+     * @tparam Func Exit function type. Must be constructible from @a ExitFunc.
+     * @param fn Exit function.
+     * @throw anything Any exception thrown during the initialization of the stored exit function.
+     * @see https://en.cppreference.com/w/cpp/experimental/scope_exit/scope_exit
+     */
+    template<typename Func>
+    requires(detail::can_construct_from<exit_action, ExitFunc, Func>)
+    explicit exit_action(
+        Func&& fn
+    ) noexcept(std::is_nothrow_constructible_v<ExitFunc, Func> || std::is_nothrow_constructible_v<ExitFunc, Func&>)
+    try
+        : m_exit_function(
+              detail::conditional_forward(
+                  std::forward<Func>(fn),
+                  std::bool_constant<
+                      std::is_nothrow_constructible_v<ExitFunc, Func> && !std::is_lvalue_reference_v<Func>>()
+              )
+          )
+    {
+        WWA_SCOPE_PROBE(armed, scope_probe_kind::exit, this);
+    }
+    catch (...) {
+        fn();
+    }
+
+    /**
+     * @brief Constructs a new @a exit_action from an exit function of type @a Func.
+     *
+     * Initializes the exit function with a function or function object `fn`. The constructed `exit_action` is active.
+     * The stored exit function is initialized with `std::forward<Func>(fn)`.
+     *
+     * This overload participates in overload resolution only if:
+     *   - `std::is_same_v<std::remove_cvref_t<Func>, exit_action>` is `false`, and
+     *   - `std::is_lvalue_reference_v<Func>` is `false`, and
+     *   - `std::is_nothrow_constructible_v<ExitFunc, Func>` is `true`.
+     *
+     * @tparam Func Exit function type. Must be constructible from @a ExitFunc.
+     * @param fn Exit function.
+     * @see https://en.cppreference.com/w/cpp/experimental/scope_exit/scope_exit
+     */
+    template<typename Func>
+    requires(detail::can_move_construct_from_noexcept<exit_action, ExitFunc, Func>)
+    explicit exit_action(Func&& fn) noexcept : m_exit_function(std::forward<Func>(fn))
+    {
+        WWA_SCOPE_PROBE(armed, scope_probe_kind::exit, this);
+    }
+
+    /**
+     * @brief Constructs a new @a exit_action that calls @a fn with bound arguments @a args.
+     *
+     * The stored exit function is a `bound_call` that holds decayed copies of `fn` and `args` (see bound_call.h); a
+     * pointer to member function can be followed by the object, which is stored as a pointer to it. The constructed
+     * `exit_action` is active. Guards constructed from the same types of `fn` and `args` share one instantiation. If
+     * storing `fn` and `args` throws an exception, calls `std::invoke(fn, args...)`.
+     *
+     * This overload participates in overload resolution only if `ExitFunc` is a `bound_call` constructible from `fn`
+     * and `args`.
+     *
+     * @tparam Func Callable type.
+     * @tparam Args Argument types.
+     * @param fn Callable, such as a function or a pointer to member function.
+     * @param args Arguments of `fn`.
+     * @throw anything Any exception thrown during the initialization of the stored exit function.
+     */
+    template<typename Func, typename... Args>
+    requires(sizeof...(Args) > 0 && std::is_constructible_v<ExitFunc, std::in_place_t, Func, Args...>)
+    exit_action(Func&& fn, Args&&... args) noexcept(
+        std::is_nothrow_constructible_v<ExitFunc, std::in_place_t, Func, Args...>
+    )
+    try
+        : m_exit_function(std::in_place, std::forward<Func>(fn), std::forward<Args>(args)...)
+    {
+        WWA_SCOPE_PROBE(armed, scope_probe_kind::exit, this);
+    }
+    catch (...) {
+        detail::bound_invoke(fn, args...);
+    }
+
+    /**
+     * @brief Move constructor.
+     *
+     * Initializes the stored exit function with the one in `other`. The constructed `exit_action` is active
+     * if and only if `other` is active before the construction.
+     *
+     * If `std::is_nothrow_move_constructible_v<ExitFunc>` is true, initializes stored exit function (denoted by
+     * `exitfun`) with `std::forward<ExitFunc>(other.exitfun)`, otherwise initializes it with `other.exitfun`.
+     *
+     * After successful move construction, `other` becomes inactive.
+     *
+     * This overload participates in overload resolution only if:
+     *   - `std::is_nothrow_move_constructible_v<ExitFunc>` is `true`, or
+     *   - `std::is_copy_constructible_v<ExitFunc>` is `true`.
+     *
+     * @param other `exit_action` to move from.
+     * @throw anything Any exception thrown during the initialization of the stored exit function.
+     * @see https://en.cppreference.com/w/cpp/experimental/scope_exit/scope_exit
+     */
+    exit_action(
+        exit_action&& other
+    ) noexcept(std::is_nothrow_move_constructible_v<ExitFunc> || std::is_nothrow_copy_constructible_v<ExitFunc>)
+    requires(std::is_nothrow_move_constructible_v<ExitFunc> || std::is_copy_constructible_v<ExitFunc>)
+        : m_exit_function(
+              detail::conditional_forward(
+                  std::forward<ExitFunc>(other.m_exit_function),
+                  std::bool_constant<std::is_nothrow_move_constructible_v<ExitFunc>>()
+              )
+          ),
+          m_is_armed(other.m_is_armed)
+    {
+        other.release();
+        WWA_SCOPE_PROBE(armed, scope_probe_kind::exit, this);
+    }
+
+    /** @cond */
+    /** @brief @a exit_action is not @a CopyConstructible */
+    exit_action(const exit_action&)            = delete;
+    /** @brief @a exit_action is not @a CopyAssignable */
+    exit_action& operator=(const exit_action&) = delete;
+    /** @brief @a exit_action is not @a MoveAssignable */
+    exit_action& operator=(exit_action&&)      = delete;
+    /** @endcond */
+
+    /**
+     * @brief Calls the exit function if @a m_is_armed is active, then destroys the object.
+     * @see https://en.cppreference.com/w/cpp/experimental/scope_exit/%7Escope_exit
+     */
+    ~exit_action() noexcept
+    {
+        if (this->m_is_armed) {
+            WWA_SCOPE_PROBE(fired, scope_probe_kind::exit, this);
+            this->m_exit_function();
+        }
+
+        WWA_SCOPE_PROBE(exited, scope_probe_kind::exit, this);
+    }
+
+    /**
+     * @brief Makes the @a exit_action object inactive.
+     *
+     * Once an @a exit_action is inactive, it cannot become active again, and it will not call its exit function upon
+     * destruction.
+     *
+     * @see https://en.cppreference.com/w/cpp/experimental/scope_exit/release
+     */
+    void release() noexcept
+    {
+        WWA_SCOPE_PROBE(released, scope_probe_kind::exit, this);
+        this->m_is_armed = false;
+    }
+
+private:
+    static_assert(
+        detail::capture_within_budget<ExitFunc>,
+        "exit_action: the exit function is larger than WWA_SCOPE_ACTION_MAX_CAPTURE_SIZE bytes"
+    );
+    static_assert(
+        detail::capture_nothrow_movable<ExitFunc>,
+        "exit_action: the exit function must be nothrow move constructible (WWA_SCOPE_ACTION_MAX_CAPTURE_SIZE)"
+    );
+
+    ExitFunc m_exit_function;  ///< The stored exit function.
+    bool m_is_armed = true;    ///< Whether this `exit_action` is active.
+};
+
+/**
+ * @brief Deduction guide for @a exit_action.
+ *
+ * @tparam ExitFunc Exit function type.
+ */
+template<typename ExitFunc>
+exit_action(ExitFunc) -> exit_action<ExitFunc>;
+
+/**
+ * @brief Deduction guide for @a exit_action constructed from a callable and its arguments.
+ *
+ * @tparam Func Callable type.
+ * @tparam Args Argument types.
+ */
+template<typename Func, typename... Args>
+requires(sizeof...(Args) > 0)
+exit_action(Func&&, Args&&...) -> exit_action<detail::bound_call_t<Func, Args...>>;
+
+}  // namespace wwa::utils
+
+#endif /* A2B581AC_C33A_4C5A_9E11_E52DA815A582 */
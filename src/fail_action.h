@@ -0,0 +1,251 @@
+#ifndef BFD60A4A_97E3_4C1C_99AB_AF397CBC0523
+#define BFD60A4A_97E3_4C1C_99AB_AF397CBC0523
+
+/**
+ * @file
+ * @brief `fail_action`: a scope guard that calls its exit function when a scope is exited via an exception.
+ *
+ * scope_action.h includes this header along with the other scope guards.
+ */
+
+#include <exception>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include "scope_action_detail.h"
+
+namespace wwa::utils {
+
+/**
+ * @brief A scope guard that calls its exit function when a scope is exited via an exception.
+ *
+ * Like `exit_action`, a `fail_action` may be active or inactive. A `fail_action` is active after construction from an
+ * exit function.
+ *
+ * An `fail_action` becomes inactive by calling `release()` or a move constructor. An inactive `fail_action`
+ * may also be obtained by initializing with another inactive `fail_action`. Once an `fail_action` is inactive,
+ * it cannot become active again.
+ *
+ * Usage example:
+ * @snippet{trimleft} scope_action.cpp Using fail_action: runs only if an exception occurs
+ *
+ * @tparam ExitFunc Exit function type. Func is either a
+ * [Destructible](https://en.cppreference.com/w/cpp/named_req/Destructible)
+ * [FunctionObject](https://en.cppreference.com/w/cpp/named_req/FunctionObject) type, or an lvalue reference to a
+ * [FunctionObject](https://en.cppreference.com/w/cpp/named_req/FunctionObject) or function.
+ * @see https://en.cppreference.com/w/cpp/experimental/scope_fail
+ * @note Constructing a `fail_action` of dynamic storage duration might lead to unexpected behavior.
+ * @note Constructing a `fail_action` from another `fail_action` created in a different thread might also lead to
+ * unexpected behavior since the count of uncaught exceptions obtained in different threads may be compared during
+ * the destruction.
+ */
+template<typename ExitFunc>
+class [[nodiscard("The object must be used to ensure the exit function is called due to an exception.")]] fail_action {
+public:
+    /**
+     * @brief Constructs a new @a fail_action from an exit function of type @a Func.
+     *
+     * Initializes the exit function with a function or function object, and initializes
+     * the counter of uncaught exceptions as if with `std::uncaught_exceptions()`.
+     * The constructed `fail_action` is active.
+     *
+     * If `Func` is not an lvalue reference type, and `std::is_nothrow_constructible_v<ExitFunc, Func>` is `true`, the
+     * stored exit function is initialized with `std::forward<Func>(fn)`; otherwise it is initialized with `fn`. If
+     * initialization of the stored exit function throws an exception, calls `fn()`.
+     *
+     * This overload participates in overload resolution only if:
+     *   - `std::is_same_v<std::remove_cvref_t<Func>, fail_action>` is `false`, and
+     *   - `std::is_constructible_v<ExitFunc, Func>` is `true`.
+     *
+     * @tparam Func Exit function type. Must be constructible from @a ExitFunc.
+     * @param fn Exit function.
+     * @throw anything Any exception thrown during the initialization of the stored exit function.
+     * @see https://en.cppreference.com/w/cpp/experimental/scope_fail/scope_fail
+     */
+    template<typename Func>
+    requires(detail::can_construct_from<fail_action, ExitFunc, Func>)
+    explicit fail_action(
+        Func&& fn
+    ) noexcept(std::is_nothrow_constructible_v<ExitFunc, Func> || std::is_nothrow_constructible_v<ExitFunc, Func&>)
+    try
+        : m_exit_function(
+              detail::conditional_forward(
+                  std::forward<Func>(fn),
+                  std::bool_constant<
+                      std::is_nothrow_constructible_v<ExitFunc, Func> && !std::is_lvalue_reference_v<Func>>()
+              )
+          )
+    {
+        WWA_SCOPE_PROBE(armed, scope_probe_kind::fail, this);
+    }
+    catch (...) {
+        fn();
+    }
+
+    /**
+     * @brief Constructs a new @a fail_action from an exit function of type @a Func.
+     *
+     * Initializes the exit function with a function or function object `fn`. The constructed `fail_action` is active.
+     * The stored exit function is initialized with `std::forward<Func>(fn)`.
+     *
+     * This overload participates in overload resolution only if:
+     *   - `std::is_same_v<std::remove_cvref_t<Func>, fail_action>` is `false`, and
+     *   - `std::is_lvalue_reference_v<Func>` is `false`, and
+     *   - `std::is_nothrow_constructible_v<ExitFunc, Func>` is `true`.
+     *
+     * @tparam Func Exit function type. Must be constructible from @a ExitFunc.
+     * @param fn Exit function.
+     * @see https://en.cppreference.com/w/cpp/experimental/scope_fail/scope_fail
+     */
+    template<typename Func>
+    requires(detail::can_move_construct_from_noexcept<fail_action, ExitFunc, Func>)
+    explicit fail_action(Func&& fn) noexcept : m_exit_function(std::forward<Func>(fn))
+    {
+        WWA_SCOPE_PROBE(armed, scope_probe_kind::fail, this);
+    }
+
+    /**
+     * @brief Constructs a new @a fail_action that calls @a fn with bound arguments @a args.
+     *
+     * The stored exit function is a `bound_call` that holds decayed copies of `fn` and `args` (see bound_call.h); a
+     * pointer to member function can be followed by the object, which is stored as a pointer to it. The constructed
+     * `fail_action` is active. Guards constructed from the same types of `fn` and `args` share one instantiation. If
+     * storing `fn` and `args` throws an exception, calls `std::invoke(fn, args...)`.
+     *
+     * This overload participates in overload resolution only if `ExitFunc` is a `bound_call` constructible from `fn`
+     * and `args`.
+     *
+     * @tparam Func Callable type.
+     * @tparam Args Argument types.
+     * @param fn Callable, such as a function or a pointer to member function.
+     * @param args Arguments of `fn`.
+     * @throw anything Any exception thrown during the initialization of the stored exit function.
+     */
+    template<typename Func, typename... Args>
+    requires(sizeof...(Args) > 0 && std::is_constructible_v<ExitFunc, std::in_place_t, Func, Args...>)
+    fail_action(Func&& fn, Args&&... args) noexcept(
+        std::is_nothrow_constructible_v<ExitFunc, std::in_place_t, Func, Args...>
+    )
+    try
+        : m_exit_function(std::in_place, std::forward<Func>(fn), std::forward<Args>(args)...)
+    {
+        WWA_SCOPE_PROBE(armed, scope_probe_kind::fail, this);
+    }
+    catch (...) {
+        detail::bound_invoke(fn, args...);
+    }
+
+    /**
+     * @brief Move constructor.
+     *
+     * Initializes the stored exit function with the one in `other`, and initializes the counter of
+     * uncaught exceptions with the one in `other`. The constructed `fail_action` is active
+     * if and only if `other` is active before the construction.
+     *
+     * If `std::is_nothrow_move_constructible_v<ExitFunc>` is true, initializes stored exit function (denoted by
+     * `exitfun`) with `std::forward<ExitFunc>(other.exitfun)`, otherwise initializes it with `other.exitfun`.
+     *
+     * After successful move construction, `other.release()` is called and `other` becomes inactive.
+     *
+     * This overload participates in overload resolution only if:
+     *   - `std::is_nothrow_move_constructible_v<ExitFunc>` is `true`, or
+     *   - `std::is_copy_constructible_v<ExitFunc>` is `true`.
+     *
+     * @param other `fail_action` to move from.
+     * @throw anything Any exception thrown during the initialization of the stored exit function.
+     * @see https://en.cppreference.com/w/cpp/experimental/scope_fail/scope_fail
+     */
+    fail_action(
+        fail_action&& other
+    ) noexcept(std::is_nothrow_move_constructible_v<ExitFunc> || std::is_nothrow_copy_constructible_v<ExitFunc>)
+    requires(std::is_nothrow_move_constructible_v<ExitFunc> || std::is_copy_constructible_v<ExitFunc>)
+        : m_exit_function(
+              detail::conditional_forward(
+                  std::forward<ExitFunc>(other.m_exit_function),
+                  std::bool_constant<std::is_nothrow_move_constructible_v<ExitFunc>>()
+              )
+          ),
+          m_uncaught_exceptions_count(other.m_uncaught_exceptions_count)
+    {
+        other.release();
+        WWA_SCOPE_PROBE(armed, scope_probe_kind::fail, this);
+    }
+
+    /** @cond */
+    /** @brief @a fail_action is not @a CopyConstructible */
+    fail_action(const fail_action&)            = delete;
+    /** @brief @a fail_action is not @a CopyAssignable */
+    fail_action& operator=(const fail_action&) = delete;
+    /** @brief @a fail_action is not @a MoveAssignable */
+    fail_action& operator=(fail_action&&)      = delete;
+    /** @endcond */
+
+    /**
+     * @brief Calls the exit function if the scope is exited via an exception and destroys the object.
+     *
+     * Calls the exit function if the result of `std::uncaught_exceptions()` is greater than the counter of uncaught
+     * exceptions (typically on stack unwinding) and the `fail_action` is active; then destroys the object.
+     *
+     * @see https://en.cppreference.com/w/cpp/experimental/scope_fail/%7Escope_fail
+     */
+    ~fail_action() noexcept
+    {
+        if (std::uncaught_exceptions() > this->m_uncaught_exceptions_count) {
+            WWA_SCOPE_PROBE(fired, scope_probe_kind::fail, this);
+            this->m_exit_function();
+        }
+
+        WWA_SCOPE_PROBE(exited, scope_probe_kind::fail, this);
+    }
+
+    /**
+     * @brief Makes the @a fail_action object inactive.
+     *
+     * Once an @a fail_action is inactive, it cannot become active again, and it will not call its exit function upon
+     * destruction.
+     *
+     * @note @a release() may be either manually called or automatically called by `fail_action`'s move constructor.
+     * @see https://en.cppreference.com/w/cpp/experimental/scope_fail/release
+     */
+    void release() noexcept
+    {
+        WWA_SCOPE_PROBE(released, scope_probe_kind::fail, this);
+        this->m_uncaught_exceptions_count = std::numeric_limits<int>::max();
+    }
+
+private:
+    static_assert(
+        detail::capture_within_budget<ExitFunc>,
+        "fail_action: the exit function is larger than WWA_SCOPE_ACTION_MAX_CAPTURE_SIZE bytes"
+    );
+    static_assert(
+        detail::capture_nothrow_movable<ExitFunc>,
+        "fail_action: the exit function must be nothrow move constructible (WWA_SCOPE_ACTION_MAX_CAPTURE_SIZE)"
+    );
+
+    ExitFunc m_exit_function;                                      ///< The stored exit function.
+    int m_uncaught_exceptions_count = std::uncaught_exceptions();  ///< The counter of uncaught exceptions.
+};
+
+/**
+ * @brief Deduction guide for @a fail_action.
+ *
+ * @tparam ExitFunc Exit function type.
+ */
+template<typename ExitFunc>
+fail_action(ExitFunc) -> fail_action<ExitFunc>;
+
+/**
+ * @brief Deduction guide for @a fail_action constructed from a callable and its arguments.
+ *
+ * @tparam Func Callable type.
+ * @tparam Args Argument types.
+ */
+template<typename Func, typename... Args>
+requires(sizeof...(Args) > 0)
+fail_action(Func&&, Args&&...) -> fail_action<detail::bound_call_t<Func, Args...>>;
+
+}  // namespace wwa::utils
+
+#endif /* BFD60A4A_97E3_4C1C_99AB_AF397CBC0523 */
@@ -0,0 +1,52 @@
+#ifndef C2E7A5F4_8B13_4D6A_9E0F_5A1C3B7D9E24
+#define C2E7A5F4_8B13_4D6A_9E0F_5A1C3B7D9E24
+
+/**
+ * @file
+ * @brief Recognition of recoverable faults for the POSIX-only utilities.
+ * @internal
+ *
+ * A utility that resolves some `SIGSEGV` or `SIGBUS` faults in its own handler (`page_snapshot`) registers a predicate
+ * here, so that other handlers of these signals (`flight_recorder`) do not mistake such faults for crashes.
+ */
+
+#include <atomic>
+
+#include <signal.h>
+
+namespace wwa::utils {
+
+/// @cond INTERNAL
+
+namespace detail {
+
+/**
+ * @brief Predicate that tells whether a fault will be resolved by its handler. Must be async-signal-safe.
+ */
+using fault_filter = bool (*)(int signo, const siginfo_t* info) noexcept;
+
+/**
+ * @brief The registered predicate, or `nullptr`.
+ */
+inline std::atomic<fault_filter> recoverable_fault_filter{nullptr};
+
+/**
+ * @brief Checks whether a fault will be resolved by the handler that registered the predicate. Async-signal-safe.
+ *
+ * @param signo Signal number.
+ * @param info Signal information.
+ * @return Whether the fault is not a crash.
+ */
+inline bool is_recoverable_fault(int signo, const siginfo_t* info) noexcept
+{
+    const fault_filter filter = recoverable_fault_filter.load(std::memory_order_acquire);
+    return filter != nullptr && filter(signo, info);
+}
+
+}  // namespace detail
+
+/// @endcond
+
+}  // namespace wwa::utils
+
+#endif /* C2E7A5F4_8B13_4D6A_9E0F_5A1C3B7D9E24 */
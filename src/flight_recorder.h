@@ -0,0 +1,485 @@
+#ifndef EAE2C8E1_B52A_4631_A51A_C7186C8C0FAD
+#define EAE2C8E1_B52A_4631_A51A_C7186C8C0FAD
+
+/**
+ * @file
+ * @brief Crash flight recorder of recent scope guard events.
+ *
+ * When `WWA_SCOPE_ACTION_FLIGHT_RECORDER` is non-zero, `exit_action`, `fail_action`, and `success_action` record
+ * their events into a ring buffer of the current thread:
+ *   - `enter`, when a guard is constructed;
+ *   - `release`, when `release()` is called;
+ *   - `fire`, when a guard is about to call its exit function;
+ *   - `exit`, when a guard is destroyed (after its exit function has returned, if it was called).
+ *
+ * Each event is 16 bytes long and holds the address of the code that recorded it (the call site of the guard in
+ * optimized builds), the low 32 bits of the address of the guard, and the kinds of the event and of the guard. Events
+ * are written with plain stores; the last `flight_recorder::ring_events` events of every thread are kept. Up to
+ * `flight_recorder::max_threads` threads record at a time; the ring of a thread that has exited is kept, and dumped,
+ * until another thread takes it over.
+ *
+ * `flight_recorder::install()` installs a handler of fatal signals that writes, with async-signal-safe functions
+ * only, the scopes that were active in every thread, the recent events, and the memory map of the process (to
+ * symbolize the addresses, e.g. with `addr2line`), and then lets the signal take its course.
+ *
+ * When `WWA_SCOPE_ACTION_FLIGHT_RECORDER` is zero (the default), the guards do not record anything. Configure the
+ * project with `-DENABLE_FLIGHT_RECORDER=ON` to enable recording for all consumers of the `wwa::scope_action` target.
+ *
+ * Usage example:
+ * @code{.cpp}
+ * int main()
+ * {
+ *     wwa::utils::flight_recorder::install("/var/tmp/worker.flight");
+ *     // ...
+ * }
+ * @endcode
+ *
+ * @note This header requires Linux. A thread can only dump after a stack overflow if it has an alternate
+ * signal stack (`sigaltstack()`).
+ */
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "fault_filter.h"
+#include "posix_error.h"
+
+#ifndef WWA_SCOPE_ACTION_FLIGHT_RECORDER
+#    define WWA_SCOPE_ACTION_FLIGHT_RECORDER 0
+#endif
+
+#ifndef WWA_FLIGHT_RECORDER_EVENTS
+#    define WWA_FLIGHT_RECORDER_EVENTS 256
+#endif
+
+namespace wwa::utils {
+
+/// @cond INTERNAL
+
+namespace detail {
+
+enum class flight_event_type : std::uint8_t {
+    armed    = 0,
+    released = 1,
+    fired    = 2,
+    exited   = 3,
+};
+
+struct flight_event {
+    std::uintptr_t site;  ///< Address of the code that recorded the event.
+    std::uint32_t guard;  ///< Low 32 bits of the address of the guard.
+    std::uint8_t type;    ///< `flight_event_type`.
+    std::uint8_t kind;    ///< `scope_probe_kind`.
+};
+
+static_assert(sizeof(flight_event) == sizeof(std::uintptr_t) + 8);
+
+struct alignas(64) flight_ring {
+    static constexpr std::size_t size = WWA_FLIGHT_RECORDER_EVENTS;
+    static_assert(size != 0 && (size & (size - 1)) == 0, "WWA_FLIGHT_RECORDER_EVENTS must be a power of two");
+
+    std::atomic<int> tid{0};                  ///< Thread ID of the owner; 0 if the ring has never been used.
+    std::atomic<std::uint64_t> position{0};   ///< Number of recorded events.
+    std::array<flight_event, size> events{};  ///< Events; `position % size` is the oldest one when the ring is full.
+};
+
+using flight_ring_array = std::array<flight_ring, 256>;
+
+inline flight_ring_array& flight_rings() noexcept
+{
+    static flight_ring_array rings{};
+    return rings;
+}
+
+/**
+ * @brief Takes over an unused ring, or the ring of a thread that has exited.
+ *
+ * Does not allocate (unlike a `thread_local` with a destructor, which would release the ring on thread exit) so that
+ * recording does not change the allocation counts of the first scope of a thread.
+ */
+[[gnu::noinline]] inline flight_ring* flight_claim_ring() noexcept
+{
+    const int saved_errno = errno;
+    const auto pid        = ::getpid();
+    const auto tid        = static_cast<int>(::syscall(SYS_gettid));
+    const auto exited     = [pid](int owner) { return ::syscall(SYS_tgkill, pid, owner, 0) == -1 && errno == ESRCH; };
+
+    flight_ring* result = nullptr;
+    for (const bool reuse : {false, true}) {
+        for (flight_ring& ring : flight_rings()) {
+            int owner = ring.tid.load(std::memory_order_relaxed);
+            if ((reuse ? owner != 0 && exited(owner) : owner == 0) &&
+                ring.tid.compare_exchange_strong(owner, tid, std::memory_order_acquire, std::memory_order_relaxed)) {
+                ring.position.store(0, std::memory_order_relaxed);
+                result = &ring;
+                break;
+            }
+        }
+
+        if (result != nullptr) {
+            break;
+        }
+    }
+
+    errno = saved_errno;
+    return result;
+}
+
+/**
+ * @brief Records an event into the ring of the calling thread.
+ */
+inline void flight_record(flight_event_type type, std::uint8_t kind, const void* site, const void* guard) noexcept
+{
+    static constinit thread_local flight_ring* ring = nullptr;
+    if (ring == nullptr) [[unlikely]] {
+        ring = flight_claim_ring();
+        if (ring == nullptr) {
+            return;
+        }
+    }
+
+    const auto position                        = ring->position.load(std::memory_order_relaxed);
+    ring->events[position % flight_ring::size] = {
+        reinterpret_cast<std::uintptr_t>(site), static_cast<std::uint32_t>(reinterpret_cast<std::uintptr_t>(guard)),
+        static_cast<std::uint8_t>(type), kind
+    };
+    ring->position.store(position + 1, std::memory_order_release);
+}
+
+/**
+ * @brief Buffered writer that only uses async-signal-safe functions.
+ */
+class flight_writer {
+public:
+    explicit flight_writer(int fd) noexcept : m_fd(fd) {}
+
+    flight_writer(const flight_writer&)            = delete;
+    flight_writer(flight_writer&&)                 = delete;
+    flight_writer& operator=(const flight_writer&) = delete;
+    flight_writer& operator=(flight_writer&&)      = delete;
+    ~flight_writer() noexcept { this->flush(); }
+
+    flight_writer& operator<<(std::string_view s) noexcept
+    {
+        for (const char c : s) {
+            if (this->m_length == this->m_buffer.size()) {
+                this->flush();
+            }
+
+            this->m_buffer[this->m_length++] = c;
+        }
+
+        return *this;
+    }
+
+    flight_writer& dec(std::uint64_t value, std::size_t width = 0) noexcept
+    {
+        std::array<char, 20> digits{};
+        std::size_t n = 0;
+        do {
+            digits[n++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+
+        for (; width > n; --width) {
+            *this << " ";
+        }
+
+        while (n > 0) {
+            *this << std::string_view(&digits[--n], 1);
+        }
+
+        return *this;
+    }
+
+    flight_writer& hex(std::uint64_t value) noexcept
+    {
+        static constexpr std::string_view xdigits = "0123456789abcdef";
+
+        *this << "0x";
+        const int digits = value == 0 ? 1 : (64 - std::countl_zero(value) + 3) / 4;
+        for (int i = digits - 1; i >= 0; --i) {
+            *this << xdigits.substr((value >> (4 * i)) & 0xFU, 1);
+        }
+
+        return *this;
+    }
+
+    void flush() noexcept
+    {
+        const char* p = this->m_buffer.data();
+        while (this->m_length > 0) {
+            const auto n = ::write(this->m_fd, p, this->m_length);
+            if (n <= 0) {
+                if (n == -1 && errno == EINTR) {
+                    continue;
+                }
+
+                break;
+            }
+
+            p += n;
+            this->m_length -= static_cast<std::size_t>(n);
+        }
+
+        this->m_length = 0;
+    }
+
+private:
+    int m_fd;                          ///< Output file descriptor.
+    std::array<char, 512> m_buffer{};  ///< Buffered output.
+    std::size_t m_length = 0;          ///< Number of buffered characters.
+};
+
+}  // namespace detail
+
+/// @endcond
+
+/**
+ * @brief The crash flight recorder: dumps the recent scope guard events of all threads.
+ */
+class flight_recorder {
+public:
+    /// @brief Number of events kept per thread (`WWA_FLIGHT_RECORDER_EVENTS`).
+    static constexpr std::size_t ring_events = detail::flight_ring::size;
+
+    /// @brief Whether the scope guards record events (`WWA_SCOPE_ACTION_FLIGHT_RECORDER`).
+    static constexpr bool enabled = WWA_SCOPE_ACTION_FLIGHT_RECORDER != 0;
+
+    /// @brief Number of threads that can record at a time.
+    static constexpr std::size_t max_threads = std::tuple_size_v<detail::flight_ring_array>;
+
+    /// @brief Maximum length of the path of the dump file.
+    static constexpr std::size_t max_path = 4095;
+
+    /**
+     * @brief Installs a handler of fatal signals that dumps the events into a file.
+     *
+     * The handler writes the dump, restores the previous disposition of the signal, and raises the signal again.
+     * Faults that the previous handler resolves, such as the copy-on-write faults of an active `page_snapshot`, are
+     * passed to it with the original signal information, without a dump. Installing the handler again for the same
+     * signal only changes the path.
+     *
+     * @param path Path of the dump file; it is created or truncated when a signal is caught.
+     * @param signals Signals to handle.
+     * @throw std::length_error The path is longer than `max_path`.
+     * @throw std::system_error `sigaction()` failed.
+     */
+    static void install(
+        std::string_view path, std::initializer_list<int> signals = {SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT}
+    )
+    {
+        if (path.size() > max_path) {
+            throw std::length_error("flight_recorder: the path is too long");
+        }
+
+        handler_state& state = handler();
+        std::memcpy(state.path.data(), path.data(), path.size());
+        state.path[path.size()] = '\0';
+
+        for (const int sig : signals) {
+            if (sig <= 0 || sig >= NSIG || state.installed[static_cast<std::size_t>(sig)]) {
+                continue;
+            }
+
+            struct sigaction sa {};
+            sa.sa_sigaction = &on_signal;
+            sa.sa_flags     = SA_SIGINFO | SA_ONSTACK;
+            sigemptyset(&sa.sa_mask);
+            if (::sigaction(sig, &sa, &state.previous[static_cast<std::size_t>(sig)]) == -1) {
+                detail::throw_errno("sigaction");
+            }
+
+            state.installed[static_cast<std::size_t>(sig)] = true;
+        }
+    }
+
+    /**
+     * @brief Writes the events of all threads. Async-signal-safe.
+     *
+     * Events that other threads record during the dump might be torn.
+     *
+     * @param fd File descriptor to write to.
+     */
+    static void dump(int fd) noexcept
+    {
+        detail::flight_writer out(fd);
+        for (const detail::flight_ring& ring : detail::flight_rings()) {
+            if (const int tid = ring.tid.load(std::memory_order_relaxed); tid != 0) {
+                dump_ring(out, ring, tid);
+            }
+        }
+
+        out << "maps:\n";
+        out.flush();
+        copy_maps(fd);
+    }
+
+private:
+    /// @cond INTERNAL
+    struct handler_state {
+        std::array<char, max_path + 1> path{};          ///< Path of the dump file.
+        std::array<struct sigaction, NSIG> previous{};  ///< Previous dispositions.
+        std::array<bool, NSIG> installed{};             ///< Signals with the handler installed.
+        std::atomic<bool> dumping{false};               ///< Whether a dump has started.
+    };
+    /// @endcond
+
+    static handler_state& handler() noexcept
+    {
+        static handler_state state;
+        return state;
+    }
+
+    static constexpr std::string_view event_name(std::uint8_t type) noexcept
+    {
+        constexpr std::array<std::string_view, 4> names = {"enter  ", "release", "fire   ", "exit   "};
+        return type < names.size() ? names[type] : "?      ";
+    }
+
+    static constexpr std::string_view kind_name(std::uint8_t kind) noexcept
+    {
+        constexpr std::array<std::string_view, 3> names = {"exit_action   ", "fail_action   ", "success_action"};
+        return kind < names.size() ? names[kind] : "?             ";
+    }
+
+    static void dump_ring(detail::flight_writer& out, const detail::flight_ring& ring, int tid) noexcept
+    {
+        const std::uint64_t end   = ring.position.load(std::memory_order_acquire);
+        const std::uint64_t begin = end > ring_events ? end - ring_events : 0;
+
+        // Guards entered but not exited within the window are the active ones, innermost last
+        constexpr std::size_t max_active = 64;
+        std::array<const detail::flight_event*, max_active> active{};
+        std::size_t depth = 0;
+        for (std::uint64_t i = begin; i < end; ++i) {
+            const detail::flight_event& e = ring.events[i % ring_events];
+            if (e.type == static_cast<std::uint8_t>(detail::flight_event_type::armed)) {
+                if (depth == max_active) {
+                    std::memmove(active.data(), active.data() + 1, (max_active - 1) * sizeof(active[0]));
+                    --depth;
+                }
+
+                active[depth++] = &e;
+            }
+            else if (e.type == static_cast<std::uint8_t>(detail::flight_event_type::exited)) {
+                for (std::size_t j = depth; j > 0; --j) {
+                    if (active[j - 1]->guard == e.guard) {
+                        std::memmove(&active[j - 1], &active[j], (depth - j) * sizeof(active[0]));
+                        --depth;
+                        break;
+                    }
+                }
+            }
+        }
+
+        out << "thread ";
+        out.dec(static_cast<std::uint64_t>(tid));
+        if (tid == static_cast<int>(::syscall(SYS_gettid))) {
+            out << " (current)";
+        }
+
+        out << ": ";
+        out.dec(end - begin);
+        out << " of ";
+        out.dec(end);
+        out << " events\n  active scopes (outermost first):\n";
+        for (std::size_t j = 0; j < depth; ++j) {
+            write_event(out, *active[j], 0, false);
+        }
+
+        out << "  events (oldest first):\n";
+        for (std::uint64_t i = begin; i < end; ++i) {
+            write_event(out, ring.events[i % ring_events], i, true);
+        }
+    }
+
+    static void write_event(detail::flight_writer& out, const detail::flight_event& e, std::uint64_t n, bool numbered)
+        noexcept
+    {
+        out << "    ";
+        if (numbered) {
+            out.dec(n, 8);
+            out << " " << event_name(e.type) << " ";
+        }
+
+        out << kind_name(e.kind) << " site=";
+        out.hex(e.site);
+        out << " guard=";
+        out.hex(e.guard);
+        out << "\n";
+    }
+
+    static void copy_maps(int fd) noexcept
+    {
+        const int maps = ::open("/proc/self/maps", O_RDONLY | O_CLOEXEC);  // NOLINT(*-vararg)
+        if (maps == -1) {
+            return;
+        }
+
+        std::array<char, 4096> buf;  // NOLINT(*-member-init)
+        ssize_t n = 0;
+        while ((n = ::read(maps, buf.data(), buf.size())) > 0 || (n == -1 && errno == EINTR)) {
+            if (n > 0) {
+                detail::flight_writer out(fd);
+                out << std::string_view(buf.data(), static_cast<std::size_t>(n));
+            }
+        }
+
+        ::close(maps);
+    }
+
+    static void on_signal(int sig, siginfo_t* info, void* context) noexcept
+    {
+        const int saved_errno = errno;
+        handler_state& state  = handler();
+
+        // Not a crash (e.g. a copy-on-write fault of `page_snapshot`): let the previous handler resolve it
+        const struct sigaction& previous = state.previous[static_cast<std::size_t>(sig)];
+        if ((previous.sa_flags & SA_SIGINFO) != 0 && detail::is_recoverable_fault(sig, info)) {
+            previous.sa_sigaction(sig, info, context);
+            errno = saved_errno;
+            return;
+        }
+
+        if (!state.dumping.exchange(true)) {
+            const int fd = ::open(state.path.data(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);  // NOLINT
+            if (fd != -1) {
+                {
+                    detail::flight_writer out(fd);
+                    out << "flight recorder: signal ";
+                    out.dec(static_cast<std::uint64_t>(sig));
+                    out << " in thread ";
+                    out.dec(static_cast<std::uint64_t>(::syscall(SYS_gettid)));
+                    out << "\n";
+                }
+
+                dump(fd);
+                ::close(fd);
+            }
+        }
+
+        // Let the signal take its course: it is blocked until the handler returns
+        ::sigaction(sig, &previous, nullptr);
+        ::raise(sig);
+        errno = saved_errno;
+    }
+};
+
+}  // namespace wwa::utils
+
+#endif /* EAE2C8E1_B52A_4631_A51A_C7186C8C0FAD */
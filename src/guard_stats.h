@@ -0,0 +1,350 @@
+#ifndef CAD5CFDF_C45D_4B1F_860E_6B0A0EC9D761
+#define CAD5CFDF_C45D_4B1F_860E_6B0A0EC9D761
+
+/**
+ * @file
+ * @brief Statistics of how often the scope guards are armed, released, and fired.
+ *
+ * When `WWA_SCOPE_ACTION_STATS` is non-zero, `exit_action`, `fail_action`, and `success_action` count, per guard
+ * kind, how many times they are armed (constructed, including by the move constructor), released (including by the
+ * move constructor on the moved-from guard), and fired (their exit function is called). This answers questions such
+ * as "how often do rollbacks actually run". The counters are relaxed atomics in cache-line-sized shards. The first
+ * threads that count get a shard of their own, which they update with plain relaxed loads and stores; later threads
+ * share the remaining shards and update them with `fetch_add()`. Per-site counters are shared by all threads.
+ *
+ * When `WWA_SCOPE_ACTION_STATS_SITES` is also non-zero, the guards additionally count per call site. A call site is
+ * identified at compile time by the type of the guard: every lambda has a distinct type, so each
+ * `exit_action([&]() { ... })` is a site of its own, while guards holding function pointers or `std::function` share
+ * one site per function type. The name of a site is the name of the guard type as spelled by the compiler, which
+ * includes the function (GCC) or the file and line (Clang) where the lambda is defined.
+ *
+ * When `WWA_SCOPE_ACTION_STATS` is zero (the default), the guards do not count anything, and `guard_stats` reports
+ * zeros. Configure the project with `-DENABLE_GUARD_STATS=ON` to enable counting for all consumers of the
+ * `wwa::scope_action` target.
+ *
+ * Usage example:
+ * @code{.cpp}
+ * int main()
+ * {
+ *     run();
+ *     wwa::utils::guard_stats::write("guard_stats.txt");
+ * }
+ * @endcode
+ *
+ * @note All translation units of a program should be compiled with the same values of `WWA_SCOPE_ACTION_STATS` and
+ * `WWA_SCOPE_ACTION_STATS_SITES`.
+ */
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <source_location>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "scope_probe.h"
+
+#ifndef WWA_SCOPE_ACTION_STATS
+#    define WWA_SCOPE_ACTION_STATS 0
+#endif
+
+#ifndef WWA_SCOPE_ACTION_STATS_SITES
+#    define WWA_SCOPE_ACTION_STATS_SITES 0
+#endif
+
+namespace wwa::utils {
+
+/**
+ * @brief Guard event counters.
+ */
+struct guard_counts {
+    std::uint64_t armed    = 0;  ///< Number of guards armed.
+    std::uint64_t released = 0;  ///< Number of guards released.
+    std::uint64_t fired    = 0;  ///< Number of exit functions called.
+
+    guard_counts& operator+=(const guard_counts& other) noexcept
+    {
+        this->armed += other.armed;
+        this->released += other.released;
+        this->fired += other.fired;
+        return *this;
+    }
+
+    friend guard_counts operator-(const guard_counts& a, const guard_counts& b) noexcept
+    {
+        return {a.armed - b.armed, a.released - b.released, a.fired - b.fired};
+    }
+
+    friend bool operator==(const guard_counts&, const guard_counts&) = default;
+};
+
+/**
+ * @brief Counters of one call site.
+ */
+struct guard_site_counts {
+    std::string_view site;                           ///< Name of the guard type.
+    scope_probe_kind kind = scope_probe_kind::exit;  ///< Kind of the guard.
+    guard_counts counts;                             ///< Counters.
+};
+
+/**
+ * @brief Counters of all guards at one point in time.
+ */
+struct guard_stats_snapshot {
+    std::array<guard_counts, 3> kinds{};   ///< Counters per `scope_probe_kind`.
+    std::vector<guard_site_counts> sites;  ///< Counters per call site, in no particular order.
+
+    /**
+     * @brief Returns the counters of guards of the given kind.
+     */
+    [[nodiscard]] const guard_counts& operator[](scope_probe_kind kind) const noexcept
+    {
+        return this->kinds[static_cast<std::size_t>(kind)];
+    }
+};
+
+/// @cond INTERNAL
+
+namespace detail {
+
+enum class guard_event : std::uint8_t {
+    armed    = 0,
+    released = 1,
+    fired    = 2,
+    exited   = 3,
+};
+
+struct alignas(64) stats_shard {
+    std::array<std::array<std::atomic<std::uint64_t>, 3>, 3> counts{};  ///< Counters by kind and event.
+};
+
+inline constexpr std::size_t stats_shard_count  = 64;
+inline constexpr std::size_t stats_shared_shards = 8;
+
+inline std::array<stats_shard, stats_shard_count>& stats_shards() noexcept
+{
+    static constinit std::array<stats_shard, stats_shard_count> shards{};
+    return shards;
+}
+
+struct stats_slot {
+    stats_shard* shard = nullptr;  ///< Shard of the thread.
+    bool exclusive     = false;    ///< Whether no other thread updates the shard.
+};
+
+/**
+ * @brief Returns the shard of the calling thread.
+ *
+ * Exclusive shards are never given back (that would need a `thread_local` with a destructor, which allocates on
+ * first use), so once they run out, new threads share the last `stats_shared_shards` shards.
+ */
+inline const stats_slot& this_thread_stats_slot() noexcept
+{
+    static constinit std::atomic<std::size_t> next{0};
+    static constinit thread_local stats_slot slot;
+    if (slot.shard == nullptr) [[unlikely]] {
+        constexpr std::size_t exclusive_shards = stats_shard_count - stats_shared_shards;
+
+        const std::size_t n = next.fetch_add(1, std::memory_order_relaxed);
+        slot.exclusive      = n < exclusive_shards;
+        slot.shard          = &stats_shards()[slot.exclusive ? n : exclusive_shards + n % stats_shared_shards];
+    }
+
+    return slot;
+}
+
+struct stats_site {
+    const char* name = nullptr;                          ///< Name of the function that names the guard type.
+    std::array<std::atomic<std::uint64_t>, 3> counts{};  ///< Counters by event.
+    scope_probe_kind kind = scope_probe_kind::exit;      ///< Kind of the guard.
+    std::atomic<bool> registered{false};                 ///< Whether the site is in the list.
+    stats_site* next = nullptr;                          ///< Next registered site.
+};
+
+inline std::atomic<stats_site*>& stats_sites() noexcept
+{
+    static constinit std::atomic<stats_site*> head{nullptr};
+    return head;
+}
+
+template<typename Guard>
+constexpr const char* stats_site_name() noexcept
+{
+    return std::source_location::current().function_name();
+}
+
+template<typename Guard>
+inline constinit stats_site stats_site_of{.name = stats_site_name<Guard>()};
+
+[[gnu::noinline]] inline void stats_register(stats_site& site, scope_probe_kind kind) noexcept
+{
+    if (!site.registered.exchange(true, std::memory_order_relaxed)) {
+        site.kind = kind;
+        site.next = stats_sites().load(std::memory_order_relaxed);
+        while (!stats_sites().compare_exchange_weak(
+            site.next, &site, std::memory_order_release, std::memory_order_relaxed
+        )) {
+        }
+    }
+}
+
+/**
+ * @brief Counts a guard event.
+ */
+template<guard_event Event, typename Guard>
+inline void stats_count(scope_probe_kind kind, const Guard* /*guard*/) noexcept
+{
+    if constexpr (Event != guard_event::exited) {
+        constexpr auto event   = static_cast<std::size_t>(Event);
+        const stats_slot& slot = this_thread_stats_slot();
+        auto& counter          = slot.shard->counts[static_cast<std::size_t>(kind)][event];
+        if (slot.exclusive) [[likely]] {
+            counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+        else {
+            counter.fetch_add(1, std::memory_order_relaxed);
+        }
+
+#if WWA_SCOPE_ACTION_STATS_SITES
+        stats_site& site = stats_site_of<Guard>;
+        if (!site.registered.load(std::memory_order_relaxed)) [[unlikely]] {
+            stats_register(site, kind);
+        }
+
+        site.counts[event].fetch_add(1, std::memory_order_relaxed);
+#endif
+    }
+}
+
+/**
+ * @brief Extracts the guard type from the name of `stats_site_name<Guard>()`.
+ */
+inline std::string_view stats_site_type(std::string_view function) noexcept
+{
+    // GCC: "... [with Guard = T]"; Clang: "... [Guard = T]"
+    constexpr std::string_view marker = "Guard = ";
+    const auto begin                  = function.find(marker);
+    const auto end                    = function.rfind(']');
+    if (begin == std::string_view::npos || end == std::string_view::npos || end < begin) {
+        return function;
+    }
+
+    return function.substr(begin + marker.size(), end - begin - marker.size());
+}
+
+}  // namespace detail
+
+/// @endcond
+
+/**
+ * @brief Reads and exports the guard statistics.
+ */
+class guard_stats {
+public:
+    /// @brief Whether the guards count events (`WWA_SCOPE_ACTION_STATS`).
+    static constexpr bool enabled = WWA_SCOPE_ACTION_STATS != 0;
+
+    /// @brief Whether the guards count events per call site (`WWA_SCOPE_ACTION_STATS_SITES`).
+    static constexpr bool by_site = enabled && WWA_SCOPE_ACTION_STATS_SITES != 0;
+
+    /**
+     * @brief Sums the counters of all shards and sites.
+     *
+     * Events counted concurrently with the snapshot may or may not be included.
+     */
+    [[nodiscard]] static guard_stats_snapshot snapshot()
+    {
+        guard_stats_snapshot result;
+        for (const detail::stats_shard& shard : detail::stats_shards()) {
+            for (std::size_t kind = 0; kind < result.kinds.size(); ++kind) {
+                result.kinds[kind] += {
+                    shard.counts[kind][0].load(std::memory_order_relaxed),
+                    shard.counts[kind][1].load(std::memory_order_relaxed),
+                    shard.counts[kind][2].load(std::memory_order_relaxed),
+                };
+            }
+        }
+
+        const detail::stats_site* site = detail::stats_sites().load(std::memory_order_acquire);
+        for (; site != nullptr; site = site->next) {
+            const guard_counts counts = {
+                site->counts[0].load(std::memory_order_relaxed),
+                site->counts[1].load(std::memory_order_relaxed),
+                site->counts[2].load(std::memory_order_relaxed),
+            };
+
+            result.sites.push_back({detail::stats_site_type(site->name), site->kind, counts});
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief Writes the counters as a text table: one line per guard kind, then one line per call site.
+     *
+     * @param os Output stream.
+     */
+    static void write(std::ostream& os)
+    {
+        if (!enabled) {
+            os << "# guard statistics are disabled (WWA_SCOPE_ACTION_STATS)\n";
+        }
+
+        const auto stats = snapshot();
+        os << "          armed        released           fired  fired/armed  kind            site\n";
+        const auto flags = os.flags();
+        os << std::fixed << std::setprecision(4);
+        for (std::size_t kind = 0; kind < stats.kinds.size(); ++kind) {
+            write_line(os, stats.kinds[kind], static_cast<scope_probe_kind>(kind));
+            os << "*\n";
+        }
+
+        for (const guard_site_counts& s : stats.sites) {
+            write_line(os, s.counts, s.kind);
+            os << s.site << '\n';
+        }
+
+        os.flags(flags);
+    }
+
+    /**
+     * @brief Writes the counters as a text table into a file.
+     *
+     * @param path Path of the file; it is created or truncated.
+     * @throw std::runtime_error The file cannot be written.
+     */
+    static void write(const std::string& path)
+    {
+        std::ofstream out(path, std::ios::out | std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("guard_stats: cannot open " + path);
+        }
+
+        write(out);
+        out.flush();
+        if (!out) {
+            throw std::runtime_error("guard_stats: cannot write " + path);
+        }
+    }
+
+private:
+    static void write_line(std::ostream& os, const guard_counts& c, scope_probe_kind kind)
+    {
+        constexpr std::array<std::string_view, 3> kinds = {"exit_action", "fail_action", "success_action"};
+
+        const double ratio = c.armed != 0 ? static_cast<double>(c.fired) / static_cast<double>(c.armed) : 0.0;
+        os << std::setw(15) << c.armed << ' ' << std::setw(15) << c.released << ' ' << std::setw(15) << c.fired << "  "
+           << std::setw(11) << ratio << "  " << std::left << std::setw(14) << kinds[static_cast<std::size_t>(kind)]
+           << std::right << "  ";
+    }
+};
+
+}  // namespace wwa::utils
+
+#endif /* CAD5CFDF_C45D_4B1F_860E_6B0A0EC9D761 */
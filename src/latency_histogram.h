@@ -0,0 +1,530 @@
+#ifndef C24E33A7_C79F_4BFB_9766_35D2D8EFD5C0
+#define C24E33A7_C79F_4BFB_9766_35D2D8EFD5C0
+
+/**
+ * @file
+ * @brief Latency distributions of scopes in mergeable per-thread log-linear histograms.
+ *
+ * This file provides `latency_scope`, which records the duration of a scope into a `latency_histogram`. Durations of
+ * scopes exited via an exception (see `fail_action`) are recorded into a separate histogram, so that fast failures do
+ * not hide in the distribution of successful calls.
+ *
+ * The histograms are log-linear, like [HdrHistogram](https://hdrhistogram.github.io/HdrHistogram/): values below
+ * 128 ns are exact, and larger values are recorded with a relative error below 1/64 (about 1.6%), up to about 18
+ * minutes. Each thread records into its own shard with plain stores, without atomic read-modify-write operations or
+ * locks; `latency_histogram::snapshot()` merges the shards without blocking the recording threads.
+ *
+ * Usage example:
+ * @code{.cpp}
+ * wwa::utils::latency_histogram get_user_latency;
+ *
+ * response get_user(const request& req)
+ * {
+ *     wwa::utils::latency_scope timer(get_user_latency);
+ *     // ...
+ * }
+ *
+ * const auto s = get_user_latency.snapshot();
+ * std::cout << "p99: " << s.succeeded.value_at_percentile(99.0) / 1000.0 << " us, "
+ *           << "failures: " << s.failed.count() << '\n';
+ * s.succeeded.write(std::cout);  // Percentile distribution, in microseconds
+ * @endcode
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iomanip>
+#include <new>
+#include <ostream>
+#include <vector>
+
+#include "exit_action.h"
+#include "thread_index.h"
+
+namespace wwa::utils {
+
+/**
+ * @brief A log-linear histogram of non-negative integer values, such as durations in nanoseconds.
+ *
+ * Values are grouped into ranges of powers of two, each of which is split into 64 buckets of equal width; values less
+ * than 128 have buckets of their own. Values greater than `max_value` are recorded as `max_value`.
+ */
+class hdr_histogram {
+public:
+    /// @brief Number of bits of the bucket index within a power of two.
+    static constexpr unsigned int sub_bucket_bits = 6;
+
+    /// @brief Number of bits of the largest trackable value.
+    static constexpr unsigned int value_bits = 40;
+
+    /// @brief Largest trackable value.
+    static constexpr std::uint64_t max_value = (std::uint64_t{1} << value_bits) - 1;
+
+    /// @brief Number of buckets within a power of two.
+    static constexpr std::size_t sub_bucket_count = std::size_t{1} << sub_bucket_bits;
+
+    /// @brief Total number of buckets.
+    static constexpr std::size_t bucket_count = (value_bits - sub_bucket_bits + 1) * sub_bucket_count;
+
+    /**
+     * @brief Creates an empty histogram.
+     *
+     * @throw std::bad_alloc Memory allocation failed.
+     */
+    hdr_histogram() : m_counts(bucket_count, 0) {}
+
+    /**
+     * @brief Returns the index of the bucket of a value.
+     *
+     * @param value Value.
+     * @return Bucket index.
+     */
+    [[nodiscard]] static constexpr std::size_t bucket_index(std::uint64_t value) noexcept
+    {
+        value = std::min(value, max_value);
+
+        // Values below 2 * sub_bucket_count map onto themselves; above, every power of two has sub_bucket_count
+        // buckets, whose index is given by the sub_bucket_bits + 1 most significant bits of the value
+        const auto width = static_cast<unsigned int>(std::bit_width(value));
+        const auto shift = width > sub_bucket_bits + 1 ? width - (sub_bucket_bits + 1) : 0U;
+        return shift * sub_bucket_count + static_cast<std::size_t>(value >> shift);
+    }
+
+    /**
+     * @brief Returns the smallest value that is recorded in a bucket.
+     *
+     * @param index Bucket index.
+     * @return Lowest value of the bucket.
+     */
+    [[nodiscard]] static constexpr std::uint64_t lowest_value(std::size_t index) noexcept
+    {
+        const auto shift = index < 2 * sub_bucket_count ? 0U : static_cast<unsigned int>(index / sub_bucket_count - 1);
+        return static_cast<std::uint64_t>(index - shift * sub_bucket_count) << shift;
+    }
+
+    /**
+     * @brief Returns the largest value that is recorded in a bucket.
+     *
+     * @param index Bucket index.
+     * @return Highest value of the bucket.
+     */
+    [[nodiscard]] static constexpr std::uint64_t highest_value(std::size_t index) noexcept
+    {
+        return index + 1 < bucket_count ? lowest_value(index + 1) - 1 : max_value;
+    }
+
+    /**
+     * @brief Records a value.
+     *
+     * @param value Value.
+     * @param count Number of times to record it.
+     */
+    void record(std::uint64_t value, std::uint64_t count = 1) noexcept
+    {
+        this->m_counts[bucket_index(value)] += count;
+        this->m_total += count;
+    }
+
+    /**
+     * @brief Adds the counts of another histogram.
+     *
+     * @param other Histogram to add.
+     * @return `*this`.
+     */
+    hdr_histogram& operator+=(const hdr_histogram& other) noexcept
+    {
+        for (std::size_t i = 0; i < bucket_count; ++i) {
+            this->m_counts[i] += other.m_counts[i];
+        }
+
+        this->m_total += other.m_total;
+        return *this;
+    }
+
+    /**
+     * @brief Returns the number of recorded values.
+     *
+     * @return Number of values.
+     */
+    [[nodiscard]] std::uint64_t count() const noexcept { return this->m_total; }
+
+    /**
+     * @brief Returns the number of values recorded in a bucket.
+     *
+     * @param index Bucket index.
+     * @return Number of values.
+     */
+    [[nodiscard]] std::uint64_t count_at_index(std::size_t index) const noexcept { return this->m_counts[index]; }
+
+    /**
+     * @brief Returns the lowest recorded value, rounded down to its bucket.
+     *
+     * @return Lowest value, or 0 if the histogram is empty.
+     */
+    [[nodiscard]] std::uint64_t min() const noexcept
+    {
+        const auto it = std::ranges::find_if(this->m_counts, [](std::uint64_t c) { return c != 0; });
+        return it != this->m_counts.end() ? lowest_value(static_cast<std::size_t>(it - this->m_counts.begin())) : 0;
+    }
+
+    /**
+     * @brief Returns the highest recorded value, rounded up to its bucket.
+     *
+     * @return Highest value, or 0 if the histogram is empty.
+     */
+    [[nodiscard]] std::uint64_t max() const noexcept
+    {
+        for (std::size_t i = bucket_count; i > 0; --i) {
+            if (this->m_counts[i - 1] != 0) {
+                return highest_value(i - 1);
+            }
+        }
+
+        return 0;
+    }
+
+    /**
+     * @brief Returns the mean of the recorded values, taking the middle of each bucket.
+     *
+     * @return Mean, or 0 if the histogram is empty.
+     */
+    [[nodiscard]] double mean() const noexcept
+    {
+        if (this->m_total == 0) {
+            return 0.0;
+        }
+
+        double sum = 0.0;
+        for (std::size_t i = 0; i < bucket_count; ++i) {
+            sum += static_cast<double>(this->m_counts[i]) * middle(i);
+        }
+
+        return sum / static_cast<double>(this->m_total);
+    }
+
+    /**
+     * @brief Returns the standard deviation of the recorded values, taking the middle of each bucket.
+     *
+     * @return Standard deviation, or 0 if the histogram is empty.
+     */
+    [[nodiscard]] double stddev() const noexcept
+    {
+        if (this->m_total == 0) {
+            return 0.0;
+        }
+
+        const double m = this->mean();
+        double sum     = 0.0;
+        for (std::size_t i = 0; i < bucket_count; ++i) {
+            const double d = middle(i) - m;
+            sum += static_cast<double>(this->m_counts[i]) * d * d;
+        }
+
+        return std::sqrt(sum / static_cast<double>(this->m_total));
+    }
+
+    /**
+     * @brief Returns the value below or at which a given percentage of the recorded values lie.
+     *
+     * @param percentile Percentile, from 0 to 100.
+     * @return The highest value of the bucket that contains the percentile, or 0 if the histogram is empty.
+     */
+    [[nodiscard]] std::uint64_t value_at_percentile(double percentile) const noexcept
+    {
+        if (this->m_total == 0) {
+            return 0;
+        }
+
+        const double clamped = std::clamp(percentile, 0.0, 100.0);
+        const auto target    = std::max<std::uint64_t>(
+            1, static_cast<std::uint64_t>(std::ceil(clamped / 100.0 * static_cast<double>(this->m_total)))
+        );
+
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < bucket_count; ++i) {
+            seen += this->m_counts[i];
+            if (seen >= target) {
+                return highest_value(i);
+            }
+        }
+
+        return this->max();
+    }
+
+    /**
+     * @brief Writes the percentile distribution in the text format of HdrHistogram.
+     *
+     * The output can be plotted with the HdrHistogram plotter.
+     *
+     * @param os Output stream.
+     * @param unit_ratio Divisor of the values; the default converts nanoseconds to microseconds.
+     */
+    void write(std::ostream& os, double unit_ratio = 1000.0) const
+    {
+        const auto flags     = os.flags();
+        const auto precision = os.precision();
+        os << std::fixed;
+        os << std::setw(12) << "Value" << ' ' << std::setw(14) << "Percentile" << ' ' << std::setw(10) << "TotalCount"
+           << ' ' << std::setw(14) << "1/(1-Percentile)" << "\n\n";
+
+        if (this->m_total != 0) {
+            // Like HdrHistogram, halve the distance to 100% every 5 rows
+            constexpr int ticks_per_half_distance = 5;
+            double percentile                     = 0.0;
+            while (true) {
+                const std::uint64_t value = this->value_at_percentile(percentile);
+                const std::uint64_t below = this->count_at_or_below(value);
+                const double reached      = 100.0 * static_cast<double>(below) / static_cast<double>(this->m_total);
+
+                os << std::setprecision(3) << std::setw(12) << static_cast<double>(value) / unit_ratio << ' '
+                   << std::setprecision(12) << std::setw(14) << reached / 100.0 << ' ' << std::setw(10) << below;
+                if (below < this->m_total) {
+                    os << ' ' << std::setprecision(2) << std::setw(14) << 1.0 / (1.0 - reached / 100.0);
+                }
+
+                os << '\n';
+                if (below == this->m_total) {
+                    break;
+                }
+
+                const double half_distance = std::exp2(std::floor(std::log2(100.0 / (100.0 - reached))) + 1);
+                percentile = std::max(reached, percentile) + 100.0 / (half_distance * ticks_per_half_distance);
+            }
+        }
+
+        os << std::setprecision(3) << "#[Mean    = " << std::setw(12) << this->mean() / unit_ratio
+           << ", StdDeviation   = " << std::setw(12) << this->stddev() / unit_ratio << "]\n"
+           << "#[Max     = " << std::setw(12) << static_cast<double>(this->max()) / unit_ratio
+           << ", Total count    = " << std::setw(12) << this->m_total << "]\n"
+           << "#[Buckets = " << std::setw(12) << value_bits - sub_bucket_bits + 1 << ", SubBuckets     = "
+           << std::setw(12) << sub_bucket_count << "]\n";
+
+        os.precision(precision);
+        os.flags(flags);
+    }
+
+private:
+    std::vector<std::uint64_t> m_counts;  ///< Counts by bucket.
+    std::uint64_t m_total = 0;            ///< Number of recorded values.
+
+    static double middle(std::size_t index) noexcept
+    {
+        return (static_cast<double>(lowest_value(index)) + static_cast<double>(highest_value(index))) / 2.0;
+    }
+
+    std::uint64_t count_at_or_below(std::uint64_t value) const noexcept
+    {
+        std::uint64_t result = 0;
+        for (std::size_t i = 0; i <= bucket_index(value); ++i) {
+            result += this->m_counts[i];
+        }
+
+        return result;
+    }
+};
+
+/**
+ * @brief Merged histograms of a `latency_histogram`.
+ */
+struct latency_snapshot {
+    hdr_histogram succeeded;  ///< Durations of scopes exited normally, in nanoseconds.
+    hdr_histogram failed;     ///< Durations of scopes exited via an exception, in nanoseconds.
+};
+
+/**
+ * @brief Concurrent latency histograms, for scopes exited normally and via an exception.
+ *
+ * Every thread records into its own shards, which are allocated on the first record. A shard is kept when its thread
+ * exits and reused by the next thread that gets the same `detail::thread_index`.
+ */
+class latency_histogram {
+public:
+    latency_histogram() noexcept = default;
+
+    /** @cond */
+    latency_histogram(const latency_histogram&)            = delete;
+    latency_histogram(latency_histogram&&)                 = delete;
+    latency_histogram& operator=(const latency_histogram&) = delete;
+    latency_histogram& operator=(latency_histogram&&)      = delete;
+    /** @endcond */
+
+    /**
+     * @brief Frees the shards.
+     */
+    ~latency_histogram() noexcept
+    {
+        for (auto* shards : std::array{&this->m_succeeded, &this->m_failed}) {
+            for (auto& s : *shards) {
+                delete s.load(std::memory_order_acquire);  // NOLINT(cppcoreguidelines-owning-memory)
+            }
+        }
+    }
+
+    /**
+     * @brief Records a duration. Does not block and, except for the first record of a thread, does not allocate.
+     *
+     * If the shard of the thread cannot be allocated, the value is lost.
+     *
+     * @param nanoseconds Duration, in nanoseconds.
+     * @param failed Whether to record it into the histogram of failures.
+     */
+    void record(std::uint64_t nanoseconds, bool failed = false) noexcept
+    {
+        const std::size_t tid = detail::thread_index::get();
+        auto& slot            = (failed ? this->m_failed : this->m_succeeded)[tid];
+        shard* s              = slot.load(std::memory_order_acquire);
+        if (s == nullptr) [[unlikely]] {
+            s = install(slot);
+            if (s == nullptr) {
+                return;
+            }
+        }
+
+        auto& counter = s->counts[hdr_histogram::bucket_index(nanoseconds)];
+        if (tid != detail::thread_index::none) [[likely]] {
+            // Only this thread writes to the shard
+            counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+        else {
+            counter.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief Records a duration.
+     *
+     * @param duration Duration.
+     * @param failed Whether to record it into the histogram of failures.
+     */
+    template<typename Rep, typename Period>
+    void record(std::chrono::duration<Rep, Period> duration, bool failed = false) noexcept
+    {
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        this->record(ns > 0 ? static_cast<std::uint64_t>(ns) : 0, failed);
+    }
+
+    /**
+     * @brief Merges the shards of all threads. Does not block recording threads.
+     *
+     * Values recorded concurrently with the snapshot may or may not be included.
+     *
+     * @return Merged histograms.
+     * @throw std::bad_alloc Memory allocation failed.
+     */
+    [[nodiscard]] latency_snapshot snapshot() const
+    {
+        latency_snapshot result;
+        merge(this->m_succeeded, result.succeeded);
+        merge(this->m_failed, result.failed);
+        return result;
+    }
+
+private:
+    /// @cond INTERNAL
+    struct shard {
+        std::array<std::atomic<std::uint64_t>, hdr_histogram::bucket_count> counts{};
+    };
+    /// @endcond
+
+    /// @brief Shards by thread index; the last one is shared by threads without an index.
+    using series = std::array<std::atomic<shard*>, detail::thread_index::max_threads + 1>;
+
+    series m_succeeded{};  ///< Shards of scopes exited normally.
+    series m_failed{};     ///< Shards of scopes exited via an exception.
+
+    [[gnu::noinline]] static shard* install(std::atomic<shard*>& slot) noexcept
+    {
+        auto* fresh     = new (std::nothrow) shard();  // NOLINT(cppcoreguidelines-owning-memory)
+        shard* expected = nullptr;
+        if (fresh == nullptr || slot.compare_exchange_strong(expected, fresh, std::memory_order_acq_rel)) {
+            return fresh;
+        }
+
+        // Only the shared shard can be installed by two threads at once
+        delete fresh;  // NOLINT(cppcoreguidelines-owning-memory)
+        return expected;
+    }
+
+    static void merge(const series& shards, hdr_histogram& into) noexcept
+    {
+        for (const auto& slot : shards) {
+            if (const shard* s = slot.load(std::memory_order_acquire); s != nullptr) {
+                for (std::size_t i = 0; i < hdr_histogram::bucket_count; ++i) {
+                    if (const auto n = s->counts[i].load(std::memory_order_relaxed); n != 0) {
+                        into.record(hdr_histogram::lowest_value(i), n);
+                    }
+                }
+            }
+        }
+    }
+};
+
+/**
+ * @brief A scope whose duration is recorded into a `latency_histogram`.
+ *
+ * The duration is measured with `std::chrono::steady_clock`. If the scope is exited via an exception, it is recorded
+ * into the histogram of failures.
+ *
+ * @note Constructing a `latency_scope` of dynamic storage duration might lead to unexpected behavior.
+ */
+class [[nodiscard("The object must be used to record the duration of the scope on exit.")]] latency_scope {
+    /// @cond INTERNAL
+    struct record_fn {
+        latency_scope* scope;
+        void operator()() const noexcept { this->scope->record(); }
+    };
+    /// @endcond
+
+public:
+    /**
+     * @brief Starts timing the scope.
+     *
+     * @param histogram Histogram to record the duration into; must outlive the scope.
+     */
+    explicit latency_scope(latency_histogram& histogram) noexcept
+        : m_histogram(histogram), m_on_exit(record_fn{this})
+    {
+        this->m_start = std::chrono::steady_clock::now();
+    }
+
+    /** @cond */
+    latency_scope(const latency_scope&)            = delete;
+    latency_scope(latency_scope&&)                 = delete;
+    latency_scope& operator=(const latency_scope&) = delete;
+    latency_scope& operator=(latency_scope&&)      = delete;
+    ~latency_scope() noexcept                      = default;
+    /** @endcond */
+
+    /**
+     * @brief Returns the time elapsed since the scope was entered.
+     *
+     * @return Elapsed time.
+     */
+    [[nodiscard]] std::chrono::steady_clock::duration elapsed() const noexcept
+    {
+        return std::chrono::steady_clock::now() - this->m_start;
+    }
+
+private:
+    latency_histogram& m_histogram;                                ///< The histogram.
+    int m_uncaught_exceptions_count = std::uncaught_exceptions();  ///< The counter of uncaught exceptions.
+    std::chrono::steady_clock::time_point m_start;                 ///< When the scope was entered.
+    exit_action<record_fn> m_on_exit;                              ///< Records the duration on scope exit.
+
+    void record() noexcept
+    {
+        const auto duration = this->elapsed();
+        this->m_histogram.record(duration, std::uncaught_exceptions() > this->m_uncaught_exceptions_count);
+    }
+};
+
+}  // namespace wwa::utils
+
+#endif /* C24E33A7_C79F_4BFB_9766_35D2D8EFD5C0 */
@@ -0,0 +1,542 @@
+#ifndef FF022E37_89BC_4B84_87D6_3B4CFAF5D351
+#define FF022E37_89BC_4B84_87D6_3B4CFAF5D351
+
+/**
+ * @file
+ * @brief Per-scope memory usage profiling: heap and RSS deltas, peaks, and page faults.
+ *
+ * This file provides `memory_scope`, which samples the memory statistics of the process when a scope is entered and
+ * exited, and reports the deltas to the sink of a `memory_profiler`. The statistics are:
+ *   - heap usage reported by the allocator (`mallinfo2()`, glibc 2.33+);
+ *   - resident set size (`/proc/self/statm`, Linux);
+ *   - minor and major page faults (`getrusage()`).
+ *
+ * To find the peak usage of a scope, and not only the usage at its boundaries, the profiler can poll the statistics
+ * in a background thread while profiled scopes are active. To bound the overhead, only one in `sample_every` scopes
+ * is profiled; the others cost a single atomic increment.
+ *
+ * `memory_profile_aggregator` is a sink that aggregates reports by call site.
+ *
+ * Usage example:
+ * @code{.cpp}
+ * wwa::utils::memory_profile_aggregator sites;
+ * wwa::utils::memory_profiler profiler(std::ref(sites), {.sample_every = 1, .poll_interval = 10ms});
+ *
+ * void load(const path& p)
+ * {
+ *     wwa::utils::memory_scope scope(profiler, "load");
+ *     // ...
+ * }
+ *
+ * sites.write(std::cerr);  // Peak growth, RSS delta, and page faults per call site
+ * @endcode
+ *
+ * @note This header requires a POSIX system; heap statistics require glibc, and RSS requires Linux. Unavailable
+ * statistics are reported as zero.
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <source_location>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#if defined(__GLIBC__)
+#    include <malloc.h>
+#endif
+
+#include "exit_action.h"
+
+namespace wwa::utils {
+
+/**
+ * @brief Memory statistics of the process at a point in time.
+ */
+struct memory_sample {
+    std::int64_t heap_in_use  = 0;  ///< Bytes allocated by the application from the heap, including mmapped chunks.
+    std::int64_t heap_mapped  = 0;  ///< Bytes obtained by the allocator from the system.
+    std::int64_t rss          = 0;  ///< Resident set size, in bytes.
+    std::int64_t minor_faults = 0;  ///< Page faults serviced without I/O.
+    std::int64_t major_faults = 0;  ///< Page faults that required I/O.
+
+    /**
+     * @brief Samples the statistics of the process. Does not allocate.
+     *
+     * @return The sample.
+     */
+    static memory_sample now() noexcept
+    {
+        memory_sample s;
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+        const struct mallinfo2 mi = ::mallinfo2();
+        s.heap_in_use             = static_cast<std::int64_t>(mi.uordblks + mi.hblkhd);
+        s.heap_mapped             = static_cast<std::int64_t>(mi.arena + mi.hblkhd);
+#endif
+        s.rss = resident_set_size();
+
+        struct rusage usage {};
+        if (::getrusage(RUSAGE_SELF, &usage) == 0) {
+            s.minor_faults = usage.ru_minflt;
+            s.major_faults = usage.ru_majflt;
+        }
+
+        return s;
+    }
+
+    /**
+     * @brief Returns the change between two samples.
+     *
+     * @param other Earlier sample.
+     * @return Difference of the statistics.
+     */
+    [[nodiscard]] constexpr memory_sample operator-(const memory_sample& other) const noexcept
+    {
+        return {
+            this->heap_in_use - other.heap_in_use, this->heap_mapped - other.heap_mapped, this->rss - other.rss,
+            this->minor_faults - other.minor_faults, this->major_faults - other.major_faults
+        };
+    }
+
+private:
+    /**
+     * @brief Reads the resident set size from `/proc/self/statm`.
+     *
+     * @return RSS in bytes, or zero if it is not available.
+     */
+    static std::int64_t resident_set_size() noexcept
+    {
+        const int fd = ::open("/proc/self/statm", O_RDONLY | O_CLOEXEC);  // NOLINT(*-vararg)
+        if (fd == -1) {
+            return 0;
+        }
+
+        std::array<char, 128> buf{};
+        const auto n = ::read(fd, buf.data(), buf.size() - 1);
+        ::close(fd);
+        if (n <= 0) {
+            return 0;
+        }
+
+        // Format: size resident shared text lib data dt, in pages
+        const char* p = buf.data();
+        while (*p != ' ' && *p != '\0') {
+            ++p;
+        }
+
+        std::int64_t pages = 0;
+        for (++p; *p >= '0' && *p <= '9'; ++p) {
+            pages = pages * 10 + (*p - '0');
+        }
+
+        return pages * ::sysconf(_SC_PAGESIZE);
+    }
+};
+
+/**
+ * @brief Memory usage of one profiled scope.
+ */
+struct memory_report {
+    std::source_location site;  ///< Where the scope was created.
+    const char* name;           ///< Name of the scope; may be empty.
+    memory_sample entry;        ///< Statistics on scope entry.
+    memory_sample exit;         ///< Statistics on scope exit.
+    std::int64_t peak_heap;     ///< Highest observed heap usage while the scope was active.
+    std::int64_t peak_rss;      ///< Highest observed RSS while the scope was active.
+    bool failed;                ///< Whether the scope was exited via an exception.
+
+    /**
+     * @brief Returns the change of the statistics between scope entry and exit.
+     *
+     * @return Deltas.
+     */
+    [[nodiscard]] constexpr memory_sample delta() const noexcept { return this->exit - this->entry; }
+
+    /**
+     * @brief Returns how far heap usage rose above its level at scope entry.
+     *
+     * @return Peak heap growth, in bytes.
+     */
+    [[nodiscard]] constexpr std::int64_t peak_heap_growth() const noexcept
+    {
+        return this->peak_heap - this->entry.heap_in_use;
+    }
+
+    /**
+     * @brief Returns how far RSS rose above its level at scope entry.
+     *
+     * @return Peak RSS growth, in bytes.
+     */
+    [[nodiscard]] constexpr std::int64_t peak_rss_growth() const noexcept { return this->peak_rss - this->entry.rss; }
+};
+
+/**
+ * @brief Options of a `memory_profiler`.
+ */
+struct memory_profile_options {
+    std::uint32_t sample_every = 1;              ///< Profile one in this many scopes; 0 disables profiling.
+    std::chrono::milliseconds poll_interval{0};  ///< Polling interval for peaks; 0 disables polling.
+};
+
+class memory_scope;
+
+/**
+ * @brief Configuration and sink of memory profiling.
+ *
+ * The profiler must outlive all scopes that use it.
+ */
+class memory_profiler {
+public:
+    /// @brief Receives the reports in the thread that exits the scope; must be thread-safe and must not throw.
+    using sink_type = std::function<void(const memory_report&)>;
+
+    /// @brief Profiling options.
+    using options = memory_profile_options;
+
+    /**
+     * @brief Creates a profiler.
+     *
+     * @param sink Receives the reports.
+     * @param opts Options.
+     * @throw std::system_error The polling thread could not be started.
+     */
+    explicit memory_profiler(sink_type sink, options opts = {}) : m_sink(std::move(sink)), m_options(opts)
+    {
+        if (this->m_options.poll_interval.count() > 0) {
+            this->m_poller = std::thread([this]() { this->poll(); });
+        }
+    }
+
+    /** @cond */
+    memory_profiler(const memory_profiler&)            = delete;
+    memory_profiler(memory_profiler&&)                 = delete;
+    memory_profiler& operator=(const memory_profiler&) = delete;
+    memory_profiler& operator=(memory_profiler&&)      = delete;
+    /** @endcond */
+
+    /**
+     * @brief Stops the polling thread.
+     */
+    ~memory_profiler()
+    {
+        if (this->m_poller.joinable()) {
+            {
+                const std::lock_guard lock(this->m_mutex);
+                this->m_stop = true;
+            }
+
+            this->m_wakeup.notify_all();
+            this->m_poller.join();
+        }
+    }
+
+    /**
+     * @brief Returns the options.
+     *
+     * @return Options.
+     */
+    [[nodiscard]] const options& get_options() const noexcept { return this->m_options; }
+
+private:
+    friend class memory_scope;
+
+    sink_type m_sink;                         ///< Receives the reports.
+    options m_options;                        ///< Options.
+    std::atomic<std::uint32_t> m_counter{0};  ///< Number of scopes created, for sampling.
+    std::mutex m_mutex;                       ///< Protects `m_active` and `m_stop`.
+    std::condition_variable m_wakeup;         ///< Wakes up the polling thread.
+    std::vector<memory_scope*> m_active;      ///< Profiled scopes that are active.
+    bool m_stop = false;                      ///< Whether the polling thread must exit.
+    std::thread m_poller;                     ///< Polling thread.
+
+    /**
+     * @brief Decides whether the next scope is profiled.
+     *
+     * @return Whether to profile the scope.
+     */
+    bool sample() noexcept
+    {
+        const auto every = this->m_options.sample_every;
+        return every != 0 && this->m_counter.fetch_add(1, std::memory_order_relaxed) % every == 0;
+    }
+
+    void add(memory_scope* scope);
+    void remove(memory_scope* scope) noexcept;
+    void poll();
+};
+
+/**
+ * @brief A scope whose memory usage is reported to a `memory_profiler`.
+ *
+ * @note Constructing a `memory_scope` of dynamic storage duration might lead to unexpected behavior.
+ */
+class [[nodiscard("The object must be used to report memory usage on scope exit.")]] memory_scope {
+    /// @cond INTERNAL
+    struct report_fn {
+        memory_scope* scope;
+        void operator()() const noexcept { this->scope->report(); }
+    };
+    /// @endcond
+
+public:
+    /**
+     * @brief Samples the memory statistics on scope entry, if the scope is selected for profiling.
+     *
+     * @param profiler The profiler.
+     * @param name Name of the scope; must be a string with static storage duration.
+     * @param site Call site; aggregation groups reports by it.
+     * @throw std::bad_alloc Memory allocation failed (only when polling is enabled).
+     */
+    explicit memory_scope(
+        memory_profiler& profiler, const char* name = "", std::source_location site = std::source_location::current()
+    )
+        : m_profiler(profiler.sample() ? &profiler : nullptr), m_site(site), m_name(name),
+          m_on_exit(report_fn{this})
+    {
+        if (this->m_profiler != nullptr) {
+            this->m_entry = memory_sample::now();
+            this->m_peak_heap.store(this->m_entry.heap_in_use, std::memory_order_relaxed);
+            this->m_peak_rss.store(this->m_entry.rss, std::memory_order_relaxed);
+            if (this->m_profiler->m_options.poll_interval.count() > 0) {
+                try {
+                    this->m_profiler->add(this);
+                }
+                catch (...) {
+                    // The scope does not exist: it must not be reported
+                    this->m_on_exit.release();
+                    throw;
+                }
+            }
+        }
+    }
+
+    /** @cond */
+    memory_scope(const memory_scope&)            = delete;
+    memory_scope(memory_scope&&)                 = delete;
+    memory_scope& operator=(const memory_scope&) = delete;
+    memory_scope& operator=(memory_scope&&)      = delete;
+    ~memory_scope() noexcept                     = default;
+    /** @endcond */
+
+    /**
+     * @brief Checks whether the scope is profiled.
+     *
+     * @return Whether the scope has been selected by sampling.
+     */
+    [[nodiscard]] bool profiled() const noexcept { return this->m_profiler != nullptr; }
+
+private:
+    friend class memory_profiler;
+
+    memory_profiler* m_profiler;                                   ///< The profiler, or `nullptr` if not profiled.
+    std::source_location m_site;                                   ///< Call site.
+    const char* m_name;                                            ///< Name of the scope.
+    memory_sample m_entry;                                         ///< Statistics on scope entry.
+    std::atomic<std::int64_t> m_peak_heap{0};                      ///< Highest observed heap usage.
+    std::atomic<std::int64_t> m_peak_rss{0};                       ///< Highest observed RSS.
+    int m_uncaught_exceptions_count = std::uncaught_exceptions();  ///< The counter of uncaught exceptions.
+    exit_action<report_fn> m_on_exit;                              ///< Reports the usage on scope exit.
+
+    /**
+     * @brief Raises the observed peaks.
+     *
+     * @param s Sample.
+     */
+    void observe(const memory_sample& s) noexcept
+    {
+        raise(this->m_peak_heap, s.heap_in_use);
+        raise(this->m_peak_rss, s.rss);
+    }
+
+    static void raise(std::atomic<std::int64_t>& peak, std::int64_t value) noexcept
+    {
+        std::int64_t current = peak.load(std::memory_order_relaxed);
+        while (value > current && !peak.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    void report() noexcept
+    {
+        if (this->m_profiler == nullptr) {
+            return;
+        }
+
+        if (this->m_profiler->m_options.poll_interval.count() > 0) {
+            this->m_profiler->remove(this);
+        }
+
+        const memory_sample exit = memory_sample::now();
+        this->observe(exit);
+
+        const memory_report r{
+            this->m_site,
+            this->m_name,
+            this->m_entry,
+            exit,
+            this->m_peak_heap.load(std::memory_order_relaxed),
+            this->m_peak_rss.load(std::memory_order_relaxed),
+            std::uncaught_exceptions() > this->m_uncaught_exceptions_count,
+        };
+
+        this->m_profiler->m_sink(r);
+    }
+};
+
+/// @cond INTERNAL
+
+inline void memory_profiler::add(memory_scope* scope)
+{
+    const std::lock_guard lock(this->m_mutex);
+    this->m_active.push_back(scope);
+}
+
+inline void memory_profiler::remove(memory_scope* scope) noexcept
+{
+    const std::lock_guard lock(this->m_mutex);
+    // Scopes usually end in the reverse order
+    const auto it = std::find(this->m_active.rbegin(), this->m_active.rend(), scope);
+    if (it != this->m_active.rend()) {
+        this->m_active.erase(std::next(it).base());
+    }
+}
+
+inline void memory_profiler::poll()
+{
+    std::unique_lock lock(this->m_mutex);
+    while (!this->m_wakeup.wait_for(lock, this->m_options.poll_interval, [this]() { return this->m_stop; })) {
+        if (!this->m_active.empty()) {
+            const memory_sample s = memory_sample::now();
+            for (memory_scope* scope : this->m_active) {
+                scope->observe(s);
+            }
+        }
+    }
+}
+
+/// @endcond
+
+/**
+ * @brief A sink that aggregates memory reports by call site.
+ *
+ * Pass it to a `memory_profiler` with `std::ref()`. It is thread-safe.
+ */
+class memory_profile_aggregator {
+public:
+    /**
+     * @brief Aggregated memory usage of a call site.
+     */
+    struct site_stats {
+        std::source_location site;               ///< Call site.
+        const char* name                  = "";  ///< Name of the scope.
+        std::uint64_t count               = 0;   ///< Number of profiled scopes.
+        std::uint64_t failures            = 0;   ///< Number of scopes exited via an exception.
+        std::int64_t max_peak_heap_growth = 0;   ///< Largest peak heap growth.
+        std::int64_t max_peak_rss_growth  = 0;   ///< Largest peak RSS growth.
+        std::int64_t heap_delta           = 0;   ///< Sum of heap deltas.
+        std::int64_t rss_delta            = 0;   ///< Sum of RSS deltas.
+        std::int64_t minor_faults         = 0;   ///< Sum of minor page faults.
+        std::int64_t major_faults         = 0;   ///< Sum of major page faults.
+    };
+
+    /**
+     * @brief Adds a report.
+     *
+     * @param r Report.
+     */
+    void operator()(const memory_report& r) noexcept
+    {
+        const std::lock_guard lock(this->m_mutex);
+        try {
+            auto [it, inserted] = this->m_sites.try_emplace(key(r.site), site_stats{r.site, r.name});
+            site_stats& s       = it->second;
+            const auto d        = r.delta();
+            ++s.count;
+            s.failures += r.failed ? 1 : 0;
+            s.max_peak_heap_growth = std::max(s.max_peak_heap_growth, r.peak_heap_growth());
+            s.max_peak_rss_growth  = std::max(s.max_peak_rss_growth, r.peak_rss_growth());
+            s.heap_delta += d.heap_in_use;
+            s.rss_delta += d.rss;
+            s.minor_faults += d.minor_faults;
+            s.major_faults += d.major_faults;
+        }
+        catch (const std::bad_alloc&) {  // NOLINT(bugprone-empty-catch)
+            // The report is lost
+        }
+    }
+
+    /**
+     * @brief Returns the aggregated statistics, sorted by the largest peak heap growth.
+     *
+     * @return Statistics by call site.
+     */
+    [[nodiscard]] std::vector<site_stats> sites() const
+    {
+        std::vector<site_stats> result;
+        {
+            const std::lock_guard lock(this->m_mutex);
+            result.reserve(this->m_sites.size());
+            for (const auto& [k, s] : this->m_sites) {
+                result.push_back(s);
+            }
+        }
+
+        std::ranges::stable_sort(result, std::ranges::greater{}, &site_stats::max_peak_heap_growth);
+        return result;
+    }
+
+    /**
+     * @brief Writes the aggregated statistics as a text table.
+     *
+     * @param os Output stream.
+     */
+    void write(std::ostream& os) const
+    {
+        os << "count  failed  peak_heap_growth  peak_rss_growth  heap_delta  rss_delta  minflt  majflt  site\n";
+        for (const site_stats& s : this->sites()) {
+            os << std::setw(5) << s.count << "  " << std::setw(6) << s.failures << "  " << std::setw(16)
+               << s.max_peak_heap_growth << "  " << std::setw(15) << s.max_peak_rss_growth << "  " << std::setw(10)
+               << s.heap_delta << "  " << std::setw(9) << s.rss_delta << "  " << std::setw(6) << s.minor_faults << "  "
+               << std::setw(6) << s.major_faults << "  " << s.site.file_name() << ':' << s.site.line();
+            if (*s.name != '\0') {
+                os << " (" << s.name << ')';
+            }
+
+            os << '\n';
+        }
+    }
+
+private:
+    using key_type = std::tuple<std::string_view, std::uint_least32_t, std::uint_least32_t>;
+
+    mutable std::mutex m_mutex;              ///< Protects `m_sites`.
+    std::map<key_type, site_stats> m_sites;  ///< Statistics by call site.
+
+    static key_type key(const std::source_location& site) noexcept
+    {
+        return {site.file_name(), site.line(), site.column()};
+    }
+};
+
+}  // namespace wwa::utils
+
+#endif /* FF022E37_89BC_4B84_87D6_3B4CFAF5D351 */
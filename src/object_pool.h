@@ -0,0 +1,364 @@
+#ifndef E3558581_6DD0_4AD6_BB99_3DC067B9BF8C
+#define E3558581_6DD0_4AD6_BB99_3DC067B9BF8C
+
+/**
+ * @file
+ * @brief Lock-free pool of reusable objects with scoped leases.
+ *
+ * This file provides `object_pool`, which recycles expensive objects (parsers, compression contexts, large buffers).
+ * `acquire()` returns a `lease`; when the lease goes out of scope, the object is optionally reset and returned to the
+ * pool. If the scope is exited via an exception, or `discard()` has been called, the object might be in an
+ * inconsistent state, and it is destroyed instead; a fresh object is created when needed.
+ *
+ * Each thread caches a few free objects in its own magazine, so acquiring and returning an object usually takes no
+ * atomic read-modify-write operations at all. Magazines overflow into, and refill from, a global lock-free stack.
+ *
+ * Usage example:
+ * @code{.cpp}
+ * wwa::utils::object_pool<parser> parsers(64, [] { return std::make_unique<parser>(config); }, &parser::reset);
+ *
+ * void handle(std::string_view input)
+ * {
+ *     auto p = parsers.acquire();
+ *     p->parse(input);  // If this throws, the parser is destroyed rather than returned to the pool
+ * }  // The parser is reset and returned to the pool here
+ * @endcode
+ */
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "thread_index.h"
+
+namespace wwa::utils {
+
+/**
+ * @brief A pool of reusable objects.
+ *
+ * The pool holds at most `capacity` objects, which are created lazily by the factory. When all of them are leased (or
+ * cached by other threads), `acquire()` creates a transient object, which is destroyed when its lease ends. All leases
+ * must end before the pool is destroyed.
+ *
+ * @tparam T Object type.
+ */
+template<typename T>
+class object_pool {
+    /// @cond INTERNAL
+    static constexpr std::uint32_t npos          = std::numeric_limits<std::uint32_t>::max();
+    static constexpr std::size_t magazine_size   = 8;
+    static constexpr std::size_t cache_line_size = 64;
+
+    struct slot {
+        std::unique_ptr<T> object;        ///< The object; `nullptr` until created, or after it has been discarded.
+        std::atomic<std::uint32_t> next;  ///< Next free slot in the global stack.
+    };
+
+    struct alignas(cache_line_size) magazine {
+        std::size_t count = 0;                           ///< Number of cached slots.
+        std::array<std::uint32_t, magazine_size> items;  ///< Cached slot indices.
+    };
+    /// @endcond
+
+public:
+    /// @brief Factory that creates pooled objects.
+    using factory_type = std::function<std::unique_ptr<T>()>;
+
+    /// @brief Function that resets an object before it is returned to the pool.
+    using reset_type = std::function<void(T&)>;
+
+    /**
+     * @brief Exclusive access to a pooled object.
+     *
+     * When the lease is destroyed, the object is reset and returned to the pool. If the lease is destroyed due to
+     * stack unwinding caused by an exception, `discard()` has been called, or the reset function throws, the object is
+     * destroyed instead.
+     *
+     * @note Constructing a `lease` of dynamic storage duration might lead to unexpected behavior.
+     */
+    class [[nodiscard("The object must be used to return the object to the pool.")]] lease {
+    public:
+        /** @cond */
+        lease(const lease&)            = delete;
+        lease(lease&&)                 = delete;
+        lease& operator=(const lease&) = delete;
+        lease& operator=(lease&&)      = delete;
+        /** @endcond */
+
+        /**
+         * @brief Returns the object to the pool, or destroys it.
+         */
+        ~lease() noexcept
+        {
+            const bool failed = this->m_discarded || std::uncaught_exceptions() > this->m_uncaught_exceptions_count;
+            this->m_pool->give_back(this->m_index, this->m_transient, failed);
+        }
+
+        /**
+         * @brief Returns the leased object.
+         *
+         * @return Reference to the object.
+         */
+        [[nodiscard]] T& operator*() const noexcept { return *this->m_object; }
+
+        /**
+         * @brief Accesses the leased object.
+         *
+         * @return Pointer to the object.
+         */
+        [[nodiscard]] T* operator->() const noexcept { return this->m_object; }
+
+        /**
+         * @brief Returns the leased object.
+         *
+         * @return Pointer to the object.
+         */
+        [[nodiscard]] T* get() const noexcept { return this->m_object; }
+
+        /**
+         * @brief Marks the object as possibly corrupted: it will be destroyed rather than returned to the pool.
+         */
+        void discard() noexcept { this->m_discarded = true; }
+
+    private:
+        friend class object_pool;
+
+        object_pool* m_pool;                                           ///< The pool.
+        std::uint32_t m_index;                                         ///< Slot index, or `npos` if transient.
+        std::unique_ptr<T> m_transient;                                ///< Object that does not fit into the pool.
+        T* m_object;                                                   ///< The object.
+        int m_uncaught_exceptions_count = std::uncaught_exceptions();  ///< The counter of uncaught exceptions.
+        bool m_discarded                = false;                       ///< Whether `discard()` has been called.
+
+        lease(object_pool* pool, std::uint32_t index, std::unique_ptr<T> transient) noexcept
+            : m_pool(pool), m_index(index), m_transient(std::move(transient)),
+              m_object(index != npos ? pool->m_slots[index].object.get() : this->m_transient.get())
+        {}
+    };
+
+    /**
+     * @brief Constructs a pool.
+     *
+     * @param capacity Maximum number of pooled objects.
+     * @param factory Creates objects; by default, `std::make_unique<T>()`.
+     * @param reset Resets an object before it is returned to the pool; optional.
+     * @throw std::invalid_argument @a capacity is too large, or @a factory is empty and `T` is not
+     * default-constructible.
+     * @throw std::bad_alloc Memory allocation failed.
+     */
+    explicit object_pool(std::size_t capacity, factory_type factory = {}, reset_type reset = {})
+        : m_slots(make_slots(capacity)), m_capacity(capacity), m_factory(make_factory(std::move(factory))),
+          m_reset(std::move(reset)), m_magazines(std::make_unique<magazine[]>(detail::thread_index::max_threads)),
+          m_head(pack(0, capacity != 0 ? 0 : npos))
+    {}
+
+    /** @cond */
+    object_pool(const object_pool&)            = delete;
+    object_pool(object_pool&&)                 = delete;
+    object_pool& operator=(const object_pool&) = delete;
+    object_pool& operator=(object_pool&&)      = delete;
+    ~object_pool()                             = default;
+    /** @endcond */
+
+    /**
+     * @brief Returns the maximum number of pooled objects.
+     *
+     * @return Capacity of the pool.
+     */
+    [[nodiscard]] std::size_t capacity() const noexcept { return this->m_capacity; }
+
+    /**
+     * @brief Leases an object, creating it if necessary.
+     *
+     * @return Lease.
+     * @throw anything Any exception thrown by the factory.
+     */
+    [[nodiscard]] lease acquire()
+    {
+        const std::uint32_t index = this->take();
+        if (index == npos) [[unlikely]] {
+            return lease(this, npos, this->create());
+        }
+
+        auto& object = this->m_slots[index].object;
+        if (!object) [[unlikely]] {
+            try {
+                object = this->create();
+            }
+            catch (...) {
+                this->push(index);
+                throw;
+            }
+        }
+
+        return lease(this, index, nullptr);
+    }
+
+private:
+    std::unique_ptr<slot[]> m_slots;          ///< Slots of pooled objects.
+    std::size_t m_capacity;                   ///< Number of slots.
+    factory_type m_factory;                   ///< Creates objects.
+    reset_type m_reset;                       ///< Resets objects; may be empty.
+    std::unique_ptr<magazine[]> m_magazines;  ///< Per-thread caches of free slots, by thread index.
+
+    /// @brief Top of the global stack: ABA tag and slot index.
+    alignas(cache_line_size) std::atomic<std::uint64_t> m_head;
+
+    /**
+     * @brief Packs the top of the global stack.
+     *
+     * @param tag Number of updates of the top, to prevent the ABA problem.
+     * @param index Slot index, or `npos` if the stack is empty.
+     * @return Packed value.
+     */
+    static constexpr std::uint64_t pack(std::uint64_t tag, std::uint32_t index) noexcept
+    {
+        return (tag << 32U) | index;
+    }
+
+    static std::unique_ptr<slot[]> make_slots(std::size_t capacity)
+    {
+        if (capacity >= npos) {
+            throw std::invalid_argument("object_pool: capacity is too large");
+        }
+
+        // Initially, all slots are free and empty, linked in order
+        auto slots = std::make_unique<slot[]>(capacity);
+        for (std::size_t i = 0; i < capacity; ++i) {
+            slots[i].next.store(i + 1 < capacity ? static_cast<std::uint32_t>(i + 1) : npos, std::memory_order_relaxed);
+        }
+
+        return slots;
+    }
+
+    static factory_type make_factory(factory_type factory)
+    {
+        if (factory) {
+            return factory;
+        }
+
+        if constexpr (std::is_default_constructible_v<T>) {
+            return []() { return std::make_unique<T>(); };
+        }
+        else {
+            throw std::invalid_argument("object_pool: a factory is required");
+        }
+    }
+
+    std::unique_ptr<T> create() { return this->m_factory(); }
+
+    /**
+     * @brief Takes a free slot from the magazine of the calling thread, or from the global stack.
+     *
+     * @return Slot index, or `npos` if there are no free slots.
+     */
+    std::uint32_t take() noexcept
+    {
+        if (const auto tid = detail::thread_index::get(); tid != detail::thread_index::none) [[likely]] {
+            magazine& m = this->m_magazines[tid];
+            if (m.count != 0) {
+                return m.items[--m.count];
+            }
+        }
+
+        return this->pop();
+    }
+
+    /**
+     * @brief Returns an object at the end of its lease.
+     *
+     * @param index Slot index, or `npos` for a transient object.
+     * @param transient The transient object.
+     * @param failed Whether the object must be destroyed.
+     */
+    void give_back(std::uint32_t index, std::unique_ptr<T>& transient, bool failed) noexcept
+    {
+        if (index == npos) {
+            transient.reset();
+            return;
+        }
+
+        auto& object = this->m_slots[index].object;
+        if (!failed && this->m_reset) {
+            try {
+                this->m_reset(*object);
+            }
+            catch (...) {
+                failed = true;
+            }
+        }
+
+        if (failed) {
+            object.reset();
+        }
+
+        if (const auto tid = detail::thread_index::get(); tid != detail::thread_index::none) [[likely]] {
+            magazine& m = this->m_magazines[tid];
+            if (m.count == magazine_size) {
+                // Flush half of the magazine so that alternating releases and acquisitions stay thread-local
+                for (std::size_t i = magazine_size / 2; i < magazine_size; ++i) {
+                    this->push(m.items[i]);
+                }
+
+                m.count = magazine_size / 2;
+            }
+
+            m.items[m.count++] = index;
+            return;
+        }
+
+        this->push(index);
+    }
+
+    /**
+     * @brief Pops a slot from the global stack.
+     *
+     * @return Slot index, or `npos` if the stack is empty.
+     */
+    std::uint32_t pop() noexcept
+    {
+        std::uint64_t head = this->m_head.load(std::memory_order_acquire);
+        for (;;) {
+            const auto index = static_cast<std::uint32_t>(head);
+            if (index == npos) {
+                return npos;
+            }
+
+            // `next` may be concurrently rewritten if the slot is popped and pushed again; the tag catches that
+            const std::uint32_t next = this->m_slots[index].next.load(std::memory_order_relaxed);
+            if (this->m_head.compare_exchange_weak(
+                    head, pack((head >> 32U) + 1, next), std::memory_order_acquire, std::memory_order_acquire
+                ))
+            {
+                return index;
+            }
+        }
+    }
+
+    /**
+     * @brief Pushes a slot onto the global stack.
+     *
+     * @param index Slot index.
+     */
+    void push(std::uint32_t index) noexcept
+    {
+        std::uint64_t head = this->m_head.load(std::memory_order_relaxed);
+        do {
+            this->m_slots[index].next.store(static_cast<std::uint32_t>(head), std::memory_order_relaxed);
+        } while (!this->m_head.compare_exchange_weak(
+            head, pack((head >> 32U) + 1, index), std::memory_order_release, std::memory_order_relaxed
+        ));
+    }
+};
+
+}  // namespace wwa::utils
+
+#endif /* E3558581_6DD0_4AD6_BB99_3DC067B9BF8C */
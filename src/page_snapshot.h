@@ -0,0 +1,420 @@
+#ifndef F6B7D1D9_209C_4F2B_AEA3_EAD4C044648E
+#define F6B7D1D9_209C_4F2B_AEA3_EAD4C044648E
+
+/**
+ * @file
+ * @brief Lazy copy-on-write snapshots of large memory regions.
+ *
+ * This file provides `page_snapshot`, a scope guard that makes it possible to restore a large buffer on failure
+ * without copying it up front. On construction, the region is write-protected with `mprotect()`. The first write to
+ * each page raises a protection fault; the fault handler copies the page aside, makes it writable again, and the
+ * faulting instruction is restarted. When the scope is exited via an exception, only the pages that have been written
+ * to are copied back; when it is exited normally, the saved pages are simply released.
+ *
+ * The cost of a snapshot is thus proportional to the number of modified pages rather than to the size of the region:
+ * a fault and a page copy per modified page, and two `mprotect()` calls over the whole region.
+ *
+ * Usage example:
+ * @code{.cpp}
+ * std::span<std::byte> heap = arena.region();  // Page-aligned, e.g. obtained with mmap()
+ * {
+ *     wwa::utils::page_snapshot snapshot(heap);
+ *     arena.compact();  // If this throws, all pages written to are restored
+ * }
+ * @endcode
+ *
+ * @note This header requires a POSIX system. The snapshot installs a process-wide `SIGSEGV` (and `SIGBUS`) handler,
+ * which forwards faults outside of snapshotted regions to the previously installed handler.
+ */
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "exit_action.h"
+#include "fail_action.h"
+#include "fault_filter.h"
+#include "posix_error.h"
+#include "success_action.h"
+
+namespace wwa::utils {
+
+/**
+ * @brief A scope guard that lazily saves the pages of a region on their first write and restores them on failure.
+ *
+ * The region must be page-aligned, readable and writable, and must not overlap with the region of another active
+ * snapshot. It may be written to by several threads while the snapshot is active; however, it must not be accessed
+ * while the snapshot is being committed or rolled back.
+ *
+ * Only stores made by user-space code are tracked. A system call that writes into a protected page (such as `read()`,
+ * `pread()`, or `recv()` into a buffer inside the region) does not raise a fault: it fails with `EFAULT` instead. Do
+ * not pass an active snapshot's pages to system calls as output buffers; read into a buffer outside the region and
+ * copy the data, or write to the pages from user space first so that they are saved and made writable.
+ *
+ * The fault handler is installed with `SA_ONSTACK`: it runs on the alternate signal stack of the thread if the thread
+ * has one (see `sigaltstack()`), and on the current stack otherwise. The snapshot does not set up an alternate stack;
+ * threads that need to handle stack overflows must provide their own.
+ *
+ * @note Constructing a `page_snapshot` of dynamic storage duration might lead to unexpected behavior.
+ */
+class [[nodiscard("The object must be used to restore the region on failure.")]] page_snapshot {
+    /// @cond INTERNAL
+    using word_type = std::atomic<std::uint64_t>;
+    static_assert(word_type::is_always_lock_free, "The fault handler requires lock-free atomics");
+
+    struct unmap_fn {
+        void* address;
+        std::size_t size;
+        void operator()() const noexcept { ::munmap(this->address, this->size); }
+    };
+
+    struct commit_fn {
+        page_snapshot* snapshot;
+        void operator()() const noexcept { this->snapshot->commit(); }
+    };
+
+    struct rollback_fn {
+        page_snapshot* snapshot;
+        void operator()() const noexcept { this->snapshot->rollback(); }
+    };
+    /// @endcond
+
+public:
+    /// @brief Maximum number of simultaneously active snapshots in the process.
+    static constexpr std::size_t max_snapshots = 64;
+
+    /**
+     * @brief Write-protects @a region and starts tracking writes to it.
+     *
+     * @param region The region to protect. Its address and size must be multiples of the page size.
+     * @throw std::invalid_argument @a region is not page-aligned, or overlaps with the region of an active snapshot.
+     * @throw std::length_error There are already `max_snapshots` active snapshots.
+     * @throw std::system_error A system call failed.
+     * @throw std::bad_alloc Memory allocation failed.
+     */
+    explicit page_snapshot(std::span<std::byte> region)
+        : m_begin(region.data()), m_size(region.size()), m_page_size(page_size()), m_shadow(map_shadow(region)),
+          m_unmap(unmap_fn{this->m_shadow, this->m_size}), m_saved(std::make_unique<word_type[]>(this->words())),
+          m_on_fail(rollback_fn{this}), m_on_success(commit_fn{this})
+    {
+        this->attach();
+        auto detach = fail_action([this]() noexcept { this->detach(); });
+        if (::mprotect(this->m_begin, this->m_size, PROT_READ) == -1) {
+            detail::throw_errno("mprotect");
+        }
+
+        this->m_active = true;
+    }
+
+    /** @cond */
+    page_snapshot(const page_snapshot&)            = delete;
+    page_snapshot(page_snapshot&&)                 = delete;
+    page_snapshot& operator=(const page_snapshot&) = delete;
+    page_snapshot& operator=(page_snapshot&&)      = delete;
+    ~page_snapshot() noexcept                      = default;
+    /** @endcond */
+
+    /**
+     * @brief Returns the number of pages saved so far.
+     *
+     * @return Number of pages written to since the snapshot was taken.
+     */
+    [[nodiscard]] std::size_t touched() const noexcept { return this->m_touched.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Returns the system page size.
+     *
+     * @return Page size in bytes.
+     */
+    [[nodiscard]] static std::size_t page_size() noexcept
+    {
+        static const auto size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        return size;
+    }
+
+    /**
+     * @brief Keeps the modifications: unprotects the region and stops tracking it.
+     *
+     * The snapshot becomes inactive; the saved pages are released when it is destroyed.
+     */
+    void commit() noexcept
+    {
+        if (this->m_active) {
+            this->finish();
+        }
+    }
+
+    /**
+     * @brief Restores the pages written to, unprotects the region and stops tracking it.
+     *
+     * The snapshot becomes inactive.
+     */
+    void rollback() noexcept
+    {
+        if (!this->m_active) {
+            return;
+        }
+
+        for (std::size_t w = 0; w < this->words(); ++w) {
+            for (auto bits = this->m_saved[w].load(std::memory_order_acquire); bits != 0; bits &= bits - 1) {
+                const auto page   = w * 64 + static_cast<std::size_t>(std::countr_zero(bits));
+                const auto offset = page * this->m_page_size;
+                std::memcpy(this->m_begin + offset, this->m_shadow + offset, this->m_page_size);
+            }
+        }
+
+        this->finish();
+    }
+
+private:
+    /// @cond INTERNAL
+    struct registry {
+        std::mutex mutex;                                                ///< Serializes attaching and detaching.
+        std::array<std::atomic<page_snapshot*>, max_snapshots> slots{};  ///< Active snapshots.
+        struct sigaction previous_segv{};                                ///< Previous `SIGSEGV` action.
+        struct sigaction previous_bus{};                                 ///< Previous `SIGBUS` action.
+        bool installed = false;                                          ///< Whether the fault handler is installed.
+    };
+
+    static registry s_registry;  ///< Active snapshots and the fault handler state.
+    /// @endcond
+
+    std::byte* m_begin;                      ///< Start of the region.
+    std::size_t m_size;                      ///< Size of the region.
+    std::size_t m_page_size;                 ///< Page size.
+    std::byte* m_shadow;                     ///< Copies of the saved pages, at the same offsets as in the region.
+    exit_action<unmap_fn> m_unmap;           ///< Releases the shadow mapping.
+    std::unique_ptr<word_type[]> m_saved;    ///< Bitmap of the saved pages.
+    std::atomic<std::size_t> m_touched{0};   ///< Number of saved pages.
+    bool m_active = false;                   ///< Whether the region is protected and tracked.
+    fail_action<rollback_fn> m_on_fail;      ///< Restores the region on failure.
+    success_action<commit_fn> m_on_success;  ///< Keeps the modifications on success.
+
+    /**
+     * @brief Validates @a region and reserves address space for the copies of its pages.
+     *
+     * Physical memory is only used for the pages that are actually saved.
+     *
+     * @param region The region to protect.
+     * @return Shadow mapping of the same size as @a region.
+     */
+    static std::byte* map_shadow(std::span<std::byte> region)
+    {
+        const auto page    = page_size();
+        const auto address = reinterpret_cast<std::uintptr_t>(region.data());
+        if (region.empty() || address % page != 0 || region.size() % page != 0) {
+            throw std::invalid_argument("page_snapshot: the region must be page-aligned");
+        }
+
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+        flags |= MAP_NORESERVE;
+#endif
+
+        void* map = ::mmap(nullptr, region.size(), PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (map == MAP_FAILED) {  // NOLINT(*-cstyle-cast,performance-no-int-to-ptr)
+            detail::throw_errno("mmap");
+        }
+
+        return static_cast<std::byte*>(map);
+    }
+
+    /**
+     * @brief Returns the size of the bitmap of the saved pages.
+     *
+     * @return Number of bitmap words.
+     */
+    [[nodiscard]] std::size_t words() const noexcept { return (this->m_size / this->m_page_size + 63) / 64; }
+
+    /**
+     * @brief Registers the snapshot with the fault handler, installing the handler on first use.
+     */
+    void attach()
+    {
+        const std::lock_guard lock(s_registry.mutex);
+
+        std::atomic<page_snapshot*>* free_slot = nullptr;
+        for (auto& slot : s_registry.slots) {
+            const page_snapshot* other = slot.load(std::memory_order_relaxed);
+            if (other == nullptr) {
+                free_slot = free_slot != nullptr ? free_slot : &slot;
+            }
+            else if (this->m_begin < other->m_begin + other->m_size && other->m_begin < this->m_begin + this->m_size) {
+                throw std::invalid_argument("page_snapshot: the region overlaps with an active snapshot");
+            }
+        }
+
+        if (free_slot == nullptr) {
+            throw std::length_error("page_snapshot: too many active snapshots");
+        }
+
+        if (!s_registry.installed) {
+            struct sigaction action{};
+            action.sa_sigaction = &page_snapshot::on_fault;
+            action.sa_flags     = SA_SIGINFO | SA_ONSTACK | SA_RESTART;
+            sigemptyset(&action.sa_mask);
+            if (::sigaction(SIGSEGV, &action, &s_registry.previous_segv) == -1 ||
+                ::sigaction(SIGBUS, &action, &s_registry.previous_bus) == -1) {
+                detail::throw_errno("sigaction");
+            }
+
+            s_registry.installed = true;
+            detail::recoverable_fault_filter.store(&page_snapshot::is_snapshot_fault, std::memory_order_release);
+        }
+
+        free_slot->store(this, std::memory_order_release);
+    }
+
+    /**
+     * @brief Unregisters the snapshot. The fault handler remains installed.
+     */
+    void detach() noexcept
+    {
+        const std::lock_guard lock(s_registry.mutex);
+        for (auto& slot : s_registry.slots) {
+            if (slot.load(std::memory_order_relaxed) == this) {
+                slot.store(nullptr, std::memory_order_release);
+                break;
+            }
+        }
+    }
+
+    /**
+     * @brief Unprotects the region and unregisters the snapshot.
+     */
+    void finish() noexcept
+    {
+        this->m_active = false;
+        ::mprotect(this->m_begin, this->m_size, PROT_READ | PROT_WRITE);
+        this->detach();
+    }
+
+    /**
+     * @brief Saves the page containing @a address and makes it writable.
+     *
+     * Called from the fault handler; must be async-signal-safe.
+     *
+     * @param address Faulting address, within the region.
+     * @return Whether the fault has been handled.
+     */
+    bool save_page(const std::byte* address) noexcept
+    {
+        const auto page = static_cast<std::size_t>(address - this->m_begin) / this->m_page_size;
+        const auto bit  = std::uint64_t{1} << (page % 64);
+        if ((this->m_saved[page / 64].fetch_or(bit, std::memory_order_acq_rel) & bit) != 0) {
+            // Another thread is saving this page; the write is retried once the page has become writable
+            return true;
+        }
+
+        std::byte* target = this->m_begin + page * this->m_page_size;
+        std::memcpy(this->m_shadow + page * this->m_page_size, target, this->m_page_size);
+        this->m_touched.fetch_add(1, std::memory_order_relaxed);
+        return ::mprotect(target, this->m_page_size, PROT_READ | PROT_WRITE) == 0;
+    }
+
+    /**
+     * @brief Finds the snapshot a fault belongs to. Async-signal-safe.
+     *
+     * @param signo Signal number.
+     * @param info Signal information.
+     * @return The snapshot whose region contains the faulting address, or `nullptr`.
+     */
+    static page_snapshot* find_snapshot(int signo, const siginfo_t* info) noexcept
+    {
+        if (signo == SIGSEGV && info->si_code != SEGV_ACCERR) {
+            return nullptr;
+        }
+
+        const auto* address = static_cast<const std::byte*>(info->si_addr);
+        for (const auto& slot : s_registry.slots) {
+            page_snapshot* snapshot = slot.load(std::memory_order_acquire);
+            if (snapshot != nullptr && address >= snapshot->m_begin && address < snapshot->m_begin + snapshot->m_size) {
+                return snapshot;
+            }
+        }
+
+        return nullptr;
+    }
+
+    /**
+     * @brief Tells other fault handlers whether a fault is a write to a snapshotted region. Async-signal-safe.
+     *
+     * @param signo Signal number.
+     * @param info Signal information.
+     * @return Whether the fault belongs to an active snapshot.
+     */
+    static bool is_snapshot_fault(int signo, const siginfo_t* info) noexcept
+    {
+        return find_snapshot(signo, info) != nullptr;
+    }
+
+    /**
+     * @brief `SIGSEGV` and `SIGBUS` handler.
+     *
+     * Saves the page if the fault is a write to a snapshotted region; forwards the signal to the previous handler
+     * otherwise.
+     *
+     * @param signo Signal number.
+     * @param info Signal information.
+     * @param context Machine context.
+     */
+    static void on_fault(int signo, siginfo_t* info, void* context)
+    {
+        const int saved_errno = errno;
+
+        bool handled = false;
+        if (page_snapshot* snapshot = find_snapshot(signo, info); snapshot != nullptr) {
+            handled = snapshot->save_page(static_cast<const std::byte*>(info->si_addr));
+        }
+
+        errno = saved_errno;
+        if (!handled) {
+            forward(signo, info, context);
+        }
+    }
+
+    /**
+     * @brief Passes a fault that does not belong to any snapshot to the previously installed handler.
+     *
+     * @param signo Signal number.
+     * @param info Signal information.
+     * @param context Machine context.
+     */
+    static void forward(int signo, siginfo_t* info, void* context)
+    {
+        const struct sigaction& previous = signo == SIGSEGV ? s_registry.previous_segv : s_registry.previous_bus;
+        if ((previous.sa_flags & SA_SIGINFO) != 0) {
+            previous.sa_sigaction(signo, info, context);
+        }
+        else if (previous.sa_handler != SIG_DFL && previous.sa_handler != SIG_IGN) {  // NOLINT(*-cstyle-cast)
+            previous.sa_handler(signo);
+        }
+        else {
+            // Restore the default action; the faulting instruction is restarted and terminates the process
+            struct sigaction action{};
+            action.sa_handler = SIG_DFL;  // NOLINT(*-cstyle-cast)
+            sigemptyset(&action.sa_mask);
+            ::sigaction(signo, &action, nullptr);
+        }
+    }
+};
+
+/// @cond INTERNAL
+inline page_snapshot::registry page_snapshot::s_registry;
+/// @endcond
+
+}  // namespace wwa::utils
+
+#endif /* F6B7D1D9_209C_4F2B_AEA3_EAD4C044648E */
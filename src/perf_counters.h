@@ -0,0 +1,487 @@
+#ifndef FA985739_B967_4946_9B59_9B916C345761
+#define FA985739_B967_4946_9B59_9B916C345761
+
+/**
+ * @file
+ * @brief Hardware performance counters for code regions: cycles, instructions, cache misses, and branch misses.
+ *
+ * This file provides `perf_scope`, which reads the hardware performance counters of the calling thread when a scope
+ * is entered and exited, and accumulates the differences by call site in a `perf_profile`.
+ *
+ * The counters of each thread are a `perf_event_open()` group opened on first use and measuring user-space events
+ * only. Where the kernel allows it (`/sys/bus/event_source/devices/cpu/rdpmc`), they are read with the `rdpmc`
+ * instruction, without a system call; otherwise, with a single `read()` of the group.
+ *
+ * Counters that cannot be opened (no PMU, as in many virtual machines; `perf_event_paranoid` too high; seccomp
+ * filters) read as zero; scopes are still counted.
+ *
+ * Usage example:
+ * @code{.cpp}
+ * wwa::utils::perf_profile profile;
+ *
+ * void parse(std::string_view input)
+ * {
+ *     wwa::utils::perf_scope scope(profile, "parse");
+ *     // ...
+ * }
+ *
+ * profile.write(std::cerr);  // Cycles, instructions, IPC, cache and branch misses per call site
+ * @endcode
+ *
+ * @note This header requires Linux. Counters are not scaled when the kernel multiplexes them.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <source_location>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include <linux/perf_event.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "exit_action.h"
+
+#if !defined(WWA_PERF_USE_RDPMC)
+#    if defined(__x86_64__)
+#        define WWA_PERF_USE_RDPMC 1
+#    else
+#        define WWA_PERF_USE_RDPMC 0
+#    endif
+#endif
+
+namespace wwa::utils {
+
+/**
+ * @brief Values of the hardware performance counters.
+ */
+struct perf_values {
+    std::uint64_t cycles        = 0;  ///< CPU cycles.
+    std::uint64_t instructions  = 0;  ///< Retired instructions.
+    std::uint64_t cache_misses  = 0;  ///< Last-level cache misses.
+    std::uint64_t branch_misses = 0;  ///< Mispredicted branches.
+
+    /**
+     * @brief Returns the change between two readings.
+     *
+     * @param other Earlier reading.
+     * @return Difference of the counters.
+     */
+    [[nodiscard]] constexpr perf_values operator-(const perf_values& other) const noexcept
+    {
+        return {
+            this->cycles - other.cycles, this->instructions - other.instructions,
+            this->cache_misses - other.cache_misses, this->branch_misses - other.branch_misses
+        };
+    }
+
+    /**
+     * @brief Adds another set of values.
+     *
+     * @param other Values to add.
+     * @return `*this`.
+     */
+    constexpr perf_values& operator+=(const perf_values& other) noexcept
+    {
+        this->cycles += other.cycles;
+        this->instructions += other.instructions;
+        this->cache_misses += other.cache_misses;
+        this->branch_misses += other.branch_misses;
+        return *this;
+    }
+};
+
+/**
+ * @brief The hardware performance counters of the calling thread.
+ *
+ * The counters run from the first call to `this_thread()` in a thread until the thread exits.
+ */
+class perf_counters {
+public:
+    /// @brief Number of counters.
+    static constexpr std::size_t count = 4;
+
+    /**
+     * @brief Returns the counters of the calling thread, opening them on the first call.
+     *
+     * @return Counters.
+     */
+    static perf_counters& this_thread() noexcept
+    {
+        thread_local perf_counters counters;
+        return counters;
+    }
+
+    /** @cond */
+    perf_counters(const perf_counters&)            = delete;
+    perf_counters(perf_counters&&)                 = delete;
+    perf_counters& operator=(const perf_counters&) = delete;
+    perf_counters& operator=(perf_counters&&)      = delete;
+    /** @endcond */
+
+    /**
+     * @brief Closes the counters.
+     */
+    ~perf_counters() noexcept
+    {
+        for (auto& c : this->m_counters) {
+            if (c.page != nullptr) {
+                ::munmap(const_cast<perf_event_mmap_page*>(c.page), page_size());  // NOLINT(*-const-cast)
+            }
+
+            if (c.fd != -1) {
+                ::close(c.fd);
+            }
+        }
+    }
+
+    /**
+     * @brief Checks whether at least one counter could be opened.
+     *
+     * @return Whether the counters are available.
+     */
+    [[nodiscard]] bool available() const noexcept { return this->m_leader != -1; }
+
+    /**
+     * @brief Checks whether the counters are read with `rdpmc`.
+     *
+     * @return Whether all open counters allow user-space reads.
+     */
+    [[nodiscard]] bool uses_rdpmc() const noexcept
+    {
+        if (!this->available()) {
+            return false;
+        }
+
+        return std::ranges::all_of(this->m_counters, [](const counter& c) {
+            return c.fd == -1 || (c.page != nullptr && c.page->cap_user_rdpmc != 0);
+        });
+    }
+
+    /**
+     * @brief Reads the counters. Does not allocate.
+     *
+     * @return Values; counters that are not available read as zero.
+     */
+    [[nodiscard]] perf_values read() const noexcept
+    {
+        std::array<std::uint64_t, count> values{};
+        if (this->available() && !this->read_user(values)) {
+            this->read_group(values);
+        }
+
+        return {values[0], values[1], values[2], values[3]};
+    }
+
+private:
+    /// @cond INTERNAL
+    struct counter {
+        int fd                              = -1;       ///< Event file descriptor.
+        std::size_t position                = 0;        ///< Position in the group read.
+        volatile perf_event_mmap_page* page = nullptr;  ///< Metadata page for `rdpmc`.
+    };
+    /// @endcond
+
+    std::array<counter, count> m_counters;  ///< Counters, in the order of `perf_values`.
+    int m_leader          = -1;             ///< File descriptor of the group leader.
+    std::size_t m_members = 0;              ///< Number of open counters.
+
+    perf_counters() noexcept
+    {
+        static constexpr std::array<std::uint64_t, count> events = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+            PERF_COUNT_HW_BRANCH_MISSES
+        };
+
+        for (std::size_t i = 0; i < count; ++i) {
+            perf_event_attr attr{};
+            attr.type           = PERF_TYPE_HARDWARE;
+            attr.size           = sizeof(attr);
+            attr.config         = events[i];
+            attr.read_format    = PERF_FORMAT_GROUP;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv     = 1;
+
+            const auto fd = ::syscall(SYS_perf_event_open, &attr, 0, -1, this->m_leader, PERF_FLAG_FD_CLOEXEC);
+            if (fd == -1) {
+                continue;
+            }
+
+            counter& c = this->m_counters[i];
+            c.fd       = static_cast<int>(fd);
+            c.position = this->m_members++;
+            if (this->m_leader == -1) {
+                this->m_leader = c.fd;
+            }
+
+#if WWA_PERF_USE_RDPMC
+            void* page = ::mmap(nullptr, page_size(), PROT_READ, MAP_SHARED, c.fd, 0);
+            if (page != MAP_FAILED) {
+                c.page = static_cast<volatile perf_event_mmap_page*>(page);
+            }
+#endif
+        }
+    }
+
+    static std::size_t page_size() noexcept { return static_cast<std::size_t>(::sysconf(_SC_PAGESIZE)); }
+
+    /**
+     * @brief Reads the counters with `rdpmc`.
+     *
+     * @param values Receives the values.
+     * @return Whether all open counters could be read; if not, the group must be read with a system call.
+     */
+    bool read_user([[maybe_unused]] std::array<std::uint64_t, count>& values) const noexcept
+    {
+#if WWA_PERF_USE_RDPMC
+        for (std::size_t i = 0; i < count; ++i) {
+            const counter& c = this->m_counters[i];
+            if (c.fd == -1) {
+                continue;
+            }
+
+            if (c.page == nullptr || !read_pmc(c.page, values[i])) {
+                return false;
+            }
+        }
+
+        return true;
+#else
+        return false;
+#endif
+    }
+
+#if WWA_PERF_USE_RDPMC
+    /**
+     * @brief Reads a counter with `rdpmc`, using the protocol described in `linux/perf_event.h`.
+     *
+     * @param page Metadata page of the counter.
+     * @param value Receives the value.
+     * @return Whether the counter could be read; it cannot when it is not scheduled on the PMU.
+     */
+    static bool read_pmc(volatile perf_event_mmap_page* page, std::uint64_t& value) noexcept
+    {
+        std::uint32_t seq = 0;
+        do {
+            seq = page->lock;
+            __asm__ __volatile__("" ::: "memory");
+
+            const std::uint32_t index = page->index;
+            if (page->cap_user_rdpmc == 0 || index == 0) {
+                return false;
+            }
+
+            std::uint32_t lo = 0;
+            std::uint32_t hi = 0;
+            __asm__ __volatile__("rdpmc" : "=a"(lo), "=d"(hi) : "c"(index - 1));
+
+            // The hardware counter is `pmc_width` bits wide; sign-extend it before adding the kernel's offset
+            const unsigned int shift = 64U - page->pmc_width;
+            const auto pmc           = static_cast<std::int64_t>((std::uint64_t{hi} << 32U | lo) << shift) >> shift;
+            value                    = static_cast<std::uint64_t>(page->offset + pmc);
+
+            __asm__ __volatile__("" ::: "memory");
+        } while (page->lock != seq);
+
+        return true;
+    }
+#endif
+
+    /**
+     * @brief Reads the counters with one `read()` of the group.
+     *
+     * @param values Receives the values.
+     */
+    void read_group(std::array<std::uint64_t, count>& values) const noexcept
+    {
+        // Format: number of counters, then their values in the order they were added to the group
+        std::array<std::uint64_t, count + 1> buf{};
+        if (::read(this->m_leader, buf.data(), sizeof(buf)) <= 0) {
+            return;
+        }
+
+        for (std::size_t i = 0; i < count; ++i) {
+            const counter& c = this->m_counters[i];
+            if (c.fd != -1 && c.position < buf[0]) {
+                values[i] = buf[c.position + 1];
+            }
+        }
+    }
+};
+
+class perf_scope;
+
+/**
+ * @brief Hardware performance counters accumulated by call site.
+ *
+ * The profile must outlive all scopes that use it. It is thread-safe.
+ */
+class perf_profile {
+public:
+    /**
+     * @brief Accumulated counters of a call site.
+     */
+    struct site_stats {
+        std::source_location site;    ///< Call site.
+        const char* name       = "";  ///< Name of the scope.
+        std::uint64_t count    = 0;   ///< Number of scopes.
+        std::uint64_t failures = 0;   ///< Number of scopes exited via an exception.
+        perf_values total      = {};  ///< Sum of the counter deltas.
+    };
+
+    /**
+     * @brief Returns the accumulated counters, sorted by the number of cycles.
+     *
+     * @return Statistics by call site.
+     */
+    [[nodiscard]] std::vector<site_stats> sites() const
+    {
+        std::vector<site_stats> result;
+        {
+            const std::lock_guard lock(this->m_mutex);
+            result.reserve(this->m_sites.size());
+            for (const auto& [k, s] : this->m_sites) {
+                result.push_back(s);
+            }
+        }
+
+        std::ranges::stable_sort(result, std::ranges::greater{}, [](const site_stats& s) { return s.total.cycles; });
+        return result;
+    }
+
+    /**
+     * @brief Writes the accumulated counters as a text table, with per-scope averages.
+     *
+     * @param os Output stream.
+     */
+    void write(std::ostream& os) const
+    {
+        if (!perf_counters::this_thread().available()) {
+            os << "# hardware performance counters are not available\n";
+        }
+
+        os << "   count  failed      cycles/op  instructions/op   IPC  cache_misses/op  branch_misses/op  site\n";
+        const auto flags = os.flags();
+        os << std::fixed;
+        for (const site_stats& s : this->sites()) {
+            const auto n   = static_cast<double>(s.count);
+            const auto ipc = s.total.cycles != 0
+                                 ? static_cast<double>(s.total.instructions) / static_cast<double>(s.total.cycles)
+                                 : 0.0;
+
+            os << std::setw(8) << s.count << "  " << std::setw(6) << s.failures << "  " << std::setprecision(1)
+               << std::setw(13) << static_cast<double>(s.total.cycles) / n << "  " << std::setw(15)
+               << static_cast<double>(s.total.instructions) / n << "  " << std::setprecision(2) << std::setw(4) << ipc
+               << "  " << std::setprecision(1) << std::setw(15) << static_cast<double>(s.total.cache_misses) / n
+               << "  " << std::setw(16) << static_cast<double>(s.total.branch_misses) / n << "  "
+               << s.site.file_name() << ':' << s.site.line();
+            if (*s.name != '\0') {
+                os << " (" << s.name << ')';
+            }
+
+            os << '\n';
+        }
+
+        os.flags(flags);
+    }
+
+private:
+    friend class perf_scope;
+
+    using key_type = std::tuple<std::string_view, std::uint_least32_t, std::uint_least32_t>;
+
+    mutable std::mutex m_mutex;              ///< Protects `m_sites`.
+    std::map<key_type, site_stats> m_sites;  ///< Statistics by call site.
+
+    void add(const std::source_location& site, const char* name, const perf_values& delta, bool failed) noexcept
+    {
+        const std::lock_guard lock(this->m_mutex);
+        try {
+            auto [it, inserted] = this->m_sites.try_emplace(key(site), site_stats{site, name});
+            site_stats& s       = it->second;
+            ++s.count;
+            s.failures += failed ? 1 : 0;
+            s.total += delta;
+        }
+        catch (const std::bad_alloc&) {  // NOLINT(bugprone-empty-catch)
+            // The measurement is lost
+        }
+    }
+
+    static key_type key(const std::source_location& site) noexcept
+    {
+        return {site.file_name(), site.line(), site.column()};
+    }
+};
+
+/**
+ * @brief A scope whose hardware performance counters are accumulated in a `perf_profile`.
+ *
+ * The counters are read last on entry and first on exit, so that the bookkeeping of the scope is mostly not counted.
+ *
+ * @note Constructing a `perf_scope` of dynamic storage duration might lead to unexpected behavior.
+ */
+class [[nodiscard("The object must be used to measure the scope until its exit.")]] perf_scope {
+    /// @cond INTERNAL
+    struct record_fn {
+        perf_scope* scope;
+        void operator()() const noexcept { this->scope->record(); }
+    };
+    /// @endcond
+
+public:
+    /**
+     * @brief Reads the counters on scope entry.
+     *
+     * @param profile The profile.
+     * @param name Name of the scope; must be a string with static storage duration.
+     * @param site Call site; the profile accumulates counters by it.
+     */
+    explicit perf_scope(
+        perf_profile& profile, const char* name = "", std::source_location site = std::source_location::current()
+    ) noexcept
+        : m_profile(profile), m_counters(perf_counters::this_thread()), m_site(site), m_name(name),
+          m_on_exit(record_fn{this})
+    {
+        this->m_entry = this->m_counters.read();
+    }
+
+    /** @cond */
+    perf_scope(const perf_scope&)            = delete;
+    perf_scope(perf_scope&&)                 = delete;
+    perf_scope& operator=(const perf_scope&) = delete;
+    perf_scope& operator=(perf_scope&&)      = delete;
+    ~perf_scope() noexcept                   = default;
+    /** @endcond */
+
+private:
+    perf_profile& m_profile;                                       ///< The profile.
+    const perf_counters& m_counters;                               ///< Counters of the thread.
+    std::source_location m_site;                                   ///< Call site.
+    const char* m_name;                                            ///< Name of the scope.
+    int m_uncaught_exceptions_count = std::uncaught_exceptions();  ///< The counter of uncaught exceptions.
+    perf_values m_entry;                                           ///< Counters on scope entry.
+    exit_action<record_fn> m_on_exit;                              ///< Accumulates the counters on scope exit.
+
+    void record() noexcept
+    {
+        const perf_values exit = this->m_counters.read();
+        const bool failed      = std::uncaught_exceptions() > this->m_uncaught_exceptions_count;
+        this->m_profile.add(this->m_site, this->m_name, exit - this->m_entry, failed);
+    }
+};
+
+}  // namespace wwa::utils
+
+#endif /* FA985739_B967_4946_9B59_9B916C345761 */
@@ -0,0 +1,35 @@
+#ifndef A431E899_EB6F_4BDC_9FE8_7E05744B2926
+#define A431E899_EB6F_4BDC_9FE8_7E05744B2926
+
+/**
+ * @file
+ * @brief Error reporting helpers for the POSIX-only utilities.
+ * @internal
+ */
+
+#include <cerrno>
+#include <system_error>
+
+namespace wwa::utils {
+
+/// @cond INTERNAL
+
+namespace detail {
+
+/**
+ * @brief Throws `std::system_error` for the current `errno`.
+ *
+ * @param what Description of the failed operation.
+ */
+[[noreturn]] inline void throw_errno(const char* what)
+{
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+}  // namespace detail
+
+/// @endcond
+
+}  // namespace wwa::utils
+
+#endif /* A431E899_EB6F_4BDC_9FE8_7E05744B2926 */
@@ -0,0 +1,331 @@
+#ifndef E84C1B27_9F3A_4D06_B5E2_71C0A9D34F18
+#define E84C1B27_9F3A_4D06_B5E2_71C0A9D34F18
+
+/**
+ * @file
+ * @brief Redo log for staged writes that become visible only on success.
+ *
+ * This file provides `redo_log`, a write buffer that keeps new values of objects aside instead of writing them in
+ * place. Code holding the log can read its own writes with `redo_log::read()`; other code keeps seeing the old values
+ * until the log is committed, at which point all buffered writes are applied in a single pass, in write order.
+ * Discarding the log takes constant time.
+ *
+ * `redo_log::transaction` is a scope guard built on `success_action` and `fail_action`: it commits the log when its
+ * scope is exited normally, and discards it when the scope is exited via an exception.
+ *
+ * Usage example:
+ * @code{.cpp}
+ * wwa::utils::redo_log log;
+ * {
+ *     auto tx = log.begin();
+ *     log.write(limits.max_rps, 1000);
+ *     log.write(limits.burst, log.read(limits.max_rps) / 10);
+ *     validate(log.read(limits.burst));  // If this throws, nothing is written
+ * }  // Both fields are updated here
+ * @endcode
+ */
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include "fail_action.h"
+#include "success_action.h"
+
+namespace wwa::utils {
+
+/**
+ * @brief A redo log (write buffer) for trivially copyable values.
+ *
+ * Buffered writes are indexed by the target address using an open-addressing hash table whose entries are
+ * invalidated by bumping a generation counter; thus, `discard()` does not depend on the number of buffered writes.
+ *
+ * @note An object must always be accessed through the log with the same type. The log is not thread-safe.
+ */
+class redo_log {
+    /// @cond INTERNAL
+    struct entry {
+        void* address;       ///< Target address.
+        std::size_t offset;  ///< Offset of the new value in the data buffer.
+        std::size_t size;    ///< Size of the new value.
+    };
+
+    struct slot {
+        const void* key;           ///< Target address.
+        std::uint32_t generation;  ///< Generation the slot belongs to; stale slots are empty.
+        std::uint32_t index;       ///< Entry index.
+    };
+
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+    /// @endcond
+
+public:
+    /**
+     * @brief A transaction scope.
+     *
+     * Commits the log when the scope is exited normally, and discards it when the scope is exited via an exception.
+     *
+     * @note Constructing a `transaction` of dynamic storage duration might lead to unexpected behavior.
+     */
+    class [[nodiscard("The object must be used to commit the log on success.")]] transaction {
+        /// @cond INTERNAL
+        struct commit_fn {
+            redo_log* log;
+            void operator()() const noexcept { this->log->commit(); }
+        };
+
+        struct discard_fn {
+            redo_log* log;
+            void operator()() const noexcept { this->log->discard(); }
+        };
+        /// @endcond
+
+    public:
+        /**
+         * @brief Starts a transaction.
+         *
+         * @param log The redo log.
+         */
+        explicit transaction(redo_log& log) noexcept : m_on_success(commit_fn{&log}), m_on_fail(discard_fn{&log}) {}
+
+        /**
+         * @brief Makes the transaction inactive: it will neither commit nor discard the log on scope exit.
+         */
+        void release() noexcept
+        {
+            this->m_on_success.release();
+            this->m_on_fail.release();
+        }
+
+    private:
+        success_action<commit_fn> m_on_success;  ///< Commits the log on success.
+        fail_action<discard_fn> m_on_fail;       ///< Discards the log on failure.
+    };
+
+    /**
+     * @brief Constructs an empty redo log.
+     */
+    redo_log() = default;
+
+    /** @cond */
+    redo_log(const redo_log&)            = delete;
+    redo_log(redo_log&&)                 = delete;
+    redo_log& operator=(const redo_log&) = delete;
+    redo_log& operator=(redo_log&&)      = delete;
+    ~redo_log()                          = default;
+    /** @endcond */
+
+    /**
+     * @brief Starts a transaction.
+     *
+     * @return Transaction scope.
+     */
+    [[nodiscard]] transaction begin() noexcept { return transaction(*this); }
+
+    /**
+     * @brief Buffers a write of @a value to @a target.
+     *
+     * @tparam T Value type. Must be trivially copyable.
+     * @param target Object to write to when the log is committed.
+     * @param value New value.
+     * @throw std::bad_alloc Memory allocation failed; the log is not modified.
+     */
+    template<typename T>
+    requires(std::is_trivially_copyable_v<T>)
+    void write(T& target, const T& value)
+    {
+        this->write_bytes(std::addressof(target), std::addressof(value), sizeof(T));
+    }
+
+    /**
+     * @brief Returns the value of @a target as seen by this log.
+     *
+     * @tparam T Value type. Must be trivially copyable.
+     * @param target Object to read.
+     * Writes are looked up by the address of @a target. If the latest write to that address has a different size
+     * (for example, a write to the first member of a struct, read as the whole struct), only the bytes it shares with
+     * @a target are taken from the log.
+     *
+     * @return The buffered value, if there is one; the current value of @a target otherwise.
+     */
+    template<typename T>
+    requires(std::is_trivially_copyable_v<T>)
+    [[nodiscard]] T read(const T& target) const noexcept
+    {
+        const auto index = this->find(std::addressof(target));
+        if (index == npos) {
+            return target;
+        }
+
+        const entry& e = this->m_entries[index];
+        T result       = target;
+        std::memcpy(std::addressof(result), this->m_data.data() + e.offset, std::min(e.size, sizeof(T)));
+        return result;
+    }
+
+    /**
+     * @brief Checks whether there are buffered writes to @a target.
+     *
+     * @param target Object to check.
+     * @return Whether the log contains a write to @a target.
+     */
+    [[nodiscard]] bool contains(const void* target) const noexcept { return this->find(target) != npos; }
+
+    /**
+     * @brief Returns the number of buffered writes.
+     *
+     * Repeated writes of the same size to the same object are coalesced.
+     *
+     * @return Number of buffered writes.
+     */
+    [[nodiscard]] std::size_t size() const noexcept { return this->m_entries.size(); }
+
+    /**
+     * @brief Checks whether the log is empty.
+     *
+     * @return Whether there are no buffered writes.
+     */
+    [[nodiscard]] bool empty() const noexcept { return this->m_entries.empty(); }
+
+    /**
+     * @brief Applies all buffered writes in write order and clears the log.
+     */
+    void commit() noexcept
+    {
+        for (const entry& e : this->m_entries) {
+            std::memcpy(e.address, this->m_data.data() + e.offset, e.size);
+        }
+
+        this->discard();
+    }
+
+    /**
+     * @brief Discards all buffered writes.
+     *
+     * Memory is retained for reuse.
+     */
+    void discard() noexcept
+    {
+        this->m_entries.clear();
+        this->m_data.clear();
+        if (++this->m_generation == 0) {
+            // Generation counter wrapped around: stale slots could look live again
+            std::fill(this->m_slots.begin(), this->m_slots.end(), slot{});
+            this->m_generation = 1;
+        }
+    }
+
+private:
+    std::vector<entry> m_entries;    ///< Buffered writes, in write order.
+    std::vector<std::byte> m_data;   ///< New values.
+    std::vector<slot> m_slots;       ///< Hash index: target address to the latest entry.
+    std::uint32_t m_generation = 1;  ///< Current index generation.
+
+    /**
+     * @brief Computes the home slot of an address.
+     *
+     * @param address Target address.
+     * @return Slot index.
+     */
+    [[nodiscard]] std::size_t home(const void* address) const noexcept
+    {
+        const auto h = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(address)) * 0x9E37'79B9'7F4A'7C15U;
+        return static_cast<std::size_t>(h >> 32U) & (this->m_slots.size() - 1);
+    }
+
+    /**
+     * @brief Finds the latest entry for an address.
+     *
+     * @param address Target address.
+     * @return Entry index, or `npos`.
+     */
+    [[nodiscard]] std::size_t find(const void* address) const noexcept
+    {
+        if (this->m_entries.empty()) {
+            return npos;
+        }
+
+        const auto mask = this->m_slots.size() - 1;
+        for (auto i = this->home(address);; i = (i + 1) & mask) {
+            const slot& s = this->m_slots[i];
+            if (s.generation != this->m_generation) {
+                return npos;
+            }
+
+            if (s.key == address) {
+                return s.index;
+            }
+        }
+    }
+
+    /**
+     * @brief Points the slot of @a address to entry @a index.
+     *
+     * @param address Target address.
+     * @param index Entry index.
+     */
+    void index(const void* address, std::size_t index) noexcept
+    {
+        const auto mask = this->m_slots.size() - 1;
+        for (auto i = this->home(address);; i = (i + 1) & mask) {
+            slot& s = this->m_slots[i];
+            if (s.generation != this->m_generation || s.key == address) {
+                s = {address, this->m_generation, static_cast<std::uint32_t>(index)};
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief Grows the hash index so that it can hold @a entries entries at a load factor of at most 1/2.
+     *
+     * @param entries Number of entries.
+     */
+    void reserve_index(std::size_t entries)
+    {
+        if (entries * 2 <= this->m_slots.size()) {
+            return;
+        }
+
+        std::vector<slot> slots(std::bit_ceil(std::max<std::size_t>(entries * 2, 16)));
+        this->m_slots.swap(slots);
+        this->m_generation = 1;
+        for (std::size_t i = 0; i < this->m_entries.size(); ++i) {
+            this->index(this->m_entries[i].address, i);
+        }
+    }
+
+    /**
+     * @brief Buffers a write.
+     *
+     * @param address Target address.
+     * @param value New value.
+     * @param size Size of the value.
+     */
+    void write_bytes(void* address, const void* value, std::size_t size)
+    {
+        const auto existing = this->find(address);
+        if (existing != npos && this->m_entries[existing].size == size) {
+            std::memcpy(this->m_data.data() + this->m_entries[existing].offset, value, size);
+            return;
+        }
+
+        this->reserve_index(this->m_entries.size() + 1);
+
+        const auto offset = this->m_data.size();
+        auto undo         = fail_action([this, offset]() noexcept { this->m_data.resize(offset); });
+        this->m_data.resize(offset + size);
+        std::memcpy(this->m_data.data() + offset, value, size);
+        this->m_entries.push_back({address, offset, size});
+        this->index(address, this->m_entries.size() - 1);
+    }
+};
+
+}  // namespace wwa::utils
+
+#endif /* E84C1B27_9F3A_4D06_B5E2_71C0A9D34F18 */
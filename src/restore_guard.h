@@ -0,0 +1,218 @@
+#ifndef FFB8F7C3_BC1F_4986_8858_ADFBDBD66620
+#define FFB8F7C3_BC1F_4986_8858_ADFBDBD66620
+
+/**
+ * @file
+ * @brief Scope guards that snapshot values and restore them on scope exit.
+ *
+ * This file provides `exit_restore` and `fail_restore`, which replace the hand-written
+ * @code{.cpp}
+ * auto saved = x;
+ * wwa::utils::fail_action restore([&x, &saved]() { x = saved; });
+ * @endcode
+ * pattern. The guards copy one or more objects on construction and put the copies back when the scope is exited
+ * (`exit_restore`) or exited via an exception (`fail_restore`).
+ *
+ * Each saved copy is constructed exactly once, and restoring never copies it again:
+ *   - trivially copyable objects are restored with `std::memcpy()`;
+ *   - other objects are move-assigned from the saved copy (for aggregates, this is a member-wise move);
+ *   - objects that are not nothrow move-assignable, but are nothrow swappable, are swapped with the saved copy.
+ *
+ * Usage example:
+ * @code{.cpp}
+ * {
+ *     wwa::utils::exit_restore restore(parser.state, parser.position, parser.error);
+ *     parse_lookahead(parser);  // Whatever happens, the parser state is restored
+ * }
+ * @endcode
+ */
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "exit_action.h"
+#include "fail_action.h"
+
+namespace wwa::utils {
+
+/// @cond INTERNAL
+
+namespace detail {
+
+/**
+ * @brief Types whose objects can be restored from a saved copy without throwing.
+ */
+template<typename T>
+concept restorable = !std::is_const_v<T> && std::is_copy_constructible_v<T> &&
+                     (std::is_trivially_copyable_v<T> || std::is_nothrow_move_assignable_v<T> ||
+                      std::is_nothrow_swappable_v<T>);
+
+/**
+ * @brief Restores @a target from @a saved.
+ *
+ * @param target Object to restore.
+ * @param saved Saved copy of the object; it is left in a valid but unspecified state.
+ */
+template<restorable T>
+void restore_value(T& target, T& saved) noexcept
+{
+    if constexpr (std::is_trivially_copyable_v<T>) {
+        std::memcpy(std::addressof(target), std::addressof(saved), sizeof(T));
+    }
+    else if constexpr (std::is_nothrow_move_assignable_v<T>) {
+        target = std::move(saved);
+    }
+    else {
+        using std::swap;
+        swap(target, saved);
+    }
+}
+
+/**
+ * @brief Copies of objects together with their addresses.
+ *
+ * @tparam T Types of the objects.
+ */
+template<restorable... T>
+class value_snapshot {
+public:
+    /**
+     * @brief Copies @a values.
+     *
+     * @param values Objects to save.
+     */
+    explicit value_snapshot(T&... values) : m_targets(values...), m_saved(values...) {}
+
+    /**
+     * @brief Restores the objects. May be called only once.
+     */
+    void restore() noexcept { this->restore(std::index_sequence_for<T...>{}); }
+
+private:
+    std::tuple<T&...> m_targets;  ///< Saved objects.
+    std::tuple<T...> m_saved;     ///< Copies of the objects.
+
+    /**
+     * @brief Restores the objects.
+     */
+    template<std::size_t... I>
+    void restore(std::index_sequence<I...>) noexcept
+    {
+        (restore_value(std::get<I>(this->m_targets), std::get<I>(this->m_saved)), ...);
+    }
+};
+
+}  // namespace detail
+
+/// @endcond
+
+/**
+ * @brief A scope guard that snapshots objects on construction and restores them when the scope is exited.
+ *
+ * @tparam T Types of the objects. Must be copy-constructible and either trivially copyable, nothrow move-assignable,
+ * or nothrow swappable.
+ * @note Constructing an `exit_restore` of dynamic storage duration might lead to unexpected behavior.
+ */
+template<detail::restorable... T>
+class [[nodiscard("The object must be used to restore the values on scope exit.")]] exit_restore {
+    /// @cond INTERNAL
+    struct restore_fn {
+        detail::value_snapshot<T...>* snapshot;
+        void operator()() const noexcept { this->snapshot->restore(); }
+    };
+    /// @endcond
+
+public:
+    /**
+     * @brief Saves copies of @a values.
+     *
+     * @param values Objects to restore on scope exit.
+     * @throw anything Any exception thrown by the copy constructors; nothing is restored.
+     */
+    explicit exit_restore(T&... values) : m_snapshot(values...), m_on_exit(restore_fn{&this->m_snapshot}) {}
+
+    /** @cond */
+    exit_restore(const exit_restore&)            = delete;
+    exit_restore(exit_restore&&)                 = delete;
+    exit_restore& operator=(const exit_restore&) = delete;
+    exit_restore& operator=(exit_restore&&)      = delete;
+    ~exit_restore() noexcept                     = default;
+    /** @endcond */
+
+    /**
+     * @brief Makes the guard inactive: the objects keep their current values on scope exit.
+     */
+    void release() noexcept { this->m_on_exit.release(); }
+
+private:
+    detail::value_snapshot<T...> m_snapshot;  ///< Saved copies.
+    exit_action<restore_fn> m_on_exit;        ///< Restores the objects on scope exit.
+};
+
+/**
+ * @brief Deduction guide for @a exit_restore.
+ *
+ * @tparam T Types of the objects.
+ */
+template<typename... T>
+exit_restore(T&...) -> exit_restore<T...>;
+
+/**
+ * @brief A scope guard that snapshots objects on construction and restores them when the scope is exited via an
+ * exception.
+ *
+ * @tparam T Types of the objects. Must be copy-constructible and either trivially copyable, nothrow move-assignable,
+ * or nothrow swappable.
+ * @note Constructing a `fail_restore` of dynamic storage duration might lead to unexpected behavior.
+ */
+template<detail::restorable... T>
+class [[nodiscard("The object must be used to restore the values on failure.")]] fail_restore {
+    /// @cond INTERNAL
+    struct restore_fn {
+        detail::value_snapshot<T...>* snapshot;
+        void operator()() const noexcept { this->snapshot->restore(); }
+    };
+    /// @endcond
+
+public:
+    /**
+     * @brief Saves copies of @a values.
+     *
+     * @param values Objects to restore on failure.
+     * @throw anything Any exception thrown by the copy constructors; nothing is restored.
+     */
+    explicit fail_restore(T&... values) : m_snapshot(values...), m_on_fail(restore_fn{&this->m_snapshot}) {}
+
+    /** @cond */
+    fail_restore(const fail_restore&)            = delete;
+    fail_restore(fail_restore&&)                 = delete;
+    fail_restore& operator=(const fail_restore&) = delete;
+    fail_restore& operator=(fail_restore&&)      = delete;
+    ~fail_restore() noexcept                     = default;
+    /** @endcond */
+
+    /**
+     * @brief Makes the guard inactive: the objects keep their current values on scope exit.
+     */
+    void release() noexcept { this->m_on_fail.release(); }
+
+private:
+    detail::value_snapshot<T...> m_snapshot;  ///< Saved copies.
+    fail_action<restore_fn> m_on_fail;        ///< Restores the objects on failure.
+};
+
+/**
+ * @brief Deduction guide for @a fail_restore.
+ *
+ * @tparam T Types of the objects.
+ */
+template<typename... T>
+fail_restore(T&...) -> fail_restore<T...>;
+
+}  // namespace wwa::utils
+
+#endif /* FFB8F7C3_BC1F_4986_8858_ADFBDBD66620 */
@@ -0,0 +1,305 @@
+#ifndef D6A3E62D_1E54_4C5B_8F1F_6E7C3C2B9A41
+#define D6A3E62D_1E54_4C5B_8F1F_6E7C3C2B9A41
+
+/**
+ * @file
+ * @brief Lock-free ring buffer with scoped slot reservations.
+ *
+ * This file provides `ring_buffer`, a bounded single-consumer queue of fixed-size slots. Producers reserve a slot,
+ * serialize a record directly into it, and publish it by leaving the scope of the returned `reservation`.
+ * If the scope is exited via an exception (detected the same way as in `fail_action`), or the reservation is
+ * cancelled, the slot is published as a *skip record*, which the consumer silently discards. Thus, a failing
+ * producer never leaves a hole that would block the ring.
+ *
+ * Usage example:
+ * @code{.cpp}
+ * wwa::utils::ring_buffer<256> ring(1024);
+ *
+ * // Producer
+ * {
+ *     auto slot = ring.reserve();
+ *     std::size_t n = serialize(message, slot.data());  // May throw
+ *     slot.resize(n);
+ * }  // Published here
+ *
+ * // Consumer
+ * ring.try_consume([](std::span<const std::byte> record) { process(record); });
+ * @endcode
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include "exit_action.h"
+
+namespace wwa::utils {
+
+/**
+ * @brief Number of threads allowed to produce into a `ring_buffer` concurrently.
+ */
+enum class producer_model : std::uint8_t {
+    single,   ///< Single producer (SPSC): reservation does not need an atomic read-modify-write operation.
+    multiple  ///< Multiple producers (MPSC).
+};
+
+/**
+ * @brief A bounded lock-free single-consumer ring buffer of fixed-size slots.
+ *
+ * Records are delivered to the consumer in reservation order. A record reserved, but not yet published, blocks the
+ * delivery of later records until it is published or abandoned.
+ *
+ * @tparam SlotSize Maximum size of a record, in bytes.
+ * @tparam Producers Producer model (`producer_model::single` or `producer_model::multiple`).
+ */
+template<std::size_t SlotSize, producer_model Producers = producer_model::multiple>
+requires(SlotSize > 0)
+class ring_buffer {
+    /// @cond INTERNAL
+    struct alignas(64) cell {
+        std::atomic<std::size_t> sequence{0};                ///< Cell state relative to the reservation position.
+        std::size_t size = 0;                                ///< Record size.
+        bool skip        = false;                            ///< Whether the record has been abandoned.
+        alignas(std::max_align_t) std::byte data[SlotSize];  ///< Record payload.
+    };
+    /// @endcond
+
+public:
+    /**
+     * @brief A reserved slot.
+     *
+     * The slot is published when the reservation is destroyed. If the reservation is destroyed due to stack unwinding
+     * caused by an exception, or `cancel()` has been called, the slot is published as a skip record instead.
+     *
+     * A reservation obtained from `try_reserve()` may be empty (if the ring is full); check it with `operator bool`.
+     *
+     * @note Constructing a `reservation` of dynamic storage duration might lead to unexpected behavior.
+     */
+    class [[nodiscard("The object must be used to publish the reserved slot.")]] reservation {
+    public:
+        /** @cond */
+        reservation(const reservation&)            = delete;
+        reservation(reservation&&)                 = delete;
+        reservation& operator=(const reservation&) = delete;
+        reservation& operator=(reservation&&)      = delete;
+        /** @endcond */
+
+        /**
+         * @brief Publishes the slot.
+         *
+         * The slot is published as a skip record if the scope is exited via an exception or `cancel()` has been called.
+         */
+        ~reservation() noexcept
+        {
+            if (this->m_cell != nullptr) {
+                this->m_cell->skip =
+                    this->m_cancelled || std::uncaught_exceptions() > this->m_uncaught_exceptions_count;
+                this->m_cell->sequence.store(this->m_position + 1, std::memory_order_release);
+            }
+        }
+
+        /**
+         * @brief Checks whether a slot has been reserved.
+         *
+         * @return Whether the reservation holds a slot.
+         */
+        explicit operator bool() const noexcept { return this->m_cell != nullptr; }
+
+        /**
+         * @brief Returns the slot memory.
+         *
+         * @return The slot memory (`SlotSize` bytes).
+         * @pre The reservation is not empty.
+         */
+        [[nodiscard]] std::span<std::byte, SlotSize> data() const noexcept
+        {
+            return std::span<std::byte, SlotSize>(this->m_cell->data);
+        }
+
+        /**
+         * @brief Sets the size of the record.
+         *
+         * By default, the record occupies the entire slot.
+         *
+         * @param size Record size.
+         * @pre The reservation is not empty and @a size does not exceed `SlotSize`.
+         */
+        void resize(std::size_t size) noexcept { this->m_cell->size = size; }
+
+        /**
+         * @brief Abandons the slot: it will be published as a skip record.
+         */
+        void cancel() noexcept { this->m_cancelled = true; }
+
+    private:
+        friend class ring_buffer;
+
+        cell* m_cell;                                                  ///< Reserved cell.
+        std::size_t m_position;                                        ///< Reservation position.
+        int m_uncaught_exceptions_count = std::uncaught_exceptions();  ///< The counter of uncaught exceptions.
+        bool m_cancelled                = false;                       ///< Whether `cancel()` has been called.
+
+        reservation(cell* c, std::size_t position) noexcept : m_cell(c), m_position(position)
+        {
+            if (c != nullptr) {
+                c->size = SlotSize;
+            }
+        }
+    };
+
+    /**
+     * @brief Constructs a ring buffer.
+     *
+     * @param capacity Number of slots. Must be a power of two.
+     * @throw std::invalid_argument @a capacity is not a power of two.
+     * @throw std::bad_alloc Memory allocation failed.
+     */
+    explicit ring_buffer(std::size_t capacity) : m_cells(make_cells(capacity)), m_mask(capacity - 1) {}
+
+    /** @cond */
+    ring_buffer(const ring_buffer&)            = delete;
+    ring_buffer(ring_buffer&&)                 = delete;
+    ring_buffer& operator=(const ring_buffer&) = delete;
+    ring_buffer& operator=(ring_buffer&&)      = delete;
+    ~ring_buffer()                             = default;
+    /** @endcond */
+
+    /**
+     * @brief Returns the number of slots.
+     *
+     * @return Capacity of the ring.
+     */
+    [[nodiscard]] std::size_t capacity() const noexcept { return this->m_mask + 1; }
+
+    /**
+     * @brief Reserves a slot, waiting for the consumer if the ring is full.
+     *
+     * @return Reservation.
+     */
+    [[nodiscard]] reservation reserve() noexcept
+    {
+        for (;;) {
+            if (const auto [c, position] = this->try_claim(); c != nullptr) {
+                return reservation(c, position);
+            }
+
+            std::this_thread::yield();
+        }
+    }
+
+    /**
+     * @brief Reserves a slot if the ring is not full.
+     *
+     * @return Reservation; empty if the ring is full.
+     */
+    [[nodiscard]] reservation try_reserve() noexcept
+    {
+        const auto [c, position] = this->try_claim();
+        return reservation(c, position);
+    }
+
+    /**
+     * @brief Consumes the next published record, discarding skip records.
+     *
+     * Must be called only from the consumer thread.
+     *
+     * @tparam Func Consumer function type, invocable with `std::span<const std::byte>`.
+     * @param fn Consumer function.
+     * @return `true` if a record has been consumed, `false` if there are no published records.
+     * @throw anything Any exception thrown by @a fn; the record is consumed anyway.
+     */
+    template<typename Func>
+    bool try_consume(Func&& fn)
+    {
+        for (;;) {
+            cell& c        = this->m_cells[this->m_head & this->m_mask];
+            const auto seq = c.sequence.load(std::memory_order_acquire);
+            if (seq != this->m_head + 1) {
+                return false;
+            }
+
+            const auto position = this->m_head++;
+            auto release        = exit_action([&c, position, this]() noexcept {
+                c.sequence.store(position + this->capacity(), std::memory_order_release);
+            });
+
+            if (!c.skip) {
+                std::forward<Func>(fn)(std::span<const std::byte>(c.data, c.size));
+                return true;
+            }
+        }
+    }
+
+private:
+    std::unique_ptr<cell[]> m_cells;                 ///< Slots.
+    std::size_t m_mask;                              ///< `capacity - 1`.
+    alignas(64) std::atomic<std::size_t> m_tail{0};  ///< Next position to reserve.
+    alignas(64) std::size_t m_head = 0;              ///< Next position to consume (consumer-owned).
+
+    /// A claimed cell and its position.
+    struct claim {
+        cell* c;               ///< The cell; `nullptr` if the ring is full.
+        std::size_t position;  ///< Reservation position.
+    };
+
+    /**
+     * @brief Allocates and initializes the slots.
+     *
+     * @param capacity Number of slots.
+     * @return Slots.
+     */
+    static std::unique_ptr<cell[]> make_cells(std::size_t capacity)
+    {
+        if (capacity == 0 || (capacity & (capacity - 1)) != 0) {
+            throw std::invalid_argument("ring_buffer capacity must be a power of two");
+        }
+
+        auto cells = std::make_unique<cell[]>(capacity);
+        for (std::size_t i = 0; i < capacity; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        return cells;
+    }
+
+    /**
+     * @brief Claims the next free cell.
+     *
+     * @return The claimed cell and its position, or `{nullptr, 0}` if the ring is full.
+     */
+    claim try_claim() noexcept
+    {
+        auto position = this->m_tail.load(std::memory_order_relaxed);
+        for (;;) {
+            cell& c        = this->m_cells[position & this->m_mask];
+            const auto seq = c.sequence.load(std::memory_order_acquire);
+            const auto dif = static_cast<std::ptrdiff_t>(seq - position);
+            if (dif < 0) {
+                return {nullptr, 0};
+            }
+
+            if (dif == 0) {
+                if constexpr (Producers == producer_model::single) {
+                    this->m_tail.store(position + 1, std::memory_order_relaxed);
+                    return {&c, position};
+                }
+                else if (this->m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    return {&c, position};
+                }
+            }
+            else {
+                position = this->m_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+};
+
+}  // namespace wwa::utils
+
+#endif /* D6A3E62D_1E54_4C5B_8F1F_6E7C3C2B9A41 */
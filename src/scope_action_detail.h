@@ -0,0 +1,71 @@
+#ifndef D724FD9D_E18D_48C3_B2C6_5AF4A863A019
+#define D724FD9D_E18D_48C3_B2C6_5AF4A863A019
+
+/**
+ * @file
+ * @brief Definitions shared by exit_action.h, fail_action.h, and success_action.h.
+ *
+ * This header includes only what `exit_action` needs; in particular, it does not include `<exception>` and
+ * `<limits>`, which only `fail_action` and `success_action` use.
+ */
+
+#include <concepts>
+#include <type_traits>
+#include <utility>
+
+#include "bound_call.h"
+#include "scope_probe.h"
+
+#ifndef WWA_SCOPE_ACTION_MAX_CAPTURE_SIZE
+#    define WWA_SCOPE_ACTION_MAX_CAPTURE_SIZE 0
+#endif
+
+/** @brief Library namespace. */
+namespace wwa::utils {
+
+/// @cond INTERNAL
+
+namespace detail {
+
+template<typename Self, typename What, typename From>
+concept can_construct_from = !std::is_same_v<std::remove_cvref_t<From>, Self> && std::constructible_from<What, From>;
+
+template<typename Self, typename What, typename From>
+concept can_move_construct_from_noexcept = can_construct_from<Self, What, From> && !std::is_lvalue_reference_v<From> &&
+                                           std::is_nothrow_constructible_v<What, From>;
+
+template<typename T>
+T&& conditional_forward(T&& t, std::true_type)
+{
+    return std::forward<T>(t);
+}
+
+template<typename T>
+const T& conditional_forward(T&& t, std::false_type)  // NOLINT(cppcoreguidelines-missing-std-forward)
+{
+    return t;
+}
+
+/**
+ * @brief Whether an exit function fits into `WWA_SCOPE_ACTION_MAX_CAPTURE_SIZE`.
+ */
+template<typename ExitFunc>
+inline constexpr bool capture_within_budget = WWA_SCOPE_ACTION_MAX_CAPTURE_SIZE == 0 ||
+                                              std::is_reference_v<ExitFunc> ||
+                                              sizeof(ExitFunc) <= WWA_SCOPE_ACTION_MAX_CAPTURE_SIZE;
+
+/**
+ * @brief Whether an exit function satisfies the nothrow move requirement of the budget.
+ */
+template<typename ExitFunc>
+inline constexpr bool capture_nothrow_movable = WWA_SCOPE_ACTION_MAX_CAPTURE_SIZE == 0 ||
+                                                std::is_reference_v<ExitFunc> ||
+                                                std::is_nothrow_move_constructible_v<ExitFunc>;
+
+}  // namespace detail
+
+/// @endcond
+
+}  // namespace wwa::utils
+
+#endif /* D724FD9D_E18D_48C3_B2C6_5AF4A863A019 */
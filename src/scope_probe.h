@@ -0,0 +1,201 @@
+#ifndef F5843710_5FBD_4533_A39A_74DCC5265ED2
+#define F5843710_5FBD_4533_A39A_74DCC5265ED2
+
+/**
+ * @file
+ * @brief Optional USDT probes and flight recorder hooks of the scope guards.
+ *
+ * When `WWA_SCOPE_ACTION_USDT` is non-zero, `exit_action`, `fail_action`, and `success_action` contain statically
+ * defined tracing points (USDT probes) of the `wwa_scope_action` provider, which can be attached to with `bpftrace`,
+ * `perf probe`, or SystemTap without recompiling the program:
+ *   - `armed` fires when a guard is constructed (including by the move constructor);
+ *   - `released` fires when `release()` is called (including by the move constructor on the moved-from guard);
+ *   - `fired` fires when a guard is about to call its exit function;
+ *   - `exited` fires when a guard is destroyed (after its exit function has returned, if it was called).
+ *
+ * Every probe has three arguments:
+ *   - `arg0`: the address of the code containing the probe, that is, the call site of the guard in optimized builds,
+ *     where the guard is inlined into its caller;
+ *   - `arg1`: the kind of the guard (`scope_probe_kind`);
+ *   - `arg2`: the address of the guard, which can be used to match `armed` with the other probes.
+ *
+ * A probe nobody is attached to costs a `nop` instruction and the computation of its arguments. The probes use
+ * `<sys/sdt.h>` if it is available, or an equivalent built-in implementation on x86-64 and AArch64 ELF targets.
+ *
+ * When `WWA_SCOPE_ACTION_USDT` is zero (the default), the probes are compiled out entirely. Configure the project with
+ * `-DENABLE_USDT=ON` to enable them for all consumers of the `wwa::scope_action` target.
+ *
+ * Usage example:
+ * @code{.sh}
+ * # Count exit functions called by fail_action, by call site
+ * bpftrace -e 'usdt:./app:wwa_scope_action:fired /arg1 == 1/ { @[usym(arg0)] = count(); }'
+ * @endcode
+ *
+ * The same points record events for the crash flight recorder when `WWA_SCOPE_ACTION_FLIGHT_RECORDER` is non-zero
+ * (see flight_recorder.h), update the guard statistics when `WWA_SCOPE_ACTION_STATS` is non-zero (see
+ * guard_stats.h), and register the guard types for the capture report when `WWA_SCOPE_ACTION_CAPTURE_REPORT` is
+ * non-zero (see capture_budget.h).
+ *
+ * @note All translation units of a program should be compiled with the same values of `WWA_SCOPE_ACTION_USDT`,
+ * `WWA_SCOPE_ACTION_FLIGHT_RECORDER`, `WWA_SCOPE_ACTION_STATS`, and `WWA_SCOPE_ACTION_CAPTURE_REPORT`.
+ */
+
+#include <cstdint>
+
+#ifndef WWA_SCOPE_ACTION_USDT
+#    define WWA_SCOPE_ACTION_USDT 0
+#endif
+
+#ifndef WWA_SCOPE_ACTION_FLIGHT_RECORDER
+#    define WWA_SCOPE_ACTION_FLIGHT_RECORDER 0
+#endif
+
+#ifndef WWA_SCOPE_ACTION_STATS
+#    define WWA_SCOPE_ACTION_STATS 0
+#endif
+
+#ifndef WWA_SCOPE_ACTION_CAPTURE_REPORT
+#    define WWA_SCOPE_ACTION_CAPTURE_REPORT 0
+#endif
+
+#if WWA_SCOPE_ACTION_FLIGHT_RECORDER
+#    include "flight_recorder.h"
+#endif
+
+#if WWA_SCOPE_ACTION_CAPTURE_REPORT
+#    include "capture_budget.h"
+#endif
+
+#if WWA_SCOPE_ACTION_USDT
+#    if __has_include(<sys/sdt.h>)
+#        include <sys/sdt.h>
+#        define WWA_SCOPE_PROBE_SDT(name, site, kind, guard) STAP_PROBE3(wwa_scope_action, name, site, kind, guard)
+#    elif defined(__ELF__) && (defined(__x86_64__) || defined(__aarch64__))
+// Same layout as the notes emitted by <sys/sdt.h>: https://sourceware.org/systemtap/wiki/UserSpaceProbeImplementation
+#        define WWA_SCOPE_PROBE_SDT(name, site, kind, guard)                                                         \
+            __asm__ __volatile__(                                                                                    \
+                "990: nop\n"                                                                                         \
+                ".pushsection .note.stapsdt,\"?\",\"note\"\n"                                                        \
+                ".balign 4\n"                                                                                        \
+                ".4byte 992f-991f, 994f-993f, 3\n"                                                                   \
+                "991: .asciz \"stapsdt\"\n"                                                                          \
+                "992: .balign 4\n"                                                                                   \
+                "993: .8byte 990b\n"                                                                                 \
+                ".8byte _.stapsdt.base\n"                                                                            \
+                ".8byte 0\n"                                                                                         \
+                ".asciz \"wwa_scope_action\"\n"                                                                      \
+                ".asciz \"" #name "\"\n"                                                                             \
+                ".asciz \"8@%0 4@%1 8@%2\"\n"                                                                        \
+                "994: .balign 4\n"                                                                                   \
+                ".popsection\n"                                                                                      \
+                ".ifndef _.stapsdt.base\n"                                                                           \
+                ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n"                              \
+                ".weak _.stapsdt.base\n"                                                                             \
+                ".hidden _.stapsdt.base\n"                                                                           \
+                "_.stapsdt.base: .space 1\n"                                                                         \
+                ".size _.stapsdt.base, 1\n"                                                                          \
+                ".popsection\n"                                                                                      \
+                ".endif\n"                                                                                           \
+                :                                                                                                    \
+                : "nor"(site), "nor"(kind), "nor"(guard)                                                             \
+            )
+#    else
+#        error "WWA_SCOPE_ACTION_USDT requires <sys/sdt.h> or an x86-64 or AArch64 ELF target"
+#    endif
+#endif
+
+namespace wwa::utils {
+
+/**
+ * @brief Kind of the guard that fired a USDT probe (the second argument of the probe).
+ */
+enum class scope_probe_kind : unsigned int {
+    exit    = 0,  ///< `exit_action`
+    fail    = 1,  ///< `fail_action`
+    success = 2,  ///< `success_action`
+};
+
+/// @cond INTERNAL
+namespace detail {
+
+#if WWA_SCOPE_ACTION_USDT || WWA_SCOPE_ACTION_FLIGHT_RECORDER
+[[gnu::always_inline]] inline const void* probe_site() noexcept
+{
+    const void* site = nullptr;
+#    if defined(__x86_64__)
+    __asm__ __volatile__("leaq 0(%%rip), %0" : "=r"(site));
+#    elif defined(__aarch64__)
+    __asm__ __volatile__("adr %0, ." : "=r"(site));
+#    else
+    site = __builtin_return_address(0);
+#    endif
+    return site;
+}
+#endif
+
+#if WWA_SCOPE_ACTION_USDT
+[[gnu::always_inline]] inline void probe_armed(scope_probe_kind kind, const void* guard) noexcept
+{
+    WWA_SCOPE_PROBE_SDT(armed, probe_site(), static_cast<unsigned int>(kind), guard);
+}
+
+[[gnu::always_inline]] inline void probe_released(scope_probe_kind kind, const void* guard) noexcept
+{
+    WWA_SCOPE_PROBE_SDT(released, probe_site(), static_cast<unsigned int>(kind), guard);
+}
+
+[[gnu::always_inline]] inline void probe_fired(scope_probe_kind kind, const void* guard) noexcept
+{
+    WWA_SCOPE_PROBE_SDT(fired, probe_site(), static_cast<unsigned int>(kind), guard);
+}
+
+[[gnu::always_inline]] inline void probe_exited(scope_probe_kind kind, const void* guard) noexcept
+{
+    WWA_SCOPE_PROBE_SDT(exited, probe_site(), static_cast<unsigned int>(kind), guard);
+}
+#endif
+
+}  // namespace detail
+
+#if WWA_SCOPE_ACTION_USDT
+#    define WWA_SCOPE_PROBE_USDT(name, kind, guard) ::wwa::utils::detail::probe_##name(kind, guard)
+#else
+#    define WWA_SCOPE_PROBE_USDT(name, kind, guard) static_cast<void>(0)
+#endif
+
+#if WWA_SCOPE_ACTION_FLIGHT_RECORDER
+#    define WWA_SCOPE_PROBE_RECORD(name, kind, guard)                                                                \
+        ::wwa::utils::detail::flight_record(                                                                         \
+            ::wwa::utils::detail::flight_event_type::name, static_cast<std::uint8_t>(kind),                          \
+            ::wwa::utils::detail::probe_site(), guard                                                                \
+        )
+#else
+#    define WWA_SCOPE_PROBE_RECORD(name, kind, guard) static_cast<void>(0)
+#endif
+
+#if WWA_SCOPE_ACTION_STATS
+#    define WWA_SCOPE_PROBE_COUNT(name, kind, guard) \
+        ::wwa::utils::detail::stats_count<::wwa::utils::detail::guard_event::name>(kind, guard)
+#else
+#    define WWA_SCOPE_PROBE_COUNT(name, kind, guard) static_cast<void>(0)
+#endif
+
+#if WWA_SCOPE_ACTION_CAPTURE_REPORT
+#    define WWA_SCOPE_PROBE_REPORT(guard) ::wwa::utils::detail::capture_report_use(guard)
+#else
+#    define WWA_SCOPE_PROBE_REPORT(guard) static_cast<void>(0)
+#endif
+
+#define WWA_SCOPE_PROBE(name, kind, guard)                                                                           \
+    (WWA_SCOPE_PROBE_USDT(name, kind, guard), WWA_SCOPE_PROBE_RECORD(name, kind, guard),                             \
+     WWA_SCOPE_PROBE_COUNT(name, kind, guard), WWA_SCOPE_PROBE_REPORT(guard))
+/// @endcond
+
+}  // namespace wwa::utils
+
+// guard_stats.h needs scope_probe_kind
+#if WWA_SCOPE_ACTION_STATS
+#    include "guard_stats.h"
+#endif
+
+#endif /* F5843710_5FBD_4533_A39A_74DCC5265ED2 */
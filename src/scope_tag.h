@@ -0,0 +1,455 @@
+#ifndef FF93F70A_B01F_4257_8517_8A54115A818B
+#define FF93F70A_B01F_4257_8517_8A54115A818B
+
+/**
+ * @file
+ * @brief Scope tags for signal-based sampling profilers.
+ *
+ * This file provides `scope_tag`, a scope that pushes a static tag (such as `"decode"`) onto a stack of the current
+ * thread on entry and pops it on exit, including when the scope is exited via an exception, and `tag_sampler`, a
+ * sampling profiler that records the tag stack and the instruction pointer of the thread that consumed CPU time,
+ * and exports the samples as folded stacks for flame graphs (`flamegraph.pl`, Speedscope, or Inferno).
+ *
+ * Entering and leaving a tagged scope is a couple of stores to a `thread_local` stack; it does not allocate or lock.
+ * The stack can be read from a signal handler running on the same thread, which is what the sampler does: a
+ * `SIGPROF` timer created with `timer_create()` fires every `tag_sampler_options::interval` of process CPU time,
+ * and the handler copies the stack of the interrupted thread into a preallocated buffer.
+ *
+ * Usage example:
+ * @code{.cpp}
+ * void handle(const request& r)
+ * {
+ *     wwa::utils::scope_tag tag("handle");
+ *     {
+ *         wwa::utils::scope_tag stage("decode");
+ *         decode(r);
+ *     }
+ *     // ...
+ * }
+ *
+ * int main()
+ * {
+ *     wwa::utils::tag_sampler sampler;
+ *     serve();
+ *     sampler.stop();
+ *     std::ofstream out("profile.folded");
+ *     sampler.write_folded(out);
+ * }
+ * @endcode
+ *
+ * @note This header requires Linux; `tag_sampler::write_folded()` uses `dladdr()`, which needs `-ldl` (`CMAKE_DL_LIBS`)
+ * with glibc older than 2.34. The tag stack of a thread is a `thread_local` variable; reading it from a signal
+ * handler is safe in executables and in libraries that are not loaded with `dlopen()`.
+ */
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <signal.h>
+#include <time.h>
+#include <ucontext.h>
+
+#include "exit_action.h"
+#include "posix_error.h"
+
+#ifndef WWA_SCOPE_TAG_DEPTH
+#    define WWA_SCOPE_TAG_DEPTH 16
+#endif
+
+namespace wwa::utils {
+
+/// @cond INTERNAL
+
+namespace detail {
+
+/**
+ * @brief Stack of tags of one thread.
+ *
+ * Only the owning thread writes the stack; a signal handler interrupting the thread reads it. Tags deeper than
+ * `max_depth` are counted but not stored.
+ */
+struct tag_stack {
+    static constexpr std::size_t max_depth = WWA_SCOPE_TAG_DEPTH;
+
+    std::array<const char*, max_depth> tags{};  ///< Tags, outermost first.
+    std::atomic<std::uint32_t> depth{0};        ///< Number of entered scopes.
+
+    static_assert(decltype(depth)::is_always_lock_free, "The depth must be accessible from a signal handler");
+};
+
+inline tag_stack& this_thread_tags() noexcept
+{
+    static constinit thread_local tag_stack stack;
+    return stack;
+}
+
+/**
+ * @brief A sample: the tag stack and the instruction pointer of the interrupted thread.
+ */
+struct tag_sample {
+    std::uintptr_t ip   = 0;                               ///< Instruction pointer; 0 if unknown.
+    std::uint32_t depth = 0;                               ///< Depth of the tag stack.
+    std::array<const char*, tag_stack::max_depth> tags{};  ///< First `min(depth, max_depth)` tags.
+};
+
+struct tag_slot {
+    tag_sample sample;               ///< Sample.
+    std::atomic<bool> ready{false};  ///< Whether `sample` has been written.
+};
+
+}  // namespace detail
+
+/// @endcond
+
+/**
+ * @brief A scope that pushes a tag onto the tag stack of the current thread and pops it on exit.
+ *
+ * @note Constructing a `scope_tag` of dynamic storage duration might lead to unexpected behavior.
+ */
+class [[nodiscard("The object must be used to pop the tag on scope exit.")]] scope_tag {
+    /// @cond INTERNAL
+    struct pop_fn {
+        void operator()() const noexcept
+        {
+            auto& stack = detail::this_thread_tags();
+            stack.depth.store(stack.depth.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+        }
+    };
+    /// @endcond
+
+public:
+    /// @brief Maximum number of tags stored per thread (`WWA_SCOPE_TAG_DEPTH`); deeper tags are not sampled.
+    static constexpr std::size_t max_depth = detail::tag_stack::max_depth;
+
+    /**
+     * @brief Pushes a tag.
+     *
+     * @param tag Tag; must be a string with static storage duration.
+     */
+    explicit scope_tag(const char* tag) noexcept : m_on_exit(push(tag)) {}
+
+    /** @cond */
+    scope_tag(const scope_tag&)            = delete;
+    scope_tag(scope_tag&&)                 = delete;
+    scope_tag& operator=(const scope_tag&) = delete;
+    scope_tag& operator=(scope_tag&&)      = delete;
+    ~scope_tag() noexcept                  = default;
+    /** @endcond */
+
+    /**
+     * @brief Returns the stored tags of the current thread, outermost first.
+     */
+    [[nodiscard]] static std::span<const char* const> current() noexcept
+    {
+        const auto& stack       = detail::this_thread_tags();
+        const std::size_t depth = stack.depth.load(std::memory_order_relaxed);
+        return {stack.tags.data(), std::min(depth, max_depth)};
+    }
+
+private:
+    exit_action<pop_fn> m_on_exit;  ///< Pops the tag on scope exit.
+
+    static pop_fn push(const char* tag) noexcept
+    {
+        auto& stack      = detail::this_thread_tags();
+        const auto depth = stack.depth.load(std::memory_order_relaxed);
+        if (depth < max_depth) {
+            stack.tags[depth] = tag;
+        }
+
+        // The tag must be in place before a signal handler can see the new depth
+        std::atomic_signal_fence(std::memory_order_release);
+        stack.depth.store(depth + 1, std::memory_order_relaxed);
+        return {};
+    }
+};
+
+/**
+ * @brief Options of a `tag_sampler`.
+ */
+struct tag_sampler_options {
+    std::chrono::microseconds interval{1000};  ///< Process CPU time between samples.
+    std::size_t buffer_samples = 16384;        ///< Number of samples kept; later samples are dropped.
+};
+
+/**
+ * @brief Sampling profiler of the tag stacks of all threads.
+ *
+ * Sampling starts on construction and stops on `stop()` or destruction. The `SIGPROF` handler is installed by the
+ * first sampler and stays installed: it ignores the signal while no sampler is active.
+ *
+ * @note Only one sampler can be active at a time.
+ */
+class tag_sampler {
+public:
+    /**
+     * @brief Starts sampling.
+     *
+     * @param opts Options.
+     * @throw std::invalid_argument The interval or the buffer size is zero.
+     * @throw std::logic_error Another sampler is active.
+     * @throw std::system_error `sigaction()`, `timer_create()`, or `timer_settime()` failed.
+     */
+    explicit tag_sampler(tag_sampler_options opts = {})
+    {
+        if (opts.interval.count() <= 0 || opts.buffer_samples == 0) {
+            throw std::invalid_argument("tag_sampler: the interval and the buffer size must be positive");
+        }
+
+        this->m_slots    = std::make_unique<detail::tag_slot[]>(opts.buffer_samples);
+        this->m_capacity = opts.buffer_samples;
+
+        auto& st = state();
+        std::call_once(st.installed, []() {
+            struct sigaction sa {};
+            sa.sa_sigaction = &on_signal;
+            sa.sa_flags     = SA_SIGINFO | SA_RESTART;
+            sigemptyset(&sa.sa_mask);
+            if (::sigaction(SIGPROF, &sa, nullptr) == -1) {
+                detail::throw_errno("sigaction");
+            }
+        });
+
+        tag_sampler* expected = nullptr;
+        if (!st.active.compare_exchange_strong(expected, this)) {
+            throw std::logic_error("tag_sampler: another sampler is active");
+        }
+
+        struct sigevent sev {};
+        sev.sigev_notify = SIGEV_SIGNAL;
+        sev.sigev_signo  = SIGPROF;
+        if (::timer_create(CLOCK_PROCESS_CPUTIME_ID, &sev, &this->m_timer) == -1) {
+            st.active.store(nullptr);
+            detail::throw_errno("timer_create");
+        }
+
+        const auto us = opts.interval.count();
+        struct itimerspec its {};
+        its.it_interval.tv_sec  = static_cast<time_t>(us / 1'000'000);
+        its.it_interval.tv_nsec = static_cast<long>(us % 1'000'000) * 1000;
+        its.it_value            = its.it_interval;
+        if (::timer_settime(this->m_timer, 0, &its, nullptr) == -1) {
+            ::timer_delete(this->m_timer);
+            st.active.store(nullptr);
+            detail::throw_errno("timer_settime");
+        }
+
+        this->m_running = true;
+    }
+
+    /** @cond */
+    tag_sampler(const tag_sampler&)            = delete;
+    tag_sampler(tag_sampler&&)                 = delete;
+    tag_sampler& operator=(const tag_sampler&) = delete;
+    tag_sampler& operator=(tag_sampler&&)      = delete;
+    /** @endcond */
+
+    /**
+     * @brief Stops sampling.
+     */
+    ~tag_sampler() noexcept { this->stop(); }
+
+    /**
+     * @brief Stops sampling; the recorded samples remain available. Does nothing if sampling has stopped.
+     */
+    void stop() noexcept
+    {
+        if (this->m_running) {
+            ::timer_delete(this->m_timer);
+
+            // Wait for the handlers that might still be using this sampler
+            auto& st = state();
+            st.active.store(nullptr);
+            while (st.in_handler.load() != 0) {
+                std::this_thread::yield();
+            }
+
+            this->m_running = false;
+        }
+    }
+
+    /**
+     * @brief Returns the number of recorded samples.
+     */
+    [[nodiscard]] std::size_t samples() const noexcept
+    {
+        return std::min(this->m_next.load(std::memory_order_relaxed), this->m_capacity);
+    }
+
+    /**
+     * @brief Returns the number of samples dropped because the buffer was full.
+     */
+    [[nodiscard]] std::size_t dropped() const noexcept
+    {
+        return this->m_next.load(std::memory_order_relaxed) - this->samples();
+    }
+
+    /**
+     * @brief Writes the recorded samples as folded stacks: one `frame;frame;... count` line per distinct stack.
+     *
+     * The frames are the tags, outermost first, followed by `[truncated]` if the tag stack was deeper than
+     * `scope_tag::max_depth`. Samples taken outside of any tagged scope have the `[untagged]` frame.
+     *
+     * @param os Output stream.
+     * @param with_ip Whether to add the function that was running (or `module+0xoffset` if the symbol is unknown) as
+     * the leaf frame.
+     */
+    void write_folded(std::ostream& os, bool with_ip = false) const
+    {
+        std::map<std::string, std::uint64_t> stacks;
+        std::map<std::uintptr_t, std::string> symbols;
+        std::string line;
+
+        const std::size_t n = this->samples();
+        for (std::size_t i = 0; i < n; ++i) {
+            const detail::tag_slot& slot = this->m_slots[i];
+            if (!slot.ready.load(std::memory_order_acquire)) {
+                continue;
+            }
+
+            const detail::tag_sample& s = slot.sample;
+            line.clear();
+            for (std::size_t j = 0; j < std::min<std::size_t>(s.depth, scope_tag::max_depth); ++j) {
+                append_frame(line, s.tags[j]);
+            }
+
+            if (s.depth > scope_tag::max_depth) {
+                append_frame(line, "[truncated]");
+            }
+
+            if (line.empty()) {
+                append_frame(line, "[untagged]");
+            }
+
+            if (with_ip) {
+                auto it = symbols.find(s.ip);
+                if (it == symbols.end()) {
+                    it = symbols.emplace(s.ip, symbolize(s.ip)).first;
+                }
+
+                append_frame(line, it->second.c_str());
+            }
+
+            ++stacks[line];
+        }
+
+        for (const auto& [stack, count] : stacks) {
+            os << stack << ' ' << count << '\n';
+        }
+    }
+
+private:
+    /// @cond INTERNAL
+    struct sampler_state {
+        std::once_flag installed;                   ///< Whether the `SIGPROF` handler is installed.
+        std::atomic<tag_sampler*> active{nullptr};  ///< Active sampler.
+        std::atomic<int> in_handler{0};             ///< Number of running signal handlers.
+    };
+    /// @endcond
+
+    std::unique_ptr<detail::tag_slot[]> m_slots;  ///< Samples.
+    std::size_t m_capacity = 0;                   ///< Number of slots.
+    std::atomic<std::size_t> m_next{0};           ///< Number of claimed slots, including dropped samples.
+    timer_t m_timer{};                            ///< Sampling timer.
+    bool m_running = false;                       ///< Whether the timer exists.
+
+    static sampler_state& state() noexcept
+    {
+        static sampler_state st;
+        return st;
+    }
+
+    static void on_signal(int /*sig*/, siginfo_t* /*info*/, void* context) noexcept
+    {
+        auto& st = state();
+        st.in_handler.fetch_add(1);
+        if (tag_sampler* self = st.active.load(); self != nullptr) {
+            self->record(static_cast<const ucontext_t*>(context));
+        }
+
+        st.in_handler.fetch_sub(1);
+    }
+
+    void record(const ucontext_t* context) noexcept
+    {
+        const std::size_t index = this->m_next.fetch_add(1, std::memory_order_relaxed);
+        if (index >= this->m_capacity) {
+            return;
+        }
+
+        const auto& stack      = detail::this_thread_tags();
+        detail::tag_slot& slot = this->m_slots[index];
+        slot.sample.depth      = stack.depth.load(std::memory_order_relaxed);
+        std::atomic_signal_fence(std::memory_order_acquire);
+        std::copy_n(
+            stack.tags.begin(), std::min<std::size_t>(slot.sample.depth, scope_tag::max_depth),
+            slot.sample.tags.begin()
+        );
+
+#if defined(__x86_64__) && defined(REG_RIP)
+        slot.sample.ip = static_cast<std::uintptr_t>(context->uc_mcontext.gregs[REG_RIP]);
+#elif defined(__aarch64__)
+        slot.sample.ip = static_cast<std::uintptr_t>(context->uc_mcontext.pc);
+#else
+        static_cast<void>(context);
+#endif
+
+        slot.ready.store(true, std::memory_order_release);
+    }
+
+    static void append_frame(std::string& line, const char* frame)
+    {
+        if (!line.empty()) {
+            line += ';';
+        }
+
+        for (const char* p = frame; *p != '\0'; ++p) {
+            // ';' separates frames, and a newline would end the stack
+            line += (*p == ';' || *p == '\n') ? ':' : *p;
+        }
+    }
+
+    static std::string symbolize(std::uintptr_t ip)
+    {
+        Dl_info info{};
+        // NOLINTNEXTLINE(performance-no-int-to-ptr)
+        if (ip == 0 || ::dladdr(reinterpret_cast<const void*>(ip), &info) == 0 || info.dli_fname == nullptr) {
+            return "[unknown]";
+        }
+
+        if (info.dli_sname != nullptr) {
+            int status = 0;
+            const std::unique_ptr<char, decltype(&std::free)> demangled(
+                abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status), &std::free
+            );
+            return status == 0 ? demangled.get() : info.dli_sname;
+        }
+
+        const char* slash = std::strrchr(info.dli_fname, '/');
+        std::ostringstream frame;
+        frame << (slash != nullptr ? slash + 1 : info.dli_fname) << "+0x" << std::hex
+              << (ip - reinterpret_cast<std::uintptr_t>(info.dli_fbase));
+        return frame.str();
+    }
+};
+
+}  // namespace wwa::utils
+
+#endif /* FF93F70A_B01F_4257_8517_8A54115A818B */
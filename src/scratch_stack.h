@@ -0,0 +1,386 @@
+#ifndef E1050366_6B45_402B_8A68_6D4112858926
+#define E1050366_6B45_402B_8A68_6D4112858926
+
+/**
+ * @file
+ * @brief Aligned temporary buffers from a thread-local LIFO scratch stack.
+ *
+ * This file provides `scratch_scope`, which hands out short-lived aligned buffers by bumping a pointer in a
+ * thread-local stack and pops all of them at once when the scope is exited. Allocation costs a few arithmetic
+ * instructions, and there is nothing to free; unlike `alloca()`, large buffers do not overflow the call stack.
+ *
+ * Requests that do not fit into the remaining space of the stack fall back to the heap; such buffers are freed when
+ * the scope is exited as well.
+ *
+ * When `WWA_SCRATCH_CANARIES` is non-zero (by default, when `NDEBUG` is not defined), each buffer is followed by a
+ * canary, which is verified when the scope is exited; a buffer overrun terminates the process with a diagnostic.
+ * The setting changes the layout of the thread's stack, so the two variants live in different inline namespaces:
+ * translation units built with different settings (e.g. debug code linked with a release library) get separate
+ * stacks, and passing a `scratch_scope` between them fails to link instead of corrupting memory.
+ *
+ * Usage example:
+ * @code{.cpp}
+ * void transform(std::span<const float> input)
+ * {
+ *     wwa::utils::scratch_scope scratch;
+ *     std::span<float> tmp = scratch.allocate<float>(input.size(), 64);  // 64-byte aligned, uninitialized
+ *     kernel(input, tmp);
+ * }  // `tmp` is released here
+ * @endcode
+ */
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+
+#include "exit_action.h"
+
+#ifndef WWA_SCRATCH_CANARIES
+#    ifdef NDEBUG
+#        define WWA_SCRATCH_CANARIES 0
+#    else
+#        define WWA_SCRATCH_CANARIES 1
+#    endif
+#endif
+
+/// @cond INTERNAL
+#if WWA_SCRATCH_CANARIES
+#    define WWA_SCRATCH_ABI scratch_canaries
+#else
+#    define WWA_SCRATCH_ABI scratch_no_canaries
+#endif
+/// @endcond
+
+namespace wwa::utils {
+
+inline namespace WWA_SCRATCH_ABI {
+class scratch_scope;
+}  // namespace WWA_SCRATCH_ABI
+
+/// @cond INTERNAL
+
+namespace detail {
+
+inline namespace WWA_SCRATCH_ABI {
+
+/**
+ * @brief The scratch stack of a thread.
+ */
+class scratch_stack {
+public:
+    /// @brief Size of the stack of each thread; address space is reserved on first use, pages are committed on touch.
+    static constexpr std::size_t capacity = std::size_t{4} << 20;
+
+    /// @brief Alignment of the base of the stack.
+    static constexpr std::size_t base_alignment = 64;
+
+    scratch_stack() = default;
+
+    scratch_stack(const scratch_stack&)            = delete;
+    scratch_stack(scratch_stack&&)                 = delete;
+    scratch_stack& operator=(const scratch_stack&) = delete;
+    scratch_stack& operator=(scratch_stack&&)      = delete;
+
+    ~scratch_stack() { ::operator delete(this->m_base, capacity, std::align_val_t{base_alignment}); }
+
+    /**
+     * @brief Returns the scratch stack of the calling thread.
+     *
+     * @return The stack.
+     */
+    static scratch_stack& instance() noexcept
+    {
+        static thread_local scratch_stack stack;
+        return stack;
+    }
+
+    /**
+     * @brief Bumps the top of the stack.
+     *
+     * @param bytes Size of the buffer.
+     * @param alignment Alignment of the buffer; a power of two.
+     * @param extra Number of bytes reserved after the buffer.
+     * @return The buffer, or `nullptr` if the stack does not have enough space left.
+     */
+    void* push(std::size_t bytes, std::size_t alignment, std::size_t extra) noexcept
+    {
+        if (this->m_base == nullptr) [[unlikely]] {
+            void* p      = ::operator new(capacity, std::align_val_t{base_alignment}, std::nothrow);
+            this->m_base = static_cast<std::byte*>(p);
+            if (this->m_base == nullptr) {
+                return nullptr;
+            }
+        }
+
+        const auto base  = reinterpret_cast<std::uintptr_t>(this->m_base);
+        const auto first = ((base + this->m_top + alignment - 1) & ~(alignment - 1)) - base;
+        if (first > capacity || capacity - first < bytes || capacity - first - bytes < extra) {
+            return nullptr;
+        }
+
+        this->m_top = first + bytes + extra;
+        return this->m_base + first;
+    }
+
+    [[nodiscard]] std::size_t top() const noexcept { return this->m_top; }
+    void pop(std::size_t top) noexcept { this->m_top = top; }
+
+    [[nodiscard]] scratch_scope* current() const noexcept { return this->m_current; }
+    void set_current(scratch_scope* scope) noexcept { this->m_current = scope; }
+
+private:
+    std::byte* m_base        = nullptr;  ///< Base of the stack.
+    std::size_t m_top        = 0;        ///< Offset of the first free byte.
+    scratch_scope* m_current = nullptr;  ///< Innermost active scope.
+};
+
+}  // namespace WWA_SCRATCH_ABI
+
+}  // namespace detail
+
+/// @endcond
+
+inline namespace WWA_SCRATCH_ABI {
+
+/**
+ * @brief A scope that allocates aligned temporary buffers from the scratch stack of the current thread.
+ *
+ * All buffers are released when the scope is exited. Scopes nest; an outer scope may still allocate while an inner
+ * scope is active, in which case its buffers come from the heap.
+ *
+ * @note Constructing a `scratch_scope` of dynamic storage duration might lead to unexpected behavior.
+ */
+class [[nodiscard("The object must be used to release the buffers on scope exit.")]] scratch_scope {
+    /// @cond INTERNAL
+    struct pop_fn {
+        scratch_scope* scope;
+        void operator()() const noexcept { this->scope->pop(); }
+    };
+
+    struct heap_block {
+        heap_block* next;       ///< Previously allocated block.
+        std::size_t bytes;      ///< Size of the buffer.
+        std::size_t alignment;  ///< Alignment the block was allocated with.
+    };
+
+    struct canary {
+        std::uint64_t value;  ///< Must be equal to `canary_value`.
+        canary* prev;         ///< Canary of the previous buffer on the stack.
+    };
+
+    static constexpr std::uint64_t canary_value = 0xC0DE'CAFE'DEAD'BEEFU;
+    static constexpr std::size_t canary_space   = WWA_SCRATCH_CANARIES != 0 ? sizeof(canary) + alignof(canary) - 1 : 0;
+    /// @endcond
+
+public:
+    /// @brief Whether buffers are followed by canaries.
+    static constexpr bool canaries = WWA_SCRATCH_CANARIES != 0;
+
+    /**
+     * @brief Opens a scope on the scratch stack of the current thread.
+     */
+    scratch_scope() noexcept
+        : m_stack(&detail::scratch_stack::instance()), m_mark(m_stack->top()), m_outer(m_stack->current()),
+          m_on_exit(pop_fn{this})
+    {
+        this->m_stack->set_current(this);
+    }
+
+    /** @cond */
+    scratch_scope(const scratch_scope&)            = delete;
+    scratch_scope(scratch_scope&&)                 = delete;
+    scratch_scope& operator=(const scratch_scope&) = delete;
+    scratch_scope& operator=(scratch_scope&&)      = delete;
+    ~scratch_scope() noexcept                      = default;
+    /** @endcond */
+
+    /**
+     * @brief Allocates an uninitialized buffer.
+     *
+     * @param bytes Size of the buffer.
+     * @param alignment Alignment of the buffer; must be a power of two.
+     * @return The buffer, valid until the scope is exited.
+     * @throw std::invalid_argument @a alignment is not a power of two.
+     * @throw std::bad_alloc The buffer does not fit into the stack, and heap allocation failed.
+     */
+    [[nodiscard]] void* allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t))
+    {
+        if (!std::has_single_bit(alignment)) {
+            throw std::invalid_argument("scratch_scope::allocate: alignment must be a power of two");
+        }
+
+        // An outer scope must not bump the stack under an active inner scope
+        void* p = this->m_stack->current() == this ? this->m_stack->push(bytes, alignment, canary_space) : nullptr;
+        if (p == nullptr) [[unlikely]] {
+            return this->allocate_heap(bytes, alignment);
+        }
+
+        if constexpr (canaries) {
+            this->m_canaries = place_canary(static_cast<std::byte*>(p) + bytes, this->m_canaries);
+        }
+
+        return p;
+    }
+
+    /**
+     * @brief Allocates an uninitialized array of @a count objects.
+     *
+     * @tparam T Object type.
+     * @param count Number of objects.
+     * @param alignment Alignment of the array; must be a power of two not less than `alignof(T)`.
+     * @return The array, valid until the scope is exited.
+     * @throw std::invalid_argument @a alignment is not a power of two or is less than `alignof(T)`.
+     * @throw std::length_error The size of the array overflows `std::size_t`.
+     * @throw std::bad_alloc The array does not fit into the stack, and heap allocation failed.
+     */
+    template<typename T>
+    requires(std::is_trivially_default_constructible_v<T> && std::is_trivially_destructible_v<T>)
+    [[nodiscard]] std::span<T> allocate(std::size_t count, std::size_t alignment = alignof(T))
+    {
+        if (alignment < alignof(T)) {
+            throw std::invalid_argument("scratch_scope::allocate: alignment is less than alignof(T)");
+        }
+
+        if (count > SIZE_MAX / sizeof(T)) {
+            throw std::length_error("scratch_scope::allocate: array is too large");
+        }
+
+        return {static_cast<T*>(this->allocate(count * sizeof(T), alignment)), count};
+    }
+
+    /**
+     * @brief Returns the number of buffers that did not fit into the stack and were allocated from the heap.
+     *
+     * @return Number of heap buffers of this scope.
+     */
+    [[nodiscard]] std::size_t heap_allocations() const noexcept { return this->m_heap_count; }
+
+private:
+    detail::scratch_stack* m_stack;      ///< Scratch stack of the thread.
+    std::size_t m_mark;                  ///< Top of the stack when the scope was opened.
+    scratch_scope* m_outer;              ///< Enclosing scope.
+    heap_block* m_heap       = nullptr;  ///< Heap buffers, most recent first.
+    std::size_t m_heap_count = 0;        ///< Number of heap buffers.
+    canary* m_canaries       = nullptr;  ///< Canary of the most recent stack buffer.
+    exit_action<pop_fn> m_on_exit;       ///< Releases the buffers on scope exit.
+
+    /**
+     * @brief Returns the offset of the buffer in a heap block.
+     *
+     * @param alignment Alignment of the buffer.
+     * @return Offset of the buffer.
+     */
+    static constexpr std::size_t payload_offset(std::size_t alignment) noexcept
+    {
+        return (sizeof(heap_block) + alignment - 1) & ~(alignment - 1);
+    }
+
+    /**
+     * @brief Writes a canary after a buffer.
+     *
+     * @param end End of the buffer.
+     * @param prev Previous canary.
+     * @return The canary.
+     */
+    static canary* place_canary(std::byte* end, canary* prev) noexcept
+    {
+        auto* c  = static_cast<canary*>(align_canary(end));
+        c->value = canary_value;
+        c->prev  = prev;
+        return c;
+    }
+
+    /**
+     * @brief Returns the address of the canary that follows a buffer.
+     *
+     * @param end End of the buffer.
+     * @return Address of the canary.
+     */
+    static void* align_canary(std::byte* end) noexcept
+    {
+        const auto misalignment = reinterpret_cast<std::uintptr_t>(end) & (alignof(canary) - 1);
+        return misalignment != 0 ? end + (alignof(canary) - misalignment) : end;
+    }
+
+    /**
+     * @brief Terminates the process if a canary has been overwritten.
+     *
+     * @param c Canary.
+     */
+    static void check_canary(const canary* c) noexcept
+    {
+        if (c->value != canary_value) [[unlikely]] {
+            std::fputs("scratch_scope: buffer overrun detected\n", stderr);
+            std::abort();
+        }
+    }
+
+    /**
+     * @brief Allocates a buffer from the heap.
+     *
+     * @param bytes Size of the buffer.
+     * @param alignment Alignment of the buffer.
+     * @return The buffer.
+     */
+    void* allocate_heap(std::size_t bytes, std::size_t alignment)
+    {
+        alignment                = std::max(alignment, alignof(heap_block));
+        const std::size_t offset = payload_offset(alignment);
+        if (bytes > SIZE_MAX - offset - canary_space) {
+            throw std::bad_alloc();
+        }
+
+        void* memory = ::operator new(offset + bytes + canary_space, std::align_val_t{alignment});
+        this->m_heap = ::new (memory) heap_block{this->m_heap, bytes, alignment};
+        ++this->m_heap_count;
+
+        auto* p = static_cast<std::byte*>(memory) + offset;
+        if constexpr (canaries) {
+            place_canary(p + bytes, nullptr);
+        }
+
+        return p;
+    }
+
+    /**
+     * @brief Releases all buffers of the scope.
+     */
+    void pop() noexcept
+    {
+        if constexpr (canaries) {
+            for (const canary* c = this->m_canaries; c != nullptr; c = c->prev) {
+                check_canary(c);
+            }
+        }
+
+        for (heap_block* block = this->m_heap; block != nullptr;) {
+            heap_block* next            = block->next;
+            const std::size_t alignment = block->alignment;
+            const std::size_t offset    = payload_offset(alignment);
+            const std::size_t size      = offset + block->bytes + canary_space;
+            if constexpr (canaries) {
+                auto* end = reinterpret_cast<std::byte*>(block) + offset + block->bytes;
+                check_canary(static_cast<const canary*>(align_canary(end)));
+            }
+
+            ::operator delete(block, size, std::align_val_t{alignment});
+            block = next;
+        }
+
+        this->m_stack->pop(this->m_mark);
+        this->m_stack->set_current(this->m_outer);
+    }
+};
+
+}  // namespace WWA_SCRATCH_ABI
+
+}  // namespace wwa::utils
+
+#endif /* E1050366_6B45_402B_8A68_6D4112858926 */
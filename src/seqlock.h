@@ -0,0 +1,363 @@
+#ifndef CDA30D80_445B_45C9_A73B_587D74DCF772
+#define CDA30D80_445B_45C9_A73B_587D74DCF772
+
+/**
+ * @file
+ * @brief Sequence lock with scoped writers and optimistic readers.
+ *
+ * This file provides `seqlock`, a synchronization primitive for small, frequently read values (clock offsets,
+ * rate limits, routing weights, etc.). Readers never write to shared memory and therefore scale with the number
+ * of threads; writers are mutually exclusive and never wait for readers.
+ *
+ * Writers use `seqlock::write_scope`: the sequence becomes odd when the scope is entered and even when it is exited,
+ * whether normally or via an exception. Readers use `seqlock::read_scope`: the scope remembers the sequence observed
+ * on entry, and `read_scope::retry()` tells whether a writer intervened and the read has to be repeated.
+ *
+ * The protected value is stored as an array of machine words accessed with atomic operations, so that a concurrent
+ * write can never produce a data race or a torn word, and a torn object is always detected by the sequence check.
+ */
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+namespace wwa::utils {
+
+/// @cond INTERNAL
+
+namespace detail {
+
+/**
+ * @brief Hints the processor that the calling thread is in a spin-wait loop.
+ */
+inline void spin_pause() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#else
+    std::this_thread::yield();
+#endif
+}
+
+}  // namespace detail
+
+/// @endcond
+
+/**
+ * @brief A sequence lock protecting a trivially copyable value.
+ *
+ * Usage example:
+ * @code{.cpp}
+ * wwa::utils::seqlock<clock_offset> offset;
+ *
+ * // Writer
+ * {
+ *     auto writer = offset.write();
+ *     auto value  = writer.get();
+ *     value.ns += delta;
+ *     writer.set(value);
+ * }
+ *
+ * // Reader
+ * clock_offset value = offset.load();
+ * @endcode
+ *
+ * @tparam T Type of the protected value. Must be trivially copyable.
+ * @note Writers spin while another writer is active; the writer critical section should therefore be short.
+ * @note To avoid false sharing, consider placing the `seqlock` into its own cache line (e.g., with `alignas(64)`).
+ */
+template<typename T>
+requires(std::is_trivially_copyable_v<T>)
+class seqlock {
+    /// @cond INTERNAL
+    using word_type                         = std::uintptr_t;
+    static constexpr std::size_t word_count = (sizeof(T) + sizeof(word_type) - 1) / sizeof(word_type);
+    using words_type                        = std::array<word_type, word_count>;
+
+    static_assert(std::atomic<word_type>::is_always_lock_free, "Machine words must be lock-free");
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "64-bit sequence counter must be lock-free");
+    /// @endcond
+
+public:
+    /**
+     * @brief A writer scope.
+     *
+     * Makes the sequence odd on construction (waiting for any other writer to finish), and even on destruction.
+     * While the scope is active, readers will retry.
+     */
+    class [[nodiscard("The object must be used to keep the seqlock locked for writing.")]] write_scope {
+    public:
+        /**
+         * @brief Enters the writer critical section.
+         *
+         * @param lock The sequence lock to acquire.
+         */
+        explicit write_scope(seqlock& lock) noexcept : m_lock(&lock), m_sequence(lock.begin_write()) {}
+
+        /** @cond */
+        write_scope(const write_scope&)            = delete;
+        write_scope(write_scope&&)                 = delete;
+        write_scope& operator=(const write_scope&) = delete;
+        write_scope& operator=(write_scope&&)      = delete;
+        /** @endcond */
+
+        /**
+         * @brief Leaves the writer critical section, making the sequence even again.
+         *
+         * This happens regardless of whether the scope is exited normally or via an exception.
+         */
+        ~write_scope() noexcept { this->m_lock->m_sequence.store(this->m_sequence + 1, std::memory_order_release); }
+
+        /**
+         * @brief Returns the current value.
+         *
+         * @return The protected value.
+         */
+        [[nodiscard]] T get() const noexcept { return this->m_lock->load_words(); }
+
+        /**
+         * @brief Replaces the protected value.
+         *
+         * @param value New value.
+         */
+        void set(const T& value) noexcept { this->m_lock->store_words(value); }
+
+    private:
+        seqlock* m_lock;           ///< The sequence lock.
+        std::uint64_t m_sequence;  ///< The (odd) sequence set on entry.
+    };
+
+    /**
+     * @brief An optimistic reader scope.
+     *
+     * Waits until no writer is active and remembers the sequence. The values read within the scope are consistent
+     * only if `retry()` returns `false`.
+     *
+     * Usage example:
+     * @code{.cpp}
+     * auto reader = lock.read();
+     * T value;
+     * do {
+     *     value = reader.get();
+     * } while (reader.retry());
+     * @endcode
+     */
+    class [[nodiscard("The object must be used to validate the read.")]] read_scope {
+    public:
+        /**
+         * @brief Enters the optimistic read section.
+         *
+         * @param lock The sequence lock to read.
+         */
+        explicit read_scope(const seqlock& lock) noexcept : m_lock(&lock), m_sequence(lock.begin_read()) {}
+
+        /** @cond */
+        read_scope(const read_scope&)            = delete;
+        read_scope(read_scope&&)                 = delete;
+        read_scope& operator=(const read_scope&) = delete;
+        read_scope& operator=(read_scope&&)      = delete;
+        ~read_scope()                            = default;
+        /** @endcond */
+
+        /**
+         * @brief Returns a snapshot of the protected value.
+         *
+         * The snapshot may be inconsistent if a writer intervened; use `valid()` or `retry()` to find out.
+         *
+         * @return Snapshot of the protected value.
+         */
+        [[nodiscard]] T get() const noexcept { return this->m_lock->load_words(); }
+
+        /**
+         * @brief Checks whether no writer has entered since the scope was (re)started.
+         *
+         * @return Whether the snapshots taken within the scope are consistent.
+         */
+        [[nodiscard]] bool valid() const noexcept
+        {
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return this->m_lock->m_sequence.load(std::memory_order_relaxed) == this->m_sequence;
+        }
+
+        /**
+         * @brief Validates the read and restarts the scope if it is invalid.
+         *
+         * @return `true` if a writer intervened and the read must be repeated, `false` otherwise.
+         */
+        [[nodiscard]] bool retry() noexcept
+        {
+            if (this->valid()) {
+                return false;
+            }
+
+            this->m_sequence = this->m_lock->begin_read();
+            return true;
+        }
+
+    private:
+        const seqlock* m_lock;     ///< The sequence lock.
+        std::uint64_t m_sequence;  ///< The (even) sequence observed on entry.
+    };
+
+    /**
+     * @brief Constructs a `seqlock` holding a value-initialized `T`.
+     */
+    seqlock() noexcept
+    requires(std::is_default_constructible_v<T>)
+        : seqlock(T{})
+    {}
+
+    /**
+     * @brief Constructs a `seqlock` holding @a value.
+     *
+     * @param value Initial value.
+     */
+    explicit seqlock(const T& value) noexcept { this->store_words(value); }
+
+    /** @cond */
+    seqlock(const seqlock&)            = delete;
+    seqlock(seqlock&&)                 = delete;
+    seqlock& operator=(const seqlock&) = delete;
+    seqlock& operator=(seqlock&&)      = delete;
+    ~seqlock()                         = default;
+    /** @endcond */
+
+    /**
+     * @brief Enters a writer scope.
+     *
+     * @return Writer scope.
+     */
+    [[nodiscard]] write_scope write() noexcept { return write_scope(*this); }
+
+    /**
+     * @brief Enters a reader scope.
+     *
+     * @return Reader scope.
+     */
+    [[nodiscard]] read_scope read() const noexcept { return read_scope(*this); }
+
+    /**
+     * @brief Returns a consistent snapshot of the protected value, retrying as needed.
+     *
+     * @return The protected value.
+     */
+    [[nodiscard]] T load() const noexcept
+    {
+        read_scope reader(*this);
+        for (;;) {
+            const T value = reader.get();
+            if (!reader.retry()) {
+                return value;
+            }
+        }
+    }
+
+    /**
+     * @brief Replaces the protected value.
+     *
+     * @param value New value.
+     */
+    void store(const T& value) noexcept
+    {
+        const write_scope writer(*this);
+        this->store_words(value);
+    }
+
+    /**
+     * @brief Returns the current sequence number.
+     *
+     * The sequence is odd while a writer is active, and is incremented by two by every completed writer.
+     *
+     * @return The current sequence number.
+     */
+    [[nodiscard]] std::uint64_t sequence() const noexcept { return this->m_sequence.load(std::memory_order_acquire); }
+
+private:
+    std::atomic<std::uint64_t> m_sequence{0};                 ///< Sequence counter; odd while a writer is active.
+    std::array<std::atomic<word_type>, word_count> m_data{};  ///< The protected value, as machine words.
+
+    /**
+     * @brief Waits for other writers to finish and makes the sequence odd.
+     *
+     * @return The new (odd) sequence.
+     */
+    std::uint64_t begin_write() noexcept
+    {
+        auto seq = this->m_sequence.load(std::memory_order_relaxed);
+        for (;;) {
+            if ((seq & 1U) != 0) {
+                detail::spin_pause();
+                seq = this->m_sequence.load(std::memory_order_relaxed);
+            }
+            else if (this->m_sequence.compare_exchange_weak(
+                         seq, seq + 1, std::memory_order_acquire, std::memory_order_relaxed
+                     ))
+            {
+                break;
+            }
+        }
+
+        // Data stores must not become visible before the odd sequence
+        std::atomic_thread_fence(std::memory_order_release);
+        return seq + 1;
+    }
+
+    /**
+     * @brief Waits until no writer is active.
+     *
+     * @return The observed (even) sequence.
+     */
+    std::uint64_t begin_read() const noexcept
+    {
+        for (;;) {
+            const auto seq = this->m_sequence.load(std::memory_order_acquire);
+            if ((seq & 1U) == 0) {
+                return seq;
+            }
+
+            detail::spin_pause();
+        }
+    }
+
+    /**
+     * @brief Reads the protected value word by word.
+     *
+     * @return The (possibly torn) value.
+     */
+    T load_words() const noexcept
+    {
+        words_type words;
+        for (std::size_t i = 0; i < word_count; ++i) {
+            words[i] = this->m_data[i].load(std::memory_order_relaxed);
+        }
+
+        std::array<unsigned char, sizeof(T)> bytes;
+        std::memcpy(bytes.data(), words.data(), sizeof(T));
+        return std::bit_cast<T>(bytes);
+    }
+
+    /**
+     * @brief Writes the protected value word by word.
+     *
+     * @param value The value to store.
+     */
+    void store_words(const T& value) noexcept
+    {
+        words_type words{};
+        std::memcpy(words.data(), &value, sizeof(T));
+        for (std::size_t i = 0; i < word_count; ++i) {
+            this->m_data[i].store(words[i], std::memory_order_relaxed);
+        }
+    }
+};
+
+}  // namespace wwa::utils
+
+#endif /* CDA30D80_445B_45C9_A73B_587D74DCF772 */
@@ -0,0 +1,251 @@
+#ifndef ABE27DFA_18C2_43CD_AA27_F1197B9F83ED
+#define ABE27DFA_18C2_43CD_AA27_F1197B9F83ED
+
+/**
+ * @file
+ * @brief `success_action`: a scope guard that calls its exit function when a scope is exited normally.
+ *
+ * scope_action.h includes this header along with the other scope guards.
+ */
+
+#include <exception>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+#include "scope_action_detail.h"
+
+namespace wwa::utils {
+
+/**
+ * @brief A scope guard that calls its exit function when a scope is exited normally.
+ *
+ * Like `exit_action`, a `success_action` may be active or inactive. A `success_action` is active after construction
+ * from an exit function.
+ *
+ * An `success_action` becomes inactive by calling `release()` or a move constructor. An inactive `success_action`
+ * may also be obtained by initializing with another inactive `success_action`. Once an `success_action` is inactive,
+ * it cannot become active again.
+ *
+ * Usage example:
+ * @snippet{trimleft} scope_action.cpp Using success_action: runs only if no exception occurs
+ *
+ * @tparam ExitFunc Exit function type. Func is either a
+ * [Destructible](https://en.cppreference.com/w/cpp/named_req/Destructible)
+ * [FunctionObject](https://en.cppreference.com/w/cpp/named_req/FunctionObject) type, or an lvalue reference to a
+ * [FunctionObject](https://en.cppreference.com/w/cpp/named_req/FunctionObject) or function.
+ * @see https://en.cppreference.com/w/cpp/experimental/scope_success
+ * @note Constructing a `success_action` of dynamic storage duration might lead to unexpected behavior.
+ * @note Constructing a `success_action` from another `success_action` created in a different thread might also lead to
+ * unexpected behavior since the count of uncaught exceptions obtained in different threads may be compared during
+ * the destruction.
+ * @note If the exit function stored in an `success_action` object refers to a local variable of the function where it
+ * is defined (e.g., as a lambda capturing the variable by reference), and that variable is used as a return operand in
+ * that function, that variable might have already been returned when the `success_action`'s destructor executes,
+ * calling the exit function. This can lead to surprising behavior.
+ */
+template<typename ExitFunc>
+class [[nodiscard(
+    "The object must be used to ensure the exit function is called on a clean scope exit."
+)]] success_action {
+public:
+    /**
+     * @brief Constructs a new @a success_action from an exit function of type @a Func.
+     *
+     * Initializes the exit function with a function or function object, and initializes
+     * the counter of uncaught exceptions as if with `std::uncaught_exceptions()`.
+     * The constructed `success_action` is active.
+     *
+     * If `Func` is not an lvalue reference type, and `std::is_nothrow_constructible_v<ExitFunc, Func>` is `true`, the
+     * stored exit function is initialized with `std::forward<Func>(fn)`; otherwise it is initialized with `fn`. If
+     * initialization of the stored exit function throws an exception, calls `fn()`.
+     *
+     * This overload participates in overload resolution only if:
+     *   - `std::is_same_v<std::remove_cvref_t<Func>, success_action>` is `false`, and
+     *   - `std::is_constructible_v<ExitFunc, Func>` is `true`.
+     *
+     * @tparam Func Exit function type. Must be constructible from @a ExitFunc.
+     * @param fn Exit function.
+     * @throw anything Any exception thrown during the initialization of the stored exit function.
+     * @see https://en.cppreference.com/w/cpp/experimental/scope_success/scope_success
+     */
+    template<typename Func>
+    requires(detail::can_construct_from<success_action, ExitFunc, Func>)
+    explicit success_action(
+        Func&& fn
+    ) noexcept(std::is_nothrow_constructible_v<ExitFunc, Func> || std::is_nothrow_constructible_v<ExitFunc, Func&>)
+        : m_exit_function(
+              detail::conditional_forward(
+                  std::forward<Func>(fn),
+                  std::bool_constant<
+                      std::is_nothrow_constructible_v<ExitFunc, Func> && !std::is_lvalue_reference_v<Func>>()
+              )
+          )
+    {
+        WWA_SCOPE_PROBE(armed, scope_probe_kind::success, this);
+    }
+
+    /**
+     * @brief Constructs a new @a success_action from an exit function of type @a Func.
+     *
+     * Initializes the exit function with a function or function object `fn`. The constructed `success_action` is
+     * active. The stored exit function is initialized with `std::forward<Func>(fn)`.
+     *
+     * This overload participates in overload resolution only if:
+     *   - `std::is_same_v<std::remove_cvref_t<Func>, success_action>` is `false`, and
+     *   - `std::is_lvalue_reference_v<Func>` is `false`, and
+     *   - `std::is_nothrow_constructible_v<ExitFunc, Func>` is `true`.
+     *
+     * @tparam Func Exit function type. Must be constructible from @a ExitFunc.
+     * @param fn Exit function.
+     * @see https://en.cppreference.com/w/cpp/experimental/scope_success/scope_success
+     */
+    template<typename Func>
+    requires detail::can_move_construct_from_noexcept<success_action, ExitFunc, Func>
+    explicit success_action(Func&& fn) noexcept : m_exit_function(std::forward<Func>(fn))
+    {
+        WWA_SCOPE_PROBE(armed, scope_probe_kind::success, this);
+    }
+
+    /**
+     * @brief Constructs a new @a success_action that calls @a fn with bound arguments @a args.
+     *
+     * The stored exit function is a `bound_call` that holds decayed copies of `fn` and `args` (see bound_call.h); a
+     * pointer to member function can be followed by the object, which is stored as a pointer to it. The constructed
+     * `success_action` is active. Guards constructed from the same types of `fn` and `args` share one instantiation.
+     * If storing `fn` and `args` throws an exception, `fn` is not called.
+     *
+     * This overload participates in overload resolution only if `ExitFunc` is a `bound_call` constructible from `fn`
+     * and `args`.
+     *
+     * @tparam Func Callable type.
+     * @tparam Args Argument types.
+     * @param fn Callable, such as a function or a pointer to member function.
+     * @param args Arguments of `fn`.
+     * @throw anything Any exception thrown during the initialization of the stored exit function.
+     */
+    template<typename Func, typename... Args>
+    requires(sizeof...(Args) > 0 && std::is_constructible_v<ExitFunc, std::in_place_t, Func, Args...>)
+    success_action(Func&& fn, Args&&... args) noexcept(
+        std::is_nothrow_constructible_v<ExitFunc, std::in_place_t, Func, Args...>
+    )
+        : m_exit_function(std::in_place, std::forward<Func>(fn), std::forward<Args>(args)...)
+    {
+        WWA_SCOPE_PROBE(armed, scope_probe_kind::success, this);
+    }
+
+    /**
+     * @brief Move constructor.
+     *
+     * Initializes the stored exit function with the one in `other`, and initializes the counter of
+     * uncaught exceptions with the one in `other`. The constructed `success_action` is active
+     * if and only if `other` is active before the construction.
+     *
+     * If `std::is_nothrow_move_constructible_v<ExitFunc>` is true, initializes stored exit function (denoted by
+     * `exitfun`) with `std::forward<ExitFunc>(other.exitfun)`, otherwise initializes it with `other.exitfun`.
+     *
+     * After successful move construction, `other.release()` is called and `other` becomes inactive.
+     *
+     * This overload participates in overload resolution only if:
+     *   - `std::is_nothrow_move_constructible_v<ExitFunc>` is `true`, or
+     *   - `std::is_copy_constructible_v<ExitFunc>` is `true`.
+     *
+     * @param other `success_action` to move from.
+     * @throw anything Any exception thrown during the initialization of the stored exit function.
+     * @see https://en.cppreference.com/w/cpp/experimental/scope_success/scope_success
+     */
+    success_action(
+        success_action&& other
+    ) noexcept(std::is_nothrow_move_constructible_v<ExitFunc> || std::is_nothrow_copy_constructible_v<ExitFunc>)
+    requires(std::is_nothrow_move_constructible_v<ExitFunc> || std::is_copy_constructible_v<ExitFunc>)
+        : m_exit_function(
+              detail::conditional_forward(
+                  std::forward<ExitFunc>(other.m_exit_function),
+                  std::bool_constant<std::is_nothrow_move_constructible_v<ExitFunc>>()
+              )
+          ),
+          m_uncaught_exceptions_count(other.m_uncaught_exceptions_count)
+    {
+        other.release();
+        WWA_SCOPE_PROBE(armed, scope_probe_kind::success, this);
+    }
+
+    /** @cond */
+    /** @brief @a success_action is not @a CopyConstructible */
+    success_action(const success_action&)            = delete;
+    /** @brief @a success_action is not @a CopyAssignable */
+    success_action& operator=(const success_action&) = delete;
+    /** @brief @a success_action is not @a MoveAssignable */
+    success_action& operator=(success_action&&)      = delete;
+    /** @endcond */
+
+    /**
+     * @brief Calls the exit function when the scope is exited normally if the `success_action` is active, then destroys
+     * the object.
+     *
+     * Calls the exit function if the result of `std::uncaught_exceptions()` is less than or equal
+     * to the counter of uncaught exceptions (typically on normal exit) and the `success_action` is active,
+     * then destroys the object.
+     *
+     * @throws anything Throws any exception thrown by calling the exit function.
+     * @see https://en.cppreference.com/w/cpp/experimental/scope_success/%7Escope_success
+     */
+    ~success_action() noexcept(noexcept(this->m_exit_function()))
+    {
+        if (std::uncaught_exceptions() <= this->m_uncaught_exceptions_count) {
+            WWA_SCOPE_PROBE(fired, scope_probe_kind::success, this);
+            this->m_exit_function();
+        }
+
+        WWA_SCOPE_PROBE(exited, scope_probe_kind::success, this);
+    }
+
+    /**
+     * @brief Makes the @a success_action object inactive.
+     *
+     * Once an @a success_action is inactive, it cannot become active again, and it will not call its exit function upon
+     * destruction.
+     *
+     * @see https://en.cppreference.com/w/cpp/experimental/scope_exit/release
+     */
+    void release() noexcept
+    {
+        WWA_SCOPE_PROBE(released, scope_probe_kind::success, this);
+        this->m_uncaught_exceptions_count = std::numeric_limits<int>::min();
+    }
+
+private:
+    static_assert(
+        detail::capture_within_budget<ExitFunc>,
+        "success_action: the exit function is larger than WWA_SCOPE_ACTION_MAX_CAPTURE_SIZE bytes"
+    );
+    static_assert(
+        detail::capture_nothrow_movable<ExitFunc>,
+        "success_action: the exit function must be nothrow move constructible (WWA_SCOPE_ACTION_MAX_CAPTURE_SIZE)"
+    );
+
+    ExitFunc m_exit_function;                                      ///< The stored exit function.
+    int m_uncaught_exceptions_count = std::uncaught_exceptions();  ///< The counter of uncaught exceptions.
+};
+
+/**
+ * @brief Deduction guide for @a success_action.
+ *
+ * @tparam ExitFunc Exit function type.
+ */
+template<typename ExitFunc>
+success_action(ExitFunc) -> success_action<ExitFunc>;
+
+/**
+ * @brief Deduction guide for @a success_action constructed from a callable and its arguments.
+ *
+ * @tparam Func Callable type.
+ * @tparam Args Argument types.
+ */
+template<typename Func, typename... Args>
+requires(sizeof...(Args) > 0)
+success_action(Func&&, Args&&...) -> success_action<detail::bound_call_t<Func, Args...>>;
+
+}  // namespace wwa::utils
+
+#endif /* ABE27DFA_18C2_43CD_AA27_F1197B9F83ED */
@@ -0,0 +1,97 @@
+#ifndef FA8D3882_DEB9_4121_81CB_BF81E483166A
+#define FA8D3882_DEB9_4121_81CB_BF81E483166A
+
+/**
+ * @file
+ * @brief Small recycled indices of threads, for per-thread slots in shared data structures.
+ */
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+namespace wwa::utils {
+
+/// @cond INTERNAL
+
+namespace detail {
+
+/**
+ * @brief Assigns small indices to threads; an index is recycled when its thread exits.
+ */
+class thread_index {
+public:
+    /// @brief Maximum number of threads with an index; other threads get `none`.
+    static constexpr std::size_t max_threads = 256;
+
+    /// @brief Index of a thread that could not get one.
+    static constexpr std::size_t none = max_threads;
+
+    /**
+     * @brief Returns the index of the calling thread.
+     *
+     * @return Index less than `max_threads`, or `none`.
+     */
+    static std::size_t get() noexcept
+    {
+        static thread_local const holder h;
+        return h.index;
+    }
+
+private:
+    static constexpr std::size_t word_bits = 64;
+
+    struct holder {
+        std::size_t index = claim();
+
+        holder() noexcept = default;
+        holder(const holder&)            = delete;
+        holder(holder&&)                 = delete;
+        holder& operator=(const holder&) = delete;
+        holder& operator=(holder&&)      = delete;
+        ~holder() noexcept { release(this->index); }
+    };
+
+    using bitmap_type = std::array<std::atomic<std::uint64_t>, max_threads / word_bits>;
+
+    static bitmap_type& bitmap() noexcept
+    {
+        static bitmap_type used{};
+        return used;
+    }
+
+    static std::size_t claim() noexcept
+    {
+        for (std::size_t w = 0; w < bitmap().size(); ++w) {
+            auto& word      = bitmap()[w];
+            std::uint64_t v = word.load(std::memory_order_relaxed);
+            while (v != ~std::uint64_t{0}) {
+                const auto bit = static_cast<std::size_t>(std::countr_one(v));
+                // Acquire: the new owner sees everything the previous owner of the index did
+                if (word.compare_exchange_weak(v, v | (std::uint64_t{1} << bit), std::memory_order_acquire)) {
+                    return w * word_bits + bit;
+                }
+            }
+        }
+
+        return none;
+    }
+
+    static void release(std::size_t index) noexcept
+    {
+        if (index != none) {
+            const auto mask = ~(std::uint64_t{1} << (index % word_bits));
+            bitmap()[index / word_bits].fetch_and(mask, std::memory_order_release);
+        }
+    }
+};
+
+}  // namespace detail
+
+/// @endcond
+
+}  // namespace wwa::utils
+
+#endif /* FA8D3882_DEB9_4121_81CB_BF81E483166A */
@@ -0,0 +1,553 @@
+#ifndef A88D22B3_F54E_46FC_92E6_25B64088052F
+#define A88D22B3_F54E_46FC_92E6_25B64088052F
+
+/**
+ * @file
+ * @brief Low-overhead tracing zones with Chrome trace-event export.
+ *
+ * This file provides `trace_zone`, a scope that records its start and end timestamps, the thread, and a static name,
+ * and `trace_session`, which streams the recorded zones to a JSON file in the Chrome trace-event format. The files can
+ * be opened in `chrome://tracing`, Perfetto UI (https://ui.perfetto.dev), or Speedscope.
+ *
+ * Recording a zone does not allocate or lock: events go to a single-producer ring buffer owned by the thread, which a
+ * writer thread of the session drains periodically. If a ring is full, events are dropped and counted. The first zone
+ * recorded by a thread allocates its ring; call `trace_session::register_thread()` to do that in advance.
+ *
+ * Timestamps come from the time-stamp counter on x86-64 (calibrated against `CLOCK_MONOTONIC_RAW` when the session
+ * starts), or from `CLOCK_MONOTONIC_RAW` elsewhere. Define `WWA_TRACE_USE_TSC` to 0 to always use the latter.
+ *
+ * Zones that are exited via an exception are closed as usual and marked with `"args": {"exception": true}`.
+ *
+ * Usage example:
+ * @code{.cpp}
+ * int main()
+ * {
+ *     wwa::utils::trace_session session("trace.json");
+ *     run();
+ * }  // The trace is complete here
+ *
+ * void step()
+ * {
+ *     wwa::utils::trace_zone zone("step");
+ *     // ...
+ * }
+ * @endcode
+ *
+ * @note This header requires a POSIX system. Only one session can be active at a time.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <time.h>
+#include <unistd.h>
+
+#if !defined(WWA_TRACE_USE_TSC)
+#    if defined(__x86_64__) || defined(_M_X64)
+#        define WWA_TRACE_USE_TSC 1
+#    else
+#        define WWA_TRACE_USE_TSC 0
+#    endif
+#endif
+
+#if WWA_TRACE_USE_TSC
+#    include <x86intrin.h>
+#endif
+
+#include "exit_action.h"
+
+namespace wwa::utils {
+
+/// @cond INTERNAL
+
+namespace detail {
+
+/**
+ * @brief Returns the current `CLOCK_MONOTONIC_RAW` time (`CLOCK_MONOTONIC` where not available), in nanoseconds.
+ */
+inline std::uint64_t monotonic_raw_ns() noexcept
+{
+#if defined(CLOCK_MONOTONIC_RAW)
+    constexpr clockid_t clock = CLOCK_MONOTONIC_RAW;
+#else
+    constexpr clockid_t clock = CLOCK_MONOTONIC;
+#endif
+    struct timespec ts {};
+    ::clock_gettime(clock, &ts);
+    return static_cast<std::uint64_t>(ts.tv_sec) * 1'000'000'000U + static_cast<std::uint64_t>(ts.tv_nsec);
+}
+
+/**
+ * @brief Returns the current time in trace clock ticks.
+ */
+inline std::uint64_t trace_ticks() noexcept
+{
+#if WWA_TRACE_USE_TSC
+    return __rdtsc();
+#else
+    return monotonic_raw_ns();
+#endif
+}
+
+/**
+ * @brief A recorded zone.
+ */
+struct trace_event {
+    const char* name;     ///< Name of the zone.
+    std::uint64_t begin;  ///< Start, in ticks.
+    std::uint64_t end;    ///< End, in ticks.
+    bool failed;          ///< Whether the zone was exited via an exception.
+};
+
+/**
+ * @brief Single-producer, single-consumer ring of events of one thread.
+ */
+class trace_buffer {
+public:
+    /**
+     * @brief Creates a ring.
+     *
+     * @param capacity Number of events; a power of two.
+     * @param tid Thread identifier used in the trace.
+     */
+    trace_buffer(std::size_t capacity, std::uint64_t tid)
+        : m_events(std::make_unique<trace_event[]>(capacity)), m_mask(capacity - 1), m_tid(tid)
+    {}
+
+    /**
+     * @brief Appends an event; called only by the owning thread.
+     *
+     * @param e Event.
+     */
+    void push(const trace_event& e) noexcept
+    {
+        const auto head = this->m_head.load(std::memory_order_relaxed);
+        if (head - this->m_cached_tail > this->m_mask) [[unlikely]] {
+            this->m_cached_tail = this->m_tail.load(std::memory_order_acquire);
+            if (head - this->m_cached_tail > this->m_mask) {
+                this->m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+
+        this->m_events[head & this->m_mask] = e;
+        this->m_head.store(head + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Removes all available events; called only by the writer.
+     *
+     * @param fn Called for each event.
+     */
+    template<typename Func>
+    void drain(Func&& fn)
+    {
+        const auto tail = this->m_tail.load(std::memory_order_relaxed);
+        const auto head = this->m_head.load(std::memory_order_acquire);
+        for (auto i = tail; i != head; ++i) {
+            fn(this->m_events[i & this->m_mask]);
+        }
+
+        this->m_tail.store(head, std::memory_order_release);
+    }
+
+    /**
+     * @brief Checks whether the writer has drained all events; called only by the writer.
+     */
+    [[nodiscard]] bool empty() const noexcept
+    {
+        return this->m_tail.load(std::memory_order_relaxed) == this->m_head.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] std::uint64_t tid() const noexcept { return this->m_tid; }
+    [[nodiscard]] std::uint64_t dropped() const noexcept { return this->m_dropped.load(std::memory_order_relaxed); }
+    [[nodiscard]] bool retired() const noexcept { return this->m_retired.load(std::memory_order_acquire); }
+    void retire() noexcept { this->m_retired.store(true, std::memory_order_release); }
+
+private:
+    static constexpr std::size_t cache_line_size = 64;
+
+    std::unique_ptr<trace_event[]> m_events;  ///< Events.
+    std::size_t m_mask;                       ///< Capacity minus one.
+    std::uint64_t m_tid;                      ///< Thread identifier.
+    std::atomic<bool> m_retired{false};       ///< Whether the thread has exited.
+
+    alignas(cache_line_size) std::atomic<std::uint64_t> m_head{0};  ///< Next event to write (producer).
+    std::uint64_t m_cached_tail = 0;                                ///< Last observed tail (producer).
+    std::atomic<std::uint64_t> m_dropped{0};                        ///< Number of dropped events (producer).
+    alignas(cache_line_size) std::atomic<std::uint64_t> m_tail{0};  ///< Next event to read (writer).
+};
+
+/**
+ * @brief Rings of all threads that have recorded zones.
+ */
+struct trace_registry {
+    std::mutex mutex;                                    ///< Protects `buffers` and `next_tid`.
+    std::vector<std::shared_ptr<trace_buffer>> buffers;  ///< Rings.
+    std::uint64_t next_tid = 1;                          ///< Next thread identifier.
+    std::size_t capacity   = 0;                          ///< Capacity of new rings; 0 if no session is active.
+    std::atomic<bool> active{false};                     ///< Whether a session is active.
+
+    static trace_registry& instance() noexcept
+    {
+        static trace_registry registry;
+        return registry;
+    }
+};
+
+/**
+ * @brief Owns the ring of the current thread and retires it on thread exit.
+ */
+struct trace_thread {
+    std::shared_ptr<trace_buffer> buffer;
+
+    trace_thread() noexcept = default;
+    trace_thread(const trace_thread&)            = delete;
+    trace_thread(trace_thread&&)                 = delete;
+    trace_thread& operator=(const trace_thread&) = delete;
+    trace_thread& operator=(trace_thread&&)      = delete;
+
+    ~trace_thread()
+    {
+        if (this->buffer) {
+            this->buffer->retire();
+        }
+    }
+
+    /**
+     * @brief Returns the ring of the current thread, creating it if necessary.
+     *
+     * @return The ring, or `nullptr` if no session is active or memory allocation failed.
+     */
+    static trace_buffer* get() noexcept
+    {
+        static thread_local trace_thread self;
+        if (self.buffer) [[likely]] {
+            return self.buffer.get();
+        }
+
+        auto& registry = trace_registry::instance();
+        const std::lock_guard lock(registry.mutex);
+        if (registry.capacity == 0) {
+            return nullptr;
+        }
+
+        try {
+            self.buffer = std::make_shared<trace_buffer>(registry.capacity, registry.next_tid);
+            registry.buffers.push_back(self.buffer);
+            ++registry.next_tid;
+        }
+        catch (const std::bad_alloc&) {
+            self.buffer.reset();
+            return nullptr;
+        }
+
+        return self.buffer.get();
+    }
+};
+
+}  // namespace detail
+
+/// @endcond
+
+/**
+ * @brief Options of a `trace_session`.
+ */
+struct trace_options {
+    std::size_t buffer_events = 16384;             ///< Capacity of rings created for new threads; a power of two.
+    std::chrono::milliseconds flush_interval{10};  ///< How often the writer drains the rings.
+    std::chrono::milliseconds calibration{5};      ///< Duration of the time-stamp counter calibration.
+};
+
+/**
+ * @brief Streams the zones recorded by all threads to a Chrome trace-event JSON file.
+ *
+ * While the session is active, `trace_zone`s are recorded. When the session is destroyed, the remaining events are
+ * written, and the file is completed.
+ */
+class trace_session {
+public:
+    /**
+     * @brief Starts a session.
+     *
+     * @param path Output file.
+     * @param opts Options.
+     * @throw std::invalid_argument `buffer_events` is not a power of two.
+     * @throw std::logic_error Another session is active.
+     * @throw std::runtime_error The file could not be opened.
+     * @throw std::system_error The writer thread could not be started.
+     */
+    explicit trace_session(const std::string& path, trace_options opts = {})
+        : m_out(path, std::ios::out | std::ios::trunc), m_options(opts)
+    {
+        if (!std::has_single_bit(opts.buffer_events)) {
+            throw std::invalid_argument("trace_session: buffer_events must be a power of two");
+        }
+
+        if (!this->m_out) {
+            throw std::runtime_error("trace_session: cannot open " + path);
+        }
+
+        this->calibrate();
+        this->m_out << std::fixed << std::setprecision(3) << R"({"displayTimeUnit":"ns","traceEvents":[)";
+        this->m_out << R"({"name":"process_name","ph":"M","pid":)" << ::getpid() << R"(,"args":{"name":"trace"}})";
+
+        auto& registry = detail::trace_registry::instance();
+        {
+            const std::lock_guard lock(registry.mutex);
+            if (registry.capacity != 0) {
+                throw std::logic_error("trace_session: another session is active");
+            }
+
+            // Discard whatever zones that spanned the end of the previous session have left behind
+            std::erase_if(registry.buffers, [](const auto& b) { return b->retired(); });
+            for (const auto& b : registry.buffers) {
+                b->drain([](const detail::trace_event&) {});
+            }
+
+            registry.capacity = opts.buffer_events;
+        }
+
+        try {
+            this->m_writer = std::thread([this]() { this->run(); });
+        }
+        catch (...) {
+            const std::lock_guard lock(registry.mutex);
+            registry.capacity = 0;
+            throw;
+        }
+
+        registry.active.store(true, std::memory_order_release);
+    }
+
+    /** @cond */
+    trace_session(const trace_session&)            = delete;
+    trace_session(trace_session&&)                 = delete;
+    trace_session& operator=(const trace_session&) = delete;
+    trace_session& operator=(trace_session&&)      = delete;
+    /** @endcond */
+
+    /**
+     * @brief Stops recording, writes the remaining events, and completes the file.
+     */
+    ~trace_session()
+    {
+        auto& registry = detail::trace_registry::instance();
+        registry.active.store(false, std::memory_order_release);
+        {
+            const std::lock_guard lock(this->m_mutex);
+            this->m_stop = true;
+        }
+
+        this->m_wakeup.notify_all();
+        this->m_writer.join();
+
+        this->flush();
+        this->m_out << "]}\n";
+
+        const std::lock_guard lock(registry.mutex);
+        registry.capacity = 0;
+    }
+
+    /**
+     * @brief Creates the ring of the calling thread, so that recording its first zone does not allocate.
+     *
+     * @return Whether the thread can record zones.
+     */
+    static bool register_thread() noexcept { return detail::trace_thread::get() != nullptr; }
+
+    /**
+     * @brief Returns the number of events dropped so far because a ring was full.
+     *
+     * @return Number of dropped events.
+     */
+    [[nodiscard]] std::uint64_t dropped() const
+    {
+        auto& registry = detail::trace_registry::instance();
+        const std::lock_guard lock(registry.mutex);
+        std::uint64_t n = 0;
+        for (const auto& b : registry.buffers) {
+            n += b->dropped();
+        }
+
+        return n;
+    }
+
+    /**
+     * @brief Writes all events recorded so far to the file.
+     */
+    void flush()
+    {
+        const std::lock_guard flush_lock(this->m_flush_mutex);
+        std::vector<std::shared_ptr<detail::trace_buffer>> buffers;
+        {
+            auto& registry = detail::trace_registry::instance();
+            const std::lock_guard lock(registry.mutex);
+            buffers = registry.buffers;
+        }
+
+        const auto pid = static_cast<long>(::getpid());
+        for (const auto& b : buffers) {
+            b->drain([this, pid, tid = b->tid()](const detail::trace_event& e) { this->write(e, pid, tid); });
+        }
+
+        this->m_out.flush();
+    }
+
+private:
+    std::ofstream m_out;               ///< Output file.
+    trace_options m_options;           ///< Options.
+    std::uint64_t m_base_ticks = 0;    ///< Ticks at the start of the session.
+    double m_ns_per_tick       = 1.0;  ///< Tick duration.
+    std::mutex m_flush_mutex;          ///< Serializes `flush()`.
+    std::mutex m_mutex;                ///< Protects `m_stop`.
+    std::condition_variable m_wakeup;  ///< Wakes up the writer.
+    bool m_stop = false;               ///< Whether the writer must exit.
+    std::thread m_writer;              ///< Writer thread.
+
+    /**
+     * @brief Measures the duration of a tick.
+     */
+    void calibrate()
+    {
+#if WWA_TRACE_USE_TSC
+        const auto ns0 = detail::monotonic_raw_ns();
+        const auto t0  = detail::trace_ticks();
+        std::this_thread::sleep_for(this->m_options.calibration);
+        const auto ns1 = detail::monotonic_raw_ns();
+        const auto t1  = detail::trace_ticks();
+        if (t1 > t0) {
+            this->m_ns_per_tick = static_cast<double>(ns1 - ns0) / static_cast<double>(t1 - t0);
+        }
+#endif
+        this->m_base_ticks = detail::trace_ticks();
+    }
+
+    void run()
+    {
+        std::unique_lock lock(this->m_mutex);
+        while (!this->m_wakeup.wait_for(lock, this->m_options.flush_interval, [this]() { return this->m_stop; })) {
+            lock.unlock();
+            this->flush();
+            this->collect();
+            lock.lock();
+        }
+    }
+
+    /**
+     * @brief Forgets the rings of exited threads once they have been drained.
+     */
+    void collect()
+    {
+        auto& registry = detail::trace_registry::instance();
+        const std::lock_guard lock(registry.mutex);
+        std::erase_if(registry.buffers, [](const auto& b) {
+            return b->retired() && b.use_count() == 1 && b->empty();
+        });
+    }
+
+    /**
+     * @brief Converts ticks to microseconds since the start of the session.
+     */
+    [[nodiscard]] double to_us(std::uint64_t ticks) const noexcept
+    {
+        const auto delta = static_cast<double>(static_cast<std::int64_t>(ticks - this->m_base_ticks));
+        return delta * this->m_ns_per_tick / 1000.0;
+    }
+
+    void write(const detail::trace_event& e, long pid, std::uint64_t tid)
+    {
+        this->m_out << R"(,{"name":")";
+        for (const char* p = e.name; *p != '\0'; ++p) {
+            const char c = *p;
+            if (c == '"' || c == '\\') {
+                this->m_out << '\\' << c;
+            }
+            else if (static_cast<unsigned char>(c) < 0x20) {
+                this->m_out << ' ';
+            }
+            else {
+                this->m_out << c;
+            }
+        }
+
+        const double ts  = this->to_us(e.begin);
+        const double dur = this->to_us(e.end) - ts;
+        this->m_out << R"(","ph":"X","ts":)" << ts << R"(,"dur":)" << dur << R"(,"pid":)" << pid << R"(,"tid":)"
+                    << tid;
+        if (e.failed) {
+            this->m_out << R"(,"args":{"exception":true})";
+        }
+
+        this->m_out << '}';
+    }
+};
+
+/**
+ * @brief A scope that is recorded as a zone if a `trace_session` is active.
+ *
+ * @note Constructing a `trace_zone` of dynamic storage duration might lead to unexpected behavior.
+ */
+class [[nodiscard("The object must be used to record the zone on scope exit.")]] trace_zone {
+    /// @cond INTERNAL
+    struct record_fn {
+        trace_zone* zone;
+        void operator()() const noexcept { this->zone->record(); }
+    };
+    /// @endcond
+
+public:
+    /**
+     * @brief Starts a zone.
+     *
+     * @param name Name of the zone; must be a string with static storage duration.
+     */
+    explicit trace_zone(const char* name) noexcept
+        : m_buffer(detail::trace_registry::instance().active.load(std::memory_order_relaxed)
+                       ? detail::trace_thread::get()
+                       : nullptr),
+          m_name(name), m_begin(m_buffer != nullptr ? detail::trace_ticks() : 0),
+          m_uncaught_exceptions_count(m_buffer != nullptr ? std::uncaught_exceptions() : 0), m_on_exit(record_fn{this})
+    {}
+
+    /** @cond */
+    trace_zone(const trace_zone&)            = delete;
+    trace_zone(trace_zone&&)                 = delete;
+    trace_zone& operator=(const trace_zone&) = delete;
+    trace_zone& operator=(trace_zone&&)      = delete;
+    ~trace_zone() noexcept                   = default;
+    /** @endcond */
+
+private:
+    detail::trace_buffer* m_buffer;    ///< Ring of the thread, or `nullptr`.
+    const char* m_name;                ///< Name of the zone.
+    std::uint64_t m_begin;             ///< Start, in ticks.
+    int m_uncaught_exceptions_count;   ///< The counter of uncaught exceptions.
+    exit_action<record_fn> m_on_exit;  ///< Records the zone on scope exit.
+
+    void record() noexcept
+    {
+        if (this->m_buffer != nullptr) {
+            const bool failed = std::uncaught_exceptions() > this->m_uncaught_exceptions_count;
+            this->m_buffer->push({this->m_name, this->m_begin, detail::trace_ticks(), failed});
+        }
+    }
+};
+
+}  // namespace wwa::utils
+
+#endif /* A88D22B3_F54E_46FC_92E6_25B64088052F */
@@ -0,0 +1,525 @@
+#ifndef F1C94A6E_3B7D_4F28_A0D5_8E2B61C7094F
+#define F1C94A6E_3B7D_4F28_A0D5_8E2B61C7094F
+
+/**
+ * @file
+ * @brief Durable, memory-mapped undo journal for crash-consistent updates of memory-mapped files.
+ *
+ * This file provides `undo_journal`, which protects a memory-mapped region (typically a `MAP_SHARED` mapping of a data
+ * file) against half-finished modifications. Before a part of the region is modified, its old bytes are appended to a
+ * memory-mapped journal file as a checksummed record. If the process crashes before the transaction is committed, the
+ * next `undo_journal` opened on the same journal and region restores the old bytes (*recovery*).
+ *
+ * Flushes happen only at transaction boundaries: on commit, the region is flushed first, and only then the journal is
+ * marked as committed (and flushed). Records of an open transaction live in the page cache, which survives process
+ * crashes; to also survive a power failure, they must reach the disk before the modified data does, which can be
+ * requested with `undo_journal::sync_mode::record` at the cost of one flush per record.
+ *
+ * `undo_journal::transaction` is a scope guard built on `success_action` and `fail_action`: it commits the journal
+ * when its scope is exited normally, and rolls the region back when the scope is exited via an exception.
+ *
+ * Usage example:
+ * @code{.cpp}
+ * std::span<std::byte> region = map_data_file("store.dat");
+ * wwa::utils::undo_journal journal("store.journal", region);  // Rolls back an interrupted transaction, if any
+ * {
+ *     auto tx = journal.begin();
+ *     auto& hdr = *reinterpret_cast<store_header*>(region.data());
+ *     journal.save(hdr.count, hdr.tail);
+ *     ++hdr.count;
+ *     hdr.tail = append(region, item);  // If this throws, or the process crashes, `hdr` is restored
+ * }  // Committed here
+ * @endcode
+ *
+ * @note This header requires a POSIX system.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "fail_action.h"
+#include "posix_error.h"
+#include "success_action.h"
+
+namespace wwa::utils {
+
+/// @cond INTERNAL
+
+namespace detail {
+
+/**
+ * @brief Lookup table for CRC-32 (IEEE 802.3, reflected polynomial 0xEDB88320).
+ */
+inline constexpr std::array<std::uint32_t, 256> crc32_table = []() {
+    std::array<std::uint32_t, 256> table{};
+    for (std::uint32_t i = 0; i < table.size(); ++i) {
+        std::uint32_t c = i;
+        for (int k = 0; k < 8; ++k) {
+            c = (c & 1U) != 0 ? 0xEDB8'8320U ^ (c >> 1U) : c >> 1U;
+        }
+
+        table[i] = c;
+    }
+
+    return table;
+}();
+
+/**
+ * @brief Updates a CRC-32 checksum.
+ *
+ * @param crc Current checksum (0 for a new checksum).
+ * @param data Data.
+ * @param size Size of the data.
+ * @return Updated checksum.
+ */
+inline std::uint32_t crc32(std::uint32_t crc, const void* data, std::size_t size) noexcept
+{
+    const auto* p = static_cast<const unsigned char*>(data);
+    crc           = ~crc;
+    for (std::size_t i = 0; i < size; ++i) {
+        crc = crc32_table[(crc ^ p[i]) & 0xFFU] ^ (crc >> 8U);
+    }
+
+    return ~crc;
+}
+
+}  // namespace detail
+
+/// @endcond
+
+/**
+ * @brief A durable undo journal protecting a memory-mapped region.
+ *
+ * The journal supports one transaction at a time. A transaction starts implicitly with the first `save()` after
+ * construction, `commit()`, or `rollback()`.
+ *
+ * @note The journal is not thread-safe.
+ */
+class undo_journal {
+    /// @cond INTERNAL
+    static constexpr std::uint64_t magic = 0x3130'4F44'4E55'4157U;  // "WAUNDO01"
+
+    struct file_header {
+        std::uint64_t magic;        ///< Journal signature.
+        std::uint64_t transaction;  ///< Current transaction; records of other transactions are stale.
+        std::uint64_t capacity;     ///< Size of the record area.
+        std::uint64_t reserved;     ///< Reserved; always zero.
+    };
+
+    struct record_header {
+        std::uint32_t checksum;     ///< CRC-32 of the rest of the header and the payload.
+        std::uint32_t size;         ///< Payload size.
+        std::uint64_t transaction;  ///< Transaction the record belongs to.
+        std::uint64_t offset;       ///< Offset of the saved bytes in the region.
+    };
+
+    static constexpr std::size_t align(std::size_t n) noexcept { return (n + 7U) & ~std::size_t{7}; }
+    /// @endcond
+
+public:
+    /**
+     * @brief When the records are flushed to the disk.
+     */
+    enum class sync_mode : std::uint8_t {
+        commit,  ///< Only at transaction boundaries; protects against process crashes.
+        record   ///< Also after every record; additionally protects against power failures.
+    };
+
+    /**
+     * @brief Default capacity of the journal record area, in bytes.
+     */
+    static constexpr std::size_t default_capacity = std::size_t{1} << 20U;
+
+    /**
+     * @brief A transaction scope.
+     *
+     * Commits the journal when the scope is exited normally (the destructor throws if the commit fails), and rolls
+     * the region back when the scope is exited via an exception.
+     *
+     * @note Constructing a `transaction` of dynamic storage duration might lead to unexpected behavior.
+     */
+    class [[nodiscard("The object must be used to commit or roll back the transaction.")]] transaction {
+        /// @cond INTERNAL
+        struct commit_fn {
+            undo_journal* journal;
+            void operator()() const { this->journal->commit(); }
+        };
+
+        struct rollback_fn {
+            undo_journal* journal;
+            void operator()() const noexcept { this->journal->rollback(); }
+        };
+        /// @endcond
+
+    public:
+        /**
+         * @brief Starts a transaction.
+         *
+         * @param journal The journal.
+         */
+        explicit transaction(undo_journal& journal) noexcept
+            : m_on_success(commit_fn{&journal}), m_on_fail(rollback_fn{&journal})
+        {}
+
+        /**
+         * @brief Makes the transaction inactive: it will neither commit nor roll back on scope exit.
+         */
+        void release() noexcept
+        {
+            this->m_on_success.release();
+            this->m_on_fail.release();
+        }
+
+    private:
+        success_action<commit_fn> m_on_success;  ///< Commits the journal on success.
+        fail_action<rollback_fn> m_on_fail;      ///< Rolls the region back on failure.
+    };
+
+    /**
+     * @brief Opens (or creates) a journal for @a region and recovers an interrupted transaction.
+     *
+     * If the journal contains records of an uncommitted transaction, their old bytes are written back into @a region
+     * in reverse order, the region is flushed, and the journal is reset. The number of restored records is available
+     * from `recovered()`.
+     *
+     * @param path Journal file.
+     * @param region The protected region. It must be the same region (or a mapping of the same file) each time the
+     * journal is opened.
+     * @param capacity Minimum size of the record area, in bytes.
+     * @param mode Flush policy.
+     * @throw std::system_error A system call failed.
+     * @throw std::runtime_error The file exists, but is not an undo journal.
+     */
+    undo_journal(
+        const std::filesystem::path& path, std::span<std::byte> region, std::size_t capacity = default_capacity,
+        sync_mode mode = sync_mode::commit
+    )
+        : m_region(region), m_mode(mode)
+    {
+        this->m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);  // NOLINT(*-vararg)
+        if (this->m_fd == -1) {
+            detail::throw_errno("open");
+        }
+
+        auto close_fd = fail_action([this]() noexcept { ::close(this->m_fd); });
+
+        struct stat st{};
+        if (::fstat(this->m_fd, &st) == -1) {
+            detail::throw_errno("fstat");
+        }
+
+        const auto existing = static_cast<std::size_t>(st.st_size);
+        file_header hdr{};
+        if (existing >= sizeof(file_header)) {
+            if (::pread(this->m_fd, &hdr, sizeof(hdr), 0) != static_cast<ssize_t>(sizeof(hdr)) || hdr.magic != magic) {
+                throw std::runtime_error("Not an undo journal: " + path.string());
+            }
+        }
+
+        capacity     = align(std::max<std::size_t>({capacity, hdr.capacity, sizeof(record_header) + 8}));
+        this->m_size = sizeof(file_header) + capacity;
+        if (existing < this->m_size) {
+            if (::ftruncate(this->m_fd, static_cast<off_t>(this->m_size)) == -1) {
+                detail::throw_errno("ftruncate");
+            }
+
+            if (::fdatasync(this->m_fd) == -1) {
+                detail::throw_errno("fdatasync");
+            }
+        }
+
+        void* map = ::mmap(nullptr, this->m_size, PROT_READ | PROT_WRITE, MAP_SHARED, this->m_fd, 0);
+        if (map == MAP_FAILED) {  // NOLINT(*-cstyle-cast,performance-no-int-to-ptr)
+            detail::throw_errno("mmap");
+        }
+
+        this->m_map      = static_cast<std::byte*>(map);
+        auto unmap       = fail_action([this]() noexcept { ::munmap(this->m_map, this->m_size); });
+        auto* header     = this->header();
+        header->capacity = capacity;
+        if (header->magic != magic) {
+            // Zero-filled records of a new journal must not belong to the current transaction
+            header->magic       = magic;
+            header->transaction = 1;
+        }
+
+        this->m_recovered = this->recover();
+        if (this->m_recovered == 0 && existing < sizeof(file_header)) {
+            this->sync_journal();
+        }
+    }
+
+    /** @cond */
+    undo_journal(const undo_journal&)            = delete;
+    undo_journal(undo_journal&&)                 = delete;
+    undo_journal& operator=(const undo_journal&) = delete;
+    undo_journal& operator=(undo_journal&&)      = delete;
+    /** @endcond */
+
+    /**
+     * @brief Closes the journal.
+     *
+     * An open transaction is neither committed nor rolled back; it will be rolled back by recovery.
+     */
+    ~undo_journal() noexcept
+    {
+        ::munmap(this->m_map, this->m_size);
+        ::close(this->m_fd);
+    }
+
+    /**
+     * @brief Starts a transaction scope.
+     *
+     * @return Transaction scope.
+     */
+    [[nodiscard]] transaction begin() noexcept { return transaction(*this); }
+
+    /**
+     * @brief Returns the number of records restored by recovery when the journal was opened.
+     *
+     * @return Number of restored records.
+     */
+    [[nodiscard]] std::size_t recovered() const noexcept { return this->m_recovered; }
+
+    /**
+     * @brief Returns the number of records in the current transaction.
+     *
+     * @return Number of records.
+     */
+    [[nodiscard]] std::size_t size() const noexcept { return this->m_records.size(); }
+
+    /**
+     * @brief Saves the current bytes of a part of the region.
+     *
+     * @param address Start of the part; must lie within the region.
+     * @param size Size of the part.
+     * @throw std::out_of_range The part does not lie within the region.
+     * @throw std::length_error The journal is full.
+     * @throw std::system_error Flushing the record failed (`sync_mode::record` only).
+     * @throw std::bad_alloc Memory allocation failed.
+     */
+    void save_bytes(const void* address, std::size_t size)
+    {
+        const auto* p     = static_cast<const std::byte*>(address);
+        const auto offset = static_cast<std::size_t>(p - this->m_region.data());
+        if (p < this->m_region.data() || offset > this->m_region.size() || size > this->m_region.size() - offset) {
+            throw std::out_of_range("undo_journal: the saved range is outside of the region");
+        }
+
+        const auto length = sizeof(record_header) + align(size);
+        if (length > this->m_size - this->m_end || size > UINT32_MAX) {
+            throw std::length_error("undo_journal: the journal is full");
+        }
+
+        if (this->m_records.size() == this->m_records.capacity()) {
+            this->m_records.reserve(std::max<std::size_t>(16, this->m_records.capacity() * 2));
+        }
+
+        record_header rec{0, static_cast<std::uint32_t>(size), this->header()->transaction, offset};
+        std::byte* dst = this->m_map + this->m_end;
+        rec.checksum   = checksum(rec, p);
+        std::memcpy(dst + sizeof(record_header), p, size);
+        std::memcpy(dst, &rec, sizeof(rec));
+
+        if (this->m_mode == sync_mode::record) {
+            sync(dst, length, "msync");
+        }
+
+        this->m_records.push_back(this->m_end);
+        this->m_end         = this->m_end + length;
+        this->m_dirty_begin = std::min(this->m_dirty_begin, offset);
+        this->m_dirty_end   = std::max(this->m_dirty_end, offset + size);
+    }
+
+    /**
+     * @brief Saves the current values of objects residing in the region.
+     *
+     * @tparam T Object types. Must be trivially copyable.
+     * @param objects Objects to save.
+     * @throw std::out_of_range An object does not lie within the region.
+     * @throw std::length_error The journal is full.
+     * @throw std::system_error Flushing a record failed (`sync_mode::record` only).
+     * @throw std::bad_alloc Memory allocation failed.
+     */
+    template<typename... T>
+    requires(sizeof...(T) > 0 && (std::is_trivially_copyable_v<T> && ...))
+    void save(const T&... objects)
+    {
+        (this->save_bytes(std::addressof(objects), sizeof(T)), ...);
+    }
+
+    /**
+     * @brief Commits the current transaction.
+     *
+     * Flushes the saved parts of the region, then marks the records as stale and flushes the journal.
+     *
+     * @throw std::system_error Flushing failed. The transaction remains open and can be rolled back.
+     */
+    void commit()
+    {
+        if (!this->m_records.empty()) {
+            this->sync_region();
+            this->finish();
+            this->sync_journal();
+        }
+    }
+
+    /**
+     * @brief Rolls the current transaction back.
+     *
+     * Restores the saved bytes in reverse order, flushes the region, and resets the journal. If flushing fails,
+     * the records are kept in the journal (new records are appended after them), so that recovery repeats the rollback
+     * if the process crashes before the next commit.
+     */
+    void rollback() noexcept
+    {
+        for (auto it = this->m_records.rbegin(); it != this->m_records.rend(); ++it) {
+            record_header rec{};
+            std::memcpy(&rec, this->m_map + *it, sizeof(rec));
+            std::memcpy(this->m_region.data() + rec.offset, this->m_map + *it + sizeof(rec), rec.size);
+        }
+
+        if (!this->m_records.empty()) {
+            try {
+                this->sync_region();
+                this->finish();
+                this->sync_journal();
+            }
+            catch (const std::system_error&) {
+                this->m_records.clear();
+            }
+        }
+    }
+
+private:
+    std::span<std::byte> m_region;                    ///< The protected region.
+    sync_mode m_mode;                                 ///< Flush policy.
+    int m_fd                  = -1;                   ///< Journal file descriptor.
+    std::byte* m_map          = nullptr;              ///< Journal mapping.
+    std::size_t m_size        = 0;                    ///< Size of the journal mapping.
+    std::size_t m_end         = sizeof(file_header);  ///< Offset of the end of the last record.
+    std::size_t m_dirty_begin = SIZE_MAX;             ///< Start of the saved part of the region.
+    std::size_t m_dirty_end   = 0;                    ///< End of the saved part of the region.
+    std::size_t m_recovered   = 0;                    ///< Number of records restored by recovery.
+    std::vector<std::size_t> m_records;               ///< Offsets of the records of the current transaction.
+
+    /**
+     * @brief Returns the journal file header.
+     *
+     * @return File header.
+     */
+    [[nodiscard]] file_header* header() const noexcept { return reinterpret_cast<file_header*>(this->m_map); }
+
+    /**
+     * @brief Computes the checksum of a record.
+     *
+     * @param rec Record header.
+     * @param payload Payload.
+     * @return Checksum.
+     */
+    static std::uint32_t checksum(const record_header& rec, const void* payload) noexcept
+    {
+        const auto* fields = reinterpret_cast<const std::byte*>(&rec) + sizeof(rec.checksum);
+        const auto crc     = detail::crc32(0, fields, sizeof(rec) - sizeof(rec.checksum));
+        return detail::crc32(crc, payload, rec.size);
+    }
+
+    /**
+     * @brief Synchronously flushes a memory range to the disk.
+     *
+     * @param address Start of the range.
+     * @param size Size of the range.
+     * @param what Description of the operation for the exception.
+     * @throw std::system_error `msync()` failed.
+     */
+    static void sync(void* address, std::size_t size, const char* what)
+    {
+        static const auto page_size = static_cast<std::uintptr_t>(::sysconf(_SC_PAGESIZE));
+        const auto start            = reinterpret_cast<std::uintptr_t>(address) & ~(page_size - 1);
+        const auto length           = reinterpret_cast<std::uintptr_t>(address) + size - start;
+        if (size != 0 && ::msync(reinterpret_cast<void*>(start), length, MS_SYNC) == -1) {  // NOLINT(*-no-int-to-ptr)
+            detail::throw_errno(what);
+        }
+    }
+
+    /**
+     * @brief Flushes the journal header.
+     */
+    void sync_journal() { sync(this->m_map, sizeof(file_header), "msync"); }
+
+    /**
+     * @brief Flushes the saved part of the region.
+     */
+    void sync_region()
+    {
+        if (this->m_dirty_begin < this->m_dirty_end) {
+            sync(this->m_region.data() + this->m_dirty_begin, this->m_dirty_end - this->m_dirty_begin, "msync");
+        }
+    }
+
+    /**
+     * @brief Marks the records of the current transaction as stale.
+     */
+    void finish() noexcept
+    {
+        ++this->header()->transaction;
+        this->m_records.clear();
+        this->m_end         = sizeof(file_header);
+        this->m_dirty_begin = SIZE_MAX;
+        this->m_dirty_end   = 0;
+    }
+
+    /**
+     * @brief Restores the region from the records of an interrupted transaction.
+     *
+     * Scanning stops at the first record that belongs to another transaction, or whose checksum does not match
+     * (a record torn by a crash).
+     *
+     * @return Number of restored records.
+     */
+    std::size_t recover()
+    {
+        const auto transaction = this->header()->transaction;
+        std::size_t pos        = sizeof(file_header);
+        while (this->m_size - pos >= sizeof(record_header)) {
+            record_header rec{};
+            std::memcpy(&rec, this->m_map + pos, sizeof(rec));
+            const auto length = sizeof(record_header) + align(rec.size);
+            if (rec.transaction != transaction || length > this->m_size - pos ||
+                rec.offset > this->m_region.size() || rec.size > this->m_region.size() - rec.offset ||
+                rec.checksum != checksum(rec, this->m_map + pos + sizeof(rec)))
+            {
+                break;
+            }
+
+            this->m_records.push_back(pos);
+            this->m_dirty_begin = std::min<std::size_t>(this->m_dirty_begin, rec.offset);
+            this->m_dirty_end   = std::max<std::size_t>(this->m_dirty_end, rec.offset + rec.size);
+            pos += length;
+        }
+
+        this->m_end      = pos;
+        const auto count = this->m_records.size();
+        this->rollback();
+        return count;
+    }
+};
+
+}  // namespace wwa::utils
+
+#endif /* F1C94A6E_3B7D_4F28_A0D5_8E2B61C7094F */
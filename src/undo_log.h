@@ -0,0 +1,405 @@
+#ifndef B3F0E7C1_5A2D_4E8B_9C61_2D7F4A8E0B53
+#define B3F0E7C1_5A2D_4E8B_9C61_2D7F4A8E0B53
+
+/**
+ * @file
+ * @brief Undo log for all-or-nothing in-place mutations.
+ *
+ * This file provides `undo_log`, which records the old values of objects before they are modified, so that the
+ * modifications can be undone. Old values are stored in an arena owned by the log; they are restored in reverse order.
+ *
+ * `undo_log::savepoint` is a scope guard built on `fail_action` and `success_action`: when its scope is exited via an
+ * exception, all modifications recorded since the savepoint was created are undone; when the outermost savepoint is
+ * exited normally, the log is committed (cleared). Savepoints may be nested to provide partial rollback; the log tracks
+ * the nesting depth, so a savepoint is outermost regardless of how many records the log held when it was created.
+ *
+ * Usage example:
+ * @code{.cpp}
+ * wwa::utils::undo_log log;
+ *
+ * auto tx = log.begin();
+ * log.save(account.balance, account.version);
+ * account.balance -= amount;
+ * ++account.version;
+ * {
+ *     auto sp = log.begin();
+ *     log.save(audit.name);
+ *     audit.name = make_name();  // If this throws, only audit.name is restored...
+ * }
+ * validate(account);  // ... and if this throws, everything is restored
+ * @endcode
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "fail_action.h"
+#include "success_action.h"
+
+namespace wwa::utils {
+
+/**
+ * @brief An undo log with nested savepoints.
+ *
+ * Trivially copyable values are saved as raw bytes and restored with `std::memcpy`. Other values are copy-constructed
+ * into the arena and restored by move assignment.
+ *
+ * @note The log is not thread-safe.
+ */
+class undo_log {
+    /// @cond INTERNAL
+    struct record {
+        void* address;                                ///< Address of the modified object.
+        std::byte* saved;                             ///< Saved value.
+        std::size_t size;                             ///< Size of the saved value.
+        std::size_t chunk;                            ///< Arena chunk index before the value was saved.
+        std::size_t offset;                           ///< Arena chunk offset before the value was saved.
+        void (*restore)(void*, std::byte*) noexcept;  ///< Restores and destroys the saved value; `nullptr` for bytes.
+        void (*destroy)(std::byte*) noexcept;         ///< Destroys the saved value; `nullptr` for bytes.
+    };
+
+    struct chunk {
+        std::unique_ptr<std::byte[]> data;  ///< Chunk memory.
+        std::size_t size;                   ///< Chunk size.
+    };
+
+    template<typename T>
+    static void restore_object(void* address, std::byte* saved) noexcept
+    {
+        T* object = std::launder(reinterpret_cast<T*>(saved));
+        *static_cast<T*>(address) = std::move(*object);
+        object->~T();
+    }
+
+    template<typename T>
+    static void destroy_object(std::byte* saved) noexcept
+    {
+        std::launder(reinterpret_cast<T*>(saved))->~T();
+    }
+    /// @endcond
+
+public:
+    /**
+     * @brief Default size of an arena chunk.
+     */
+    static constexpr std::size_t default_chunk_size = 4096;
+
+    /**
+     * @brief A savepoint scope.
+     *
+     * If the scope is exited via an exception, rolls the log back to the state it was in when the savepoint was
+     * created. If the outermost savepoint (the one created when no other savepoint of the log is alive) is exited
+     * normally, commits the log. A nested savepoint exited normally leaves its records in the log, so that an enclosing
+     * savepoint can still undo them.
+     *
+     * @note Constructing a `savepoint` of dynamic storage duration might lead to unexpected behavior.
+     */
+    class [[nodiscard("The object must be used to roll back on failure.")]] savepoint {
+        /// @cond INTERNAL
+        struct rollback_fn {
+            undo_log* log;
+            std::size_t mark;
+            void operator()() const noexcept { this->log->rollback_to(this->mark); }
+        };
+
+        struct commit_fn {
+            undo_log* log;
+            void operator()() const noexcept
+            {
+                if (this->log->m_depth == 0) {
+                    this->log->commit();
+                }
+            }
+        };
+        /// @endcond
+
+    public:
+        /**
+         * @brief Creates a savepoint.
+         *
+         * @param log The undo log.
+         */
+        explicit savepoint(undo_log& log) noexcept
+            : m_log(&log), m_mark(log.mark()), m_on_fail(rollback_fn{&log, m_mark}),
+              m_on_success(commit_fn{&log})
+        {
+            ++log.m_depth;
+        }
+
+        /**
+         * @brief Leaves the savepoint.
+         *
+         * The nesting depth is decreased before the exit functions run, so that the outermost savepoint sees zero.
+         */
+        ~savepoint() noexcept { --this->m_log->m_depth; }
+
+        /** @cond */
+        savepoint(const savepoint&)            = delete;
+        savepoint(savepoint&&)                 = delete;
+        savepoint& operator=(const savepoint&) = delete;
+        savepoint& operator=(savepoint&&)      = delete;
+        /** @endcond */
+
+        /**
+         * @brief Undoes the modifications recorded since the savepoint was created.
+         *
+         * The savepoint remains active.
+         */
+        void rollback() noexcept { this->m_log->rollback_to(this->m_mark); }
+
+        /**
+         * @brief Makes the savepoint inactive: it will neither roll back nor commit the log on scope exit.
+         */
+        void release() noexcept
+        {
+            this->m_on_fail.release();
+            this->m_on_success.release();
+        }
+
+    private:
+        undo_log* m_log;                         ///< The undo log.
+        std::size_t m_mark;                      ///< Number of records when the savepoint was created.
+        fail_action<rollback_fn> m_on_fail;      ///< Rolls the log back on failure.
+        success_action<commit_fn> m_on_success;  ///< Commits the log on success.
+    };
+
+    /**
+     * @brief Constructs an empty undo log.
+     *
+     * @param chunk_size Size of arena chunks.
+     */
+    explicit undo_log(std::size_t chunk_size = default_chunk_size) noexcept : m_chunk_size(chunk_size) {}
+
+    /** @cond */
+    undo_log(const undo_log&)            = delete;
+    undo_log(undo_log&&)                 = delete;
+    undo_log& operator=(const undo_log&) = delete;
+    undo_log& operator=(undo_log&&)      = delete;
+    /** @endcond */
+
+    /**
+     * @brief Destroys the log, discarding (not restoring) all saved values.
+     */
+    ~undo_log() noexcept { this->commit(); }
+
+    /**
+     * @brief Creates a savepoint.
+     *
+     * @return Savepoint scope.
+     */
+    [[nodiscard]] savepoint begin() noexcept { return savepoint(*this); }
+
+    /**
+     * @brief Saves the current values of the objects.
+     *
+     * @tparam T Object types. Each type must be either trivially copyable, or copy constructible and nothrow move
+     * assignable.
+     * @param objects Objects to save.
+     * @throw std::bad_alloc Memory allocation failed; the log is not modified.
+     * @throw anything Any exception thrown by the copy constructor of `T`; the log is not modified.
+     */
+    template<typename... T>
+    requires(sizeof...(T) > 0)
+    void save(T&... objects)
+    {
+        if constexpr (sizeof...(T) == 1) {
+            (this->save_one(objects), ...);
+        }
+        else {
+            // The objects have not been modified yet, so restoring them is the same as discarding the records
+            auto undo = fail_action([this, mark = this->mark()]() noexcept { this->rollback_to(mark); });
+            (this->save_one(objects), ...);
+        }
+    }
+
+    /**
+     * @brief Saves a range of raw bytes.
+     *
+     * @param address Start of the range.
+     * @param size Size of the range.
+     * @throw std::bad_alloc Memory allocation failed; the log is not modified.
+     */
+    void save_bytes(void* address, std::size_t size)
+    {
+        const auto [chunk, offset] = this->position();
+        std::byte* saved           = this->allocate(size, 1);
+        std::memcpy(saved, address, size);
+        this->push({address, saved, size, chunk, offset, nullptr, nullptr});
+    }
+
+    /**
+     * @brief Returns the number of records in the log.
+     *
+     * This value can be passed to `rollback_to()`.
+     *
+     * @return Number of records.
+     */
+    [[nodiscard]] std::size_t mark() const noexcept { return this->m_records.size(); }
+
+    /**
+     * @brief Checks whether the log is empty.
+     *
+     * @return Whether there are no records.
+     */
+    [[nodiscard]] bool empty() const noexcept { return this->m_records.empty(); }
+
+    /**
+     * @brief Restores the values saved after @a mark, in reverse order, and removes them from the log.
+     *
+     * @param mark Number of records to keep.
+     */
+    void rollback_to(std::size_t mark) noexcept
+    {
+        while (this->m_records.size() > mark) {
+            const record& r = this->m_records.back();
+            if (r.restore == nullptr) {
+                std::memcpy(r.address, r.saved, r.size);
+            }
+            else {
+                r.restore(r.address, r.saved);
+            }
+
+            this->m_chunk  = r.chunk;
+            this->m_offset = r.offset;
+            this->m_records.pop_back();
+        }
+    }
+
+    /**
+     * @brief Restores all saved values in reverse order and clears the log.
+     */
+    void rollback() noexcept { this->rollback_to(0); }
+
+    /**
+     * @brief Discards all saved values and clears the log.
+     *
+     * Arena memory is retained for reuse.
+     */
+    void commit() noexcept
+    {
+        for (const record& r : this->m_records) {
+            if (r.destroy != nullptr) {
+                r.destroy(r.saved);
+            }
+        }
+
+        this->m_records.clear();
+        this->m_chunk  = 0;
+        this->m_offset = 0;
+    }
+
+private:
+    std::vector<record> m_records;  ///< Undo records.
+    std::vector<chunk> m_chunks;    ///< Arena chunks.
+    std::size_t m_chunk  = 0;       ///< Current arena chunk.
+    std::size_t m_offset = 0;       ///< Offset within the current arena chunk.
+    std::size_t m_chunk_size;       ///< Default arena chunk size.
+    std::size_t m_depth  = 0;       ///< Number of alive savepoints.
+
+    /**
+     * @brief Saves a single object.
+     *
+     * @tparam T Object type.
+     * @param object Object to save.
+     */
+    template<typename T>
+    void save_one(T& object)
+    {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            this->save_bytes(std::addressof(object), sizeof(T));
+        }
+        else {
+            static_assert(
+                std::is_copy_constructible_v<T> && std::is_nothrow_move_assignable_v<T>,
+                "T must be trivially copyable, or copy constructible and nothrow move assignable"
+            );
+            static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__, "Over-aligned types are not supported");
+
+            const auto [chunk, offset] = this->position();
+            std::byte* saved           = this->allocate(sizeof(T), alignof(T));
+            auto undo                  = fail_action([this, chunk, offset]() noexcept {
+                this->m_chunk  = chunk;
+                this->m_offset = offset;
+            });
+
+            ::new (static_cast<void*>(saved)) T(object);
+            undo.release();
+            auto destroy = fail_action([saved]() noexcept { destroy_object<T>(saved); });
+            this->push(
+                {std::addressof(object), saved, sizeof(T), chunk, offset, &restore_object<T>, &destroy_object<T>}
+            );
+        }
+    }
+
+    /**
+     * @brief Returns the current arena position.
+     *
+     * @return Chunk index and offset.
+     */
+    [[nodiscard]] std::pair<std::size_t, std::size_t> position() const noexcept
+    {
+        return {this->m_chunk, this->m_offset};
+    }
+
+    /**
+     * @brief Appends a record; on failure, restores the arena position.
+     *
+     * @param r Record to append.
+     */
+    void push(const record& r)
+    {
+        auto undo = fail_action([this, &r]() noexcept {
+            this->m_chunk  = r.chunk;
+            this->m_offset = r.offset;
+        });
+
+        this->m_records.push_back(r);
+    }
+
+    /**
+     * @brief Allocates memory from the arena.
+     *
+     * @param size Number of bytes.
+     * @param alignment Alignment.
+     * @return Allocated memory.
+     */
+    std::byte* allocate(std::size_t size, std::size_t alignment)
+    {
+        for (;;) {
+            if (this->m_chunk < this->m_chunks.size()) {
+                chunk& c           = this->m_chunks[this->m_chunk];
+                const auto aligned = (this->m_offset + alignment - 1) & ~(alignment - 1);
+                if (aligned + size <= c.size) {
+                    this->m_offset = aligned + size;
+                    return c.data.get() + aligned;
+                }
+
+                if (this->m_chunk + 1 < this->m_chunks.size() && this->m_chunks[this->m_chunk + 1].size >= size) {
+                    ++this->m_chunk;
+                    this->m_offset = 0;
+                    continue;
+                }
+            }
+
+            // Insert a new chunk after the current one; the chunks after it hold no live values
+            const auto n     = std::max(size, this->m_chunk_size);
+            const auto index = this->m_chunks.empty() ? 0 : this->m_chunk + 1;
+            this->m_chunks.insert(
+                this->m_chunks.begin() + static_cast<std::ptrdiff_t>(index),
+                chunk{std::make_unique_for_overwrite<std::byte[]>(n), n}
+            );
+            this->m_chunk  = index;
+            this->m_offset = 0;
+        }
+    }
+};
+
+}  // namespace wwa::utils
+
+#endif /* B3F0E7C1_5A2D_4E8B_9C61_2D7F4A8E0B53 */
@@ -0,0 +1,36 @@
+#ifndef AF71D959_CD53_4FC4_97EB_61E9914264BF
+#define AF71D959_CD53_4FC4_97EB_61E9914264BF
+
+#include <gtest/gtest.h>
+
+#include <utility>
+
+#include "allocation_scope.h"
+
+/**
+ * @brief Test fixture for asserting that code does not touch the heap.
+ *
+ * The allocation hooks are defined in `allocation_scope.cpp`; tests are skipped if they are not linked in.
+ */
+class AllocationCountingTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        if (!wwa::utils::allocation_scope::hooks_installed()) {
+            GTEST_SKIP() << "Allocation hooks are not installed";
+        }
+    }
+
+    /**
+     * @brief Runs @a fn and returns the heap activity of the current thread during the call.
+     */
+    template<typename Func>
+    static wwa::utils::allocation_stats count_allocations(Func&& fn)
+    {
+        const wwa::utils::allocation_scope scope;
+        std::forward<Func>(fn)();
+        return scope.stats();
+    }
+};
+
+#endif /* AF71D959_CD53_4FC4_97EB_61E9914264BF */
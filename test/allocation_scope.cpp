@@ -0,0 +1,145 @@
+#define WWA_ALLOCATION_SCOPE_DEFINE_HOOKS
+#include "allocation_scope.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "allocation_counting.h"
+
+using AllocationScope = AllocationCountingTest;
+
+TEST_F(AllocationScope, CountsNewAndDelete)
+{
+    wwa::utils::allocation_scope scope;
+    EXPECT_EQ(scope.stats(), wwa::utils::allocation_stats{});
+
+    auto p = std::make_unique<int>(1);
+    auto a = std::make_unique<int[]>(10);  // NOLINT(*-avoid-c-arrays)
+    EXPECT_EQ(scope.stats().allocations, 2);
+    EXPECT_EQ(scope.stats().bytes, sizeof(int) * 11);
+    EXPECT_EQ(scope.stats().deallocations, 0);
+
+    p.reset();
+    a.reset();
+    EXPECT_EQ(scope.stats().deallocations, 2);
+}
+
+TEST_F(AllocationScope, CountsAlignedNew)
+{
+    struct alignas(64) aligned {
+        char data[64];  // NOLINT(*-avoid-c-arrays)
+    };
+
+    wwa::utils::allocation_scope scope;
+    auto p = std::make_unique<aligned>();
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(p.get()) % 64, 0);
+    p.reset();
+
+    void* q = ::operator new(16, std::nothrow);
+    ::operator delete(q, std::nothrow);
+
+    EXPECT_EQ(scope.stats().allocations, 2);
+    EXPECT_EQ(scope.stats().deallocations, 2);
+}
+
+TEST_F(AllocationScope, CountsMalloc)
+{
+    if (!wwa::utils::allocation_scope::counts_malloc()) {
+        GTEST_SKIP() << "malloc() is not counted on this platform";
+    }
+
+    wwa::utils::allocation_scope scope;
+    void* p = std::malloc(100);  // NOLINT(*-no-malloc)
+    p       = std::realloc(p, 200);  // NOLINT(*-no-malloc)
+    std::free(p);  // NOLINT(*-no-malloc)
+    EXPECT_EQ(scope.stats().allocations, 2);
+    EXPECT_EQ(scope.stats().bytes, 300);
+    EXPECT_EQ(scope.stats().deallocations, 1);
+}
+
+TEST_F(AllocationScope, CountsAlignedMalloc)
+{
+    if (!wwa::utils::allocation_scope::counts_malloc()) {
+        GTEST_SKIP() << "malloc() is not counted on this platform";
+    }
+
+    wwa::utils::allocation_scope scope;
+    void* p = nullptr;
+    ASSERT_EQ(::posix_memalign(&p, 64, 100), 0);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(p) % 64, 0);
+    std::free(p);  // NOLINT(*-no-malloc)
+
+    p = std::aligned_alloc(64, 128);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(p) % 64, 0);
+    std::free(p);  // NOLINT(*-no-malloc)
+
+    EXPECT_EQ(scope.stats().allocations, 2);
+    EXPECT_EQ(scope.stats().bytes, 228);
+    EXPECT_EQ(scope.stats().deallocations, 2);
+}
+
+TEST_F(AllocationScope, NestedScopes)
+{
+    wwa::utils::allocation_scope outer;
+    const std::vector<int> v(100);
+    {
+        wwa::utils::allocation_scope inner;
+        const std::string s(100, 'a');
+        EXPECT_EQ(inner.stats().allocations, 1);
+    }
+
+    EXPECT_EQ(outer.stats().allocations, 2);
+    EXPECT_EQ(outer.stats().deallocations, 1);
+
+    outer.reset();
+    EXPECT_EQ(outer.stats(), wwa::utils::allocation_stats{});
+}
+
+TEST_F(AllocationScope, PerThread)
+{
+    wwa::utils::allocation_scope scope;
+    std::thread([]() {
+        const std::vector<int> v(100);
+        (void)v;
+    }).join();
+
+    // Only the allocations of this thread (such as the thread state) are counted
+    EXPECT_LT(scope.stats().bytes, 100 * sizeof(int));
+}
+
+TEST_F(AllocationScope, Reporter)
+{
+    wwa::utils::allocation_stats reported;
+    {
+        const wwa::utils::allocation_scope scope([&reported](const wwa::utils::allocation_stats& stats) {
+            reported = stats;
+        });
+
+        const std::string s(100, 'a');
+    }
+
+    EXPECT_EQ(reported.allocations, 1);
+    EXPECT_EQ(reported.deallocations, 1);
+
+    // Not called on failure
+    reported = {};
+    try {
+        const wwa::utils::allocation_scope scope([&reported](const wwa::utils::allocation_stats& stats) {
+            reported = stats;
+        });
+
+        throw std::runtime_error("error");
+    }
+    catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+    }
+
+    EXPECT_EQ(reported, wwa::utils::allocation_stats{});
+}
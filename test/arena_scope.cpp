@@ -0,0 +1,124 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <memory_resource>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "arena_scope.h"
+
+namespace {
+
+bool within(const void* p, std::span<const std::byte> buffer)
+{
+    const auto* b = static_cast<const std::byte*>(p);
+    return std::less_equal<>{}(buffer.data(), b) && std::less<>{}(b, buffer.data() + buffer.size());
+}
+
+}  // namespace
+
+TEST(ArenaScope, AllocatesFromArena)
+{
+    alignas(std::max_align_t) std::array<std::byte, 4096> buffer{};
+    {
+        wwa::utils::arena_scope arena(buffer);
+        EXPECT_EQ(wwa::utils::arena_scope::current(), arena.resource());
+
+        std::pmr::vector<int> v({1, 2, 3, 4, 5}, arena.resource());
+        EXPECT_TRUE(within(v.data(), buffer));
+
+        // Outgrows the buffer: continues in chunks
+        std::pmr::vector<int> big(100'000, 7, arena.resource());
+        EXPECT_FALSE(within(big.data(), buffer));
+        EXPECT_EQ(big.back(), 7);
+
+        // The default resource is not affected
+        const std::pmr::vector<int> heap{1, 2, 3};
+        EXPECT_FALSE(within(heap.data(), buffer));
+    }
+
+    EXPECT_EQ(wwa::utils::arena_scope::current(), nullptr);
+}
+
+TEST(ArenaScope, ContainerFromOutsideOutlivesScope)
+{
+    alignas(std::max_align_t) std::array<std::byte, 4096> buffer{};
+    std::pmr::vector<int> v{1, 2, 3};
+
+    {
+        const wwa::utils::arena_scope arena(buffer);
+        for (int i = 0; i < 100; ++i) {
+            v.push_back(i);
+        }
+
+        EXPECT_FALSE(within(v.data(), buffer));
+    }
+
+    buffer.fill(std::byte{0xFF});
+    v.push_back(100);
+    ASSERT_EQ(v.size(), 104);
+    EXPECT_EQ(v[2], 3);
+    EXPECT_EQ(v[3], 0);
+    EXPECT_EQ(v.back(), 100);
+}
+
+TEST(ArenaScope, NestedScopes)
+{
+    alignas(std::max_align_t) std::array<std::byte, 1024> outer_buffer{};
+    alignas(std::max_align_t) std::array<std::byte, 1024> inner_buffer{};
+
+    const wwa::utils::arena_scope outer(outer_buffer);
+    std::pmr::string s1(100, 'a', wwa::utils::arena_scope::current());
+    EXPECT_TRUE(within(s1.data(), outer_buffer));
+
+    {
+        const wwa::utils::arena_scope inner(inner_buffer);
+        const std::pmr::string s2(100, 'b', wwa::utils::arena_scope::current());
+        EXPECT_TRUE(within(s2.data(), inner_buffer));
+
+        // A container keeps the arena it was constructed with
+        s1.append(200, 'c');
+        EXPECT_TRUE(within(s1.data(), outer_buffer));
+    }
+
+    const std::pmr::string s3(100, 'd', wwa::utils::arena_scope::current());
+    EXPECT_TRUE(within(s3.data(), outer_buffer));
+}
+
+TEST(ArenaScope, ExplicitResourceAndReset)
+{
+    alignas(std::max_align_t) std::array<std::byte, 1024> buffer{};
+    wwa::utils::arena_scope arena(buffer);
+
+    void* p1 = arena.resource()->allocate(64, 16);
+    EXPECT_TRUE(within(p1, buffer));
+
+    arena.reset();
+    void* p2 = arena.resource()->allocate(64, 16);
+    EXPECT_TRUE(within(p2, buffer));
+}
+
+TEST(ArenaScope, PerThread)
+{
+    alignas(std::max_align_t) std::array<std::byte, 1024> buffer{};
+    const wwa::utils::arena_scope arena(buffer);
+
+    bool other_thread_has_arena = true;
+    std::thread([&]() { other_thread_has_arena = wwa::utils::arena_scope::current() != nullptr; }).join();
+
+    EXPECT_FALSE(other_thread_has_arena);
+}
+
+TEST(ArenaScope, NoBuffer)
+{
+    wwa::utils::arena_scope arena;
+    std::pmr::vector<std::pmr::string> v(arena.resource());
+    for (int i = 0; i < 1000; ++i) {
+        v.emplace_back("a string which does not fit into the small string buffer");
+    }
+
+    EXPECT_EQ(v.size(), 1000);
+}
@@ -0,0 +1,213 @@
+#include <gtest/gtest.h>
+
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "scope_action.h"
+
+namespace {
+
+struct counter {
+    int value = 0;
+
+    void add(int n) { this->value += n; }
+};
+
+struct empty_functor {
+    void operator()(int& i) const noexcept { i += 1; }
+};
+
+struct throwing_copy {
+    bool* do_throw = nullptr;
+
+    explicit throwing_copy(bool* flag) noexcept : do_throw(flag) {}
+
+    throwing_copy(const throwing_copy& other) : do_throw(other.do_throw)
+    {
+        if (*this->do_throw) {
+            throw std::runtime_error("copy");
+        }
+    }
+
+    throwing_copy(throwing_copy&&)                 = delete;
+    throwing_copy& operator=(const throwing_copy&) = delete;
+    throwing_copy& operator=(throwing_copy&&)      = delete;
+    ~throwing_copy()                               = default;
+};
+
+void add(int& i, int n)
+{
+    i += n;
+}
+
+void record(int& i, const throwing_copy& /*arg*/)
+{
+    i += 1;
+}
+
+auto make_guard(int& i)
+{
+    return wwa::utils::exit_action(add, std::ref(i), 1);
+}
+
+}  // namespace
+
+static_assert(std::is_same_v<
+              decltype(wwa::utils::exit_action(add, std::declval<std::reference_wrapper<int>>(), 1)),
+              wwa::utils::exit_action<wwa::utils::bound_call<void (*)(int&, int), std::reference_wrapper<int>, int>>>);
+
+static_assert(sizeof(wwa::utils::bound_call<empty_functor, std::reference_wrapper<int>>) == sizeof(int*));
+
+TEST(BoundCall, FunctionWithArguments)
+{
+    int i = 0;
+    {
+        const wwa::utils::exit_action guard(add, std::ref(i), 2);
+        EXPECT_EQ(i, 0);
+    }
+
+    EXPECT_EQ(i, 2);
+}
+
+TEST(BoundCall, ArgumentsAreCopied)
+{
+    int i = 0;
+    int n = 1;
+    {
+        const wwa::utils::exit_action guard(add, std::ref(i), n);
+        n = 10;
+    }
+
+    EXPECT_EQ(i, 1);
+}
+
+TEST(BoundCall, MemberFunctionWithObject)
+{
+    counter c;
+    {
+        const wwa::utils::exit_action guard(&counter::add, c, 3);
+        static_assert(std::is_same_v<
+                      std::remove_const_t<decltype(guard)>,
+                      wwa::utils::exit_action<wwa::utils::bound_call<void (counter::*)(int), counter*, int>>>);
+    }
+
+    EXPECT_EQ(c.value, 3);
+}
+
+TEST(BoundCall, MemberFunctionWithPointer)
+{
+    counter c;
+    {
+        const wwa::utils::exit_action guard(&counter::add, &c, 4);
+    }
+
+    EXPECT_EQ(c.value, 4);
+}
+
+TEST(BoundCall, MemberFunctionWithWrapper)
+{
+    counter c;
+    auto ref = std::ref(c);
+    auto ptr = std::make_shared<counter>();
+    {
+        const wwa::utils::exit_action by_ref(&counter::add, ref, 5);
+        const wwa::utils::exit_action by_smart_pointer(&counter::add, ptr, 6);
+        static_assert(std::is_same_v<
+                      std::remove_const_t<decltype(by_smart_pointer)>,
+                      wwa::utils::exit_action<
+                          wwa::utils::bound_call<void (counter::*)(int), std::shared_ptr<counter>, int>>>);
+    }
+
+    EXPECT_EQ(c.value, 5);
+    EXPECT_EQ(ptr->value, 6);
+}
+
+TEST(BoundCall, SharedInstantiation)
+{
+    int i = 0;
+    {
+        const wwa::utils::exit_action first(add, std::ref(i), 1);
+        const wwa::utils::exit_action second(add, std::ref(i), 2);
+        const auto third = make_guard(i);
+        static_assert(std::is_same_v<decltype(first), decltype(second)>);
+        static_assert(std::is_same_v<std::remove_const_t<decltype(first)>, std::remove_const_t<decltype(third)>>);
+    }
+
+    EXPECT_EQ(i, 4);
+}
+
+TEST(BoundCall, EmptyFunctor)
+{
+    int i = 0;
+    {
+        const wwa::utils::exit_action guard(empty_functor{}, std::ref(i));
+    }
+
+    EXPECT_EQ(i, 1);
+}
+
+TEST(BoundCall, Release)
+{
+    int i = 0;
+    {
+        wwa::utils::exit_action guard(add, std::ref(i), 1);
+        guard.release();
+    }
+
+    EXPECT_EQ(i, 0);
+}
+
+TEST(BoundCall, FailAndSuccess)
+{
+    int failed    = 0;
+    int succeeded = 0;
+
+    try {
+        const wwa::utils::fail_action on_fail(add, std::ref(failed), 1);
+        const wwa::utils::success_action on_success(add, std::ref(succeeded), 1);
+        throw std::runtime_error("error");
+    }
+    catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+    }
+
+    EXPECT_EQ(failed, 1);
+    EXPECT_EQ(succeeded, 0);
+
+    {
+        const wwa::utils::fail_action on_fail(add, std::ref(failed), 1);
+        const wwa::utils::success_action on_success(add, std::ref(succeeded), 1);
+    }
+
+    EXPECT_EQ(failed, 1);
+    EXPECT_EQ(succeeded, 1);
+}
+
+TEST(BoundCall, CallsFunctionIfCopyThrows)
+{
+    int i         = 0;
+    bool do_throw = false;
+    const throwing_copy arg(&do_throw);
+
+    {
+        const wwa::utils::exit_action guard(record, std::ref(i), arg);
+    }
+
+    EXPECT_EQ(i, 1);
+
+    do_throw = true;
+    EXPECT_THROW({ const wwa::utils::exit_action guard(record, std::ref(i), arg); }, std::runtime_error);
+    EXPECT_EQ(i, 2);
+}
+
+TEST(BoundCall, SuccessActionDoesNotCallFunctionIfCopyThrows)
+{
+    int i         = 0;
+    bool do_throw = true;
+    const throwing_copy arg(&do_throw);
+
+    EXPECT_THROW({ const wwa::utils::success_action guard(record, std::ref(i), arg); }, std::runtime_error);
+    EXPECT_EQ(i, 0);
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <sstream>
+#include <string>
+
+#include "scope_action.h"
+
+namespace {
+
+struct throwing_move {
+    throwing_move() = default;
+    throwing_move(const throwing_move&) noexcept(false) {}
+    void operator()() const noexcept {}
+};
+
+void exit_function() {}
+
+}  // namespace
+
+TEST(CaptureBudget, EnforcesBudget)
+{
+    using small = std::array<char, 32>;
+    using large = std::array<char, 33>;
+
+    EXPECT_TRUE(wwa::utils::detail::capture_within_budget<small>);
+    EXPECT_FALSE(wwa::utils::detail::capture_within_budget<large>);
+    EXPECT_TRUE(wwa::utils::detail::capture_within_budget<large&>);
+    EXPECT_EQ(wwa::utils::capture_report::budget, 32);
+}
+
+TEST(CaptureBudget, RequiresNothrowMove)
+{
+    EXPECT_TRUE(wwa::utils::detail::capture_nothrow_movable<void (*)()>);
+    EXPECT_FALSE(wwa::utils::detail::capture_nothrow_movable<throwing_move>);
+    EXPECT_TRUE(wwa::utils::detail::capture_nothrow_movable<throwing_move&>);
+}
+
+TEST(CaptureBudget, AcceptsSmallCaptures)
+{
+    int calls = 0;
+    {
+        const std::array<int, 4> values{1, 2, 3, 4};
+        const wwa::utils::exit_action guard([&calls, values]() { calls += values[3]; });
+    }
+
+    {
+        const wwa::utils::success_action guard(exit_function);
+    }
+
+    EXPECT_EQ(calls, 4);
+}
+
+TEST(CaptureReport, ListsGuardTypes)
+{
+    {
+        const std::array<char, 24> buffer{};
+        const wwa::utils::fail_action guard([buffer]() { static_cast<void>(buffer); });
+    }
+
+    const auto entries = wwa::utils::capture_report::entries();
+    ASSERT_FALSE(entries.empty());
+    EXPECT_TRUE(
+        std::ranges::is_sorted(entries, std::ranges::greater{}, &wwa::utils::capture_report_entry::function_size)
+    );
+
+    const auto it = std::ranges::find_if(entries, [](const wwa::utils::capture_report_entry& e) {
+        return e.function_size == 24 && e.guard.find("fail_action<") != std::string_view::npos;
+    });
+
+    ASSERT_NE(it, entries.end());
+    EXPECT_GE(it->guard_size, it->function_size);
+    EXPECT_TRUE(it->nothrow_movable);
+}
+
+TEST(CaptureReport, WritesTextReport)
+{
+    std::ostringstream os;
+    wwa::utils::capture_report::write(os);
+    const std::string report = os.str();
+
+    EXPECT_EQ(report.rfind("function  guard  nothrow_move  guard type\n", 0), 0) << report;
+    EXPECT_NE(report.find("wwa::utils::success_action<void (*)()>"), std::string::npos) << report;
+}
@@ -0,0 +1,12 @@
+#define WWA_SCOPE_ACTION_MAX_CAPTURE_SIZE 16
+
+#include <array>
+
+#include "scope_action.h"
+
+int main()
+{
+    std::array<char, 64> buffer{};
+    const wwa::utils::fail_action guard([buffer]() { static_cast<void>(buffer); });
+    return 0;
+}
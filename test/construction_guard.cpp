@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "construction_guard.h"
+
+namespace {
+
+class tracked {
+public:
+    static inline int live        = 0;
+    static inline int throw_after = -1;
+    static inline std::vector<int> destroyed;
+
+    explicit tracked(int v = 0) : m_value(v) { construct(); }
+    tracked(const tracked& other) : m_value(other.m_value) { construct(); }
+    tracked(tracked&& other) : m_value(other.m_value) { construct(); }  // NOLINT(*-noexcept-move*)
+    tracked& operator=(const tracked&) = default;
+    tracked& operator=(tracked&&)      = default;
+
+    ~tracked()
+    {
+        --live;
+        destroyed.push_back(this->m_value);
+    }
+
+    [[nodiscard]] int value() const noexcept { return this->m_value; }
+
+    static void reset(int fail_after)
+    {
+        live        = 0;
+        throw_after = fail_after;
+        destroyed.clear();
+    }
+
+private:
+    int m_value;
+
+    static void construct()
+    {
+        if (throw_after == 0) {
+            throw std::runtime_error("construction failed");
+        }
+
+        --throw_after;
+        ++live;
+    }
+};
+
+template<typename T>
+class storage {
+public:
+    explicit storage(std::size_t n) : m_data(std::allocator<T>().allocate(n)), m_size(n) {}
+    storage(const storage&)            = delete;
+    storage(storage&&)                 = delete;
+    storage& operator=(const storage&) = delete;
+    storage& operator=(storage&&)      = delete;
+    ~storage() { std::allocator<T>().deallocate(this->m_data, this->m_size); }
+
+    [[nodiscard]] T* data() const noexcept { return this->m_data; }
+
+private:
+    T* m_data;
+    std::size_t m_size;
+};
+
+}  // namespace
+
+static_assert(sizeof(wwa::utils::construction_guard<int>) == 2 * sizeof(int*));
+
+TEST(ConstructionGuard, Success)
+{
+    const std::array<std::string, 3> src = {"a", "b", "c"};
+    const storage<std::string> buf(10);
+
+    wwa::utils::construction_guard guard(buf.data());
+    guard.copy(src.begin(), src.end());
+    guard.emplace("d");
+    guard.fill(2, "e");
+    guard.value_construct(1);
+    EXPECT_EQ(guard.size(), 7);
+
+    std::string* end = guard.release();
+    EXPECT_EQ(end, buf.data() + 7);
+    EXPECT_EQ(buf.data()[3], "d");
+    EXPECT_EQ(buf.data()[5], "e");
+    EXPECT_EQ(buf.data()[6], "");
+    std::destroy(buf.data(), end);
+}
+
+TEST(ConstructionGuard, DestroysInReverseOnFailure)
+{
+    std::vector<tracked> src;
+    for (int i = 1; i <= 5; ++i) {
+        src.emplace_back(i);
+    }
+
+    const storage<tracked> buf(10);
+    tracked::reset(7);
+    try {
+        wwa::utils::construction_guard guard(buf.data());
+        guard.copy(src.begin(), src.end());
+        guard.move(src.begin(), src.end());  // Throws on the third element
+        FAIL() << "Expected an exception";
+    }
+    catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+    }
+
+    EXPECT_EQ(tracked::live, 0);
+    // uninitialized_move() destroys its own prefix first, then the guard destroys the copies in reverse
+    ASSERT_EQ(tracked::destroyed.size(), 7);
+    const std::vector<int> copies(tracked::destroyed.begin() + 2, tracked::destroyed.end());
+    EXPECT_EQ(copies, (std::vector<int>{5, 4, 3, 2, 1}));
+    tracked::reset(-1);
+}
+
+TEST(ConstructionGuard, EmplaceFailure)
+{
+    const storage<tracked> buf(4);
+    tracked::reset(2);
+    try {
+        wwa::utils::construction_guard guard(buf.data());
+        guard.emplace(1);
+        guard.emplace(2);
+        guard.emplace(3);
+    }
+    catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+    }
+
+    EXPECT_EQ(tracked::live, 0);
+    EXPECT_EQ(tracked::destroyed, (std::vector<int>{2, 1}));
+    tracked::reset(-1);
+}
+
+TEST(ConstructionGuard, NoDestructionOnSuccess)
+{
+    const storage<tracked> buf(4);
+    tracked::reset(-1);
+    tracked* end = nullptr;
+    {
+        wwa::utils::construction_guard guard(buf.data());
+        guard.value_construct(4);
+        end = guard.end();
+    }
+
+    EXPECT_EQ(tracked::live, 4);
+    std::destroy(buf.data(), end);
+    EXPECT_EQ(tracked::live, 0);
+}
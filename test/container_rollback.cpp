@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "container_rollback.h"
+
+TEST(AppendGuard, RollbackOnFailure)
+{
+    std::vector<int> v{1, 2, 3};
+    std::string s = "abc";
+
+    try {
+        wwa::utils::append_guard gv(v);
+        wwa::utils::append_guard gs(s);
+        for (int i = 0; i < 100; ++i) {
+            v.push_back(i);
+            s += "xyz";
+        }
+
+        throw std::runtime_error("error");
+    }
+    catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+    }
+
+    EXPECT_EQ(v, (std::vector<int>{1, 2, 3}));
+    EXPECT_EQ(s, "abc");
+}
+
+TEST(AppendGuard, CommitOnSuccess)
+{
+    std::vector<int> v{1, 2, 3};
+    {
+        wwa::utils::append_guard guard(v);
+        v.push_back(4);
+    }
+
+    EXPECT_EQ(v, (std::vector<int>{1, 2, 3, 4}));
+}
+
+TEST(AppendGuard, ExplicitRollbackAndCommit)
+{
+    std::vector<std::string> v{"a"};
+    wwa::utils::append_guard guard(v);
+
+    v.emplace_back("b");
+    guard.commit();
+    v.emplace_back("c");
+    guard.rollback();
+    EXPECT_EQ(v, (std::vector<std::string>{"a", "b"}));
+
+    v.clear();
+    guard.rollback();  // The container has shrunk: nothing to undo
+    EXPECT_TRUE(v.empty());
+}
+
+TEST(InsertGuard, RollbackOnFailure)
+{
+    std::unordered_map<std::string, int> m{{"a", 1}, {"b", 2}};
+
+    try {
+        wwa::utils::insert_guard guard(m);
+        for (int i = 0; i < 1000; ++i) {
+            guard.emplace("key" + std::to_string(i), i);
+        }
+
+        EXPECT_FALSE(guard.try_emplace("a", 100).second);
+        EXPECT_TRUE(guard.insert(std::pair<const std::string, int>{"c", 3}).second);
+        EXPECT_EQ(guard.size(), 1001);
+        throw std::runtime_error("error");
+    }
+    catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+    }
+
+    EXPECT_EQ(m, (std::unordered_map<std::string, int>{{"a", 1}, {"b", 2}}));
+}
+
+TEST(InsertGuard, CommitOnSuccess)
+{
+    std::map<int, std::string> m{{1, "one"}};
+    std::set<int> s{1};
+    {
+        wwa::utils::insert_guard gm(m);
+        wwa::utils::insert_guard gs(s);
+        gm.try_emplace(2, "two");
+        gs.insert(2);
+    }
+
+    EXPECT_EQ(m, (std::map<int, std::string>{{1, "one"}, {2, "two"}}));
+    EXPECT_EQ(s, (std::set<int>{1, 2}));
+}
+
+TEST(InsertGuard, ExplicitRollbackAndCommit)
+{
+    std::set<int> s{1};
+    wwa::utils::insert_guard guard(s);
+
+    guard.insert(2);
+    guard.commit();
+    guard.emplace(3);
+    guard.rollback();
+    EXPECT_EQ(s, (std::set<int>{1, 2}));
+    EXPECT_EQ(guard.size(), 0);
+}
+
+TEST(OverwriteGuard, RollbackOnFailure)
+{
+    std::vector<std::string> v{"a", "b", "c"};
+    std::unordered_map<int, std::string> m{{1, "one"}, {2, "two"}};
+
+    try {
+        wwa::utils::overwrite_guard gv(v);
+        wwa::utils::overwrite_guard gm(m);
+        gv.set(1, "B");
+        gv.modify(2) = "C";
+        gv.modify(1) += "B";
+        gm.set(2, "TWO");
+        EXPECT_EQ(v, (std::vector<std::string>{"a", "BB", "C"}));
+        EXPECT_EQ(gv.size(), 3);
+        throw std::runtime_error("error");
+    }
+    catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+    }
+
+    EXPECT_EQ(v, (std::vector<std::string>{"a", "b", "c"}));
+    EXPECT_EQ(m, (std::unordered_map<int, std::string>{{1, "one"}, {2, "two"}}));
+}
+
+TEST(OverwriteGuard, MissingElement)
+{
+    std::vector<int> v{1, 2, 3};
+    std::map<std::string, int> m;
+    wwa::utils::overwrite_guard gv(v);
+    wwa::utils::overwrite_guard gm(m);
+
+    EXPECT_THROW(gv.set(3, 4), std::out_of_range);
+    EXPECT_THROW(gm.set("a", 1), std::out_of_range);
+    EXPECT_EQ(gv.size(), 0);
+    EXPECT_EQ(gm.size(), 0);
+}
+
+TEST(OverwriteGuard, CombinedWithAppend)
+{
+    std::vector<int> v{1, 2, 3};
+
+    try {
+        wwa::utils::overwrite_guard overwrite(v);
+        wwa::utils::append_guard append(v);
+        overwrite.set(0, 10);
+        v.resize(1000, 7);  // Reallocates: indices remain valid
+        overwrite.set(1, 20);
+        throw std::runtime_error("error");
+    }
+    catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+    }
+
+    EXPECT_EQ(v, (std::vector<int>{1, 2, 3}));
+}
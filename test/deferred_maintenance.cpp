@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "deferred_maintenance.h"
+
+TEST(DeferredMaintenance, Compaction)
+{
+    std::vector<std::string> v{"a", "b", "c", "d", "e"};
+    {
+        wwa::utils::deferred_maintenance batch(v);
+        for (std::size_t i = 0; i < v.size(); ++i) {
+            if (i % 2 == 0) {
+                batch.erase(i);
+            }
+        }
+
+        batch.erase(0);
+        batch.insert("f");
+        EXPECT_EQ(batch.erase_count(), 3);
+        EXPECT_TRUE(batch.erased(2));
+        EXPECT_FALSE(batch.erased(3));
+        EXPECT_EQ(v.size(), 5);  // Not modified during the scope
+    }
+
+    EXPECT_EQ(v, (std::vector<std::string>{"b", "d", "f"}));
+}
+
+TEST(DeferredMaintenance, SortedMerge)
+{
+    std::vector<int> v{10, 20, 30, 40};
+    {
+        wwa::utils::deferred_maintenance batch(v, wwa::utils::container_order::sorted);
+        batch.insert(35);
+        batch.insert(5);
+        batch.insert(20);
+        batch.erase(1);
+        EXPECT_EQ(batch.pending().size(), 3);
+    }
+
+    EXPECT_EQ(v, (std::vector<int>{5, 10, 20, 30, 35, 40}));
+}
+
+TEST(DeferredMaintenance, SortedDescending)
+{
+    std::vector<int> v{30, 20, 10};
+    {
+        wwa::utils::deferred_maintenance batch(v, wwa::utils::container_order::sorted, std::greater<>{});
+        batch.insert(25);
+        batch.insert(40);
+    }
+
+    EXPECT_EQ(v, (std::vector<int>{40, 30, 25, 20, 10}));
+}
+
+TEST(DeferredMaintenance, Heap)
+{
+    std::vector<int> v{1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    std::ranges::make_heap(v);
+
+    {
+        // Few insertions: pushed one by one
+        wwa::utils::deferred_maintenance batch(v, wwa::utils::container_order::heap);
+        batch.insert(11);
+    }
+
+    EXPECT_TRUE(std::ranges::is_heap(v));
+    EXPECT_EQ(v.front(), 11);
+
+    {
+        // Erasures break the heap property: rebuilt
+        wwa::utils::deferred_maintenance batch(v, wwa::utils::container_order::heap);
+        batch.erase(0);
+        batch.erase(v.size() - 1);
+    }
+
+    EXPECT_EQ(v.size(), 9);
+    EXPECT_TRUE(std::ranges::is_heap(v));
+    EXPECT_EQ(v.front(), 10);
+
+    {
+        wwa::utils::deferred_maintenance batch(v, wwa::utils::container_order::heap);
+        for (int i = 20; i < 40; ++i) {
+            batch.insert(i);
+        }
+    }
+
+    EXPECT_EQ(v.size(), 29);
+    EXPECT_TRUE(std::ranges::is_heap(v));
+    EXPECT_EQ(v.front(), 39);
+}
+
+TEST(DeferredMaintenance, DiscardOnFailure)
+{
+    std::vector<int> v{1, 2, 3};
+
+    try {
+        wwa::utils::deferred_maintenance batch(v, wwa::utils::container_order::sorted);
+        batch.erase(0);
+        batch.insert(4);
+        throw std::runtime_error("error");
+    }
+    catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+    }
+
+    EXPECT_EQ(v, (std::vector<int>{1, 2, 3}));
+}
+
+TEST(DeferredMaintenance, ExplicitApplyAndDiscard)
+{
+    std::vector<int> v{1, 2, 3};
+    {
+        wwa::utils::deferred_maintenance batch(v);
+        batch.erase(0);
+        batch.apply();
+        EXPECT_EQ(v, (std::vector<int>{2, 3}));
+
+        batch.insert(4);
+        batch.discard();
+        EXPECT_THROW(batch.erase(2), std::out_of_range);
+    }
+
+    EXPECT_EQ(v, (std::vector<int>{2, 3}));
+}
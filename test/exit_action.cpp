@@ -1,11 +1,13 @@
 #include <gtest/gtest.h>
 
+#include <array>
 #include <functional>
 #include <stdexcept>
 #include <type_traits>
 #include <utility>
 
-#include "scope_action.h"
+#include "allocation_counting.h"
+#include "exit_action.h"
 
 static_assert(!std::is_copy_constructible_v<wwa::utils::exit_action<void (*)()>>);
 static_assert(!std::is_copy_assignable_v<wwa::utils::exit_action<void (*)()>>);
@@ -257,3 +259,25 @@ TEST(ExitAction, MoveAction)
         EXPECT_EQ(i, 1);
     }
 }
+
+using ExitActionAllocations = AllocationCountingTest;
+
+TEST_F(ExitActionAllocations, SmallLambdasDoNotAllocate)
+{
+    int i                = 0;
+    std::array<int, 4> a = {1, 2, 3, 4};
+    const auto stats     = count_allocations([&i, &a]() {
+        {
+            const wwa::utils::exit_action by_reference([&i]() noexcept { ++i; });
+            const wwa::utils::exit_action by_value([a, &i]() noexcept { i += a[3]; });
+            auto released = wwa::utils::exit_action([&i]() noexcept { i = -1; });
+            released.release();
+        }
+
+        const wwa::utils::exit_action function_pointer(&g);
+    });
+
+    EXPECT_EQ(stats.allocations, 0);
+    EXPECT_EQ(stats.deallocations, 0);
+    EXPECT_EQ(i, 5);
+}
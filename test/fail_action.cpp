@@ -3,7 +3,7 @@
 #include <stdexcept>
 #include <utility>
 
-#include "scope_action.h"
+#include "fail_action.h"
 
 static_assert(!std::is_copy_constructible_v<wwa::utils::fail_action<void (*)()>>);
 static_assert(!std::is_copy_assignable_v<wwa::utils::fail_action<void (*)()>>);
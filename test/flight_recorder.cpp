@@ -0,0 +1,236 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "page_snapshot.h"
+#include "scope_action.h"
+
+namespace {
+
+class FlightRecorderTest : public ::testing::Test {
+protected:
+    std::filesystem::path path;
+
+    void SetUp() override
+    {
+        this->path = std::filesystem::temp_directory_path() /
+                     ("flight_recorder_" + std::to_string(::getpid()) + "_" +
+                      ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".txt");
+    }
+
+    void TearDown() override { std::filesystem::remove(this->path); }
+
+    [[nodiscard]] std::string contents() const
+    {
+        std::ifstream in(this->path);
+        return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    }
+
+    /**
+     * Dumps the events into the file and returns the section of the calling thread.
+     */
+    [[nodiscard]] std::string dump_current_thread() const
+    {
+        const int fd = ::open(this->path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);  // NOLINT
+        if (fd == -1) {
+            return {};
+        }
+
+        wwa::utils::flight_recorder::dump(fd);
+        ::close(fd);
+
+        const std::string dump = "\n" + this->contents();
+        const auto current     = dump.find(" (current)");
+        if (current == std::string::npos) {
+            return {};
+        }
+
+        const auto begin       = dump.rfind("\nthread ", current);
+        const auto next_thread = dump.find("\nthread ", current);
+        const auto maps        = dump.find("\nmaps:", current);
+        const auto end         = next_thread < maps ? next_thread : maps;
+        return dump.substr(begin + 1, end - begin);
+    }
+};
+
+std::size_t count(const std::string& haystack, const std::string& needle)
+{
+    std::size_t n = 0;
+    for (auto pos = haystack.find(needle); pos != std::string::npos; pos = haystack.find(needle, pos + 1)) {
+        ++n;
+    }
+
+    return n;
+}
+
+}  // namespace
+
+TEST_F(FlightRecorderTest, IsEnabled)
+{
+    EXPECT_TRUE(wwa::utils::flight_recorder::enabled);
+    EXPECT_EQ(wwa::utils::flight_recorder::ring_events, WWA_FLIGHT_RECORDER_EVENTS);
+}
+
+TEST_F(FlightRecorderTest, ListsActiveScopes)
+{
+    std::string section;
+    std::thread([this, &section]() {
+        {
+            const wwa::utils::exit_action done([]() {});
+        }
+
+        const wwa::utils::exit_action outer([]() {});
+        const wwa::utils::fail_action inner([]() {});
+        section = this->dump_current_thread();
+    }).join();
+
+    ASSERT_FALSE(section.empty());
+    EXPECT_NE(section.find(": 5 of 5 events\n"), std::string::npos) << section;
+
+    const auto active = section.substr(0, section.find("  events (oldest first):"));
+    EXPECT_EQ(count(active, "exit_action"), 1) << section;
+    EXPECT_EQ(count(active, "fail_action"), 1) << section;
+    EXPECT_LT(active.find("exit_action"), active.find("fail_action")) << section;
+}
+
+TEST_F(FlightRecorderTest, RecordsEventsInOrder)
+{
+    std::string section;
+    std::thread([this, &section]() {
+        {
+            const wwa::utils::exit_action fired([]() {});
+        }
+
+        {
+            wwa::utils::success_action released([]() {});
+            released.release();
+        }
+
+        section = this->dump_current_thread();
+    }).join();
+
+    const auto events = section.substr(section.find("  events (oldest first):"));
+    const auto enter1 = events.find("enter   exit_action");
+    const auto fire   = events.find("fire    exit_action");
+    const auto exit1  = events.find("exit    exit_action");
+    const auto enter2 = events.find("enter   success_action");
+    const auto rel    = events.find("release success_action");
+    const auto exit2  = events.find("exit    success_action");
+
+    ASSERT_NE(exit2, std::string::npos) << section;
+    EXPECT_LT(enter1, fire);
+    EXPECT_LT(fire, exit1);
+    EXPECT_LT(exit1, enter2);
+    EXPECT_LT(enter2, rel);
+    EXPECT_LT(rel, exit2);
+    EXPECT_EQ(count(events, "fire "), 1) << section;
+}
+
+TEST_F(FlightRecorderTest, KeepsTheLastEvents)
+{
+    constexpr std::size_t scopes = wwa::utils::flight_recorder::ring_events;
+
+    std::string section;
+    std::thread([this, &section]() {
+        for (std::size_t i = 0; i < scopes; ++i) {
+            const wwa::utils::fail_action guard([]() {});
+        }
+
+        section = this->dump_current_thread();
+    }).join();
+
+    const std::string expected = ": " + std::to_string(scopes) + " of " + std::to_string(2 * scopes) + " events\n";
+    EXPECT_NE(section.find(expected), std::string::npos) << section.substr(0, 200);
+    EXPECT_EQ(count(section, "fail_action"), scopes);
+}
+
+TEST_F(FlightRecorderTest, KeepsRingsOfExitedThreads)
+{
+    long tid = 0;
+    std::thread([&tid]() {
+        tid = ::syscall(SYS_gettid);
+        const wwa::utils::success_action guard([]() {});
+    }).join();
+
+    const int fd = ::open(this->path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);  // NOLINT
+    ASSERT_NE(fd, -1);
+    wwa::utils::flight_recorder::dump(fd);
+    ::close(fd);
+
+    const std::string dump = this->contents();
+    const auto section     = dump.find("thread " + std::to_string(tid) + ": 3 of 3 events\n");
+    ASSERT_NE(section, std::string::npos) << dump.substr(0, dump.find("maps:"));
+    EXPECT_NE(dump.find("exit    success_action", section), std::string::npos);
+}
+
+TEST_F(FlightRecorderTest, DumpsOnFatalSignal)
+{
+    EXPECT_DEATH(
+        {
+            wwa::utils::flight_recorder::install(this->path.string(), {SIGABRT});
+            const wwa::utils::exit_action guard([]() {});
+            std::abort();
+        },
+        ""
+    );
+
+    const std::string dump = this->contents();
+    EXPECT_EQ(dump.rfind("flight recorder: signal " + std::to_string(SIGABRT) + " in thread ", 0), 0) << dump;
+    EXPECT_NE(dump.find(" (current)"), std::string::npos);
+    EXPECT_NE(dump.find("enter   exit_action"), std::string::npos);
+    EXPECT_NE(dump.find("\nmaps:\n"), std::string::npos);
+}
+
+TEST_F(FlightRecorderTest, PassesSnapshotFaultsToPageSnapshot)
+{
+    const auto run = [this](bool crash) {
+        const std::size_t size = wwa::utils::page_snapshot::page_size();
+        void* map              = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (map == MAP_FAILED) {  // NOLINT(*-cstyle-cast,performance-no-int-to-ptr)
+            std::_Exit(2);
+        }
+
+        auto* region = static_cast<volatile int*>(map);
+        {
+            // The snapshot installs its fault handler first, so the flight recorder handler runs before it
+            const wwa::utils::page_snapshot snapshot({static_cast<std::byte*>(map), size});
+            wwa::utils::flight_recorder::install(this->path.string(), {SIGSEGV});
+            region[0] = 1;
+            if (region[0] != 1 || snapshot.touched() != 1 || std::filesystem::exists(this->path)) {
+                std::_Exit(1);
+            }
+
+            if (crash) {
+                *static_cast<volatile int*>(nullptr) = 1;  // NOLINT(clang-analyzer-core.NullDereference)
+            }
+        }
+
+        std::_Exit(0);
+    };
+
+    EXPECT_EXIT(run(false), ::testing::ExitedWithCode(0), "");
+    EXPECT_FALSE(std::filesystem::exists(this->path));
+
+    // A genuine crash is still dumped
+    EXPECT_EXIT(run(true), ::testing::KilledBySignal(SIGSEGV), "");
+    const std::string dump = this->contents();
+    EXPECT_EQ(dump.rfind("flight recorder: signal " + std::to_string(SIGSEGV) + " in thread ", 0), 0) << dump;
+}
+
+TEST_F(FlightRecorderTest, RejectsLongPaths)
+{
+    const std::string path(wwa::utils::flight_recorder::max_path + 1, 'x');
+    EXPECT_THROW(wwa::utils::flight_recorder::install(path, {}), std::length_error);
+}
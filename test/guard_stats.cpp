@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "guard_stats.h"
+#include "scope_action.h"
+
+using wwa::utils::guard_counts;
+using wwa::utils::guard_stats;
+using wwa::utils::scope_probe_kind;
+
+TEST(GuardStats, IsEnabled)
+{
+    EXPECT_TRUE(guard_stats::enabled);
+    EXPECT_TRUE(guard_stats::by_site);
+}
+
+TEST(GuardStats, CountsPerKind)
+{
+    const auto before = guard_stats::snapshot();
+
+    {
+        const wwa::utils::exit_action fired([]() {});
+        wwa::utils::exit_action released([]() {});
+        released.release();
+    }
+
+    try {
+        const wwa::utils::fail_action fired([]() {});
+        const wwa::utils::success_action not_fired([]() {});
+        throw std::runtime_error("error");
+    }
+    catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+    }
+
+    {
+        const wwa::utils::fail_action not_fired([]() {});
+        const wwa::utils::success_action fired([]() {});
+    }
+
+    const auto after = guard_stats::snapshot();
+    EXPECT_EQ(after[scope_probe_kind::exit] - before[scope_probe_kind::exit], (guard_counts{2, 1, 1}));
+    EXPECT_EQ(after[scope_probe_kind::fail] - before[scope_probe_kind::fail], (guard_counts{2, 0, 1}));
+    EXPECT_EQ(after[scope_probe_kind::success] - before[scope_probe_kind::success], (guard_counts{2, 0, 1}));
+}
+
+TEST(GuardStats, MoveCountsArmedAndReleased)
+{
+    const auto before = guard_stats::snapshot();
+    {
+        wwa::utils::exit_action guard([]() {});
+        const wwa::utils::exit_action moved(std::move(guard));
+    }
+
+    const auto after = guard_stats::snapshot();
+    EXPECT_EQ(after[scope_probe_kind::exit] - before[scope_probe_kind::exit], (guard_counts{2, 1, 1}));
+}
+
+TEST(GuardStats, CountsPerSite)
+{
+    constexpr std::size_t iterations = 7;
+    for (std::size_t i = 0; i < iterations; ++i) {
+        const wwa::utils::fail_action guard([]() {});
+    }
+
+    const auto stats = guard_stats::snapshot();
+    const auto site  = std::ranges::find_if(stats.sites, [](const wwa::utils::guard_site_counts& s) {
+        return s.kind == scope_probe_kind::fail && s.counts == guard_counts{iterations, 0, 0};
+    });
+
+    ASSERT_NE(site, stats.sites.end());
+    EXPECT_NE(site->site.find("fail_action<"), std::string_view::npos) << site->site;
+}
+
+TEST(GuardStats, CountsAcrossThreads)
+{
+    constexpr std::size_t threads    = 4;
+    constexpr std::size_t iterations = 1000;
+
+    const auto before = guard_stats::snapshot();
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (std::size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([]() {
+            for (std::size_t i = 0; i < iterations; ++i) {
+                const wwa::utils::success_action guard([]() {});
+            }
+        });
+    }
+
+    for (auto& w : workers) {
+        w.join();
+    }
+
+    const auto after = guard_stats::snapshot();
+    EXPECT_EQ(
+        after[scope_probe_kind::success] - before[scope_probe_kind::success],
+        (guard_counts{threads * iterations, 0, threads * iterations})
+    );
+}
+
+TEST(GuardStats, WritesTextReport)
+{
+    {
+        const wwa::utils::exit_action guard([]() {});
+    }
+
+    std::ostringstream os;
+    guard_stats::write(os);
+    const std::string report = os.str();
+
+    EXPECT_EQ(report.rfind("          armed", 0), 0) << report;
+    EXPECT_NE(report.find("exit_action     *\n"), std::string::npos) << report;
+    EXPECT_NE(report.find("fail_action     *\n"), std::string::npos) << report;
+    EXPECT_NE(report.find("success_action  *\n"), std::string::npos) << report;
+    EXPECT_NE(report.find("exit_action     wwa::utils::exit_action<"), std::string::npos) << report;
+}
+
+TEST(GuardStats, WritesFile)
+{
+    const auto path = std::filesystem::temp_directory_path() / ("guard_stats_" + std::to_string(::getpid()) + ".txt");
+    guard_stats::write(path.string());
+
+    std::ifstream in(path);
+    const std::string contents{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    std::filesystem::remove(path);
+
+    std::ostringstream os;
+    guard_stats::write(os);
+    EXPECT_EQ(contents.substr(0, contents.find('\n')), os.str().substr(0, os.str().find('\n')));
+    EXPECT_THROW(guard_stats::write(std::string("/nonexistent/guard_stats.txt")), std::runtime_error);
+}
@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "latency_histogram.h"
+
+namespace {
+
+void timed_failure(wwa::utils::latency_histogram& histogram)
+{
+    const wwa::utils::latency_scope timer(histogram);
+    throw std::runtime_error("error");
+}
+
+}  // namespace
+
+TEST(HdrHistogram, BucketsCoverValues)
+{
+    using wwa::utils::hdr_histogram;
+
+    for (std::uint64_t v = 0; v < 2 * hdr_histogram::sub_bucket_count; ++v) {
+        EXPECT_EQ(hdr_histogram::lowest_value(hdr_histogram::bucket_index(v)), v);
+        EXPECT_EQ(hdr_histogram::highest_value(hdr_histogram::bucket_index(v)), v);
+    }
+
+    for (std::uint64_t v = 100; v < hdr_histogram::max_value; v = v * 3 / 2 + 7) {
+        const auto index = hdr_histogram::bucket_index(v);
+        const auto lo    = hdr_histogram::lowest_value(index);
+        const auto hi    = hdr_histogram::highest_value(index);
+        EXPECT_LE(lo, v);
+        EXPECT_GE(hi, v);
+        EXPECT_LE(static_cast<double>(hi - lo), static_cast<double>(v) / hdr_histogram::sub_bucket_count) << v;
+        EXPECT_EQ(hdr_histogram::bucket_index(lo), index);
+        EXPECT_EQ(hdr_histogram::bucket_index(hi), index);
+        EXPECT_EQ(hdr_histogram::bucket_index(hi + 1), index + 1);
+    }
+
+    EXPECT_EQ(hdr_histogram::bucket_index(hdr_histogram::max_value), hdr_histogram::bucket_count - 1);
+    EXPECT_EQ(hdr_histogram::bucket_index(UINT64_MAX), hdr_histogram::bucket_count - 1);
+}
+
+TEST(HdrHistogram, Percentiles)
+{
+    wwa::utils::hdr_histogram h;
+    EXPECT_EQ(h.value_at_percentile(50.0), 0);
+    EXPECT_EQ(h.min(), 0);
+    EXPECT_EQ(h.max(), 0);
+
+    for (std::uint64_t v = 1; v <= 100'000; ++v) {
+        h.record(v);
+    }
+
+    EXPECT_EQ(h.count(), 100'000);
+    EXPECT_EQ(h.min(), 1);
+    EXPECT_NEAR(static_cast<double>(h.max()), 100'000.0, 100'000.0 / 64);
+    EXPECT_NEAR(h.mean(), 50'000.0, 50'000.0 / 64);
+    EXPECT_NEAR(static_cast<double>(h.value_at_percentile(50.0)), 50'000.0, 50'000.0 / 64);
+    EXPECT_NEAR(static_cast<double>(h.value_at_percentile(99.0)), 99'000.0, 99'000.0 / 64);
+    EXPECT_NEAR(static_cast<double>(h.value_at_percentile(99.9)), 99'900.0, 99'900.0 / 64);
+    EXPECT_EQ(h.value_at_percentile(0.0), 1);
+    EXPECT_EQ(h.value_at_percentile(100.0), h.max());
+}
+
+TEST(HdrHistogram, Merge)
+{
+    wwa::utils::hdr_histogram a;
+    wwa::utils::hdr_histogram b;
+    a.record(10, 3);
+    b.record(1'000'000);
+
+    a += b;
+    EXPECT_EQ(a.count(), 4);
+    EXPECT_EQ(a.value_at_percentile(75.0), 10);
+    EXPECT_GE(a.value_at_percentile(100.0), 1'000'000);
+}
+
+TEST(HdrHistogram, Write)
+{
+    wwa::utils::hdr_histogram h;
+    for (std::uint64_t v = 1; v <= 1000; ++v) {
+        h.record(v * 1000);
+    }
+
+    std::ostringstream os;
+    h.write(os);
+    const auto text = os.str();
+    EXPECT_EQ(text.find("       Value     Percentile TotalCount"), 0);
+    EXPECT_NE(text.find("1.000000000000       1000\n"), std::string::npos);
+    EXPECT_NE(text.find("#[Mean    =      500."), std::string::npos);
+    EXPECT_NE(text.find("Total count    =         1000]"), std::string::npos);
+}
+
+TEST(LatencyHistogram, RecordsSuccessAndFailureSeparately)
+{
+    wwa::utils::latency_histogram histogram;
+    for (int i = 0; i < 10; ++i) {
+        const wwa::utils::latency_scope timer(histogram);
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_THROW(timed_failure(histogram), std::runtime_error);
+    }
+
+    histogram.record(std::chrono::milliseconds(5));
+
+    const auto s = histogram.snapshot();
+    EXPECT_EQ(s.succeeded.count(), 11);
+    EXPECT_EQ(s.failed.count(), 3);
+    EXPECT_GE(s.succeeded.max(), 5'000'000);
+}
+
+TEST(LatencyHistogram, MergesThreads)
+{
+    constexpr int threads = 8;
+    constexpr int records = 10'000;
+
+    wwa::utils::latency_histogram histogram;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&histogram, t]() {
+            for (int i = 0; i < records; ++i) {
+                histogram.record(static_cast<std::uint64_t>(t * 1000 + i % 100), i % 10 == 0);
+            }
+        });
+    }
+
+    // Snapshots do not block the writers
+    const auto partial = histogram.snapshot();
+    EXPECT_LE(partial.succeeded.count() + partial.failed.count(), threads * records);
+
+    for (auto& w : workers) {
+        w.join();
+    }
+
+    const auto s = histogram.snapshot();
+    EXPECT_EQ(s.succeeded.count(), threads * records * 9 / 10);
+    EXPECT_EQ(s.failed.count(), threads * records / 10);
+    EXPECT_EQ(s.succeeded.min(), 1);
+    EXPECT_EQ(s.failed.min(), 0);
+}
@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "memory_profile.h"
+
+namespace {
+
+constexpr std::size_t block_size = std::size_t{32} << 20;
+
+class report_collector {
+public:
+    void operator()(const wwa::utils::memory_report& r)
+    {
+        const std::lock_guard lock(this->m_mutex);
+        this->m_reports.push_back(r);
+    }
+
+    [[nodiscard]] std::vector<wwa::utils::memory_report> reports() const
+    {
+        const std::lock_guard lock(this->m_mutex);
+        return this->m_reports;
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::vector<wwa::utils::memory_report> m_reports;
+};
+
+bool heap_statistics_available()
+{
+    return wwa::utils::memory_sample::now().heap_in_use != 0;
+}
+
+void touch(std::byte* p, std::size_t size)
+{
+    std::memset(p, 1, size);
+}
+
+}  // namespace
+
+TEST(MemorySample, Now)
+{
+    const auto s = wwa::utils::memory_sample::now();
+    EXPECT_GT(s.rss, 0);
+    EXPECT_GE(s.heap_mapped, 0);
+    EXPECT_GT(s.minor_faults, 0);
+}
+
+TEST(MemoryScope, ReportsDeltas)
+{
+    report_collector collector;
+    wwa::utils::memory_profiler profiler(std::ref(collector));
+
+    auto block = std::make_unique_for_overwrite<std::byte[]>(block_size);  // NOLINT(*-avoid-c-arrays)
+    {
+        const wwa::utils::memory_scope scope(profiler, "allocate");
+        block.reset();
+        block = std::make_unique_for_overwrite<std::byte[]>(block_size);  // NOLINT(*-avoid-c-arrays)
+        touch(block.get(), block_size);
+    }
+
+    const auto reports = collector.reports();
+    ASSERT_EQ(reports.size(), 1);
+
+    const auto& r = reports.front();
+    EXPECT_STREQ(r.name, "allocate");
+    EXPECT_FALSE(r.failed);
+    EXPECT_GT(r.delta().minor_faults, 0);
+    EXPECT_GE(r.delta().rss, static_cast<std::int64_t>(block_size / 2));
+    EXPECT_GE(r.peak_rss, r.exit.rss);
+}
+
+TEST(MemoryScope, PollingCapturesPeak)
+{
+    if (!heap_statistics_available()) {
+        GTEST_SKIP() << "Heap statistics are not available";
+    }
+
+    report_collector collector;
+    wwa::utils::memory_profiler profiler(
+        std::ref(collector), {.sample_every = 1, .poll_interval = std::chrono::milliseconds(1)}
+    );
+    {
+        const wwa::utils::memory_scope scope(profiler);
+        auto block = std::make_unique_for_overwrite<std::byte[]>(block_size);  // NOLINT(*-avoid-c-arrays)
+        touch(block.get(), block_size);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    const auto reports = collector.reports();
+    ASSERT_EQ(reports.size(), 1);
+
+    // The block is gone on exit, but the peak has been observed
+    const auto& r = reports.front();
+    EXPECT_LT(r.delta().heap_in_use, static_cast<std::int64_t>(block_size / 2));
+    EXPECT_GE(r.peak_heap_growth(), static_cast<std::int64_t>(block_size));
+    EXPECT_GE(r.peak_rss_growth(), static_cast<std::int64_t>(block_size / 2));
+}
+
+TEST(MemoryScope, Sampling)
+{
+    report_collector collector;
+    wwa::utils::memory_profiler profiler(std::ref(collector), {.sample_every = 4});
+
+    int profiled = 0;
+    for (int i = 0; i < 20; ++i) {
+        const wwa::utils::memory_scope scope(profiler);
+        profiled += scope.profiled() ? 1 : 0;
+    }
+
+    EXPECT_EQ(profiled, 5);
+    EXPECT_EQ(collector.reports().size(), 5);
+
+    wwa::utils::memory_profiler disabled(std::ref(collector), {.sample_every = 0});
+    const wwa::utils::memory_scope scope(disabled);
+    EXPECT_FALSE(scope.profiled());
+}
+
+TEST(MemoryScope, Failure)
+{
+    report_collector collector;
+    wwa::utils::memory_profiler profiler(std::ref(collector));
+
+    try {
+        const wwa::utils::memory_scope scope(profiler);
+        throw std::runtime_error("error");
+    }
+    catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+    }
+
+    const auto reports = collector.reports();
+    ASSERT_EQ(reports.size(), 1);
+    EXPECT_TRUE(reports.front().failed);
+}
+
+TEST(MemoryProfileAggregator, GroupsByCallSite)
+{
+    wwa::utils::memory_profile_aggregator aggregator;
+    wwa::utils::memory_profiler profiler(std::ref(aggregator));
+
+    for (int i = 0; i < 3; ++i) {
+        const wwa::utils::memory_scope a(profiler, "a");
+    }
+
+    {
+        const wwa::utils::memory_scope b(profiler, "b");
+        const std::vector<std::byte> v(block_size);
+    }
+
+    const auto sites = aggregator.sites();
+    ASSERT_EQ(sites.size(), 2);
+    for (const auto& s : sites) {
+        EXPECT_EQ(s.count, std::strcmp(s.name, "a") == 0 ? 3 : 1);
+    }
+
+    std::ostringstream os;
+    aggregator.write(os);
+    EXPECT_NE(os.str().find("memory_profile.cpp"), std::string::npos);
+    EXPECT_NE(os.str().find("(a)"), std::string::npos);
+}
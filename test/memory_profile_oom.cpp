@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <vector>
+
+#include "memory_profile.h"
+
+namespace {
+
+thread_local bool fail_allocations = false;
+
+}  // namespace
+
+// The replacements make allocations of the current thread fail on demand; the program must not define other ones
+
+void* operator new(std::size_t size)
+{
+    if (!fail_allocations) {
+        if (void* p = std::malloc(size != 0 ? size : 1); p != nullptr) {  // NOLINT(*-no-malloc)
+            return p;
+        }
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);  // NOLINT(*-no-malloc)
+}
+
+void operator delete(void* p, std::size_t /* size */) noexcept
+{
+    std::free(p);  // NOLINT(*-no-malloc)
+}
+
+TEST(MemoryScope, NotReportedIfConstructionFails)
+{
+    std::vector<wwa::utils::memory_report> reports;
+    reports.reserve(1);
+
+    wwa::utils::memory_profiler profiler(
+        [&reports](const wwa::utils::memory_report& r) { reports.push_back(r); },
+        {.sample_every = 1, .poll_interval = std::chrono::milliseconds(1)}
+    );
+
+    fail_allocations = true;
+    EXPECT_THROW({ const wwa::utils::memory_scope scope(profiler); }, std::bad_alloc);
+    fail_allocations = false;
+
+    EXPECT_TRUE(reports.empty());
+
+    {
+        const wwa::utils::memory_scope scope(profiler);
+    }
+
+    EXPECT_EQ(reports.size(), 1);
+}
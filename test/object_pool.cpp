@@ -0,0 +1,197 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "object_pool.h"
+
+namespace {
+
+struct resource {
+    static inline std::atomic<int> created   = 0;
+    static inline std::atomic<int> destroyed = 0;
+
+    std::string data;
+    std::atomic<bool> in_use = false;
+
+    resource() { ++created; }
+    resource(const resource&)            = delete;
+    resource(resource&&)                 = delete;
+    resource& operator=(const resource&) = delete;
+    resource& operator=(resource&&)      = delete;
+    ~resource() { ++destroyed; }
+};
+
+class ObjectPoolTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        resource::created   = 0;
+        resource::destroyed = 0;
+    }
+};
+
+}  // namespace
+
+TEST_F(ObjectPoolTest, ReusesObjects)
+{
+    wwa::utils::object_pool<resource> pool(4);
+    const resource* first = nullptr;
+    {
+        auto r = pool.acquire();
+        first  = r.get();
+        r->data = "hello";
+    }
+
+    {
+        auto r = pool.acquire();
+        EXPECT_EQ(r.get(), first);
+        EXPECT_EQ(r->data, "hello");
+    }
+
+    EXPECT_EQ(resource::created, 1);
+    EXPECT_EQ(resource::destroyed, 0);
+}
+
+TEST_F(ObjectPoolTest, Reset)
+{
+    wwa::utils::object_pool<resource> pool(4, {}, [](resource& r) { r.data.clear(); });
+    {
+        auto r  = pool.acquire();
+        r->data = "hello";
+    }
+
+    auto r = pool.acquire();
+    EXPECT_TRUE(r->data.empty());
+    EXPECT_EQ(resource::created, 1);
+}
+
+TEST_F(ObjectPoolTest, DiscardsOnFailure)
+{
+    wwa::utils::object_pool<resource> pool(4);
+    try {
+        auto r = pool.acquire();
+        throw std::runtime_error("error");
+    }
+    catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+    }
+
+    EXPECT_EQ(resource::created, 1);
+    EXPECT_EQ(resource::destroyed, 1);
+
+    {
+        auto r = pool.acquire();
+        r.discard();
+    }
+
+    EXPECT_EQ(resource::created, 2);
+    EXPECT_EQ(resource::destroyed, 2);
+
+    // The slot is reused with a fresh object
+    {
+        auto r = pool.acquire();
+    }
+
+    EXPECT_EQ(resource::created, 3);
+    EXPECT_EQ(resource::destroyed, 2);
+}
+
+TEST_F(ObjectPoolTest, DiscardsWhenResetThrows)
+{
+    wwa::utils::object_pool<resource> pool(4, {}, [](resource&) { throw std::runtime_error("error"); });
+    {
+        auto r = pool.acquire();
+    }
+
+    EXPECT_EQ(resource::created, 1);
+    EXPECT_EQ(resource::destroyed, 1);
+}
+
+TEST_F(ObjectPoolTest, TransientObjects)
+{
+    wwa::utils::object_pool<resource> pool(1);
+    {
+        auto a = pool.acquire();
+        auto b = pool.acquire();
+        EXPECT_NE(a.get(), b.get());
+    }
+
+    // The transient object is destroyed, the pooled one is kept
+    EXPECT_EQ(resource::created, 2);
+    EXPECT_EQ(resource::destroyed, 1);
+}
+
+TEST_F(ObjectPoolTest, FactoryFailure)
+{
+    bool fail = true;
+    wwa::utils::object_pool<resource> pool(1, [&fail]() {
+        if (fail) {
+            throw std::runtime_error("error");
+        }
+
+        return std::make_unique<resource>();
+    });
+
+    EXPECT_THROW((void)pool.acquire(), std::runtime_error);
+
+    // The slot has not been lost
+    fail = false;
+    {
+        auto a = pool.acquire();
+        EXPECT_EQ(resource::created, 1);
+    }
+
+    auto b = pool.acquire();
+    EXPECT_EQ(resource::created, 1);
+}
+
+TEST_F(ObjectPoolTest, ObjectsAreNotShared)
+{
+    constexpr int threads    = 8;
+    constexpr int iterations = 20'000;
+
+    wwa::utils::object_pool<resource> pool(16);
+    std::atomic<int> conflicts = 0;
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&pool, &conflicts]() {
+            for (int i = 0; i < iterations; ++i) {
+                auto a = pool.acquire();
+                auto b = pool.acquire();
+                for (auto* r : {a.get(), b.get()}) {
+                    if (r->in_use.exchange(true)) {
+                        ++conflicts;
+                    }
+                }
+
+                a->in_use = false;
+                b->in_use = false;
+            }
+        });
+    }
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    EXPECT_EQ(conflicts, 0);
+    // Magazines may hold objects when all of them are leased elsewhere, so a few transient objects are fine
+    EXPECT_GE(resource::created, 2);
+}
+
+TEST(ObjectPool, InvalidArguments)
+{
+    struct no_default {
+        explicit no_default(int) {}
+    };
+
+    EXPECT_THROW(wwa::utils::object_pool<no_default>(1), std::invalid_argument);
+    EXPECT_NO_THROW(wwa::utils::object_pool<no_default>(1, []() { return std::make_unique<no_default>(1); }));
+}
@@ -0,0 +1,202 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <sys/mman.h>
+
+#include "page_snapshot.h"
+
+namespace {
+
+constexpr std::size_t pages = 16;
+
+class anonymous_mapping {
+public:
+    explicit anonymous_mapping(std::size_t size, int protection = PROT_READ | PROT_WRITE) : m_size(size)
+    {
+        void* map = ::mmap(nullptr, size, protection, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (map == MAP_FAILED) {  // NOLINT(*-cstyle-cast,performance-no-int-to-ptr)
+            throw std::runtime_error("Unable to map memory");
+        }
+
+        this->m_map = static_cast<std::byte*>(map);
+    }
+
+    anonymous_mapping(const anonymous_mapping&)            = delete;
+    anonymous_mapping(anonymous_mapping&&)                 = delete;
+    anonymous_mapping& operator=(const anonymous_mapping&) = delete;
+    anonymous_mapping& operator=(anonymous_mapping&&)      = delete;
+
+    ~anonymous_mapping() { ::munmap(this->m_map, this->m_size); }
+
+    [[nodiscard]] std::span<std::byte> region() const { return {this->m_map, this->m_size}; }
+
+    [[nodiscard]] std::byte& page(std::size_t n, std::size_t offset = 0) const
+    {
+        return this->m_map[n * wwa::utils::page_snapshot::page_size() + offset];
+    }
+
+private:
+    std::byte* m_map = nullptr;
+    std::size_t m_size;
+};
+
+class PageSnapshot : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        for (std::size_t i = 0; i < pages; ++i) {
+            this->m_memory.page(i)     = std::byte{1};
+            this->m_memory.page(i, 99) = std::byte{2};
+        }
+    }
+
+    [[nodiscard]] const anonymous_mapping& memory() const { return this->m_memory; }
+
+    [[nodiscard]] bool unchanged(std::size_t page) const
+    {
+        return this->m_memory.page(page) == std::byte{1} && this->m_memory.page(page, 99) == std::byte{2};
+    }
+
+private:
+    anonymous_mapping m_memory{pages * wwa::utils::page_snapshot::page_size()};
+};
+
+}  // namespace
+
+TEST_F(PageSnapshot, CommitOnSuccess)
+{
+    {
+        wwa::utils::page_snapshot snapshot(this->memory().region());
+        this->memory().page(1)     = std::byte{10};
+        this->memory().page(1, 99) = std::byte{11};
+        this->memory().page(5, 99) = std::byte{12};
+        EXPECT_EQ(snapshot.touched(), 2);
+    }
+
+    EXPECT_EQ(this->memory().page(1), std::byte{10});
+    EXPECT_EQ(this->memory().page(1, 99), std::byte{11});
+    EXPECT_EQ(this->memory().page(5, 99), std::byte{12});
+
+    // The region is writable again
+    this->memory().page(7) = std::byte{13};
+    EXPECT_EQ(this->memory().page(7), std::byte{13});
+}
+
+TEST_F(PageSnapshot, RollbackOnFailure)
+{
+    try {
+        wwa::utils::page_snapshot snapshot(this->memory().region());
+        this->memory().page(0)      = std::byte{10};
+        this->memory().page(3, 99)  = std::byte{11};
+        this->memory().page(15, 99) = std::byte{12};
+        throw std::runtime_error("error");
+    }
+    catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+    }
+
+    for (std::size_t i = 0; i < pages; ++i) {
+        EXPECT_TRUE(this->unchanged(i)) << "page " << i;
+    }
+
+    this->memory().page(3) = std::byte{13};
+    EXPECT_EQ(this->memory().page(3), std::byte{13});
+}
+
+TEST_F(PageSnapshot, ReadsDoNotSavePages)
+{
+    wwa::utils::page_snapshot snapshot(this->memory().region());
+    for (std::size_t i = 0; i < pages; ++i) {
+        EXPECT_TRUE(this->unchanged(i));
+    }
+
+    EXPECT_EQ(snapshot.touched(), 0);
+}
+
+TEST_F(PageSnapshot, ExplicitRollback)
+{
+    wwa::utils::page_snapshot snapshot(this->memory().region());
+    std::memset(&this->memory().page(2), 0xFF, 3 * wwa::utils::page_snapshot::page_size());
+    EXPECT_EQ(snapshot.touched(), 3);
+
+    snapshot.rollback();
+    for (std::size_t i = 0; i < pages; ++i) {
+        EXPECT_TRUE(this->unchanged(i)) << "page " << i;
+    }
+
+    // The snapshot is inactive: the modifications are kept
+    this->memory().page(4) = std::byte{10};
+    snapshot.rollback();
+    EXPECT_EQ(this->memory().page(4), std::byte{10});
+}
+
+TEST_F(PageSnapshot, InvalidRegion)
+{
+    const auto region = this->memory().region();
+    EXPECT_THROW(wwa::utils::page_snapshot(region.subspan(1, region.size() - 1)), std::invalid_argument);
+    EXPECT_THROW(wwa::utils::page_snapshot(region.first(100)), std::invalid_argument);
+    EXPECT_THROW(wwa::utils::page_snapshot(region.first(0)), std::invalid_argument);
+}
+
+TEST_F(PageSnapshot, OverlappingRegions)
+{
+    const auto page   = wwa::utils::page_snapshot::page_size();
+    const auto region = this->memory().region();
+
+    wwa::utils::page_snapshot first(region.first(4 * page));
+    EXPECT_THROW(wwa::utils::page_snapshot(region.subspan(3 * page, page)), std::invalid_argument);
+
+    wwa::utils::page_snapshot second(region.subspan(4 * page, 4 * page));
+    this->memory().page(0) = std::byte{10};
+    this->memory().page(4) = std::byte{11};
+    EXPECT_EQ(first.touched(), 1);
+    EXPECT_EQ(second.touched(), 1);
+
+    second.rollback();
+    EXPECT_TRUE(this->unchanged(4));
+    EXPECT_EQ(this->memory().page(0), std::byte{10});
+}
+
+TEST_F(PageSnapshot, ConcurrentWriters)
+{
+    constexpr std::size_t threads = 4;
+
+    wwa::utils::page_snapshot snapshot(this->memory().region());
+    {
+        std::vector<std::jthread> writers;
+        for (std::size_t t = 0; t < threads; ++t) {
+            writers.emplace_back([this, t]() {
+                for (std::size_t i = 0; i < pages; ++i) {
+                    // All threads write to every page, each to its own byte
+                    this->memory().page(i, 1 + t) = std::byte{0xAA};
+                }
+            });
+        }
+    }
+
+    EXPECT_EQ(snapshot.touched(), pages);
+    for (std::size_t i = 0; i < pages; ++i) {
+        for (std::size_t t = 0; t < threads; ++t) {
+            EXPECT_EQ(this->memory().page(i, 1 + t), std::byte{0xAA});
+        }
+    }
+
+    snapshot.rollback();
+    for (std::size_t i = 0; i < pages; ++i) {
+        EXPECT_TRUE(this->unchanged(i));
+        EXPECT_EQ(this->memory().page(i, 1), std::byte{0});
+    }
+}
+
+TEST_F(PageSnapshot, ForeignFaultsAreForwarded)
+{
+    const anonymous_mapping readonly(wwa::utils::page_snapshot::page_size(), PROT_READ);
+    const wwa::utils::page_snapshot snapshot(this->memory().region());
+
+    EXPECT_DEATH(readonly.page(0) = std::byte{1}, "");
+}
@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include "perf_counters.h"
+
+namespace {
+
+std::uint64_t busy_work(std::uint64_t n)
+{
+    volatile std::uint64_t sum = 0;
+    for (std::uint64_t i = 0; i < n; ++i) {
+        sum = sum + i;
+    }
+
+    return sum;
+}
+
+void measured_failure(wwa::utils::perf_profile& profile)
+{
+    const wwa::utils::perf_scope scope(profile, "failure");
+    throw std::runtime_error("error");
+}
+
+}  // namespace
+
+TEST(PerfCounters, ReadIsMonotonic)
+{
+    const auto& counters = wwa::utils::perf_counters::this_thread();
+    const auto before    = counters.read();
+    busy_work(100'000);
+    const auto after = counters.read();
+
+    if (!counters.available()) {
+        EXPECT_EQ(after.instructions, 0);
+        EXPECT_EQ(after.cycles, 0);
+        EXPECT_FALSE(counters.uses_rdpmc());
+        GTEST_SKIP() << "Hardware performance counters are not available";
+    }
+
+    const auto delta = after - before;
+    EXPECT_GE(delta.instructions, 100'000);
+    EXPECT_GT(delta.cycles, 0);
+}
+
+TEST(PerfCounters, CountersArePerThread)
+{
+    const auto* main_counters   = &wwa::utils::perf_counters::this_thread();
+    const void* thread_counters = nullptr;
+    std::thread([&thread_counters]() { thread_counters = &wwa::utils::perf_counters::this_thread(); }).join();
+    EXPECT_NE(main_counters, thread_counters);
+}
+
+TEST(PerfScope, AccumulatesBySite)
+{
+    wwa::utils::perf_profile profile;
+    for (int i = 0; i < 3; ++i) {
+        const wwa::utils::perf_scope scope(profile, "loop");
+        busy_work(10'000);
+    }
+
+    EXPECT_THROW(measured_failure(profile), std::runtime_error);
+
+    const auto sites = profile.sites();
+    ASSERT_EQ(sites.size(), 2);
+
+    const auto& loop = std::string_view(sites[0].name) == "loop" ? sites[0] : sites[1];
+    const auto& fail = std::string_view(sites[0].name) == "loop" ? sites[1] : sites[0];
+    EXPECT_EQ(loop.count, 3);
+    EXPECT_EQ(loop.failures, 0);
+    EXPECT_EQ(fail.count, 1);
+    EXPECT_EQ(fail.failures, 1);
+
+    if (wwa::utils::perf_counters::this_thread().available()) {
+        EXPECT_GE(loop.total.instructions, 30'000);
+        EXPECT_GE(loop.total.instructions, fail.total.instructions);
+    }
+    else {
+        EXPECT_EQ(loop.total.instructions, 0);
+    }
+}
+
+TEST(PerfScope, Write)
+{
+    wwa::utils::perf_profile profile;
+    {
+        const wwa::utils::perf_scope scope(profile, "region");
+    }
+
+    std::ostringstream os;
+    profile.write(os);
+    const auto text = os.str();
+    EXPECT_NE(text.find("instructions/op"), std::string::npos);
+    EXPECT_NE(text.find("perf_counters.cpp:"), std::string::npos);
+    EXPECT_NE(text.find("(region)"), std::string::npos);
+}
@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "redo_log.h"
+
+namespace {
+
+struct limits {
+    std::uint32_t max_rps;
+    std::uint32_t burst;
+    double weight;
+};
+
+}  // namespace
+
+TEST(RedoLog, WritesInvisibleUntilCommit)
+{
+    wwa::utils::redo_log log;
+    limits l{100, 10, 1.0};
+
+    log.write(l.max_rps, 200U);
+    log.write(l.weight, 0.5);
+    EXPECT_EQ(log.size(), 2);
+    EXPECT_EQ(l.max_rps, 100);
+    EXPECT_EQ(l.weight, 1.0);
+
+    log.commit();
+    EXPECT_TRUE(log.empty());
+    EXPECT_EQ(l.max_rps, 200);
+    EXPECT_EQ(l.burst, 10);
+    EXPECT_EQ(l.weight, 0.5);
+}
+
+TEST(RedoLog, ReadYourOwnWrites)
+{
+    wwa::utils::redo_log log;
+    limits l{100, 10, 1.0};
+
+    EXPECT_EQ(log.read(l.max_rps), 100);
+    EXPECT_FALSE(log.contains(&l.max_rps));
+
+    log.write(l.max_rps, 200U);
+    log.write(l.burst, log.read(l.max_rps) / 10);
+    EXPECT_TRUE(log.contains(&l.max_rps));
+    EXPECT_EQ(log.read(l.max_rps), 200);
+    EXPECT_EQ(log.read(l.burst), 20);
+    EXPECT_EQ(l.burst, 10);
+}
+
+TEST(RedoLog, MixedSizeAccess)
+{
+    wwa::utils::redo_log log;
+    limits l{100, 10, 1.0};
+
+    // The entry for &l is 4 bytes long, and it is the last one in the log
+    log.write(l.max_rps, 200U);
+    const limits whole = log.read(l);
+    EXPECT_EQ(whole.max_rps, 200);
+    EXPECT_EQ(whole.burst, 10);
+    EXPECT_EQ(whole.weight, 1.0);
+
+    // A larger entry at the same address: only the leading bytes are read
+    log.write(l, limits{300, 30, 3.0});
+    EXPECT_EQ(log.read(l.max_rps), 300);
+    EXPECT_EQ(log.read(l).burst, 30);
+
+    log.commit();
+    EXPECT_EQ(l.max_rps, 300);
+    EXPECT_EQ(l.burst, 30);
+    EXPECT_EQ(l.weight, 3.0);
+}
+
+TEST(RedoLog, RepeatedWritesCoalesce)
+{
+    wwa::utils::redo_log log;
+    int x = 0;
+
+    log.write(x, 1);
+    log.write(x, 2);
+    log.write(x, 3);
+    EXPECT_EQ(log.size(), 1);
+    EXPECT_EQ(log.read(x), 3);
+
+    log.commit();
+    EXPECT_EQ(x, 3);
+}
+
+TEST(RedoLog, Discard)
+{
+    wwa::utils::redo_log log;
+    int x = 0;
+
+    log.write(x, 1);
+    log.discard();
+    EXPECT_TRUE(log.empty());
+    EXPECT_FALSE(log.contains(&x));
+    EXPECT_EQ(log.read(x), 0);
+
+    log.commit();
+    EXPECT_EQ(x, 0);
+}
+
+TEST(RedoLog, TransactionSuccess)
+{
+    wwa::utils::redo_log log;
+    limits l{100, 10, 1.0};
+
+    {
+        auto tx = log.begin();
+        log.write(l.max_rps, 200U);
+        log.write(l.burst, 20U);
+        EXPECT_EQ(l.max_rps, 100);
+    }
+
+    EXPECT_TRUE(log.empty());
+    EXPECT_EQ(l.max_rps, 200);
+    EXPECT_EQ(l.burst, 20);
+}
+
+TEST(RedoLog, TransactionFailure)
+{
+    wwa::utils::redo_log log;
+    limits l{100, 10, 1.0};
+
+    try {
+        auto tx = log.begin();
+        log.write(l.max_rps, 200U);
+        log.write(l.burst, 20U);
+        throw std::runtime_error("error");
+    }
+    catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+    }
+
+    EXPECT_TRUE(log.empty());
+    EXPECT_EQ(l.max_rps, 100);
+    EXPECT_EQ(l.burst, 10);
+}
+
+TEST(RedoLog, TransactionRelease)
+{
+    wwa::utils::redo_log log;
+    int x = 0;
+
+    {
+        auto tx = log.begin();
+        log.write(x, 1);
+        tx.release();
+    }
+
+    EXPECT_EQ(x, 0);
+    EXPECT_EQ(log.read(x), 1);
+}
+
+TEST(RedoLog, LongWriteSet)
+{
+    wwa::utils::redo_log log;
+    std::vector<int> values(10000, 0);
+
+    for (int round = 1; round <= 3; ++round) {
+        for (auto& value : values) {
+            log.write(value, round);
+        }
+
+        EXPECT_EQ(log.size(), values.size());
+        for (const auto& value : values) {
+            ASSERT_EQ(value, round - 1);
+            ASSERT_EQ(log.read(value), round);
+        }
+
+        log.commit();
+        for (const auto& value : values) {
+            ASSERT_EQ(value, round);
+        }
+    }
+}
@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "restore_guard.h"
+
+namespace {
+
+struct settings {
+    int level;
+    std::string name;
+    std::vector<int> values;
+};
+
+class counted {
+public:
+    static inline int copies = 0;
+    static inline int moves  = 0;
+
+    explicit counted(int v) : m_value(v) {}
+    counted(const counted& other) : m_value(other.m_value) { ++copies; }
+    counted(counted&& other) noexcept : m_value(other.m_value) { ++moves; }
+
+    counted& operator=(const counted& other)
+    {
+        this->m_value = other.m_value;
+        ++copies;
+        return *this;
+    }
+
+    counted& operator=(counted&& other) noexcept
+    {
+        this->m_value = other.m_value;
+        ++moves;
+        return *this;
+    }
+
+    ~counted() = default;
+
+    [[nodiscard]] int value() const noexcept { return this->m_value; }
+    void set(int v) noexcept { this->m_value = v; }
+
+private:
+    int m_value;
+};
+
+class swap_only {
+public:
+    explicit swap_only(int v) : m_value(v) {}
+    swap_only(const swap_only&)            = default;
+    swap_only(swap_only&&)                 = delete;
+    swap_only& operator=(const swap_only&) = default;
+    swap_only& operator=(swap_only&&)      = delete;
+    ~swap_only() { this->m_value = 0; }  // Not trivially copyable
+
+    friend void swap(swap_only& a, swap_only& b) noexcept { std::swap(a.m_value, b.m_value); }
+
+    [[nodiscard]] int value() const noexcept { return this->m_value; }
+    void set(int v) noexcept { this->m_value = v; }
+
+private:
+    int m_value;
+};
+
+}  // namespace
+
+TEST(ExitRestore, RestoresOnScopeExit)
+{
+    int x                = 1;
+    std::array<int, 3> a = {1, 2, 3};
+    std::string s        = "hello";
+
+    {
+        wwa::utils::exit_restore restore(x, a, s);
+        x = 2;
+        a = {4, 5, 6};
+        s = "world";
+    }
+
+    EXPECT_EQ(x, 1);
+    EXPECT_EQ(a, (std::array<int, 3>{1, 2, 3}));
+    EXPECT_EQ(s, "hello");
+}
+
+TEST(ExitRestore, RestoresOnException)
+{
+    settings cfg{1, "default", {1, 2}};
+
+    try {
+        wwa::utils::exit_restore restore(cfg);
+        cfg.level = 2;
+        cfg.name  = "custom";
+        cfg.values.push_back(3);
+        throw std::runtime_error("error");
+    }
+    catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+    }
+
+    EXPECT_EQ(cfg.level, 1);
+    EXPECT_EQ(cfg.name, "default");
+    EXPECT_EQ(cfg.values, (std::vector<int>{1, 2}));
+}
+
+TEST(ExitRestore, Release)
+{
+    int x = 1;
+    {
+        wwa::utils::exit_restore restore(x);
+        x = 2;
+        restore.release();
+    }
+
+    EXPECT_EQ(x, 2);
+}
+
+TEST(FailRestore, KeepsValuesOnSuccess)
+{
+    int x         = 1;
+    std::string s = "hello";
+    {
+        wwa::utils::fail_restore restore(x, s);
+        x = 2;
+        s = "world";
+    }
+
+    EXPECT_EQ(x, 2);
+    EXPECT_EQ(s, "world");
+}
+
+TEST(FailRestore, RestoresOnFailure)
+{
+    int x         = 1;
+    settings cfg  = {1, "default", {}};
+    std::string s = "hello";
+
+    try {
+        wwa::utils::fail_restore restore(x, cfg, s);
+        x         = 2;
+        cfg.level = 3;
+        s         = "world";
+        throw std::runtime_error("error");
+    }
+    catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+    }
+
+    EXPECT_EQ(x, 1);
+    EXPECT_EQ(cfg.level, 1);
+    EXPECT_EQ(s, "hello");
+}
+
+TEST(FailRestore, CopiesOnlyOnce)
+{
+    counted c(1);
+    counted::copies = 0;
+    counted::moves  = 0;
+
+    try {
+        wwa::utils::fail_restore restore(c);
+        c.set(2);
+        throw std::runtime_error("error");
+    }
+    catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+    }
+
+    EXPECT_EQ(c.value(), 1);
+    EXPECT_EQ(counted::copies, 1);
+    EXPECT_EQ(counted::moves, 1);
+}
+
+TEST(FailRestore, SwapOnly)
+{
+    swap_only v(1);
+
+    try {
+        wwa::utils::fail_restore restore(v);
+        v.set(2);
+        throw std::runtime_error("error");
+    }
+    catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+    }
+
+    EXPECT_EQ(v.value(), 1);
+}
@@ -0,0 +1,229 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "ring_buffer.h"
+
+namespace {
+
+using ring = wwa::utils::ring_buffer<sizeof(int)>;
+
+void put(ring& r, int value)
+{
+    auto slot = r.reserve();
+    std::memcpy(slot.data().data(), &value, sizeof(value));
+}
+
+int get(ring& r)
+{
+    int value = -1;
+    const bool consumed = r.try_consume([&value](std::span<const std::byte> record) {
+        std::memcpy(&value, record.data(), sizeof(value));
+    });
+    EXPECT_TRUE(consumed);
+    return value;
+}
+
+}  // namespace
+
+TEST(RingBuffer, Capacity)
+{
+    EXPECT_THROW(ring(0), std::invalid_argument);
+    EXPECT_THROW(ring(3), std::invalid_argument);
+    EXPECT_EQ(ring(4).capacity(), 4);
+}
+
+TEST(RingBuffer, PublishOnScopeExit)
+{
+    ring r(4);
+
+    EXPECT_FALSE(r.try_consume([](std::span<const std::byte>) { FAIL(); }));
+
+    put(r, 1);
+    put(r, 2);
+    EXPECT_EQ(get(r), 1);
+    EXPECT_EQ(get(r), 2);
+    EXPECT_FALSE(r.try_consume([](std::span<const std::byte>) { FAIL(); }));
+}
+
+TEST(RingBuffer, Resize)
+{
+    wwa::utils::ring_buffer<16> r(2);
+
+    {
+        auto slot = r.reserve();
+        slot.resize(3);
+    }
+
+    std::size_t size = 0;
+    EXPECT_TRUE(r.try_consume([&size](std::span<const std::byte> record) { size = record.size(); }));
+    EXPECT_EQ(size, 3);
+}
+
+TEST(RingBuffer, SkipOnException)
+{
+    ring r(4);
+
+    put(r, 1);
+    try {
+        auto slot = r.reserve();
+        throw std::runtime_error("serialization failed");
+    }
+    catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+    }
+
+    put(r, 2);
+
+    EXPECT_EQ(get(r), 1);
+    EXPECT_EQ(get(r), 2);
+    EXPECT_FALSE(r.try_consume([](std::span<const std::byte>) { FAIL(); }));
+}
+
+TEST(RingBuffer, Cancel)
+{
+    ring r(2);
+
+    {
+        auto slot = r.reserve();
+        slot.cancel();
+    }
+
+    EXPECT_FALSE(r.try_consume([](std::span<const std::byte>) { FAIL(); }));
+
+    // The skipped slot has been recycled
+    put(r, 1);
+    put(r, 2);
+    EXPECT_EQ(get(r), 1);
+    EXPECT_EQ(get(r), 2);
+}
+
+TEST(RingBuffer, TryReserveFull)
+{
+    ring r(2);
+
+    put(r, 1);
+    put(r, 2);
+
+    {
+        auto slot = r.try_reserve();
+        EXPECT_FALSE(slot);
+    }
+
+    EXPECT_EQ(get(r), 1);
+
+    {
+        auto slot = r.try_reserve();
+        EXPECT_TRUE(slot);
+    }
+
+    EXPECT_EQ(get(r), 2);
+}
+
+TEST(RingBuffer, PendingReservationBlocksConsumer)
+{
+    ring r(4);
+
+    {
+        auto slot = r.reserve();
+        put(r, 2);
+        EXPECT_FALSE(r.try_consume([](std::span<const std::byte>) { FAIL(); }));
+        const int value = 1;
+        std::memcpy(slot.data().data(), &value, sizeof(value));
+    }
+
+    EXPECT_EQ(get(r), 1);
+    EXPECT_EQ(get(r), 2);
+}
+
+TEST(RingBuffer, ConsumerException)
+{
+    ring r(2);
+
+    put(r, 1);
+    EXPECT_THROW(
+        r.try_consume([](std::span<const std::byte>) { throw std::runtime_error("error"); }), std::runtime_error
+    );
+    EXPECT_FALSE(r.try_consume([](std::span<const std::byte>) { FAIL(); }));
+}
+
+TEST(RingBuffer, MultipleProducers)
+{
+    constexpr int producers = 4;
+    constexpr int messages  = 5000;
+
+    ring r(64);
+    std::vector<std::thread> threads;
+    threads.reserve(producers);
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&r]() {
+            for (int i = 0; i < messages; ++i) {
+                try {
+                    auto slot = r.reserve();
+                    if (i % 2 != 0) {
+                        throw std::runtime_error("odd");
+                    }
+
+                    std::memcpy(slot.data().data(), &i, sizeof(i));
+                }
+                catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+                }
+            }
+        });
+    }
+
+    int count = 0;
+    int odd   = 0;
+    while (count < producers * messages / 2) {
+        const bool consumed = r.try_consume([&count, &odd](std::span<const std::byte> record) {
+            int value = 0;
+            std::memcpy(&value, record.data(), sizeof(value));
+            odd += value % 2;
+            ++count;
+        });
+
+        if (!consumed) {
+            std::this_thread::yield();
+        }
+    }
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(odd, 0);
+    EXPECT_FALSE(r.try_consume([](std::span<const std::byte>) { FAIL(); }));
+}
+
+TEST(RingBuffer, SingleProducer)
+{
+    constexpr int messages = 10000;
+
+    wwa::utils::ring_buffer<sizeof(int), wwa::utils::producer_model::single> r(16);
+    std::thread producer([&r]() {
+        for (int i = 0; i < messages; ++i) {
+            auto slot = r.reserve();
+            std::memcpy(slot.data().data(), &i, sizeof(i));
+        }
+    });
+
+    int expected = 0;
+    while (expected < messages) {
+        const bool consumed = r.try_consume([&expected](std::span<const std::byte> record) {
+            int value = 0;
+            std::memcpy(&value, record.data(), sizeof(value));
+            EXPECT_EQ(value, expected);
+            ++expected;
+        });
+
+        if (!consumed) {
+            std::this_thread::yield();
+        }
+    }
+
+    producer.join();
+}
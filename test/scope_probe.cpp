@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <elf.h>
+
+#include "scope_action.h"
+
+namespace {
+
+struct probe_note {
+    std::string provider;
+    std::string name;
+    std::string args;
+};
+
+/**
+ * Reads `stapsdt` notes from the `.note.stapsdt` section of the running executable.
+ */
+std::vector<probe_note> read_probe_notes()
+{
+    std::ifstream in("/proc/self/exe", std::ios::binary);
+    const std::vector<char> image{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+
+    Elf64_Ehdr ehdr{};
+    std::memcpy(&ehdr, image.data(), sizeof(ehdr));
+    if (std::memcmp(ehdr.e_ident, ELFMAG, SELFMAG) != 0 || ehdr.e_ident[EI_CLASS] != ELFCLASS64) {
+        return {};
+    }
+
+    std::vector<Elf64_Shdr> sections(ehdr.e_shnum);
+    std::memcpy(sections.data(), image.data() + ehdr.e_shoff, sections.size() * sizeof(Elf64_Shdr));
+    const char* names = image.data() + sections.at(ehdr.e_shstrndx).sh_offset;
+
+    std::vector<probe_note> notes;
+    for (const auto& section : sections) {
+        if (section.sh_type != SHT_NOTE || std::strcmp(names + section.sh_name, ".note.stapsdt") != 0) {
+            continue;
+        }
+
+        std::size_t offset = 0;
+        while (offset + sizeof(Elf64_Nhdr) <= section.sh_size) {
+            Elf64_Nhdr nhdr{};
+            const char* note = image.data() + section.sh_offset + offset;
+            std::memcpy(&nhdr, note, sizeof(nhdr));
+
+            const char* owner = note + sizeof(nhdr);
+            const char* desc  = owner + ((nhdr.n_namesz + 3) & ~3U);
+            if (nhdr.n_type == 3 && std::strcmp(owner, "stapsdt") == 0) {
+                // pc, base, and semaphore addresses are followed by the provider, name, and argument strings
+                const char* provider = desc + 3 * sizeof(std::uint64_t);
+                const char* name     = provider + std::strlen(provider) + 1;
+                const char* args     = name + std::strlen(name) + 1;
+                notes.push_back({provider, name, args});
+            }
+
+            offset += sizeof(nhdr) + ((nhdr.n_namesz + 3) & ~3U) + ((nhdr.n_descsz + 3) & ~3U);
+        }
+    }
+
+    return notes;
+}
+
+}  // namespace
+
+TEST(ScopeProbe, GuardsBehaveAsUsual)
+{
+    int exit_calls    = 0;
+    int fail_calls    = 0;
+    int success_calls = 0;
+
+    {
+        const wwa::utils::exit_action exit([&exit_calls]() { ++exit_calls; });
+        const wwa::utils::fail_action fail([&fail_calls]() { ++fail_calls; });
+        const wwa::utils::success_action success([&success_calls]() { ++success_calls; });
+    }
+
+    {
+        wwa::utils::exit_action exit([&exit_calls]() { ++exit_calls; });
+        wwa::utils::exit_action moved(std::move(exit));
+        moved.release();
+    }
+
+    EXPECT_EQ(exit_calls, 1);
+    EXPECT_EQ(fail_calls, 0);
+    EXPECT_EQ(success_calls, 1);
+}
+
+TEST(ScopeProbe, ProbesArePresentInElfNotes)
+{
+    const auto notes = read_probe_notes();
+
+    std::set<std::string> names;
+    for (const auto& note : notes) {
+        if (note.provider == "wwa_scope_action") {
+            names.insert(note.name);
+
+            std::size_t args = 0;
+            for (auto pos = note.args.find('@'); pos != std::string::npos; pos = note.args.find('@', pos + 1)) {
+                ++args;
+            }
+
+            EXPECT_EQ(args, 3) << note.name << ": " << note.args;
+            EXPECT_EQ(note.args.rfind("8@", 0), 0) << note.name << ": " << note.args;
+        }
+    }
+
+    EXPECT_EQ(names, (std::set<std::string>{"armed", "exited", "fired", "released"}));
+}
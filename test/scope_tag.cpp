@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <time.h>
+
+#include "scope_tag.h"
+
+namespace {
+
+/**
+ * Consumes at least `ms` milliseconds of CPU time.
+ */
+void burn(std::chrono::milliseconds ms)
+{
+    const auto now = []() {
+        struct timespec ts {};
+        ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+    };
+
+    volatile std::uint64_t x = 0;
+    const auto end           = now() + ms;
+    while (now() < end) {
+        for (int i = 0; i < 1000; ++i) {
+            x = x + static_cast<std::uint64_t>(i);
+        }
+    }
+}
+
+}  // namespace
+
+TEST(ScopeTag, PushesAndPops)
+{
+    EXPECT_TRUE(wwa::utils::scope_tag::current().empty());
+    {
+        const wwa::utils::scope_tag outer("outer");
+        {
+            const wwa::utils::scope_tag inner("inner");
+
+            const auto tags = wwa::utils::scope_tag::current();
+            ASSERT_EQ(tags.size(), 2);
+            EXPECT_STREQ(tags[0], "outer");
+            EXPECT_STREQ(tags[1], "inner");
+        }
+
+        ASSERT_EQ(wwa::utils::scope_tag::current().size(), 1);
+        EXPECT_STREQ(wwa::utils::scope_tag::current()[0], "outer");
+    }
+
+    EXPECT_TRUE(wwa::utils::scope_tag::current().empty());
+}
+
+TEST(ScopeTag, PopsOnException)
+{
+    try {
+        const wwa::utils::scope_tag outer("outer");
+        const wwa::utils::scope_tag inner("inner");
+        throw std::runtime_error("error");
+    }
+    catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+    }
+
+    EXPECT_TRUE(wwa::utils::scope_tag::current().empty());
+}
+
+TEST(ScopeTag, DeepStacksAreTruncated)
+{
+    const auto nest = [](auto&& self, std::size_t levels) -> std::size_t {
+        const wwa::utils::scope_tag tag("level");
+        return levels == 1 ? wwa::utils::scope_tag::current().size() : self(self, levels - 1);
+    };
+
+    EXPECT_EQ(nest(nest, wwa::utils::scope_tag::max_depth + 2), wwa::utils::scope_tag::max_depth);
+    EXPECT_TRUE(wwa::utils::scope_tag::current().empty());
+}
+
+TEST(TagSampler, RecordsTagStacks)
+{
+    wwa::utils::tag_sampler sampler({.interval = std::chrono::milliseconds(1)});
+    {
+        const wwa::utils::scope_tag outer("outer");
+        {
+            const wwa::utils::scope_tag inner("inner");
+            burn(std::chrono::milliseconds(200));
+        }
+    }
+
+    sampler.stop();
+    EXPECT_GT(sampler.samples(), 0);
+    EXPECT_EQ(sampler.dropped(), 0);
+
+    std::ostringstream folded;
+    sampler.write_folded(folded);
+    EXPECT_NE(folded.str().find("outer;inner "), std::string::npos) << folded.str();
+
+    std::ostringstream with_ip;
+    sampler.write_folded(with_ip, true);
+    EXPECT_NE(with_ip.str().find("outer;inner;"), std::string::npos) << with_ip.str();
+}
+
+TEST(TagSampler, CountsDroppedSamples)
+{
+    wwa::utils::tag_sampler sampler({.interval = std::chrono::milliseconds(1), .buffer_samples = 1});
+    burn(std::chrono::milliseconds(100));
+    sampler.stop();
+
+    EXPECT_EQ(sampler.samples(), 1);
+    EXPECT_GT(sampler.dropped(), 0);
+
+    std::ostringstream folded;
+    sampler.write_folded(folded);
+    EXPECT_EQ(folded.str(), "[untagged] 1\n");
+}
+
+TEST(TagSampler, OnlyOneSamplerIsActive)
+{
+    wwa::utils::tag_sampler sampler;
+    EXPECT_THROW(wwa::utils::tag_sampler{}, std::logic_error);
+
+    sampler.stop();
+    EXPECT_NO_THROW(wwa::utils::tag_sampler{});
+}
+
+TEST(TagSampler, RejectsInvalidOptions)
+{
+    EXPECT_THROW(wwa::utils::tag_sampler({.interval = std::chrono::microseconds(0)}), std::invalid_argument);
+    EXPECT_THROW(wwa::utils::tag_sampler({.buffer_samples = 0}), std::invalid_argument);
+}
@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+
+#include "scratch_stack.h"
+
+namespace {
+
+bool aligned(const void* p, std::size_t alignment)
+{
+    return reinterpret_cast<std::uintptr_t>(p) % alignment == 0;
+}
+
+}  // namespace
+
+TEST(ScratchScope, AlignedBuffers)
+{
+    wwa::utils::scratch_scope scratch;
+    for (std::size_t alignment = 1; alignment <= 4096; alignment *= 2) {
+        void* p = scratch.allocate(3, alignment);
+        EXPECT_TRUE(aligned(p, alignment)) << alignment;
+        std::memset(p, 0xFF, 3);
+    }
+
+    const std::span<double> d = scratch.allocate<double>(100, 64);
+    EXPECT_EQ(d.size(), 100);
+    EXPECT_TRUE(aligned(d.data(), 64));
+    EXPECT_EQ(scratch.heap_allocations(), 0);
+}
+
+TEST(ScratchScope, LifoReuse)
+{
+    void* first = nullptr;
+    {
+        wwa::utils::scratch_scope scratch;
+        first = scratch.allocate(1000, 64);
+        {
+            wwa::utils::scratch_scope inner;
+            void* p = inner.allocate(1000, 64);
+            EXPECT_GT(p, first);
+        }
+
+        // The inner scope's buffer has been popped
+        void* second = scratch.allocate(1000, 64);
+        {
+            wwa::utils::scratch_scope inner;
+            void* p = inner.allocate(1000, 64);
+            EXPECT_GT(p, second);
+        }
+    }
+
+    wwa::utils::scratch_scope scratch;
+    EXPECT_EQ(scratch.allocate(1000, 64), first);
+}
+
+TEST(ScratchScope, HeapFallback)
+{
+    wwa::utils::scratch_scope scratch;
+    const std::span<std::byte> big = scratch.allocate<std::byte>(wwa::utils::detail::scratch_stack::capacity + 1, 256);
+    EXPECT_TRUE(aligned(big.data(), 256));
+    big.front() = std::byte{1};
+    big.back()  = std::byte{2};
+    EXPECT_EQ(scratch.heap_allocations(), 1);
+
+    // The stack is still usable
+    void* p = scratch.allocate(16);
+    EXPECT_NE(p, nullptr);
+    EXPECT_EQ(scratch.heap_allocations(), 1);
+}
+
+TEST(ScratchScope, OuterScopeAllocatesUnderInnerScope)
+{
+    wwa::utils::scratch_scope outer;
+    wwa::utils::scratch_scope inner;
+    void* a = inner.allocate(64);
+    void* b = outer.allocate(64);
+    EXPECT_NE(a, b);
+    EXPECT_EQ(outer.heap_allocations(), 1);
+    EXPECT_EQ(inner.heap_allocations(), 0);
+}
+
+TEST(ScratchScope, InvalidArguments)
+{
+    wwa::utils::scratch_scope scratch;
+    EXPECT_THROW((void)scratch.allocate(16, 3), std::invalid_argument);
+    EXPECT_THROW((void)scratch.allocate<std::uint64_t>(1, 4), std::invalid_argument);
+    EXPECT_THROW((void)scratch.allocate<std::uint64_t>(SIZE_MAX / 4), std::length_error);
+}
+
+TEST(ScratchScope, PerThread)
+{
+    void* theirs = nullptr;
+
+    wwa::utils::scratch_scope scratch;
+    void* mine = scratch.allocate(64);
+    std::thread([&theirs]() {
+        wwa::utils::scratch_scope other;
+        theirs = other.allocate(64);
+        std::memset(theirs, 0, 64);
+    }).join();
+
+    EXPECT_NE(mine, theirs);
+}
+
+TEST(ScratchScope, CanarySettingSelectsNamespace)
+{
+    // Translation units with different settings must not share the entities
+#if WWA_SCRATCH_CANARIES
+    EXPECT_TRUE((std::is_same_v<wwa::utils::scratch_scope, wwa::utils::scratch_canaries::scratch_scope>));
+#else
+    EXPECT_TRUE((std::is_same_v<wwa::utils::scratch_scope, wwa::utils::scratch_no_canaries::scratch_scope>));
+#endif
+}
+
+TEST(ScratchScopeDeathTest, DetectsOverrun)
+{
+    if (!wwa::utils::scratch_scope::canaries) {
+        GTEST_SKIP() << "Canaries are disabled";
+    }
+
+    EXPECT_DEATH(
+        {
+            wwa::utils::scratch_scope scratch;
+            auto* p = static_cast<unsigned char*>(scratch.allocate(16, 16));
+            std::memset(p, 0xAA, 24);
+        },
+        "buffer overrun"
+    );
+
+    EXPECT_DEATH(
+        {
+            wwa::utils::scratch_scope scratch;
+            const std::span<std::byte> big = scratch.allocate<std::byte>(wwa::utils::detail::scratch_stack::capacity);
+            std::memset(big.data(), 0xAA, big.size() + 8);
+        },
+        "buffer overrun"
+    );
+}
@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "seqlock.h"
+
+namespace {
+
+struct triple {
+    std::uint64_t a;
+    std::uint64_t b;
+    std::uint64_t c;
+};
+
+struct odd_sized {
+    char data[11];
+};
+
+}  // namespace
+
+TEST(Seqlock, LoadStore)
+{
+    wwa::utils::seqlock<triple> lock;
+
+    auto value = lock.load();
+    EXPECT_EQ(value.a, 0);
+    EXPECT_EQ(value.b, 0);
+    EXPECT_EQ(value.c, 0);
+
+    lock.store({1, 2, 3});
+    value = lock.load();
+    EXPECT_EQ(value.a, 1);
+    EXPECT_EQ(value.b, 2);
+    EXPECT_EQ(value.c, 3);
+    EXPECT_EQ(lock.sequence(), 2);
+}
+
+TEST(Seqlock, OddSizedValue)
+{
+    const odd_sized initial = {"0123456789"};
+    wwa::utils::seqlock<odd_sized> lock(initial);
+
+    EXPECT_STREQ(lock.load().data, "0123456789");
+
+    const odd_sized updated = {"abcdefghij"};
+    lock.store(updated);
+    EXPECT_STREQ(lock.load().data, "abcdefghij");
+}
+
+TEST(Seqlock, WriteScope)
+{
+    wwa::utils::seqlock<int> lock(1);
+
+    {
+        auto writer = lock.write();
+        EXPECT_EQ(lock.sequence(), 1);
+        EXPECT_EQ(writer.get(), 1);
+        writer.set(2);
+    }
+
+    EXPECT_EQ(lock.sequence(), 2);
+    EXPECT_EQ(lock.load(), 2);
+}
+
+TEST(Seqlock, WriteScopeException)
+{
+    wwa::utils::seqlock<int> lock(1);
+
+    try {
+        auto writer = lock.write();
+        writer.set(2);
+        throw std::runtime_error("error");
+    }
+    catch (const std::runtime_error&) {
+        EXPECT_EQ(lock.sequence(), 2);
+    }
+
+    EXPECT_EQ(lock.load(), 2);
+}
+
+TEST(Seqlock, ReadScopeRetry)
+{
+    wwa::utils::seqlock<int> lock(1);
+
+    auto reader = lock.read();
+    EXPECT_EQ(reader.get(), 1);
+    EXPECT_TRUE(reader.valid());
+
+    lock.store(2);
+    EXPECT_FALSE(reader.valid());
+    EXPECT_TRUE(reader.retry());
+    EXPECT_EQ(reader.get(), 2);
+    EXPECT_FALSE(reader.retry());
+}
+
+TEST(Seqlock, NoTornReads)
+{
+    constexpr int readers    = 3;
+    constexpr int iterations = 20000;
+
+    wwa::utils::seqlock<triple> lock;
+    std::atomic<bool> done{false};
+    std::atomic<int> torn{0};
+
+    std::vector<std::thread> threads;
+    threads.reserve(readers);
+    for (int i = 0; i < readers; ++i) {
+        threads.emplace_back([&lock, &done, &torn]() {
+            while (!done.load(std::memory_order_relaxed)) {
+                const auto value = lock.load();
+                if (value.a != value.b || value.b != value.c) {
+                    torn.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+
+    for (std::uint64_t i = 1; i <= iterations; ++i) {
+        lock.store({i, i, i});
+    }
+
+    done.store(true, std::memory_order_relaxed);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(torn.load(), 0);
+    EXPECT_EQ(lock.load().a, iterations);
+    EXPECT_EQ(lock.sequence(), 2 * iterations);
+}
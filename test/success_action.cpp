@@ -3,7 +3,7 @@
 #include <stdexcept>
 #include <utility>
 
-#include "scope_action.h"
+#include "success_action.h"
 
 static_assert(!std::is_copy_constructible_v<wwa::utils::success_action<void (*)()>>);
 static_assert(!std::is_copy_assignable_v<wwa::utils::success_action<void (*)()>>);
@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+#include "allocation_counting.h"
+#include "trace_zone.h"
+
+namespace {
+
+class TraceZoneTest : public ::testing::Test {
+protected:
+    std::filesystem::path path;
+
+    void SetUp() override
+    {
+        this->path = std::filesystem::temp_directory_path() /
+                     ("trace_zone_" + std::to_string(::getpid()) + "_" +
+                      ::testing::UnitTest::GetInstance()->current_test_info()->name() + ".json");
+    }
+
+    void TearDown() override { std::filesystem::remove(this->path); }
+
+    [[nodiscard]] std::string contents() const
+    {
+        std::ifstream in(this->path);
+        return {std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    }
+};
+
+std::size_t count(const std::string& haystack, const std::string& needle)
+{
+    std::size_t n = 0;
+    for (auto pos = haystack.find(needle); pos != std::string::npos; pos = haystack.find(needle, pos + 1)) {
+        ++n;
+    }
+
+    return n;
+}
+
+void traced_failure()
+{
+    const wwa::utils::trace_zone zone("failing");
+    throw std::runtime_error("error");
+}
+
+}  // namespace
+
+TEST_F(TraceZoneTest, WritesChromeTraceEvents)
+{
+    {
+        wwa::utils::trace_session session(this->path.string());
+        const wwa::utils::trace_zone outer("outer");
+        for (int i = 0; i < 3; ++i) {
+            const wwa::utils::trace_zone inner("in\"ner");
+        }
+    }
+
+    const auto json = this->contents();
+    EXPECT_EQ(json.rfind(R"({"displayTimeUnit":"ns","traceEvents":[)", 0), 0);
+    EXPECT_EQ(json.substr(json.size() - 3), "]}\n");
+    EXPECT_EQ(count(json, R"("name":"in\"ner","ph":"X")"), 3);
+    EXPECT_EQ(count(json, R"("name":"outer","ph":"X")"), 1);
+}
+
+TEST_F(TraceZoneTest, ZonesCloseDuringUnwinding)
+{
+    {
+        wwa::utils::trace_session session(this->path.string());
+        EXPECT_THROW(traced_failure(), std::runtime_error);
+    }
+
+    const auto json = this->contents();
+    EXPECT_EQ(count(json, R"("name":"failing")"), 1);
+    EXPECT_EQ(count(json, R"("args":{"exception":true})"), 1);
+}
+
+TEST_F(TraceZoneTest, ThreadsAndPeriodicFlush)
+{
+    {
+        wwa::utils::trace_session session(this->path.string(), {.flush_interval = std::chrono::milliseconds(1)});
+        std::thread([]() {
+            for (int i = 0; i < 100; ++i) {
+                const wwa::utils::trace_zone zone("worker");
+            }
+        }).join();
+
+        const wwa::utils::trace_zone zone("main");
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        EXPECT_EQ(count(this->contents(), R"("name":"worker")"), 100);
+    }
+
+    const auto json = this->contents();
+    EXPECT_EQ(count(json, R"("name":"worker")"), 100);
+    EXPECT_EQ(count(json, R"("name":"main")"), 1);
+}
+
+TEST_F(TraceZoneTest, NoSession)
+{
+    {
+        const wwa::utils::trace_zone zone("ignored");
+    }
+
+    {
+        wwa::utils::trace_session session(this->path.string());
+    }
+
+    EXPECT_EQ(count(this->contents(), R"("name":"ignored")"), 0);
+}
+
+TEST_F(TraceZoneTest, DropsEventsWhenFull)
+{
+    wwa::utils::trace_session session(
+        this->path.string(), {.buffer_events = 16, .flush_interval = std::chrono::milliseconds(10'000)}
+    );
+
+    std::thread([]() {
+        for (int i = 0; i < 100; ++i) {
+            const wwa::utils::trace_zone zone("zone");
+        }
+    }).join();
+
+    EXPECT_EQ(session.dropped(), 84);
+}
+
+TEST_F(TraceZoneTest, InvalidUse)
+{
+    EXPECT_THROW(wwa::utils::trace_session(this->path.string(), {.buffer_events = 1000}), std::invalid_argument);
+
+    const wwa::utils::trace_session session(this->path.string());
+    EXPECT_THROW(wwa::utils::trace_session(this->path.string() + ".2"), std::logic_error);
+    std::filesystem::remove(this->path.string() + ".2");
+}
+
+using TraceZoneAllocations = AllocationCountingTest;
+
+TEST_F(TraceZoneAllocations, RecordingDoesNotAllocate)
+{
+    const auto path = std::filesystem::temp_directory_path() / ("trace_zone_" + std::to_string(::getpid()) + ".json");
+    {
+        wwa::utils::trace_session session(path.string());
+        ASSERT_TRUE(wwa::utils::trace_session::register_thread());
+
+        const auto stats = count_allocations([]() {
+            for (int i = 0; i < 1000; ++i) {
+                const wwa::utils::trace_zone zone("zone");
+            }
+        });
+
+        EXPECT_EQ(stats.allocations, 0);
+    }
+
+    std::filesystem::remove(path);
+}
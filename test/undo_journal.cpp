@@ -0,0 +1,294 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+
+#include <csignal>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "undo_journal.h"
+
+namespace {
+
+constexpr std::size_t region_size = 8192;
+
+struct store {
+    std::uint64_t count;
+    std::uint64_t tail;
+    std::array<std::uint64_t, 16> items;
+};
+
+class mapped_file {
+public:
+    explicit mapped_file(const std::filesystem::path& path)
+        : m_fd(::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644))  // NOLINT(*-vararg)
+    {
+        if (this->m_fd == -1 || ::ftruncate(this->m_fd, region_size) == -1) {
+            throw std::runtime_error("Unable to create " + path.string());
+        }
+
+        void* map = ::mmap(nullptr, region_size, PROT_READ | PROT_WRITE, MAP_SHARED, this->m_fd, 0);
+        if (map == MAP_FAILED) {  // NOLINT(*-cstyle-cast,performance-no-int-to-ptr)
+            throw std::runtime_error("Unable to map " + path.string());
+        }
+
+        this->m_map = static_cast<std::byte*>(map);
+    }
+
+    mapped_file(const mapped_file&)            = delete;
+    mapped_file(mapped_file&&)                 = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+    mapped_file& operator=(mapped_file&&)      = delete;
+
+    ~mapped_file()
+    {
+        ::munmap(this->m_map, region_size);
+        ::close(this->m_fd);
+    }
+
+    [[nodiscard]] std::span<std::byte> region() const { return {this->m_map, region_size}; }
+    [[nodiscard]] store& data() const { return *reinterpret_cast<store*>(this->m_map); }
+
+private:
+    int m_fd;
+    std::byte* m_map = nullptr;
+};
+
+class UndoJournal : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        this->m_dir      = std::filesystem::temp_directory_path() /
+                      ("wwa-undo-journal-" + std::to_string(::getpid()) + "-" + info->name());
+        std::filesystem::remove_all(this->m_dir);
+        std::filesystem::create_directories(this->m_dir);
+    }
+
+    void TearDown() override { std::filesystem::remove_all(this->m_dir); }
+
+    [[nodiscard]] std::filesystem::path data_path() const { return this->m_dir / "store.dat"; }
+    [[nodiscard]] std::filesystem::path journal_path() const { return this->m_dir / "store.journal"; }
+
+    /**
+     * Runs @a fn in a child process which is killed with SIGKILL when it calls `hang()`, simulating a crash.
+     */
+    template<typename Func>
+    void crash(Func fn)
+    {
+        std::array<int, 2> fds{};
+        ASSERT_EQ(::pipe(fds.data()), 0);
+
+        const pid_t pid = ::fork();
+        ASSERT_NE(pid, -1);
+        if (pid == 0) {
+            ::close(fds[0]);
+            this->m_ready_fd = fds[1];
+            fn();
+            ::_exit(1);
+        }
+
+        ::close(fds[1]);
+        char ready = 0;
+        EXPECT_EQ(::read(fds[0], &ready, 1), 1);
+        ::close(fds[0]);
+
+        ASSERT_EQ(::kill(pid, SIGKILL), 0);
+        int status = 0;
+        ASSERT_EQ(::waitpid(pid, &status, 0), pid);
+        EXPECT_TRUE(WIFSIGNALED(status));
+    }
+
+    /**
+     * Tells the parent process that the child is ready to be killed, and waits for that.
+     */
+    [[noreturn]] void hang() const
+    {
+        const char ready = 1;
+        if (::write(this->m_ready_fd, &ready, 1) != 1) {
+            ::_exit(1);
+        }
+
+        for (;;) {
+            ::pause();
+        }
+    }
+
+private:
+    std::filesystem::path m_dir;
+    int m_ready_fd = -1;
+};
+
+}  // namespace
+
+TEST_F(UndoJournal, CommitOnSuccess)
+{
+    const mapped_file file(this->data_path());
+    wwa::utils::undo_journal journal(this->journal_path(), file.region());
+    EXPECT_EQ(journal.recovered(), 0);
+
+    {
+        auto tx = journal.begin();
+        journal.save(file.data().count, file.data().items[0]);
+        file.data().count    = 1;
+        file.data().items[0] = 42;
+        EXPECT_EQ(journal.size(), 2);
+    }
+
+    EXPECT_EQ(journal.size(), 0);
+    EXPECT_EQ(file.data().count, 1);
+    EXPECT_EQ(file.data().items[0], 42);
+}
+
+TEST_F(UndoJournal, RollbackOnFailure)
+{
+    const mapped_file file(this->data_path());
+    wwa::utils::undo_journal journal(this->journal_path(), file.region());
+    file.data().count = 5;
+
+    try {
+        auto tx = journal.begin();
+        journal.save(file.data().count);
+        file.data().count = 6;
+        journal.save(file.data().count);
+        file.data().count = 7;
+        throw std::runtime_error("error");
+    }
+    catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+    }
+
+    EXPECT_EQ(journal.size(), 0);
+    EXPECT_EQ(file.data().count, 5);
+}
+
+TEST_F(UndoJournal, OutOfRegion)
+{
+    const mapped_file file(this->data_path());
+    wwa::utils::undo_journal journal(this->journal_path(), file.region());
+    int local = 0;
+
+    EXPECT_THROW(journal.save(local), std::out_of_range);
+    EXPECT_THROW(journal.save_bytes(file.region().data() + region_size - 4, 8), std::out_of_range);
+}
+
+TEST_F(UndoJournal, JournalFull)
+{
+    const mapped_file file(this->data_path());
+    wwa::utils::undo_journal journal(this->journal_path(), file.region(), 64);
+
+    journal.save(file.data().count);
+    EXPECT_THROW(journal.save_bytes(file.region().data(), 1024), std::length_error);
+    EXPECT_EQ(journal.size(), 1);
+}
+
+TEST_F(UndoJournal, NotAJournal)
+{
+    {
+        std::ofstream f(this->journal_path(), std::ios::binary);
+        f << "This is definitely not an undo journal";
+    }
+
+    const mapped_file file(this->data_path());
+    EXPECT_THROW(wwa::utils::undo_journal(this->journal_path(), file.region()), std::runtime_error);
+}
+
+TEST_F(UndoJournal, RecoveryAfterCrash)
+{
+    {
+        const mapped_file file(this->data_path());
+        file.data().count = 10;
+        file.data().tail  = 20;
+    }
+
+    this->crash([this]() {
+        const mapped_file file(this->data_path());
+        wwa::utils::undo_journal journal(this->journal_path(), file.region());
+        auto tx = journal.begin();
+        journal.save(file.data().count, file.data().tail);
+        file.data().count = 11;
+        file.data().tail  = 21;
+        journal.save(file.data().tail);
+        file.data().tail = 22;
+        this->hang();
+    });
+
+    const mapped_file file(this->data_path());
+    EXPECT_EQ(file.data().count, 11);
+    EXPECT_EQ(file.data().tail, 22);
+
+    const wwa::utils::undo_journal journal(this->journal_path(), file.region());
+    EXPECT_EQ(journal.recovered(), 3);
+    EXPECT_EQ(file.data().count, 10);
+    EXPECT_EQ(file.data().tail, 20);
+
+    // Recovery is complete: reopening does not restore anything
+    const wwa::utils::undo_journal again(this->journal_path(), file.region());
+    EXPECT_EQ(again.recovered(), 0);
+}
+
+TEST_F(UndoJournal, NoRecoveryAfterCommit)
+{
+    this->crash([this]() {
+        const mapped_file file(this->data_path());
+        wwa::utils::undo_journal journal(this->journal_path(), file.region());
+        {
+            auto tx = journal.begin();
+            journal.save(file.data().count);
+            file.data().count = 1;
+        }
+
+        // The second transaction is interrupted
+        auto tx = journal.begin();
+        journal.save(file.data().count, file.data().items[3]);
+        file.data().count    = 2;
+        file.data().items[3] = 3;
+        this->hang();
+    });
+
+    const mapped_file file(this->data_path());
+    const wwa::utils::undo_journal journal(this->journal_path(), file.region());
+    EXPECT_EQ(journal.recovered(), 2);
+    EXPECT_EQ(file.data().count, 1);
+    EXPECT_EQ(file.data().items[3], 0);
+}
+
+TEST_F(UndoJournal, TornRecordIsIgnored)
+{
+    this->crash([this]() {
+        const mapped_file file(this->data_path());
+        wwa::utils::undo_journal journal(this->journal_path(), file.region());
+        file.data().count = 1;
+        file.data().tail  = 1;
+        journal.commit();
+
+        journal.save(file.data().count);
+        file.data().count = 2;
+        journal.save(file.data().tail);
+        file.data().tail = 2;
+        this->hang();
+    });
+
+    {
+        // Corrupt the payload of the second record: file header (32 bytes), first record (24 + 8 bytes),
+        // second record header (24 bytes)
+        constexpr std::streamoff offset = 32 + 24 + 8 + 24;
+        std::fstream f(this->journal_path(), std::ios::binary | std::ios::in | std::ios::out);
+        f.seekp(offset);
+        f.put('\xFF');
+    }
+
+    const mapped_file file(this->data_path());
+    const wwa::utils::undo_journal journal(this->journal_path(), file.region());
+    EXPECT_EQ(journal.recovered(), 1);
+    EXPECT_EQ(file.data().count, 1);
+    EXPECT_EQ(file.data().tail, 2);
+}
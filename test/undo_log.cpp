@@ -0,0 +1,249 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "undo_log.h"
+
+namespace {
+
+struct account {
+    int balance;
+    int version;
+    std::string owner;
+};
+
+class throwing_copy {
+public:
+    throwing_copy() = default;
+    throwing_copy(const throwing_copy&) { throw std::runtime_error("copy"); }
+    throwing_copy(throwing_copy&&) noexcept            = default;
+    throwing_copy& operator=(const throwing_copy&)     = default;
+    throwing_copy& operator=(throwing_copy&&) noexcept = default;
+    ~throwing_copy()                                   = default;
+};
+
+}  // namespace
+
+TEST(UndoLog, Rollback)
+{
+    wwa::utils::undo_log log;
+    account a{100, 1, "alice"};
+
+    log.save(a.balance, a.version, a.owner);
+    EXPECT_EQ(log.mark(), 3);
+    a.balance = 50;
+    a.version = 2;
+    a.owner   = "bob";
+
+    log.rollback();
+    EXPECT_TRUE(log.empty());
+    EXPECT_EQ(a.balance, 100);
+    EXPECT_EQ(a.version, 1);
+    EXPECT_EQ(a.owner, "alice");
+}
+
+TEST(UndoLog, ReverseOrder)
+{
+    wwa::utils::undo_log log;
+    int x = 1;
+
+    log.save(x);
+    x = 2;
+    log.save(x);
+    x = 3;
+
+    log.rollback_to(1);
+    EXPECT_EQ(x, 2);
+    log.rollback();
+    EXPECT_EQ(x, 1);
+}
+
+TEST(UndoLog, SaveBytes)
+{
+    wwa::utils::undo_log log;
+    std::array<char, 6> buf = {'a', 'b', 'c', 'd', 'e', 'f'};
+
+    log.save_bytes(&buf[1], 3);
+    buf = {'z', 'z', 'z', 'z', 'z', 'z'};
+    log.rollback();
+
+    EXPECT_EQ(buf, (std::array<char, 6>{'z', 'b', 'c', 'd', 'z', 'z'}));
+}
+
+TEST(UndoLog, SavepointFailure)
+{
+    wwa::utils::undo_log log;
+    account a{100, 1, "alice"};
+
+    try {
+        auto tx = log.begin();
+        log.save(a.balance, a.owner);
+        a.balance = 0;
+        a.owner   = "mallory";
+        throw std::runtime_error("error");
+    }
+    catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+    }
+
+    EXPECT_TRUE(log.empty());
+    EXPECT_EQ(a.balance, 100);
+    EXPECT_EQ(a.owner, "alice");
+}
+
+TEST(UndoLog, SavepointSuccess)
+{
+    wwa::utils::undo_log log;
+    account a{100, 1, "alice"};
+
+    {
+        auto tx = log.begin();
+        log.save(a.balance, a.owner);
+        a.balance = 0;
+        a.owner   = "bob";
+    }
+
+    EXPECT_TRUE(log.empty());
+    EXPECT_EQ(a.balance, 0);
+    EXPECT_EQ(a.owner, "bob");
+}
+
+TEST(UndoLog, NestedPartialRollback)
+{
+    wwa::utils::undo_log log;
+    account a{100, 1, "alice"};
+
+    {
+        auto tx = log.begin();
+        log.save(a.balance);
+        a.balance = 50;
+
+        try {
+            auto sp = log.begin();
+            log.save(a.owner);
+            a.owner = "mallory";
+            throw std::runtime_error("error");
+        }
+        catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+        }
+
+        EXPECT_EQ(a.owner, "alice");
+        EXPECT_EQ(a.balance, 50);
+        EXPECT_EQ(log.mark(), 1);
+    }
+
+    EXPECT_TRUE(log.empty());
+    EXPECT_EQ(a.balance, 50);
+}
+
+TEST(UndoLog, NestedSuccessOuterFailure)
+{
+    wwa::utils::undo_log log;
+    account a{100, 1, "alice"};
+
+    try {
+        auto tx = log.begin();
+        log.save(a.balance);
+        a.balance = 50;
+
+        {
+            auto sp = log.begin();
+            log.save(a.owner, a.version);
+            a.owner   = "bob";
+            a.version = 2;
+        }
+
+        EXPECT_EQ(log.mark(), 3);
+        throw std::runtime_error("error");
+    }
+    catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+    }
+
+    EXPECT_TRUE(log.empty());
+    EXPECT_EQ(a.balance, 100);
+    EXPECT_EQ(a.version, 1);
+    EXPECT_EQ(a.owner, "alice");
+}
+
+TEST(UndoLog, NestedSuccessBeforeOuterSave)
+{
+    wwa::utils::undo_log log;
+    int x = 0;
+
+    try {
+        auto tx = log.begin();
+        {
+            auto sp = log.begin();
+            log.save(x);
+            x = 1;
+        }
+
+        EXPECT_EQ(log.mark(), 1);
+        throw std::runtime_error("error");
+    }
+    catch (const std::runtime_error&) {  // NOLINT(bugprone-empty-catch)
+    }
+
+    EXPECT_TRUE(log.empty());
+    EXPECT_EQ(x, 0);
+}
+
+TEST(UndoLog, ExplicitRollbackAndRelease)
+{
+    wwa::utils::undo_log log;
+    int x = 1;
+
+    {
+        auto tx = log.begin();
+        log.save(x);
+        x = 2;
+        tx.rollback();
+        EXPECT_EQ(x, 1);
+
+        log.save(x);
+        x = 3;
+        tx.release();
+    }
+
+    EXPECT_EQ(x, 3);
+    EXPECT_EQ(log.mark(), 1);
+    log.rollback();
+    EXPECT_EQ(x, 1);
+}
+
+TEST(UndoLog, ArenaGrowth)
+{
+    wwa::utils::undo_log log(16);
+    std::vector<std::string> values(100);
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        values[i] = "value #" + std::to_string(i) + " which does not fit into the small string buffer";
+    }
+
+    for (int round = 0; round < 2; ++round) {
+        for (auto& value : values) {
+            log.save(value);
+            value.clear();
+        }
+
+        log.rollback();
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            EXPECT_EQ(values[i], "value #" + std::to_string(i) + " which does not fit into the small string buffer");
+        }
+    }
+}
+
+TEST(UndoLog, ThrowingCopy)
+{
+    wwa::utils::undo_log log;
+    int x = 1;
+    throwing_copy t;
+
+    EXPECT_THROW(log.save(x, t), std::runtime_error);
+    EXPECT_TRUE(log.empty());
+
+    log.save(x);
+    EXPECT_THROW(log.save(t), std::runtime_error);
+    EXPECT_EQ(log.mark(), 1);
+}